@@ -0,0 +1,36 @@
+#ifndef BOOTLOG_H
+#define BOOTLOG_H
+
+#include <Arduino.h>
+#include "Perf.h"
+
+// ---------- Boot timeline ----------
+// bootMark("stage") stamps a stage with millis() since reset and prints it
+// right away (and into the perf trace); bootSummary() prints the whole
+// timeline with per-stage deltas.
+// Stage names must be string literals (only the pointer is kept).
+
+static const int BOOT_MAX_MARKS = 16;
+
+struct BootMark { const char* name; uint32_t ms; };
+static BootMark g_bootMarks[BOOT_MAX_MARKS];
+static int      g_bootMarkCount = 0;
+
+inline void bootMark(const char* stage) {
+  uint32_t ms = millis();
+  if (g_bootMarkCount < BOOT_MAX_MARKS) g_bootMarks[g_bootMarkCount++] = { stage, ms };
+  perfInstant(stage, PERF_BOOT);
+  Serial.printf("[boot %6lu ms] %s\n", (unsigned long)ms, stage);
+}
+
+inline void bootSummary() {
+  Serial.println("---- boot timeline ----");
+  uint32_t prev = 0;
+  for (int i = 0; i < g_bootMarkCount; ++i) {
+    Serial.printf("  %6lu ms  (+%5lu)  %s\n", (unsigned long)g_bootMarks[i].ms,
+                  (unsigned long)(g_bootMarks[i].ms - prev), g_bootMarks[i].name);
+    prev = g_bootMarks[i].ms;
+  }
+}
+
+#endif // BOOTLOG_H
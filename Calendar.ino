@@ -7,6 +7,23 @@
 #include <SD.h>
 #include <SPI.h>
 #include <vector>
+#include <algorithm>
+#include "WiFiManager.h"
+#include "BootLog.h"
+#include "SleepScheduler.h"
+#include "WorldClock.h"
+#include "LastKnown.h"
+#include "GrayRender.h"
+#include "Perf.h"
+#include "ConfigServer.h"
+#include "CalFeeds.h"
+#include "Agenda.h"
+#include "WeekGrid.h"
+#include "GlyphFont.h"
+#include "FrameStore.h"
+#include "TouchInput.h"
+#include "WxHourly.h"
+#include "DeltaOta.h"
 
 // ---------- PaperS3 SD pins ----------
 #define SD_CS   47
@@ -19,8 +36,7 @@ String ssid;
 String password;
 String backup_ssid;
 String backup_password;
-String calendarUrl;
-String calendarUrl2;
+String calendarUrls[CAL_MAX_FEEDS];   // CAL_URL1..CAL_URL8
 String weatherApiKey;
 String LAT = "";           
 String LON = "-";
@@ -29,23 +45,27 @@ constexpr char DEG = (char)248;
 // ---------- Time ----------
 const char* ntpServer = "pool.ntp.org";
 const char* TZ_INFO   = "EST5EDT,M3.2.0/2,M11.1.0/2";
+const char* TZ_ZONE   = "America/New_York";   // same zone, for WorldClock.h
 
 // ---------- UI ----------
 const int SCREEN_W = 960;
 const int SCREEN_H = 540;
 const int HEADER_H = 110;
+const int HOURLY_H = 40;
 const int FORECAST_H = 56;
-const int TOP_AREA_H = HEADER_H + FORECAST_H + 8;
+const int TOP_AREA_H = HEADER_H + HOURLY_H + FORECAST_H + 8;
 const int DAYS_TO_SHOW = 5;
 
 // Colors 
 const uint16_t BG         = 0xFFFF;
 const uint16_t TEXT       = 0x0000;
-const uint16_t SUBTLE     = 0xDEFB;
-const uint16_t LINE       = 0xC618;
+// Grays are panel levels (GrayRender.h), one each so the header, rules,
+// badges and today's card stay apart
+const uint16_t SUBTLE     = gray565(0xDD);
+const uint16_t LINE       = gray565(0xBB);
 const uint16_t DARKLINE   = 0x0000;
-const uint16_t BADGE_FILL = 0xE71C;
-const uint16_t TODAY_BG   = 0xCEDC;
+const uint16_t BADGE_FILL = gray565(0xEE);
+const uint16_t TODAY_BG   = GRAY_LIGHT;
 
 // ---------- Models ----------
 struct CalendarEvent {
@@ -55,13 +75,21 @@ struct CalendarEvent {
   int sh, sm;
   int eh, em;
   bool allDay;
+  uint32_t endYmd;     // DTEND's local date, yyyymmdd (exclusive when all-day); 0 = none
+  uint32_t key;        // hash of UID + RECURRENCE-ID
+  uint32_t seq, mod;   // SEQUENCE, LAST-MODIFIED (CalFeeds.h calStamp)
+  uint32_t sig;        // hash of what the card shows
 };
 
-CalendarEvent events[160];
+// Sorted and merged from every feed; sized per refresh, so large blocks
+// land in PSRAM (FEED_MAX_EVENTS bounds it)
+std::vector<CalendarEvent> events;
 int eventCount = 0;
+uint32_t g_eventsRev = 1;      // bumped when a refresh changes events[]
 
 struct WeatherNow { int t, lo, hi; String cond; } nowWx;
 struct ForecastDay { int y,m,d, hi, lo; String cond; } fcast[7];
+WxTimeline g_wx;               // hourly, from the one forecast request (WxHourly.h)
 
 struct DayView {
   int y,m,d,wday;
@@ -90,6 +118,17 @@ void clearMarquees() {
   marquees.clear();
 }
 
+// Drop the marquees inside one day card before it is redrawn
+void clearMarqueesIn(int x,int y,int w,int h) {
+  for (size_t i = 0; i < marquees.size(); ) {
+    Marquee& m = marquees[i];
+    if (m.x >= x && m.x < x + w && m.y >= y && m.y < y + h) {
+      if (m.sp) { m.sp->deleteSprite(); delete m.sp; }
+      marquees.erase(marquees.begin() + i);
+    } else ++i;
+  }
+}
+
 void addMarquee(int x,int y,int w,int h,const String& text,int textSize) {
   M5Canvas* sp = new M5Canvas(&M5.Display);
   sp->setColorDepth(8);
@@ -98,19 +137,17 @@ void addMarquee(int x,int y,int w,int h,const String& text,int textSize) {
   sp->setTextWrap(false);
   sp->setTextSize(textSize);
 
-  int textW = sp->textWidth(text.c_str());
-  int lh    = sp->fontHeight();
+  int textW = uiTextWidth(*sp, text, textSize);
+  int lh    = uiLineH(*sp, textSize);
   int gap   = 32;
   int loopW = textW + gap + w;
 
   if (textW <= w) {
     sp->deleteSprite();
     delete sp;
-    M5.Display.setTextSize(textSize);
     M5.Display.setTextColor(TEXT, BG);
-    M5.Display.setCursor(x, y);
     M5.Display.setClipRect(x, y, w, lh + 2);
-    M5.Display.print(text);
+    uiText(M5.Display, x, y, text, textSize, TEXT);
     M5.Display.clearClipRect();
     return;
   }
@@ -120,8 +157,8 @@ void addMarquee(int x,int y,int w,int h,const String& text,int textSize) {
   sp->fillSprite(BG);
   sp->setTextColor(TEXT, BG);
   sp->setTextSize(textSize);
-  sp->setCursor(0, 0);                 sp->print(text);
-  sp->setCursor(textW + gap, 0);       sp->print(text);
+  uiText(*sp, 0, 0, text, textSize, TEXT);
+  uiText(*sp, textW + gap, 0, text, textSize, TEXT);
 
   Marquee m;
   m.x = x; m.y = y; m.w = w; m.h = lh + 2;
@@ -152,6 +189,7 @@ void updateMarquees() {
     if (!m.sp) continue;
     if (now - m.lastMs < MARQUEE_STEP_MS) continue;
     m.lastMs = now;
+    PERF_SCOPE("marquee step", PERF_RENDER);
 
     m.offset += m.speed;
     if (m.offset >= m.loopW) m.offset -= m.loopW;
@@ -166,10 +204,35 @@ void updateMarquees() {
 
 // ---------- Refresh state ----------
 int lastMinute = -1;
+int lastHour = -1;
 int lastY=-1, lastM=-1, lastD=-1;
 unsigned long lastWxMS = 0;
 const unsigned long WX_PERIOD = 30UL*60UL*1000UL;
 
+// ---------- Sleep ----------
+// Kept in RTC memory so a deep-sleep wake can redraw the header without
+// touching SD or the network.
+struct RtcCalendarState {
+  uint32_t magic;
+  time_t   lastWxEpoch;
+  int16_t  y, m, d;                // day currently on the panel
+  int16_t  wxT, wxLo, wxHi;
+  char     wxCond[16];
+  bool     sleepEnabled;
+  int8_t   deepFrom, deepTo;       // local hours for deep sleep, equal = never
+  uint32_t wxAt;                   // when the weather on screen was fetched, 0 = never
+};
+const uint32_t RTC_STATE_MAGIC = 0x43414C31; // "CAL1"
+RTC_DATA_ATTR RtcCalendarState g_rtcState = {};
+
+const unsigned long IDLE_BEFORE_SLEEP_MS = 20000;  // stay up this long after a touch
+const unsigned long NET_WAIT_MAX_MS      = 20000;  // give a join this long before giving up
+bool g_wxPending  = false;
+bool g_calPending = false;
+unsigned long g_pendingSinceMs = 0;
+unsigned long g_lastTouchMs    = 0;
+unsigned long g_awakeSinceMs   = 0;
+
 // ---------- Utils ----------
 String two(int v){ char b[8]; sprintf(b,"%02d",v); return String(b); }
 
@@ -193,35 +256,41 @@ void badge(int x,int y,const String& s){
   M5.Display.print(s);
 }
 
-int wrapInsideBox(int x,int y,int w,int bottom,const String& text,int sz){
-  M5.Display.setTextSize(sz);
-  int lineH = M5.Display.fontHeight();
+// Word-wrap `text` into a box on any target; returns the y below it. With
+// draw false it only measures (agenda row heights).
+int wrapText(LovyanGFX& g,int x,int y,int w,int bottom,const String& text,int sz,bool draw){
+  int lineH = uiLineH(g, sz);
   String word, line; int cy=y;
   auto flushLine=[&](){
     if (cy + lineH > bottom) return false;
-    M5.Display.setCursor(x, cy); M5.Display.print(line);
+    if (draw) uiText(g, x, cy, line, sz, TEXT);
     cy += lineH + 2; line = ""; return true;
   };
   for (int i=0;i<=text.length();++i){
     char c=(i<text.length())?text[i]:' ';
     if (c==' '||c=='\n'||i==text.length()){
       String prospect = line.length()? (line+" "+word):word;
-      if (M5.Display.textWidth(prospect.c_str()) <= w) line = prospect;
+      if (uiTextWidth(g, prospect, sz) <= w) line = prospect;
       else { if (!flushLine()) return bottom; line = word; }
       word = "";
       if (c=='\n'){ if (!flushLine()) return bottom; }
     } else word += c;
   }
   if (line.length()){
-    if (M5.Display.textWidth(line.c_str()) > w){
-      while (line.length() && M5.Display.textWidth((line+"…").c_str()) > w) line.remove(line.length()-1);
+    if (uiTextWidth(g, line, sz) > w){
+      // Trim whole codepoints so a multi-byte character is never cut in half
+      while (line.length() && uiTextWidth(g, line+"…", sz) > w) line.remove(utf8DropLast(line.c_str(), line.length()));
       line += "…";
     }
-    if (y + lineH <= bottom){ M5.Display.setCursor(x, cy); cy += lineH + 2; }
+    flushLine();
   }
   return cy;
 }
 
+int wrapInsideBox(int x,int y,int w,int bottom,const String& text,int sz){
+  return wrapText(M5.Display, x, y, w, bottom, text, sz, true);
+}
+
 // ---------- Time ----------
 void setupTime(){
   configTime(0, 0, ntpServer);
@@ -230,11 +299,12 @@ void setupTime(){
 }
 
 bool readLocal(struct tm &out){
-  if (getLocalTime(&out)) return true;
+  // Short wait only: before NTP has synced this is called every loop
+  if (getLocalTime(&out, 10)) return true;
 
   if (M5.In_I2C.isEnabled()){
     m5::rtc_time_t rt; m5::rtc_date_t rd;
-    M5.Rtc.getTime(&rt); M5.Rtc.getDate(&rd);
+    { I2cBusLock bus; M5.Rtc.getTime(&rt); M5.Rtc.getDate(&rd); }
     if (rd.year > 2000){
       memset(&out, 0, sizeof(out));
       out.tm_year = rd.year - 1900;
@@ -251,14 +321,21 @@ bool readLocal(struct tm &out){
 
 void syncRTCFromNTP(){
   struct tm ti{};
-  if (getLocalTime(&ti)){
+  if (getLocalTime(&ti, 10)){
     m5::rtc_time_t t; t.hours=ti.tm_hour; t.minutes=ti.tm_min; t.seconds=ti.tm_sec;
     m5::rtc_date_t d; d.date=ti.tm_mday; d.month=ti.tm_mon+1; d.year=ti.tm_year+1900;
-    if (M5.In_I2C.isEnabled()){ M5.Rtc.setTime(&t); M5.Rtc.setDate(&d); }
+    if (M5.In_I2C.isEnabled()){ I2cBusLock bus; M5.Rtc.setTime(&t); M5.Rtc.setDate(&d); }
   }
 }
 
 // ---------- Calendar parsing ----------
+// Built once, before any feed worker parses with it
+static WcTable g_calTz;
+static bool    g_calTzReady = false;
+void calTzInit(){
+  if (!g_calTzReady) { wcBuild(*wcFind(TZ_ZONE), g_calTz); g_calTzReady = true; }
+}
+
 void parseICSDateTime(const String& line, bool isEnd, CalendarEvent& ev){
   // Split header:value
   int p = line.indexOf(':');
@@ -268,8 +345,9 @@ void parseICSDateTime(const String& line, bool isEnd, CalendarEvent& ev){
   dt.trim();
   dt.replace("\r", "");
 
-  // 1) Pure DATE form => all-day; DTEND (if present) is exclusive and ignored
+  // 1) Pure DATE form => all-day; DTEND (if present) is the day after the last
   if (head.indexOf("VALUE=DATE") != -1) {
+    if (isEnd && dt.length() >= 8) ev.endYmd = (uint32_t)dt.substring(0, 8).toInt();
     if (!isEnd) {
       ev.allDay = true;
       if (dt.length() >= 8) {
@@ -315,241 +393,281 @@ void parseICSDateTime(const String& line, bool isEnd, CalendarEvent& ev){
       ev.y  = y; ev.m = m; ev.d = d;
       ev.sh = -1; ev.sm = -1;
       ev.eh = -1; ev.em = -1;
+    } else {
+      ev.endYmd = (uint32_t)(y*10000 + m*100 + d);   // all-day: exclusive; timed: ends at midnight
     }
-    return; // Ignore DTEND for all-day cards
+    return;
   }
 
   // 2b) Timed events, with local or UTC conversion
   if (!hasZ) {
     // Treat as local (either with TZID or "floating")
     if (!isEnd) { ev.y = y; ev.m = m; ev.d = d; ev.sh = hh; ev.sm = mm; }
-    else        { ev.eh = hh; ev.em = mm; }
+    else        { ev.eh = hh; ev.em = mm; ev.endYmd = (uint32_t)(y*10000 + m*100 + d); }
     return;
   }
 
-  struct tm tmutc{};
-  tmutc.tm_year = y - 1900;
-  tmutc.tm_mon  = m - 1;
-  tmutc.tm_mday = d;
-  tmutc.tm_hour = hh;
-  tmutc.tm_min  = mm;
-  tmutc.tm_sec  = 0;
-
-  // Save previous TZ
-  char* prevTZ = getenv("TZ");
-  String prev = prevTZ ? String(prevTZ) : String();
-
-  setenv("TZ", "UTC", 1); tzset();
-  time_t utc_ts = mktime(&tmutc);
-
-  setenv("TZ", TZ_INFO, 1); tzset();
-  struct tm lt = *localtime(&utc_ts);
+  // UTC -> local through the zone's transition table (no TZ swap)
+  calTzInit();
+  WcCivil lt = wcCivil(wcLocalMinute(g_calTz, wcEpoch(y, m, d, hh, mm)));
 
   if (!isEnd) {
-    ev.y  = lt.tm_year + 1900;
-    ev.m  = lt.tm_mon + 1;
-    ev.d  = lt.tm_mday;
-    ev.sh = lt.tm_hour;
-    ev.sm = lt.tm_min;
+    ev.y  = lt.year;
+    ev.m  = lt.month;
+    ev.d  = lt.day;
+    ev.sh = lt.hour;
+    ev.sm = lt.min;
   } else {
-    ev.eh = lt.tm_hour;
-    ev.em = lt.tm_min;
+    ev.eh = lt.hour;
+    ev.em = lt.min;
+    ev.endYmd = (uint32_t)(lt.year*10000 + lt.month*100 + lt.day);
   }
-
-  // Restore TZ
-  if (prev.length() > 0) { setenv("TZ", prev.c_str(), 1); tzset(); }
-  else                   { setenv("TZ", TZ_INFO, 1);     tzset(); }
 }
 
-bool parseAndAddEvents(const String& data, int maxEvents) {
-  int pos = 0;
-  bool success = false;
-  while (pos < data.length() && eventCount < maxEvents) {
-    int s=data.indexOf("BEGIN:VEVENT",pos); if(s<0)break;
-    int e=data.indexOf("END:VEVENT",s); if(e<0)break;
-    String body=data.substring(s,e);
+// ---------- Calendar feeds ----------
+// Each feed's worker builds its own list from the unfolded lines; the lists
+// are sorted and merged into events[] once every feed is done. Upcoming
+// events past FEED_MAX_EVENTS (per feed and in total) are dropped, latest
+// first; that is months of a busy shared calendar.
+static const int FEED_MAX_EVENTS = 2000;
+
+struct FeedEvents {
+  std::vector<CalendarEvent> list;
+  CalendarEvent cur;
+  bool     inEvent = false;
+  int      depth = 0;            // nested VALARM etc.: their lines are not the event's
+  uint32_t today = 0;            // yyyymmdd; events starting earlier are never drawn
+  uint32_t uid = 0, rid = 0;     // hashes of UID / RECURRENCE-ID
+  bool     hasUid = false;
+};
 
-    CalendarEvent ev; 
-    ev.title=""; ev.location=""; ev.y=ev.m=ev.d=0; 
-    ev.sh=ev.sm=-1; ev.eh=ev.em=-1; ev.allDay=false;
+static bool eventBefore(const CalendarEvent& a, const CalendarEvent& b){
+  if (a.y != b.y) return a.y < b.y;
+  if (a.m != b.m) return a.m < b.m;
+  if (a.d != b.d) return a.d < b.d;
+  if (a.sh != b.sh) return a.sh < b.sh;
+  return a.sm < b.sm;
+}
 
-    int p=body.indexOf("SUMMARY:");  
-    if(p!=-1){ 
-      int q=body.indexOf("\n",p); 
-      ev.title=body.substring(p+8,q); 
-      ev.title.trim(); 
-      ev.title.replace("\r",""); 
-    }
-    
-    p=body.indexOf("LOCATION:");     
-    if(p!=-1){ 
-      int q=body.indexOf("\n",p); 
-      ev.location=body.substring(p+9,q); 
-      ev.location.trim(); 
-      ev.location.replace("\r",""); 
-    }
-    
-    p=body.indexOf("DTSTART");       
-    if(p!=-1){ 
-      int q=body.indexOf("\n",p); 
-      parseICSDateTime(body.substring(p,q),false,ev); 
-    }
-    
-    p=body.indexOf("DTEND");         
-    if(p!=-1){ 
-      int q=body.indexOf("\n",p); 
-      parseICSDateTime(body.substring(p,q),true,ev); 
-    }
+// What a card shows of the event; a change means its day needs a redraw
+static uint32_t eventSig(const CalendarEvent& ev){
+  uint32_t h = calHash(ev.location.c_str(), calHash(ev.title.c_str()));
+  h = calHashInt(ev.y*10000 + ev.m*100 + ev.d, h);
+  h = calHashInt(((ev.sh*60 + ev.sm)*1440 + ev.eh*60 + ev.em)*2 + ev.allDay, h);
+  h = calHashInt((int32_t)ev.endYmd, h);
+  return h;
+}
 
-    events[eventCount++]=ev;
-    pos=e+10;
-    success = true;
-  }
-  return success;
+// "NAME;PARAM=x:value" -> value, if the line is property `name`
+static const char* icsValue(const char* line, const char* name){
+  size_t n = strlen(name);
+  if (strncmp(line, name, n) || (line[n] != ':' && line[n] != ';')) return nullptr;
+  const char* v = strchr(line + n, ':');
+  return v ? v + 1 : nullptr;
 }
 
-void fetchAndParse(const char* url, const char* filename){
-  if (WiFi.status()!=WL_CONNECTED) return;
-  HTTPClient http; 
-  http.begin(url);
-  http.addHeader("User-Agent","PaperS3-Calendar/1.4");
-  int code=http.GET();
-  if (code==HTTP_CODE_OK){
-    String payload=http.getString();
-    File f=SD.open(filename,FILE_WRITE); 
-    if(f){ f.print(payload); f.close(); }
-    parseAndAddEvents(payload, 160);
-  } else {
-    File f=SD.open(filename,FILE_READ);
-    if(f){ 
-      String payload=f.readString(); 
-      f.close(); 
-      parseAndAddEvents(payload, 160); 
+bool onIcsLine(void* ctx, const char* line, int /*len*/){
+  FeedEvents& fe = *(FeedEvents*)ctx;
+  if (!fe.inEvent){
+    if (strcmp(line, "BEGIN:VEVENT")) return false;
+    CalendarEvent ev;
+    ev.title=""; ev.location=""; ev.y=ev.m=ev.d=0;
+    ev.sh=ev.sm=-1; ev.eh=ev.em=-1; ev.allDay=false;
+    ev.key=ev.seq=ev.mod=ev.sig=0; ev.endYmd=0;
+    fe.cur = ev;
+    fe.inEvent = true;
+    fe.depth = 0;
+    fe.uid = fe.rid = 0; fe.hasUid = false;
+    return false;
+  }
+  if (!strcmp(line, "END:VEVENT")){
+    fe.inEvent = false;
+    CalendarEvent& ev = fe.cur;
+    ev.sig = eventSig(ev);
+    // No UID: same title at the same start is the same event
+    ev.key = fe.hasUid ? calHashInt((int32_t)fe.rid, fe.uid)
+                       : calHashInt(ev.y*10000 + ev.m*100 + ev.d, calHashInt(ev.sh*60 + ev.sm, calHash(ev.title.c_str())));
+    if ((uint32_t)(ev.y*10000 + ev.m*100 + ev.d) >= fe.today){
+      fe.list.push_back(ev);
+      // Only the earliest FEED_MAX_EVENTS can be shown: trim as the list grows
+      if ((int)fe.list.size() >= 2*FEED_MAX_EVENTS){
+        std::sort(fe.list.begin(), fe.list.end(), eventBefore);
+        fe.list.resize(FEED_MAX_EVENTS);
+      }
     }
+    return true;
   }
-  http.end();
+  if (!strncmp(line, "BEGIN:", 6)) { fe.depth++; return false; }
+  if (!strncmp(line, "END:", 4))   { if (fe.depth) fe.depth--; return false; }
+  if (fe.depth) return false;
+
+  const char* v;
+  if ((v = icsValue(line, "SUMMARY")))       { fe.cur.title = v; fe.cur.title.trim(); }
+  else if ((v = icsValue(line, "LOCATION"))) { fe.cur.location = v; fe.cur.location.trim(); }
+  else if (icsValue(line, "DTSTART"))        parseICSDateTime(String(line), false, fe.cur);
+  else if (icsValue(line, "DTEND"))          parseICSDateTime(String(line), true, fe.cur);
+  else if ((v = icsValue(line, "UID")))           { fe.uid = calHash(v); fe.hasUid = true; }
+  else if ((v = icsValue(line, "RECURRENCE-ID"))) fe.rid = calHash(v);
+  else if ((v = icsValue(line, "SEQUENCE")))      fe.cur.seq = strtoul(v, nullptr, 10);
+  else if ((v = icsValue(line, "LAST-MODIFIED"))) fe.cur.mod = calStamp(v);
+  return false;
 }
 
-void fetchCalendar(){
-  eventCount = 0;
-  
-  if (calendarUrl.length() > 0) {
-    fetchAndParse(calendarUrl.c_str(), "/calendar1.ics");
-  }
+void onIcsReset(void* ctx){
+  FeedEvents& fe = *(FeedEvents*)ctx;
+  fe.list.clear();
+  fe.inEvent = false;
+}
 
-  if (calendarUrl2.length() > 0) {
-    fetchAndParse(calendarUrl2.c_str(), "/calendar2.ics");
-  }
+// Visible days touched by a refresh, as a bit per day card
+struct DirtyDays {
+  uint32_t ymd[DAYS_TO_SHOW];
+  uint32_t mask;
+};
 
-  // Sort events
-  for (int i=0;i<eventCount-1;i++)
-    for (int j=0;j<eventCount-i-1;j++){
-      auto&a=events[j]; auto&b=events[j+1];
-      if (a.y!=b.y? a.y>b.y : (a.m!=b.m? a.m>b.m : (a.d!=b.d? a.d>b.d : (a.sh!=b.sh? a.sh>b.sh : a.sm>b.sm)))){
-        auto t=events[j]; events[j]=events[j+1]; events[j+1]=t;
-      }
-    }
+void markDirtyDay(void* ctx, CalChange, uint32_t ymd){
+  DirtyDays& dd = *(DirtyDays*)ctx;
+  for (int i=0;i<DAYS_TO_SHOW;i++) if (dd.ymd[i] == ymd) dd.mask |= 1u << i;
 }
 
-static uint32_t ymd_key(time_t ts) {
-  struct tm lt = *localtime(&ts);
-  return (uint32_t)( (lt.tm_year+1900)*10000 + (lt.tm_mon+1)*100 + lt.tm_mday );
-}
+// Refetch (or reload from SD) every feed; returns the day cards whose
+// events changed since the previous call
+uint32_t fetchCalendar(){
+  static FeedEvents feedEvents[CAL_MAX_FEEDS];
+  static CalFeed    feeds[CAL_MAX_FEEDS];
 
-bool fetchWeather(){
-  if (weatherApiKey.length() == 0) return false;
+  struct tm t{};
+  uint32_t today = readLocal(t) ? (uint32_t)((t.tm_year+1900)*10000 + (t.tm_mon+1)*100 + t.tm_mday) : 0;
+  calTzInit();                     // before the workers share it
+
+  int n = 0;
+  for (int i=0;i<CAL_MAX_FEEDS;i++){
+    if (calendarUrls[i].length() == 0) continue;
+    FeedEvents& fe = feedEvents[n];
+    fe.list.clear(); fe.inEvent = false; fe.today = today;
+    feeds[n].url = calendarUrls[i];
+    snprintf(feeds[n].cache, sizeof(feeds[n].cache), "/calendar%d.ics", i+1);
+    feeds[n].ctx = &fe;
+    n++;
+  }
+  calFetchAll(feeds, n, onIcsLine, onIcsReset, WiFi.status()==WL_CONNECTED);
+
+  // Sort each feed, then merge them in order into events[]
+  PERF_SCOPE("ics merge", PERF_PARSE);
+  for (int k=0;k<n;k++){
+    std::vector<CalendarEvent>& l = feedEvents[k].list;
+    std::stable_sort(l.begin(), l.end(), eventBefore);
+    if ((int)l.size() > FEED_MAX_EVENTS) l.resize(FEED_MAX_EVENTS);
+  }
 
-  // Current conditions
-  {
-    HTTPClient http;
-    String u = "https://api.openweathermap.org/data/2.5/weather?lat=" + LAT
-             + "&lon=" + LON + "&units=imperial&appid=" + weatherApiKey;
-    http.begin(u);
-    int code = http.GET();
-    if (code != HTTP_CODE_OK) { http.end(); return false; }
-    DynamicJsonDocument d1(8*1024);
-    if (deserializeJson(d1, http.getString())) { http.end(); return false; }
-    http.end();
-
-    nowWx.t    = int(d1["main"]["temp"].as<float>() + 0.5f);
-    nowWx.cond = d1["weather"][0]["main"].as<String>();
-  }
-
-  // Forecast
-  {
-    HTTPClient http;
-    String u = "https://api.openweathermap.org/data/2.5/forecast?lat=" + LAT
-             + "&lon=" + LON + "&units=imperial&appid=" + weatherApiKey;
-    http.begin(u);
-    int code = http.GET();
-    if (code != HTTP_CODE_OK) { http.end(); return false; }
-    DynamicJsonDocument d2(64*1024);
-    if (deserializeJson(d2, http.getString())) { http.end(); return false; }
-    http.end();
-
-    for (int i=0;i<7;i++){ 
-      fcast[i].y=fcast[i].m=fcast[i].d=0; 
-      fcast[i].hi=-999; 
-      fcast[i].lo=999; 
-      fcast[i].cond=""; 
+  // One copy per UID across the feeds: the newest revision wins
+  std::vector<CalRef> refs;
+  for (int k=0;k<n;k++)
+    for (size_t i=0;i<feedEvents[k].list.size();i++){
+      const CalendarEvent& ev = feedEvents[k].list[i];
+      refs.push_back({ ev.key, ev.seq, ev.mod, (uint16_t)k, (uint16_t)i, false });
+    }
+  int dups = calDedupe(refs.data(), (int)refs.size());
+  if (dups){
+    std::vector<uint8_t> drop[CAL_MAX_FEEDS];
+    for (int k=0;k<n;k++) drop[k].assign(feedEvents[k].list.size(), 0);
+    for (const CalRef& r : refs) if (r.drop) drop[r.feed][r.idx] = 1;
+    for (int k=0;k<n;k++){
+      std::vector<CalendarEvent>& l = feedEvents[k].list;
+      size_t w = 0;
+      for (size_t i=0;i<l.size();i++) if (!drop[k][i]) { if (w != i) l[w] = l[i]; w++; }
+      l.resize(w);
     }
+  }
 
-    uint32_t keys[7];
-    int slotCount = 0;
-
-    auto findOrAddSlot = [&](uint32_t key, time_t ts)->int {
-      for (int i=0;i<slotCount;i++) if (keys[i]==key) return i;
-      if (slotCount >= 7) return -1;
-      int s = slotCount++;
-      keys[s] = key;
-      struct tm lt = *localtime(&ts);
-      fcast[s].y = lt.tm_year + 1900;
-      fcast[s].m = lt.tm_mon + 1;
-      fcast[s].d = lt.tm_mday;
-      fcast[s].hi = -999;
-      fcast[s].lo = 999;
-      fcast[s].cond = "";
-      return s;
-    };
-
-    JsonArray arr = d2["list"].as<JsonArray>();
-    for (JsonObject item : arr){
-      time_t ts = item["dt"].as<long>();
-      uint32_t key = ymd_key(ts);
-      int s = findOrAddSlot(key, ts);
-      if (s < 0) continue;
-
-      float tmin = item["main"]["temp_min"].as<float>();
-      float tmax = item["main"]["temp_max"].as<float>();
-      if (tmax > fcast[s].hi) fcast[s].hi = int(tmax + 0.5f);
-      if (tmin < fcast[s].lo) fcast[s].lo = int(tmin + 0.5f);
-
-      int hour = localtime(&ts)->tm_hour;
-      String cond = item["weather"][0]["main"].as<String>();
-      if ((hour >= 11 && hour <= 14) || fcast[s].cond == "") fcast[s].cond = cond;
+  size_t pos[CAL_MAX_FEEDS] = {0}, total = 0;
+  for (int k=0;k<n;k++) total += feedEvents[k].list.size();
+  events.clear();
+  events.reserve(std::min(total, (size_t)FEED_MAX_EVENTS));
+  eventCount = 0;
+  while (eventCount < FEED_MAX_EVENTS){
+    int best = -1;
+    for (int k=0;k<n;k++){
+      const std::vector<CalendarEvent>& l = feedEvents[k].list;
+      if (pos[k] < l.size() && (best < 0 || eventBefore(l[pos[k]], feedEvents[best].list[pos[best]]))) best = k;
     }
+    if (best < 0) break;
+    events.push_back(feedEvents[best].list[pos[best]++]);
+    eventCount++;
+  }
+  for (int k=0;k<n;k++) std::vector<CalendarEvent>().swap(feedEvents[k].list);
 
-    struct tm nowLT{}; 
-    getLocalTime(&nowLT);
-    uint32_t todayKey = (nowLT.tm_year+1900)*10000 + (nowLT.tm_mon+1)*100 + nowLT.tm_mday;
+  // Diff against the previous refresh
+  static std::vector<CalSig> prevSigs;
+  std::vector<CalSig> sigs(eventCount);
+  for (int i=0;i<eventCount;i++)
+    sigs[i] = { events[i].key, events[i].sig, (uint32_t)(events[i].y*10000 + events[i].m*100 + events[i].d) };
+  calSortSigs(sigs.data(), eventCount);
 
-    int todaySlot = -1;
-    for (int i=0;i<slotCount;i++){
-      if (keys[i] == todayKey){ todaySlot = i; break; }
-    }
+  DirtyDays dd{};
+  for (int i=0;i<DAYS_TO_SHOW;i++){
+    tm dt=t; dt.tm_mday += i; mktime(&dt);
+    dd.ymd[i] = (uint32_t)((dt.tm_year+1900)*10000 + (dt.tm_mon+1)*100 + dt.tm_mday);
+  }
+  CalDiffCount c = calDiff(prevSigs.data(), (int)prevSigs.size(), sigs.data(), eventCount, markDirtyDay, &dd);
+  prevSigs.swap(sigs);
+  if (c.added || c.changed || c.removed) g_eventsRev++;
+  Serial.printf("calendar: %d events, %d duplicates; +%d ~%d -%d, dirty days 0x%02lx\n",
+                eventCount, dups, c.added, c.changed, c.removed, (unsigned long)dd.mask);
+  return dd.mask;
+}
 
-    if (todaySlot >= 0) {
-      nowWx.hi = (fcast[todaySlot].hi == -999) ? nowWx.t : fcast[todaySlot].hi;
-      nowWx.lo = (fcast[todaySlot].lo ==  999) ? nowWx.t : fcast[todaySlot].lo;
-    } else if (slotCount > 0) {
-      nowWx.hi = (fcast[0].hi == -999) ? nowWx.t : fcast[0].hi;
-      nowWx.lo = (fcast[0].lo ==  999) ? nowWx.t : fcast[0].lo;
-    } else {
-      nowWx.hi = nowWx.t;
-      nowWx.lo = nowWx.t;
+// Current conditions and the daily ribbon, read off the hourly timeline
+void applyWeather(){
+  time_t now = time(nullptr);
+  const WxHour* h = g_wx.at((uint32_t)now);
+  if (!h) return;
+  nowWx.t    = wxDeg(h->temp10);
+  nowWx.cond = wxCondName(h->cond);
+
+  WxDay days[7];
+  int n = wxDays(g_wx, days, 7);
+  for (int i=0;i<7;i++){
+    if (i < n) fcast[i] = { days[i].y, days[i].m, days[i].d, days[i].hi, days[i].lo, wxCondName(days[i].cond) };
+    else       fcast[i] = { 0, 0, 0, 0, 0, "" };
+  }
+  struct tm lt = *localtime(&now);
+  nowWx.hi = nowWx.lo = nowWx.t;
+  for (int i=0;i<n;i++){
+    if (days[i].y == lt.tm_year+1900 && days[i].m == lt.tm_mon+1 && days[i].d == lt.tm_mday){
+      nowWx.hi = days[i].hi; nowWx.lo = days[i].lo;
+      break;
     }
   }
+}
+
+// One /forecast request; "now" is the hour of it we are in. /weather is
+// not asked for any more.
+bool fetchWeather(){
+  if (weatherApiKey.length() == 0) return false;
+  String u = "https://api.openweathermap.org/data/2.5/forecast?lat=" + LAT
+           + "&lon=" + LON + "&units=imperial&appid=" + weatherApiKey;
+  WxTimeline* tl = new WxTimeline;
+  bool ok = wxFetch(u, *tl);
+  if (ok) { g_wx = *tl; g_wx.fetchedAt = (uint32_t)time(nullptr); applyWeather(); }
+  delete tl;
+  return ok;
+}
+
+// ---------- Last known weather ----------
+// The last good timeline is kept on SD, so a cold boot without WiFi still
+// shows weather (badged with its age) instead of an empty block.
+const char* WX_PATH = "/cache/wx.bin";
 
+void saveWeather(){
+  g_rtcState.wxAt = g_wx.fetchedAt;
+  if (!wxSave(WX_PATH, g_wx)) Serial.println("weather: save failed");
+}
+
+bool loadWeather(){
+  if (!wxLoad(WX_PATH, g_wx)) return false;
+  applyWeather();
+  g_rtcState.wxAt = g_wx.fetchedAt;
   return true;
 }
 
@@ -592,6 +710,16 @@ void drawHeader(const tm& t){
   int pct = M5.Power.getBatteryLevel();
   M5.Display.setCursor(x, 86);
   M5.Display.printf("%s  %d%%", charging ? "CHG" : "BATT", pct);
+
+  // Weather older than one missed refresh (e.g. booted offline)
+  uint32_t wxAt = g_rtcState.wxAt;
+  if (wxAt && time(nullptr) > VALID_EPOCH && time(nullptr) - wxAt > (time_t)(WX_PERIOD / 1000) + 300){
+    char since[24];
+    lkStaleLabel(since, sizeof(since), wxAt);
+    M5.Display.setTextSize(2);
+    M5.Display.setCursor(300, 72);
+    M5.Display.printf("weather %s", since);
+  }
 }
 
 void drawForecastRibbon(int x,int y,int w){
@@ -618,6 +746,46 @@ void drawForecastRibbon(int x,int y,int w){
   }
 }
 
+// Next 24 hours: temperature every 3 h, a line for the temperature and
+// bars for the chance of precipitation
+void drawHourlyStrip(int x,int y,int w,int h){
+  const int HOURS = 24, labelH = 18;
+  M5.Display.fillRect(x, y, w, h, BG);
+  int i0 = g_wx.indexAt((uint32_t)time(nullptr));
+  if (i0 < 0) return;
+  int n = std::min(HOURS, (int)g_wx.count - i0);
+  if (n < 2) return;
+  const WxHour* hr = &g_wx.hour[i0];
+
+  int lo = hr[0].temp10, hi = hr[0].temp10;
+  for (int i=1;i<n;i++){ lo = std::min(lo, (int)hr[i].temp10); hi = std::max(hi, (int)hr[i].temp10); }
+  if (hi - lo < 50) { hi += 25; lo -= 25; }        // a flat day stays a flat line
+
+  const float cellW = (float)w / HOURS;
+  const int gy = y + labelH, gh = h - labelH - 2;
+  M5.Display.setTextSize(2);
+  M5.Display.setTextColor(TEXT);
+  int px = 0, py = 0;
+  for (int i=0;i<n;i++){
+    int cx = x + (int)(i * cellW);
+    int bh = hr[i].pop * gh / 100;
+    if (bh) M5.Display.fillRect(cx + 1, gy + gh - bh, std::max(1, (int)cellW - 2), bh, SUBTLE);
+    int tx = cx + (int)(cellW / 2);
+    int ty = gy + gh - 1 - (hr[i].temp10 - lo) * (gh - 2) / (hi - lo);
+    if (i) { M5.Display.drawLine(px, py, tx, ty, TEXT); M5.Display.drawLine(px, py + 1, tx, ty + 1, TEXT); }
+    px = tx; py = ty;
+
+    time_t ts = g_wx.timeOf(i0 + i);
+    struct tm lt = *localtime(&ts);
+    if (lt.tm_hour % 3 == 0 && cx + 6 * 12 <= x + w){
+      M5.Display.setCursor(cx + 2, y);
+      M5.Display.printf("%d%c %d%c", (lt.tm_hour % 12) ? lt.tm_hour % 12 : 12, lt.tm_hour < 12 ? 'a' : 'p',
+                        wxDeg(hr[i].temp10), DEG);
+    }
+  }
+  M5.Display.drawLine(x, y + h - 1, x + w, y + h - 1, LINE);
+}
+
 void drawEventBlock(int x,int y,int w,int bottom,const CalendarEvent& ev,int &nextY) {
   int cy = y;
 
@@ -635,16 +803,14 @@ void drawEventBlock(int x,int y,int w,int bottom,const CalendarEvent& ev,int &ne
   int textX = x + 10;
   int textW = w - 20;
 
-  M5.Display.setTextSize(2);
-  int lhTitle = M5.Display.fontHeight();
-  int titleW  = M5.Display.textWidth(ev.title.c_str());
+  int lhTitle = uiLineH(M5.Display, 2);
+  int titleW  = uiTextWidth(M5.Display, ev.title, 2);
   if (titleW > textW && (cy + lhTitle + 2) <= bottom) {
     addMarquee(textX, cy, textW, lhTitle + 2, ev.title, 2);
     cy += lhTitle + 6;
   } else {
     if (cy + lhTitle <= bottom) {
-      M5.Display.setCursor(textX, cy);
-      M5.Display.print(ev.title);
+      uiText(M5.Display, textX, cy, ev.title, 2, TEXT);
       cy += lhTitle + 4;
     }
   }
@@ -700,17 +866,8 @@ void drawDayCard(int x,int y,int w,int h,const DayView& dv,bool isToday){
   }
 }
 
-void drawAll(){
-  M5.Display.fillScreen(BG);
-  clearMarquees();
-
-  struct tm t{}; 
-  if(!readLocal(t)) return;
-
-  drawHeader(t);
-  drawForecastRibbon(10, HEADER_H+4, SCREEN_W-20);
-
-  DayView days[DAYS_TO_SHOW];
+// Day i (0 = today) and the events on it
+void buildDays(const tm& t, DayView* days){
   for (int i=0;i<DAYS_TO_SHOW;i++){
     tm dt=t; 
     dt.tm_mday += i; 
@@ -723,14 +880,464 @@ void drawAll(){
       if (events[j].y==days[i].y && events[j].m==days[i].m && events[j].d==days[i].d)
         days[i].idx.push_back(j);
   }
+}
 
-  int top = TOP_AREA_H;
-  int h   = SCREEN_H - top - 10;
+void dayCardRect(int i, int& x, int& y, int& w, int& h){
   int colW = (SCREEN_W - 20 - (DAYS_TO_SHOW-1)*8) / DAYS_TO_SHOW;
+  x = 10 + i*(colW + 8);
+  y = TOP_AREA_H;
+  w = colW;
+  h = SCREEN_H - TOP_AREA_H - 10;
+}
+
+// ---------- Agenda view ----------
+// Tap a day card for every event from today on as one list, opened at that
+// day. Drag to scroll; tap the header to go back to the cards.
+struct AgendaRow { int16_t ev; int16_t y; int8_t m, d, wday; };   // ev < 0: day heading
+std::vector<AgendaRow> g_agendaRows;
+AgendaView g_agenda;
+bool g_agendaOpen = false;
+uint32_t g_agendaRev = 0;      // g_eventsRev it was laid out for
+
+const int AGENDA_HEAD_H = 44;
+const int AGENDA_TIME_W = 170;
+const int AGENDA_PAD    = 10;
+const unsigned long AGENDA_STEP_MS = 150;   // batch drag movement into one fast update
+
+int agendaTextW(){ return g_agenda.w - AGENDA_TIME_W - 2*AGENDA_PAD; }
+
+int agendaRowH(int i){
+  const AgendaRow& r = g_agendaRows[i];
+  if (r.ev < 0) return AGENDA_HEAD_H;
+  const CalendarEvent& ev = events[r.ev];
+  LovyanGFX& g = *g_agenda.canvas;
+  int cy = wrapText(g, 0, 0, agendaTextW(), INT16_MAX, ev.title, 2, false);
+  if (ev.location.length()) cy = wrapText(g, 0, cy, agendaTextW(), INT16_MAX, ev.location, 1, false);
+  return std::max(cy, 36) + 2*AGENDA_PAD;      // at least the two time lines
+}
+
+void drawAgendaRow(LovyanGFX& g, int i, int y, int w){
+  static const char* DOW[]={"SUN","MON","TUE","WED","THU","FRI","SAT"};
+  const AgendaRow& r = g_agendaRows[i];
+  int h = g_agenda.layout.rowH(i);
+  g.setTextColor(TEXT);
+  if (r.ev < 0){
+    g.fillRect(0, y + 4, w, h - 8, SUBTLE);
+    g.setTextSize(2);
+    g.setCursor(AGENDA_PAD, y + 14);
+    g.printf("%s %d/%d", DOW[r.wday], r.m, r.d);
+    return;
+  }
+  const CalendarEvent& ev = events[r.ev];
+  g.setTextSize(2);
+  g.setCursor(AGENDA_PAD, y + AGENDA_PAD);
+  g.print(ev.allDay ? String("All-day") : time12(ev.sh, ev.sm));
+  if (!ev.allDay && ev.eh >= 0){
+    g.setCursor(AGENDA_PAD, y + AGENDA_PAD + 20);
+    g.print(time12(ev.eh, ev.em));
+  }
+  int tx = AGENDA_TIME_W + AGENDA_PAD;
+  int cy = wrapText(g, tx, y + AGENDA_PAD, agendaTextW(), y + h, ev.title, 2, true);
+  if (ev.location.length()) wrapText(g, tx, cy, agendaTextW(), y + h, ev.location, 1, true);
+  g.drawLine(AGENDA_PAD, y + h - 1, w - AGENDA_PAD, y + h - 1, LINE);
+}
+
+// Rows from events[] (already sorted), measured once per refresh
+void agendaLayout(){
+  PERF_SCOPE("agenda layout", PERF_RENDER);
+  g_agendaRows.clear();
+  for (int j=0;j<eventCount;j++){
+    const CalendarEvent& ev = events[j];
+    if (g_agendaRows.empty() || g_agendaRows.back().y != ev.y || g_agendaRows.back().m != ev.m || g_agendaRows.back().d != ev.d){
+      tm dt{}; dt.tm_year = ev.y - 1900; dt.tm_mon = ev.m - 1; dt.tm_mday = ev.d; dt.tm_hour = 12;
+      mktime(&dt);
+      g_agendaRows.push_back({ -1, (int16_t)ev.y, (int8_t)ev.m, (int8_t)ev.d, (int8_t)dt.tm_wday });
+    }
+    g_agendaRows.push_back({ (int16_t)j, (int16_t)ev.y, (int8_t)ev.m, (int8_t)ev.d, 0 });
+  }
+  g_agenda.layout.build((int)g_agendaRows.size(), agendaRowH);
+  g_agendaRev = g_eventsRev;
+}
+
+// First row on or after the day
+int agendaRowOfDay(int y, int m, int d){
+  uint32_t key = (uint32_t)(y*10000 + m*100 + d);
+  auto it = std::lower_bound(g_agendaRows.begin(), g_agendaRows.end(), key,
+    [](const AgendaRow& r, uint32_t k){ return (uint32_t)(r.y*10000 + r.m*100 + r.d) < k; });
+  return (int)(it - g_agendaRows.begin());
+}
+
+void openAgenda(const DayView& day){
+  if (!g_agenda.begin(0, HEADER_H, SCREEN_W, SCREEN_H - HEADER_H, BG, drawAgendaRow)) return;
+  agendaLayout();
+  int row = agendaRowOfDay(day.y, day.m, day.d);
+  g_agenda.scroll = row < g_agenda.layout.count() ? g_agenda.layout.rowTop(row) : g_agenda.layout.total();
+  g_agendaOpen = true;
+  drawAll();
+}
+
+void closeAgenda(){
+  g_agendaOpen = false;
+  drawAll();
+}
+
+void agendaTouch(const TouchEvent& e){
+  static int32_t pending = 0;
+  static uint32_t lastMs = 0;
+  if (touchIsTap(e) && e.y < HEADER_H) { pending = 0; closeAgenda(); return; }
+  if (e.type == TOUCH_DRAG) pending -= e.dy;
+  if (pending && (e.ms - lastMs >= AGENDA_STEP_MS || e.type == TOUCH_UP)){
+    g_agenda.scrollBy(pending);
+    pending = 0;
+    lastMs = e.ms;
+  }
+}
+
+// ---------- Week view ----------
+// Tap the forecast ribbon to switch between the day cards and an hour grid
+// of the next seven days. Overlapping events sit side by side (WeekGrid.h).
+// Events past midnight continue on the next day's column; all-day and
+// day-long events span their days in a band above the grid. The layout is
+// cached until events[] or the date changes. Tap a day for its agenda.
+const int WEEK_DAYS    = 7;
+const int WEEK_FIRST_H = 7, WEEK_LAST_H = 22;   // hours on the grid; earlier / later events are clamped
+const int WEEK_AXIS_W  = 44;
+const int WEEK_HEAD_H  = 28;
+const int WEEK_BAND_H  = 40;                    // all-day band: two rows of spans
+const int WEEK_BAND_ROWS = 2;
+const int WEEK_MIN_MIN = 20;                    // shortest block drawn, in minutes
+
+struct WeekDay {
+  int y, m, d, wday;
+  std::vector<GridItem> timed;
+  uint8_t bandMore;                             // spans the last band row's "+ N more" stands for
+};
+WeekDay  g_week[WEEK_DAYS];
+std::vector<GridItem> g_weekBand;               // start/end are columns, col is the row
+uint32_t g_weekRev = 0, g_weekYmd = 0;
+bool     g_weekView = false;
+
+void weekLayout(const tm& t){
+  uint32_t ymd = (uint32_t)((t.tm_year+1900)*10000 + (t.tm_mon+1)*100 + t.tm_mday);
+  if (g_weekRev == g_eventsRev && g_weekYmd == ymd) return;
+  PERF_SCOPE("week layout", PERF_RENDER);
+  std::vector<GridItem> timed[WEEK_DAYS];
+  for (int i=0;i<WEEK_DAYS;i++){
+    tm dt=t; dt.tm_mday += i; mktime(&dt);
+    WeekDay& wd = g_week[i];
+    wd.y = dt.tm_year+1900; wd.m = dt.tm_mon+1; wd.d = dt.tm_mday; wd.wday = dt.tm_wday;
+  }
+  g_weekBand.clear();
+  const int32_t day0 = wcDays(g_week[0].y, g_week[0].m, g_week[0].d);
+  const WeekHours hrs = { (int16_t)(WEEK_FIRST_H*60), (int16_t)(WEEK_LAST_H*60), (int16_t)WEEK_MIN_MIN };
+  for (int j=0;j<eventCount;j++){
+    const CalendarEvent& ev = events[j];
+    WeekSpan sp;
+    sp.startDay = wcDays(ev.y, ev.m, ev.d);
+    sp.allDay = ev.allDay || ev.sh < 0;
+    sp.idx = (uint16_t)j;
+    sp.startMin = (int16_t)(sp.allDay ? 0 : ev.sh*60 + ev.sm);
+    if (sp.allDay){
+      // DTEND is the day after the last; none = one day
+      sp.endDay = ev.endYmd ? wcDays(ev.endYmd/10000, ev.endYmd/100%100, ev.endYmd%100) - 1 : sp.startDay;
+      sp.endMin = 0;
+    } else if (ev.endYmd){
+      sp.endDay = wcDays(ev.endYmd/10000, ev.endYmd/100%100, ev.endYmd%100);
+      sp.endMin = (int16_t)(ev.eh >= 0 ? ev.eh*60 + ev.em : 0);
+    } else {
+      sp.endDay = sp.startDay;                   // no DTEND: an hour
+      sp.endMin = (int16_t)(ev.eh >= 0 ? ev.eh*60 + ev.em : sp.startMin + 60);
+    }
+    weekPlace(sp, day0, WEEK_DAYS, hrs, g_weekBand, timed);
+  }
+  for (int i=0;i<WEEK_DAYS;i++){
+    gridLayout(timed[i].data(), (int)timed[i].size());
+    g_week[i].timed = std::move(timed[i]);
+  }
+  gridLayout(g_weekBand.data(), (int)g_weekBand.size());
+  uint8_t more[WEEK_DAYS];
+  weekBandMore(g_weekBand.data(), (int)g_weekBand.size(), WEEK_BAND_ROWS, more, WEEK_DAYS);
+  for (int i=0;i<WEEK_DAYS;i++) g_week[i].bandMore = more[i];
+  g_weekRev = g_eventsRev;
+  g_weekYmd = ymd;
+}
+
+void weekColumnRect(int i, int& x, int& w){
+  w = (SCREEN_W - 20 - WEEK_AXIS_W) / WEEK_DAYS;
+  x = 10 + WEEK_AXIS_W + i*w;
+}
+
+void drawWeekGrid(const tm& t){
+  static const char* DOW[]={"SUN","MON","TUE","WED","THU","FRI","SAT"};
+  weekLayout(t);
+  PERF_SCOPE("week grid", PERF_RENDER);
+  const int top = TOP_AREA_H, bottom = SCREEN_H - 10;
+  const int gridTop = top + WEEK_HEAD_H + WEEK_BAND_H;
+  const int first = WEEK_FIRST_H*60;
+  const float pxPerMin = (bottom - gridTop) / float((WEEK_LAST_H - WEEK_FIRST_H)*60);
+  int x0, colW;
+  weekColumnRect(0, x0, colW);
+  const int right = x0 + WEEK_DAYS*colW;
+
+  M5.Display.setTextColor(TEXT);
+  M5.Display.setTextSize(1);
+  for (int h=WEEK_FIRST_H; h<=WEEK_LAST_H; h++){
+    int y = gridTop + (int)((h*60 - first) * pxPerMin);
+    M5.Display.drawFastHLine(x0, y, right - x0, LINE);
+    M5.Display.setCursor(10, y - 3);
+    M5.Display.printf("%d%s", h % 12 ? h % 12 : 12, h < 12 ? "a" : "p");
+  }
+
+  for (int i=0;i<WEEK_DAYS;i++){
+    const WeekDay& wd = g_week[i];
+    int x, w;
+    weekColumnRect(i, x, w);
+    if (i == 0) M5.Display.fillRect(x, top, w, WEEK_HEAD_H, TODAY_BG);
+    M5.Display.drawFastVLine(x, top, bottom - top, DARKLINE);
+    M5.Display.setTextSize(2);
+    M5.Display.setCursor(x + 6, top + 6);
+    M5.Display.printf("%s %d", DOW[wd.wday], wd.d);
+
+    M5.Display.setTextSize(1);
+    if (wd.bandMore){
+      M5.Display.setCursor(x + 6, top + WEEK_HEAD_H + 2 + (WEEK_BAND_ROWS-1)*18 + 5);
+      M5.Display.printf("+ %d more", wd.bandMore);
+    }
+
+    // Timed blocks, side by side where they overlap; a block carried over
+    // from the day before shows when it ends
+    uint32_t ymd = (uint32_t)(wd.y*10000 + wd.m*100 + wd.d);
+    for (const GridItem& it : wd.timed){
+      const CalendarEvent& ev = events[it.idx];
+      int y0 = gridTop + (int)((it.start - first) * pxPerMin);
+      int y1 = gridTop + (int)((it.end - first) * pxPerMin);
+      int slotW = (w - 4) / it.cols;
+      int bx = x + 2 + it.col * slotW;
+      int bw = slotW - 2;
+      M5.Display.fillRect(bx, y0 + 1, bw, y1 - y0 - 2, SUBTLE);
+      M5.Display.drawRect(bx, y0 + 1, bw, y1 - y0 - 2, DARKLINE);
+      M5.Display.setClipRect(bx + 1, y0 + 2, bw - 2, y1 - y0 - 4);
+      M5.Display.setCursor(bx + 3, y0 + 4);
+      if ((uint32_t)(ev.y*10000 + ev.m*100 + ev.d) == ymd) M5.Display.print(time12(ev.sh, ev.sm));
+      else if (ev.eh >= 0) M5.Display.printf("to %s", time12(ev.eh, ev.em).c_str());
+      wrapText(M5.Display, bx + 3, y0 + 14, bw - 6, y1 - 2, ev.title, 1, true);
+      M5.Display.clearClipRect();
+    }
+  }
+
+  // Band: each span across the columns it covers. The last row gives way
+  // to "+ N more" in columns that have more spans than rows.
+  for (const GridItem& sp : g_weekBand){
+    if (sp.col >= WEEK_BAND_ROWS) continue;
+    int by = top + WEEK_HEAD_H + 2 + sp.col*18;
+    bool lastRow = sp.col == WEEK_BAND_ROWS - 1;
+    for (int i = sp.start; i < sp.end; ){
+      if (lastRow && g_week[i].bandMore) { i++; continue; }
+      int j = i;
+      while (j < sp.end && !(lastRow && g_week[j].bandMore)) j++;
+      int xa, wa, xb, wb;
+      weekColumnRect(i, xa, wa);
+      weekColumnRect(j - 1, xb, wb);
+      M5.Display.fillRoundRect(xa + 3, by, xb + wb - xa - 6, 16, 4, BADGE_FILL);
+      M5.Display.setClipRect(xa + 3, by, xb + wb - xa - 6, 16);
+      uiText(M5.Display, xa + 6, by + 4, events[sp.idx].title, 1, TEXT);
+      M5.Display.clearClipRect();
+      i = j;
+    }
+  }
+  M5.Display.drawFastVLine(right, top, bottom - top, DARKLINE);
+  M5.Display.drawFastHLine(x0, top + WEEK_HEAD_H, right - x0, DARKLINE);
+  M5.Display.drawFastHLine(x0, gridTop, right - x0, DARKLINE);
+}
+
+// Tap on the forecast ribbon: cards <-> week grid. Tap on a day (card or
+// week column): open the agenda at that day
+void viewTap(const TouchEvent& e, const tm& t){
+  if (!touchIsTap(e) || e.y < HEADER_H) return;
+  if (e.y < TOP_AREA_H) { g_weekView = !g_weekView; drawAll(); return; }
+  if (g_weekView){
+    weekLayout(t);
+    for (int i=0;i<WEEK_DAYS;i++){
+      int x, w;
+      weekColumnRect(i, x, w);
+      if (e.x < x || e.x >= x + w) continue;
+      DayView dv;
+      dv.y = g_week[i].y; dv.m = g_week[i].m; dv.d = g_week[i].d; dv.wday = g_week[i].wday;
+      openAgenda(dv);
+      return;
+    }
+    return;
+  }
+  DayView days[DAYS_TO_SHOW];
+  buildDays(t, days);
+  for (int i=0;i<DAYS_TO_SHOW;i++){
+    int x, y, w, h;
+    dayCardRect(i, x, y, w, h);
+    if (e.x >= x && e.x < x + w) { openAgenda(days[i]); return; }
+  }
+}
+
+// Everything but the hourly strip and forecast ribbon (drawCharts());
+// false when those are not on screen either
+bool drawFrame(){
+  M5.Display.fillScreen(BG);
+  clearMarquees();
+
+  struct tm t{}; 
+  if(!readLocal(t)) return false;
+
+  drawHeader(t);
+  if (g_agendaOpen){
+    if (g_agendaRev != g_eventsRev) agendaLayout();
+    g_agenda.paint();
+    return false;
+  }
+  if (g_weekView) { drawWeekGrid(t); return true; }
+
+  DayView days[DAYS_TO_SHOW];
+  buildDays(t, days);
+  for (int i=0;i<DAYS_TO_SHOW;i++){
+    int x, y, w, h;
+    dayCardRect(i, x, y, w, h);
+    drawDayCard(x, y, w, h, days[i], i==0);
+  }
+  return true;
+}
+
+// The shaded parts that are a chart: the only content drawn in the grays
+void drawCharts(){
+  drawHourlyStrip(10, HEADER_H+4, SCREEN_W-20, HOURLY_H);
+  drawForecastRibbon(10, HEADER_H+4+HOURLY_H, SCREEN_W-20);
+}
+
+// Hour rollover: "now" moves one slot along the timeline. Only the strip
+// is redrawn here; the header picks the new reading up on its next minute.
+void drawHourly(){
+  applyWeather();
+  if (g_agendaOpen) return;
+  auto prevMode = grayUse(GC_CHART);
+  PERF_SCOPE("hourly strip", PERF_RENDER);
+  M5.Display.startWrite();
+  drawHourlyStrip(10, HEADER_H+4, SCREEN_W-20, HOURLY_H);
+  M5.Display.endWrite();
+  M5.Display.setEpdMode(prevMode);
+}
+
+// Redraw only the day cards in `mask` (bit i = day i), each flushed on its own
+void drawDayCards(uint32_t mask){
+  if (g_agendaOpen){
+    if (g_agendaRev != g_eventsRev) { agendaLayout(); g_agenda.redraw(); }
+    return;
+  }
+  if (g_weekView){
+    if (g_weekRev != g_eventsRev) drawAll();    // the grid spans a week, not the 5 cards
+    return;
+  }
+  struct tm t{};
+  if (!mask || !readLocal(t)) return;
+  DayView days[DAYS_TO_SHOW];
+  buildDays(t, days);
+  auto prevMode = grayUse(GC_TEXT);
+  PERF_SCOPE("day cards", PERF_RENDER);
   for (int i=0;i<DAYS_TO_SHOW;i++){
-    int x = 10 + i*(colW + 8);
-    drawDayCard(x, top, colW, h, days[i], i==0);
+    if (!(mask & (1u << i))) continue;
+    int x, y, w, h;
+    dayCardRect(i, x, y, w, h);
+    clearMarqueesIn(x, y, w, h);
+    M5.Display.startWrite();
+    drawDayCard(x, y, w, h, days[i], i==0);
+    M5.Display.endWrite();
+  }
+  M5.Display.setEpdMode(prevMode);
+}
+
+// Full redraw in two batches: text and cards in the fast black/white
+// waveform, then the strip and ribbon on their own in quality
+void drawAll(){
+  auto prevMode = grayUse(GC_TEXT);
+  bool charts;
+  M5.Display.startWrite();
+  { PERF_SCOPE("drawAll", PERF_RENDER); charts = drawFrame(); }
+  { PERF_SCOPE("panel flush", PERF_FLUSH); M5.Display.endWrite(); }
+  if (charts){
+    grayUse(GC_CHART);
+    M5.Display.startWrite();
+    { PERF_SCOPE("charts", PERF_RENDER); drawCharts(); }
+    { PERF_SCOPE("panel flush", PERF_FLUSH); M5.Display.endWrite(); }
+  }
+  M5.Display.setEpdMode(prevMode);
+  uiFontsReport();
+}
+
+// ---------- Saved frame ----------
+// The default view, saved to SD when its body changes so a wake or reset
+// can restore it instead of rendering (FrameStore.h). Header: clock,
+// weather, battery. Strip: the next 24 hours. Body: forecast ribbon and
+// day cards.
+const char* FRAME_PATH = "/cache/frame.bin";
+enum { FRAME_HEADER, FRAME_STRIP, FRAME_BODY, FRAME_N };
+uint32_t g_frameBody = 0;      // body hash of the copy on SD, 0 = none
+
+void frameRegions(const tm& t, FrameRegion* r){
+  uint32_t h = calHashInt((t.tm_year*400 + t.tm_yday)*1440 + t.tm_hour*60 + t.tm_min, 2166136261u);
+  h = calHashInt(((nowWx.t*256 + nowWx.lo)*256 + nowWx.hi), calHash(nowWx.cond.c_str(), h));
+  h = calHashInt(M5.Power.getBatteryLevel()*2 + M5.Power.isCharging(), h);
+  uint32_t wxAt = g_rtcState.wxAt;
+  h = calHashInt(wxAt && time(nullptr) - wxAt > (time_t)(WX_PERIOD / 1000) + 300 ? (int32_t)wxAt : 0, h);
+  r[FRAME_HEADER] = { 0, 0, SCREEN_W, HEADER_H + 1, h };
+
+  int i0 = g_wx.indexAt((uint32_t)time(nullptr));
+  uint32_t s = calHashInt(i0 < 0 ? -1 : (int32_t)g_wx.timeOf(i0), 2166136261u);
+  if (i0 >= 0) s = frameFnv((const uint8_t*)&g_wx.hour[i0], sizeof(WxHour) * std::min(24, g_wx.count - i0), s);
+  r[FRAME_STRIP] = { 0, HEADER_H + 1, SCREEN_W, HOURLY_H + 3, s };
+
+  uint32_t b = calHashInt((t.tm_year + 1900)*10000 + (t.tm_mon + 1)*100 + t.tm_mday, 2166136261u);
+  for (const ForecastDay& f : fcast)
+    b = calHashInt((f.y*10000 + f.m*100 + f.d)*7 + f.hi*256 + f.lo, calHash(f.cond.c_str(), b));
+  for (int i=0;i<eventCount;i++) b = calHashInt((int32_t)events[i].sig, b);
+  r[FRAME_BODY] = { 0, HEADER_H + HOURLY_H + 4, SCREEN_W, SCREEN_H - HEADER_H - HOURLY_H - 4, b ? b : 1 };
+}
+
+// Restore the saved frame and draw only the regions that moved. Returns
+// false when nothing usable was saved (the caller draws the whole frame).
+// Marquees come back with the next full frame.
+bool restoreFrame(const tm& t){
+  FrameRegion r[FRAME_N];
+  frameRegions(t, r);
+  uint32_t stale = frameRestore(FRAME_PATH, r, FRAME_N);
+  if (stale & (1u << FRAME_BODY)) return false;
+  g_frameBody = r[FRAME_BODY].hash;
+  auto prevMode = grayUse(GC_TEXT);
+  if (stale & (1u << FRAME_HEADER)){
+    M5.Display.startWrite();
+    drawHeader(t);
+    { PERF_SCOPE("panel flush", PERF_FLUSH); M5.Display.endWrite(); }
+  }
+  if (stale & (1u << FRAME_STRIP)){
+    grayUse(GC_CHART);
+    M5.Display.startWrite();
+    drawHourlyStrip(10, HEADER_H+4, SCREEN_W-20, HOURLY_H);
+    { PERF_SCOPE("panel flush", PERF_FLUSH); M5.Display.endWrite(); }
+  }
+  M5.Display.setEpdMode(prevMode);
+  lastMinute = t.tm_min;
+  lastHour = t.tm_hour;
+  return true;
+}
+
+// Before sleep: keep SD in step with the body on the panel. Only the
+// default view is saved; with the agenda or week open the copy is dropped.
+void saveFrame(){
+  struct tm t{};
+  if (!readLocal(t)) return;
+  if (g_agendaOpen || g_weekView){
+    if (g_frameBody){ frameForget(FRAME_PATH); g_frameBody = 0; }
+    return;
   }
+  FrameRegion r[FRAME_N];
+  frameRegions(t, r);
+  if (r[FRAME_BODY].hash == g_frameBody) return;
+  if (frameSave(FRAME_PATH, r, FRAME_N)) g_frameBody = r[FRAME_BODY].hash;
 }
 
 // ---------- SD Card Secrets Loader ----------
@@ -749,11 +1356,13 @@ bool loadSecretsFromSD(const char* path="/secrets.txt"){
   password = "";
   backup_ssid = "";
   backup_password = "";
-  calendarUrl = "";
-  calendarUrl2 = "";
+  for (int i=0;i<CAL_MAX_FEEDS;i++) calendarUrls[i] = "";
   weatherApiKey = "";
   LAT = "25.7617";  // Keep default location
   LON = "-80.1918";
+  g_rtcState.sleepEnabled = false;   // opt in with SLEEP=on
+  g_rtcState.deepFrom = g_rtcState.deepTo = 0;
+  cfgAuth("");
 
   if (!SD.exists(path)) {
     Serial.println("WARNING: secrets.txt not found on SD card!");
@@ -804,20 +1413,22 @@ bool loadSecretsFromSD(const char* path="/secrets.txt"){
       backup_password = val;
       Serial.println("  BACKUP_PASSWORD: [set]");
     }
-    // Calendar URLs - support multiple formats
-    else if (key == "CAL_URL1" || key == "CALENDARURL" || key == "CALENDAR_URL" || key == "CAL1") {
-      calendarUrl = val;
-      Serial.println("  CAL_URL1: [set]");
-    }
-    else if (key == "CAL_URL2" || key == "CALENDARURL2" || key == "CALENDAR_URL2" || key == "CAL2") {
-      calendarUrl2 = val;
-      Serial.println("  CAL_URL2: [set]");
+    // Calendar URLs - CAL_URL1..8, CALENDAR_URLn, CALn
+    else if (calFeedSlot(key.c_str()) >= 0) {
+      int slot = calFeedSlot(key.c_str());
+      calendarUrls[slot] = val;
+      Serial.printf("  CAL_URL%d: [set]\n", slot+1);
     }
     // Weather API - support multiple formats
     else if (key == "WEATHER_API_KEY" || key == "WEATHERAPIKEY" || key == "API_KEY" || key == "OWM_KEY") {
       weatherApiKey = val;
       Serial.println("  WEATHER_API_KEY: [set]");
     }
+    // Config page login
+    else if (key == "CFG_PASS") {
+      cfgAuth(val);
+      Serial.println("  CFG_PASS: [set]");
+    }
     // Location
     else if (key == "LAT") {
       LAT = val;
@@ -827,6 +1438,20 @@ bool loadSecretsFromSD(const char* path="/secrets.txt"){
       LON = val;
       Serial.println("  LON: " + LON);
     }
+    // Power
+    else if (key == "SLEEP") {
+      val.toLowerCase();
+      g_rtcState.sleepEnabled = val == "on" || val == "1" || val == "yes";
+      Serial.println(String("  SLEEP: ") + (g_rtcState.sleepEnabled ? "on" : "off"));
+    }
+    else if (key == "DEEP_SLEEP_HOURS") {   // e.g. 23-6
+      int dash = val.indexOf('-');
+      if (dash > 0) {
+        g_rtcState.deepFrom = val.substring(0, dash).toInt() % 24;
+        g_rtcState.deepTo   = val.substring(dash + 1).toInt() % 24;
+        Serial.println("  DEEP_SLEEP_HOURS: " + val);
+      }
+    }
   }
   f.close();
 
@@ -834,59 +1459,144 @@ bool loadSecretsFromSD(const char* path="/secrets.txt"){
 }
 
 // ---------- WiFi Connection ----------
-bool connectWiFiWithFallback(unsigned long timeoutMs = 20000){
-  // Try primary WiFi
-  if (ssid.length() > 0 && password.length() > 0){
-    Serial.print("Connecting to primary WiFi: ");
-    Serial.println(ssid);
-    WiFi.begin(ssid.c_str(), password.c_str());
-    
-    unsigned long start = millis();
-    while (millis() - start < timeoutMs){
-      if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("Connected to primary WiFi!");
-        Serial.print("IP: ");
-        Serial.println(WiFi.localIP());
-        return true;
-      }
-      delay(250);
-    }
-    Serial.println("Primary WiFi connection failed");
-  } else {
-    Serial.println("No primary WiFi credentials provided");
-  }
-
-  // Try backup WiFi if defined
-  if (backup_ssid.length() > 0 && backup_password.length() > 0){
-    Serial.print("Connecting to backup WiFi: ");
-    Serial.println(backup_ssid);
-    WiFi.begin(backup_ssid.c_str(), backup_password.c_str());
-    
-    unsigned long start = millis();
-    while (millis() - start < timeoutMs){
-      if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("Connected to backup WiFi!");
-        Serial.print("IP: ");
-        Serial.println(WiFi.localIP());
-        return true;
-      }
-      delay(250);
-    }
-    Serial.println("Backup WiFi connection failed");
+std::vector<WiFiCred> wifiCredsFromSecrets(){
+  std::vector<WiFiCred> list;
+  if (ssid.length() > 0)        list.push_back({ ssid, password });
+  if (backup_ssid.length() > 0) list.push_back({ backup_ssid, backup_password });
+  return list;
+}
+
+// ---------- Setup / Loop ----------
+// Boot is staged so the slow parts overlap: the WiFi join runs in the WiFi
+// task while we parse the cached calendars from SD and draw the first frame.
+// Weather, fresh calendars and the RTC sync happen from loop() once the
+// link comes up.
+bool g_onlineOnce = false;
+bool g_rtcSynced  = false;
+
+bool timeValid(){ return time(nullptr) > VALID_EPOCH; }
+
+bool weatherDue(){
+  if (timeValid() && g_rtcState.lastWxEpoch > VALID_EPOCH)
+    return time(nullptr) - g_rtcState.lastWxEpoch >= (time_t)(WX_PERIOD / 1000);
+  return millis() - lastWxMS > WX_PERIOD;
+}
+
+void rememberWeather(){
+  lastWxMS = millis();
+  if (timeValid()) g_rtcState.lastWxEpoch = time(nullptr);
+  g_rtcState.wxT = nowWx.t; g_rtcState.wxLo = nowWx.lo; g_rtcState.wxHi = nowWx.hi;
+  strncpy(g_rtcState.wxCond, nowWx.cond.c_str(), sizeof(g_rtcState.wxCond) - 1);
+}
+
+void requestFetch(bool weather, bool calendar){
+  if (!g_wxPending && !g_calPending) g_pendingSinceMs = millis();
+  g_wxPending  |= weather;
+  g_calPending |= calendar;
+}
+
+// Runs the queued weather/calendar refresh once the link is up. Wakes the
+// radio if sleep turned it off; gives up after NET_WAIT_MAX_MS offline.
+void serviceFetches(){
+  if (!g_wxPending && !g_calPending) return;
+  if (!net_isUp()){
+    net_resume();
+    if (millis() - g_pendingSinceMs < NET_WAIT_MAX_MS) return;
+    Serial.println("Offline - keeping cached weather/calendar");
+    if (g_wxPending) rememberWeather();   // don't retry every loop
+    g_wxPending = g_calPending = false;
+    return;
+  }
+  if (g_wxPending){
+    Serial.println("Fetching weather...");
+    if (fetchWeather()) saveWeather();
+    rememberWeather();
   }
+  bool full = g_wxPending || !g_onlineOnce;
+  uint32_t dirty = 0;
+  if (g_calPending){
+    Serial.println("Fetching calendar...");
+    dirty = fetchCalendar();
+  }
+  g_wxPending = g_calPending = false;
+  // A calendar-only refresh repaints just the days it changed
+  if (full) drawAll();
+  else      drawDayCards(dirty);
+  if (!g_onlineOnce){ bootMark("online frame"); bootSummary(); g_onlineOnce = true; }
+}
 
-  Serial.println("WiFi connection failed - no valid credentials or connection");
-  return false;
+// Sleep until the next header/weather/midnight deadline once nothing is
+// pending and the panel has not been touched for a while.
+void maybeSleep(){
+  if (!g_rtcState.sleepEnabled || !timeValid()) return;
+  if (g_wxPending || g_calPending) return;
+  if (g_marqueeTouchActive || millis() - g_lastTouchMs < IDLE_BEFORE_SLEEP_MS) return;
+
+  time_t now = time(nullptr);
+  WakePlan plan = planNextWake(now, g_rtcState.lastWxEpoch, WX_PERIOD / 1000);
+  struct tm lt; localtime_r(&now, &lt);
+  SleepKind kind = hourInWindow(lt.tm_hour, g_rtcState.deepFrom, g_rtcState.deepTo)
+                   ? SLEEP_DEEP : SLEEP_LIGHT;
+
+  g_rtcState.magic = RTC_STATE_MAGIC;
+  g_rtcState.y = lastY; g_rtcState.m = lastM; g_rtcState.d = lastD;
+
+  awakeAccount(now, millis() - g_awakeSinceMs);
+  M5.Display.waitDisplay();          // let the EPD finish before the rails drop
+  saveFrame();
+  net_suspend();
+  sleepUntil(plan.at, kind);
+
+  // Light sleep returns here with RAM intact; loop() redraws what is due
+  g_awakeSinceMs = millis();
+  if (wokeByTouch()) g_lastTouchMs = millis();
+}
+
+// Deep-sleep timer wake in the quiet hours with only the clock due: redraw
+// the header from RTC state and go straight back to sleep.
+bool headerOnlyWake(){
+  if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) return false;
+  if (g_rtcState.magic != RTC_STATE_MAGIC || !timeValid()) return false;
+
+  setenv("TZ", TZ_INFO, 1);   // env does not survive deep sleep; the clock does
+  tzset();
+  struct tm t{};
+  if (!readLocal(t)) return false;
+  if (!hourInWindow(t.tm_hour, g_rtcState.deepFrom, g_rtcState.deepTo)) return false;
+  if (t.tm_year + 1900 != g_rtcState.y || t.tm_mon + 1 != g_rtcState.m || t.tm_mday != g_rtcState.d) return false;
+  if (time(nullptr) - g_rtcState.lastWxEpoch >= (time_t)(WX_PERIOD / 1000)) return false;
+
+  nowWx.t = g_rtcState.wxT; nowWx.lo = g_rtcState.wxLo; nowWx.hi = g_rtcState.wxHi;
+  nowWx.cond = g_rtcState.wxCond;
+  drawHeader(t);
+  M5.Display.waitDisplay();
+
+  time_t now = time(nullptr);
+  awakeAccount(now, millis());
+  sleepUntil(planNextWake(now, g_rtcState.lastWxEpoch, WX_PERIOD / 1000).at, SLEEP_DEEP);
+  return true;   // not reached
+}
+
+// secrets.txt edited on the config page (ConfigServer.h): new feeds, keys
+// and networks apply without a reboot; the link stays up
+void onSecretsSaved(){
+  loadSecretsFromSD();
+  net_update(wifiCredsFromSecrets());
+  requestFetch(true, true);
 }
 
-// ---------- Setup / Loop ----------
 void setup() {
   Serial.begin(115200);
-  delay(1000);
   Serial.println("\n\n=== M5Paper S3 Calendar Starting ===");
+  bootMark("reset");
+
+  // After a deep-sleep wake the panel still shows the last frame
+  bool deepWake = (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER &&
+                   g_rtcState.magic == RTC_STATE_MAGIC);
 
+  // Not cleared here: the first frame is restored from SD or drawn in full
   auto cfg = M5.config(); 
-  cfg.clear_display = true; 
+  cfg.clear_display = false; 
   M5.begin(cfg);
   
   if (M5.Display.isEPD()) {
@@ -895,7 +1605,9 @@ void setup() {
   }
   M5.Display.setRotation(1);
   M5.Display.setTextColor(TEXT);
-  M5.Display.fillScreen(BG);
+  if (deepWake && headerOnlyWake()) return;
+  touchBegin();
+  bootMark("display");
 
   // Initialize SD card
   Serial.println("Initializing SD card...");
@@ -903,6 +1615,7 @@ void setup() {
   
   if (!SD.begin(SD_CS, SPI, 25000000)) {
     Serial.println("ERROR: SD Card initialization failed!");
+    M5.Display.fillScreen(BG);
     M5.Display.setTextSize(2);
     M5.Display.setCursor(20, 20);
     M5.Display.print("ERROR: SD Card Failed!");
@@ -912,10 +1625,14 @@ void setup() {
   }
   
   Serial.println("SD card initialized successfully");
+  bootMark("sd mounted");
+  if (otaFromSd("/update/calendar.dlt")) ESP.restart();   // a firmware patch left on the card
+  uiFontsBegin();
 
   // Load credentials from SD card
   if (!loadSecretsFromSD("/secrets.txt")) {
     Serial.println("ERROR: Failed to load credentials from SD card");
+    M5.Display.fillScreen(BG);
     M5.Display.setTextSize(2);
     M5.Display.setCursor(20, 20);
     M5.Display.print("ERROR: secrets.txt missing or invalid");
@@ -923,65 +1640,86 @@ void setup() {
     M5.Display.print("Please create secrets.txt on SD card");
     return;  // Cannot continue without credentials
   }
+  bootMark("config");
+  cfgServe("/secrets.txt", "Calendars, WiFi and keys", onSecretsSaved, cfgSecretsKeyValue);
+  cfgServeUpdate(otaFromUrl);
 
-  // Connect to WiFi
-  Serial.println("Connecting to WiFi...");
-  if (!connectWiFiWithFallback(15000)) {
-    Serial.println("WARNING: WiFi connection failed - continuing with limited functionality");
-    M5.Display.setTextSize(2);
-    M5.Display.setCursor(20, 20);
-    M5.Display.print("WiFi connection failed");
-    M5.Display.setCursor(20, 50);
-    M5.Display.print("Check credentials in secrets.txt");
-    delay(3000);
-  }
-
-  // Setup time
+  // Start joining WiFi; net_tick() in loop() finishes it
+  net_begin(wifiCredsFromSecrets());
   setupTime();
-  delay(1200);
-  syncRTCFromNTP();
+  bootMark("wifi + sntp started");
 
-  // Fetch data
-  lastWxMS = millis();
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("Fetching weather...");
-    fetchWeather();
-    Serial.println("Fetching calendar...");
-    fetchCalendar();
-  } else {
-    Serial.println("Skipping data fetch - no WiFi connection");
-  }
+  // First frame from the SD copies of the calendars (RTC time until NTP lands)
+  fetchCalendar();
+  bootMark("calendar cache parsed");
 
   struct tm t{}; 
   readLocal(t);
   lastMinute = -1;
+  lastHour = t.tm_hour;
   lastY = t.tm_year+1900; 
   lastM = t.tm_mon+1; 
   lastD = t.tm_mday;
 
-  Serial.println("Drawing display...");
-  drawAll();
+  if (deepWake) {
+    // Panel already shows yesterday's/last frame; only refresh what is due
+    if (!loadWeather()) {              // else the RTC copy of the header values
+      nowWx.t = g_rtcState.wxT; nowWx.lo = g_rtcState.wxLo; nowWx.hi = g_rtcState.wxHi;
+      nowWx.cond = g_rtcState.wxCond;
+    }
+    requestFetch(weatherDue(), lastY != g_rtcState.y || lastM != g_rtcState.m || lastD != g_rtcState.d);
+  } else {
+    if (loadWeather()) Serial.println("Weather from SD until the network is up");
+    requestFetch(true, true);
+  }
+  // The saved frame when its body still matches (a new day or changed
+  // events do not), else a full render
+  if (!restoreFrame(t)) {
+    Serial.println("Drawing display...");
+    drawAll();
+  }
+  bootMark("first frame");
+  g_awakeSinceMs = millis();
   Serial.println("Setup complete!");
 }
 
 void loop() {
+  PerfScope tick("loop", PERF_TICK);
+  net_tick();
+  if (net_justConnected()) {
+    if (!g_onlineOnce) bootMark("network up");
+    cfgBegin();
+  }
+  cfgTick();
+  if (perfPoll()) drawAll();          // stats overlay closed
+
   struct tm t{};
   bool haveTime = readLocal(t);
 
-  M5.update();
-  auto td = M5.Touch.getDetail();
+  // Write NTP time back to the RTC once SNTP has actually synced
+  if (!g_rtcSynced && net_isUp() && timeValid()){
+    syncRTCFromNTP();
+    g_rtcSynced = true;
+    bootMark("rtc synced");
+  }
 
-  static unsigned long touchExpire = 0;
-  if (td.isPressed() || td.wasPressed()) {
-    g_marqueeTouchActive = true;
-    touchExpire = millis() + 1200;
-  } else if (millis() > touchExpire) {
-    g_marqueeTouchActive = false;
+  // Touch: events queued by the sampler task (TouchInput.h)
+  TouchEvent te;
+  while (touchPoll(te)) {
+    if (g_agendaOpen) agendaTouch(te);
+    else if (haveTime) viewTap(te, t);
   }
+  uint32_t pressMs = touchLastMs();
+  if (pressMs && (long)(pressMs - g_lastTouchMs) > 0) g_lastTouchMs = pressMs;
+  g_marqueeTouchActive = g_lastTouchMs && millis() - g_lastTouchMs < 1200;
 
   updateMarquees();
 
-  bool needsUpdate = false;
+  // Hourly strip: slide along once per hour (before the header, which shows the same hour)
+  if (haveTime && t.tm_hour != lastHour) {
+    if (lastHour >= 0) drawHourly();
+    lastHour = t.tm_hour;
+  }
 
   // Header clock: redraw once per minute
   if (haveTime && t.tm_min != lastMinute) {
@@ -989,28 +1727,23 @@ void loop() {
     // redraw header background consistently
     M5.Display.fillRect(0, 0, SCREEN_W, HEADER_H, SUBTLE);
     drawHeader(t);
-    needsUpdate = true;
   }
 
-  // Calendar: refresh at midnight
+  // Calendar: refresh at midnight (redraw from SD now, refetch when online)
   if (haveTime) {
     int y = t.tm_year + 1900, m = t.tm_mon + 1, d = t.tm_mday;
     if (y != lastY || m != lastM || d != lastD) {
       lastY = y; lastM = m; lastD = d;
-      if (WiFi.status() == WL_CONNECTED) fetchCalendar();
       drawAll();
-      needsUpdate = true;
+      requestFetch(false, true);
     }
   }
 
   // Weather: refresh every 30 minutes
-  if (millis() - lastWxMS > WX_PERIOD) {
-    if (WiFi.status() == WL_CONNECTED) fetchWeather();
-    lastWxMS = millis();
-    drawAll();
-    needsUpdate = true;
-  }
+  if (weatherDue()) requestFetch(true, false);
 
-  // No light sleep — keep the UI responsive for touch/scroll
+  serviceFetches();
+  tick.end();
+  maybeSleep();
   delay(30);
 }
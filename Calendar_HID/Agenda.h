@@ -0,0 +1,151 @@
+#ifndef AGENDA_H
+#define AGENDA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <algorithm>
+
+// ---------- Agenda ----------
+// A scrolling list of rows of different heights (day headings, wrapped
+// events). Each row is measured once per refresh. A prefix sum of the
+// heights maps a scroll offset to its first visible row by binary search,
+// and a row to its offset. Only the rows that intersect the viewport are
+// drawn. This part is plain C++.
+//
+//   layout.build(n, [](int i) { return measureRow(i); });
+//   int first = layout.rowAt(scroll);         // O(log n)
+//   scroll = layout.clamp(layout.rowTop(i), viewH);
+
+struct AgendaLayout {
+  std::vector<int32_t> top;    // top[i]: y of row i; top[n]: total height
+
+  template <class F>
+  void build(int n, F heightOf) {
+    top.resize(n + 1);
+    top[0] = 0;
+    for (int i = 0; i < n; ++i) top[i + 1] = top[i] + heightOf(i);
+  }
+
+  int     count() const        { return top.empty() ? 0 : (int)top.size() - 1; }
+  int32_t total() const        { return top.empty() ? 0 : top.back(); }
+  int32_t rowTop(int i) const  { return top[i]; }
+  int32_t rowH(int i) const    { return top[i + 1] - top[i]; }
+
+  // Row covering y (clamped to the first / last row)
+  int rowAt(int32_t y) const {
+    int n = count();
+    if (n == 0) return 0;
+    int i = (int)(std::upper_bound(top.begin(), top.end(), y) - top.begin()) - 1;
+    return i < 0 ? 0 : (i >= n ? n - 1 : i);
+  }
+
+  // Keep a viewH window inside the content
+  int32_t clamp(int32_t scroll, int viewH) const {
+    int32_t maxScroll = total() - viewH;
+    if (scroll > maxScroll) scroll = maxScroll;
+    return scroll < 0 ? 0 : scroll;
+  }
+};
+
+// What a scroll from `from` to `to` costs in an h-tall viewport: the pixels
+// still on screen move by `shift`, and canvas rows [y0, y1) are drawn fresh
+struct AgendaStrip { int32_t shift; int y0, y1; };
+
+inline AgendaStrip agendaScroll(int32_t from, int32_t to, int h) {
+  int32_t dy = to - from;
+  if (dy >= h || dy <= -h) return { 0, 0, h };
+  if (dy > 0) return { -dy, h - (int)dy, h };
+  return { -dy, 0, (int)-dy };
+}
+
+#ifdef ARDUINO
+#include <M5Unified.h>
+#include "GrayRender.h"
+#include "Perf.h"
+
+// Draws row `row` with its top at canvas y `y`
+typedef void (*AgendaDrawFn)(LovyanGFX& g, int row, int y, int w);
+
+// The viewport keeps one canvas until end(). A scroll moves the
+// pixels already drawn, renders only the strip that scrolled in, and goes
+// out as one fast update. E-ink has no hardware scroll, so the whole
+// viewport is refreshed, but only the new strip is redrawn.
+struct AgendaView {
+  int          x = 0, y = 0, w = 0, h = 0;
+  int32_t      scroll = 0;
+  uint16_t     bg = 0xFFFF;
+  AgendaLayout layout;
+  AgendaDrawFn draw = nullptr;
+  M5Canvas*    canvas = nullptr;
+
+  bool begin(int vx, int vy, int vw, int vh, uint16_t background, AgendaDrawFn fn) {
+    x = vx; y = vy; w = vw; h = vh; bg = background; draw = fn;
+    if (!canvas) canvas = grayCanvas(w, h);
+    if (canvas) canvas->setBaseColor(bg);
+    return canvas != nullptr;
+  }
+
+  // Canvas and layout freed; begin() makes a new canvas
+  void end() {
+    if (canvas) { canvas->deleteSprite(); delete canvas; canvas = nullptr; }
+    layout.top.clear(); layout.top.shrink_to_fit();
+    scroll = 0;
+  }
+
+  // Canvas rows [y0, y1): clear, then draw every row that crosses them
+  void renderStrip(int y0, int y1) {
+    canvas->setClipRect(0, y0, w, y1 - y0);
+    canvas->fillRect(0, y0, w, y1 - y0, bg);
+    int n = layout.count();
+    for (int i = layout.rowAt(scroll + y0); i < n && layout.rowTop(i) < scroll + y1; ++i)
+      draw(*canvas, i, layout.rowTop(i) - scroll, w);
+    canvas->clearClipRect();
+  }
+
+  // Draw the whole viewport at the current offset into the panel buffer;
+  // the caller's batch flushes it (after a relayout, or under a full frame)
+  void paint() {
+    if (!canvas) return;
+    scroll = layout.clamp(scroll, h);
+    { PERF_SCOPE("agenda frame", PERF_RENDER); renderStrip(0, h); }
+    canvas->pushSprite(&M5.Display, x, y);
+  }
+
+  void push() {
+    PERF_SCOPE("agenda push", PERF_FLUSH);
+    auto prevMode = grayUse(GC_TEXT);
+    canvas->pushSprite(&M5.Display, x, y);
+    M5.Display.display(x, y, w, h);
+    M5.Display.setEpdMode(prevMode);
+  }
+
+  // paint() and flush it on its own
+  void redraw() {
+    if (!canvas) return;
+    paint();
+    auto prevMode = grayUse(GC_TEXT);
+    M5.Display.display(x, y, w, h);
+    M5.Display.setEpdMode(prevMode);
+  }
+
+  void scrollTo(int32_t s) {
+    if (!canvas) return;
+    s = layout.clamp(s, h);
+    if (s == scroll) return;
+    AgendaStrip st = agendaScroll(scroll, s, h);
+    scroll = s;
+    {
+      PERF_SCOPE("agenda frame", PERF_RENDER);
+      if (st.shift) canvas->scroll(0, st.shift);   // keep what is still on screen
+      renderStrip(st.y0, st.y1);
+    }
+    push();
+  }
+
+  void scrollBy(int32_t d)   { scrollTo(scroll + d); }
+  void scrollToRow(int row)  { if (row < layout.count()) scrollTo(layout.rowTop(row)); }
+};
+#endif // ARDUINO
+
+#endif // AGENDA_H
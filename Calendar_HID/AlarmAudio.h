@@ -0,0 +1,64 @@
+#ifndef ALARMAUDIO_H
+#define ALARMAUDIO_H
+
+#include <M5Unified.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+// ---------- Non-blocking tones ----------
+// Tone patterns are queued to a small FreeRTOS task, so the UI loop keeps
+// running (and can cancel with a tap) while an alarm is sounding.
+//   audio_begin();                       once from setup()
+//   audio_play(TONE_ALARM, 2, 5);        returns immediately
+//   audio_stop();                        e.g. on touch
+
+struct ToneStep { uint16_t freq; uint16_t ms; };
+
+static const ToneStep TONE_ALARM[] = { {1000, 500}, {1200, 500} };
+static const ToneStep TONE_CHIME[] = { {1568, 120}, {0, 60}, {2093, 180} };
+
+struct TonePattern { const ToneStep* steps; uint8_t count; uint8_t repeats; uint8_t volume; };
+
+static QueueHandle_t  s_audioQ    = nullptr;
+static volatile bool  s_audioStop = false;
+static volatile bool  s_audioBusy = false;
+
+inline void audio_task(void*) {
+  TonePattern p;
+  for (;;) {
+    if (xQueueReceive(s_audioQ, &p, portMAX_DELAY) != pdTRUE) continue;
+    s_audioStop = false;
+    s_audioBusy = true;
+    M5.Speaker.setVolume(p.volume);
+    for (int r = 0; r < p.repeats && !s_audioStop; ++r) {
+      for (int i = 0; i < p.count && !s_audioStop; ++i) {
+        if (p.steps[i].freq) M5.Speaker.tone(p.steps[i].freq, p.steps[i].ms);
+        vTaskDelay(pdMS_TO_TICKS(p.steps[i].ms));
+      }
+    }
+    M5.Speaker.stop();
+    s_audioBusy = false;
+  }
+}
+
+inline void audio_begin() {
+  if (s_audioQ) return;
+  s_audioQ = xQueueCreate(4, sizeof(TonePattern));
+  xTaskCreatePinnedToCore(audio_task, "tones", 3072, nullptr, 2, nullptr, 0);
+}
+
+inline bool audio_play(const ToneStep* steps, uint8_t count, uint8_t repeats, uint8_t volume = 200) {
+  if (!s_audioQ) return false;
+  TonePattern p{ steps, count, repeats, volume };
+  return xQueueSend(s_audioQ, &p, 0) == pdTRUE;
+}
+
+inline void audio_stop() {
+  s_audioStop = true;
+  if (s_audioQ) xQueueReset(s_audioQ);
+}
+
+inline bool audio_busy() { return s_audioBusy; }
+
+#endif // ALARMAUDIO_H
@@ -0,0 +1,150 @@
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// ---------- Alarms ----------
+// Up to MAX_ALARMS wall-clock alarms with a day-of-week repeat mask.
+// alarmNextFire() is pure (localtime/mktime only) so it can be exercised on
+// the host; loading/saving /Wifi/ALARMS.txt is Arduino-only.
+//
+// ALARMS.txt, one alarm per line:
+//   07:30 daily on
+//   08:00 once off
+//   06:45 mon,tue,thu on
+//   09:00 weekends on
+
+static const int MAX_ALARMS = 4;
+
+enum : uint8_t {
+  ALARM_SUN = 1 << 0, ALARM_MON = 1 << 1, ALARM_TUE = 1 << 2, ALARM_WED = 1 << 3,
+  ALARM_THU = 1 << 4, ALARM_FRI = 1 << 5, ALARM_SAT = 1 << 6,
+  ALARM_ONCE     = 0,
+  ALARM_DAILY    = 0x7F,
+  ALARM_WEEKDAYS = ALARM_MON | ALARM_TUE | ALARM_WED | ALARM_THU | ALARM_FRI,
+  ALARM_WEEKENDS = ALARM_SAT | ALARM_SUN,
+};
+
+struct Alarm {
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t days;      // ALARM_* mask, 0 = one-shot
+  bool    enabled;
+  int     jobId;     // TimerWheel id while armed, -1 otherwise
+};
+
+// Next local time strictly after `now` that matches the alarm, -1 if none
+inline time_t alarmNextFire(const Alarm& a, time_t now) {
+  struct tm lt; localtime_r(&now, &lt);
+  for (int d = 0; d < 8; ++d) {
+    struct tm c = lt;
+    c.tm_mday += d; c.tm_hour = a.hour; c.tm_min = a.minute; c.tm_sec = 0; c.tm_isdst = -1;
+    time_t t = mktime(&c);           // normalises tm_wday too
+    if (t <= now) continue;
+    if (a.days == ALARM_ONCE || (a.days & (1 << c.tm_wday))) return t;
+  }
+  return -1;
+}
+
+// "Daily", "Weekdays", "Once", or "Mon Tue ..." for custom masks
+inline const char* alarmRepeatLabel(uint8_t days, char* buf, size_t n) {
+  static const char* DOW[] = {"Sun","Mon","Tue","Wed","Thu","Fri","Sat"};
+  if (days == ALARM_ONCE)     return "Once";
+  if (days == ALARM_DAILY)    return "Daily";
+  if (days == ALARM_WEEKDAYS) return "Weekdays";
+  if (days == ALARM_WEEKENDS) return "Weekends";
+  buf[0] = 0;
+  for (int i = 0; i < 7; ++i) {
+    if (!(days & (1 << i))) continue;
+    if (buf[0]) strncat(buf, " ", n - strlen(buf) - 1);
+    strncat(buf, DOW[i], n - strlen(buf) - 1);
+  }
+  return buf;
+}
+
+// Presets the alarm screen cycles through
+inline uint8_t alarmNextRepeatPreset(uint8_t days) {
+  switch (days) {
+    case ALARM_ONCE:     return ALARM_DAILY;
+    case ALARM_DAILY:    return ALARM_WEEKDAYS;
+    case ALARM_WEEKDAYS: return ALARM_WEEKENDS;
+    default:             return ALARM_ONCE;
+  }
+}
+
+inline uint8_t alarmParseDays(const char* s) {
+  if (!strcmp(s, "once"))     return ALARM_ONCE;
+  if (!strcmp(s, "daily"))    return ALARM_DAILY;
+  if (!strcmp(s, "weekdays")) return ALARM_WEEKDAYS;
+  if (!strcmp(s, "weekends")) return ALARM_WEEKENDS;
+  static const char* DOW[] = {"sun","mon","tue","wed","thu","fri","sat"};
+  uint8_t mask = 0;
+  for (int i = 0; i < 7; ++i) if (strstr(s, DOW[i])) mask |= (1 << i);
+  return mask;
+}
+
+inline void alarmFormatDays(uint8_t days, char* buf, size_t n) {
+  if (days == ALARM_ONCE)          { snprintf(buf, n, "once");     return; }
+  if (days == ALARM_DAILY)         { snprintf(buf, n, "daily");    return; }
+  if (days == ALARM_WEEKDAYS)      { snprintf(buf, n, "weekdays"); return; }
+  if (days == ALARM_WEEKENDS)      { snprintf(buf, n, "weekends"); return; }
+  static const char* DOW[] = {"sun","mon","tue","wed","thu","fri","sat"};
+  buf[0] = 0;
+  for (int i = 0; i < 7; ++i) {
+    if (!(days & (1 << i))) continue;
+    if (buf[0]) strncat(buf, ",", n - strlen(buf) - 1);
+    strncat(buf, DOW[i], n - strlen(buf) - 1);
+  }
+}
+
+// "HH:MM <repeat> on|off"
+inline bool alarmParseLine(const char* line, Alarm& a) {
+  int h, m; char rep[40] = {0}, state[8] = {0};
+  if (sscanf(line, "%d:%d %39s %7s", &h, &m, rep, state) < 2) return false;
+  if (h < 0 || h > 23 || m < 0 || m > 59) return false;
+  for (char* p = rep; *p; ++p) if (*p >= 'A' && *p <= 'Z') *p += 32;
+  a.hour = (uint8_t)h; a.minute = (uint8_t)m;
+  a.days = rep[0] ? alarmParseDays(rep) : (uint8_t)ALARM_ONCE;
+  a.enabled = strcmp(state, "off") != 0;
+  a.jobId = -1;
+  return true;
+}
+
+#ifdef ARDUINO
+#include <SD.h>
+
+// Fills all MAX_ALARMS slots (unused ones are 08:00, off); returns how many
+// came from the file
+inline int loadAlarmsFromSD(Alarm* alarms, const char* path = "/Wifi/ALARMS.txt") {
+  for (int i = 0; i < MAX_ALARMS; ++i) alarms[i] = { 8, 0, ALARM_ONCE, false, -1 };
+  int n = 0;
+  File f = SD.open(path, FILE_READ);
+  if (f) {
+    while (f.available() && n < MAX_ALARMS) {
+      String line = f.readStringUntil('\n'); line.trim();
+      if (line.length() == 0 || line[0] == '#') continue;
+      if (alarmParseLine(line.c_str(), alarms[n])) n++;
+    }
+    f.close();
+  }
+  return n;
+}
+
+inline bool saveAlarmsToSD(const Alarm* alarms, int n, const char* path = "/Wifi/ALARMS.txt") {
+  SD.remove(path);
+  File f = SD.open(path, FILE_WRITE);
+  if (!f) return false;
+  for (int i = 0; i < n; ++i) {
+    char days[40]; alarmFormatDays(alarms[i].days, days, sizeof(days));
+    f.printf("%02d:%02d %s %s\n", alarms[i].hour, alarms[i].minute, days,
+             alarms[i].enabled ? "on" : "off");
+  }
+  f.close();
+  return true;
+}
+#endif // ARDUINO
+
+#endif // ALARMS_H
@@ -0,0 +1,170 @@
+#ifndef ALERTENGINE_H
+#define ALERTENGINE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "InstrumentTable.h"
+
+// ---------- Price alerts ----------
+// Rules live in one array sorted by instrument id, with a start offset per
+// id, so a quote update only walks the rules for that symbol. Each rule
+// re-arms only once the price has moved back past a hysteresis band, so a
+// price sitting on the level does not fire on every poll.
+//
+// /Wifi/ALERTS.txt, one rule per line ('#' starts a comment):
+//   BTC-USD above 70000          price >= level
+//   AAPL    below 180 1.5        price <= level, re-arm above 181.5
+//   ETH-USD cross 3000           either direction through the level
+//   TSLA    move  5              |day change %| >= 5
+// The optional last number is the band, in the level's units. Default: 0.5 %
+// of the level for prices, 0.5 points for moves.
+//
+//   AlertHit hits[4];
+//   int n = gAlerts.onQuote(id, price, changePct, hits, 4);
+
+enum AlertKind : uint8_t { ALERT_ABOVE, ALERT_BELOW, ALERT_CROSS, ALERT_MOVE };
+
+inline const char* alertKindName(uint8_t k) {
+  switch (k) {
+    case ALERT_ABOVE: return "above";
+    case ALERT_BELOW: return "below";
+    case ALERT_CROSS: return "cross";
+    default:          return "move";
+  }
+}
+
+struct AlertRule {
+  int16_t id;          // instrument id
+  uint8_t kind;
+  int8_t  state;       // above/below/move: 1 armed, 0 fired; cross: side -1/+1, 0 unknown
+  float   level;
+  float   band;
+};
+
+struct AlertHit {
+  int16_t rule, id;
+  uint8_t kind;
+  int8_t  dir;         // +1 up through / above, -1 down
+  float   level, value;
+};
+
+struct AlertBook {
+  static const int MAX = 64;
+
+  AlertRule rule[MAX];
+  int       count = 0;
+  uint8_t   start[InstrumentTable::CAP + 1];   // rules of id: [start[id], start[id + 1])
+
+  void clear() { count = 0; build(); }
+
+  bool add(int id, uint8_t kind, float level, float band = -1) {
+    if (count >= MAX || id < 0 || id >= InstrumentTable::CAP) return false;
+    if (band < 0) band = (kind == ALERT_MOVE) ? 0.5f : fabsf(level) * 0.005f;
+    AlertRule& r = rule[count++];
+    r.id = (int16_t)id; r.kind = kind; r.level = level; r.band = band;
+    r.state = (kind == ALERT_CROSS) ? 0 : 1;
+    return true;
+  }
+
+  // Sort by id (stable, file order within a symbol) and fill the offsets.
+  // Call once after the last add().
+  void build() {
+    for (int i = 1; i < count; ++i) {
+      AlertRule r = rule[i];
+      int j = i - 1;
+      while (j >= 0 && rule[j].id > r.id) { rule[j + 1] = rule[j]; --j; }
+      rule[j + 1] = r;
+    }
+    int k = 0;
+    for (int id = 0; id <= InstrumentTable::CAP; ++id) {
+      while (k < count && rule[k].id < id) ++k;
+      start[id] = (uint8_t)k;
+    }
+  }
+
+  int rulesFor(int id) const { return start[id + 1] - start[id]; }
+
+  // Evaluate the rules for `id`; writes up to `maxOut` hits, returns how many
+  int onQuote(int id, float price, float changePct, AlertHit* out, int maxOut) {
+    if (id < 0 || id >= InstrumentTable::CAP || price <= 0) return 0;
+    int n = 0;
+    for (int i = start[id]; i < start[id + 1]; ++i) {
+      AlertRule& r = rule[i];
+      int8_t dir = 0;
+      float v = price;
+      switch (r.kind) {
+        case ALERT_ABOVE:
+          if (r.state && price >= r.level) { r.state = 0; dir = 1; }
+          else if (!r.state && price < r.level - r.band) r.state = 1;
+          break;
+        case ALERT_BELOW:
+          if (r.state && price <= r.level) { r.state = 0; dir = -1; }
+          else if (!r.state && price > r.level + r.band) r.state = 1;
+          break;
+        case ALERT_MOVE:
+          v = changePct;
+          if (r.state && fabsf(changePct) >= r.level) { r.state = 0; dir = changePct < 0 ? -1 : 1; }
+          else if (!r.state && fabsf(changePct) < r.level - r.band) r.state = 1;
+          break;
+        case ALERT_CROSS: {
+          int8_t side = r.state;
+          if (price >= r.level + r.band)      side = 1;
+          else if (price <= r.level - r.band) side = -1;
+          if (r.state && side != r.state) dir = side;
+          r.state = side;
+          break;
+        }
+      }
+      if (dir && n < maxOut) out[n++] = { (int16_t)i, r.id, r.kind, dir, r.level, v };
+    }
+    return n;
+  }
+};
+
+// "AAPL below 180 1.5" -> symbol, kind, level, band (-1 = default).
+// False for blank lines, comments and anything malformed.
+inline bool alertParseLine(const char* line, char* sym, size_t symLen,
+                           uint8_t& kind, float& level, float& band) {
+  char s[InstrumentTable::SYM_LEN], k[8];
+  float lv, bd = -1;
+  while (*line == ' ' || *line == '\t') ++line;
+  if (!*line || *line == '#') return false;
+  int got = sscanf(line, "%15s %7s %f %f", s, k, &lv, &bd);
+  if (got < 3) return false;
+  if      (!strcmp(k, "above")) kind = ALERT_ABOVE;
+  else if (!strcmp(k, "below")) kind = ALERT_BELOW;
+  else if (!strcmp(k, "cross")) kind = ALERT_CROSS;
+  else if (!strcmp(k, "move"))  kind = ALERT_MOVE;
+  else return false;
+  snprintf(sym, symLen, "%s", s);
+  level = lv; band = (got == 4) ? bd : -1;
+  return true;
+}
+
+#ifdef ARDUINO
+#include <SD.h>
+
+// Load rules for symbols that are on the watchlist; returns the rule count
+inline int alertsLoadFromSD(AlertBook& book, const InstrumentTable& t, const char* path = "/Wifi/ALERTS.txt") {
+  book.count = 0;
+  File f = SD.open(path, FILE_READ);
+  if (f) {
+    while (f.available()) {
+      String line = f.readStringUntil('\n');
+      char sym[InstrumentTable::SYM_LEN]; uint8_t kind; float level, band;
+      if (!alertParseLine(line.c_str(), sym, sizeof(sym), kind, level, band)) continue;
+      int id = t.find(sym);
+      if (id < 0 || !book.add(id, kind, level, band))
+        Serial.printf("alerts: skipping '%s'\n", line.c_str());
+    }
+    f.close();
+  }
+  book.build();
+  Serial.printf("alerts: %d rules\n", book.count);
+  return book.count;
+}
+#endif // ARDUINO
+
+#endif // ALERTENGINE_H
@@ -0,0 +1,202 @@
+#ifndef APPHOST_H
+#define APPHOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Perf.h"
+
+// ---------- App host ----------
+// Apps in one firmware, one in front at a time, behind a common lifecycle:
+//   init      once, on the first open (nothing is set up before it's needed)
+//   resume    each time it comes to the front: draw from what it kept
+//   tick      every loop() while in front; false = go back to the home app
+//   suspend   leaving the front: free sprites, canvases, caches
+//   teardown  on close: drop the rest; the next open inits again
+// Switches are queued and done at the start of the next tick, never in the
+// middle of an app's own tick.
+//
+// Each app's heap use is accounted. The free heap is sampled when it comes
+// to the front (the base) and on every tick (the low). It is sampled again
+// after suspend: base minus that is what the app still holds while in the
+// background, and should stay near zero. The numbers are logged on every
+// switch and kept per app. This part is plain C++, so a switch sequence can
+// be replayed on a host with a fake heap.
+//
+//   static const AppOps CAL = { "calendar", calInit, calResume, calTick, calSuspend, calTeardown };
+//   int cal = g_apps.add(&CAL, nullptr);
+//   g_apps.switchTo(cal);                  // setup(): first frame now
+//   g_apps.open(hid);                      // from a tap; happens next tick
+//   g_apps.tick();                         // loop()
+
+typedef bool     (*AppInitFn)(void* ctx);    // false: cannot run now
+typedef void     (*AppFn)(void* ctx);
+typedef bool     (*AppTickFn)(void* ctx);
+typedef uint32_t (*AppProbeFn)();
+
+struct AppOps {
+  const char* name;
+  AppInitFn   init;
+  AppFn       resume;
+  AppTickFn   tick;
+  AppFn       suspend;
+  AppFn       teardown;
+};
+
+enum AppRun : uint8_t { APP_IDLE, APP_SUSPENDED, APP_RUNNING };
+
+struct AppStats {
+  uint32_t opens = 0, inits = 0;
+  uint32_t resumeMs = 0, resumeMaxMs = 0;   // init + resume, last and worst
+  int32_t  peak = 0;           // most heap used while in front, vs its base
+  int32_t  held = 0;           // in use just before the last suspend
+  int32_t  retained = 0;       // still held after the last suspend
+  int32_t  retainedMax = 0;
+};
+
+struct AppHost {
+  static const int MAX = 4;
+  static const uint32_t RESUME_BUDGET_MS = 1000;
+
+  struct Slot {
+    const AppOps* ops;
+    void*         ctx;
+    uint8_t       run;
+    uint32_t      base, low;   // free heap when it came to the front, least since
+    AppStats      st;
+  };
+
+  Slot       app[MAX];
+  int        count = 0, cur = -1, next = -1, home = 0;
+  AppProbeFn heapFree = nullptr;   // free heap bytes; null = not accounted
+  AppProbeFn clockMs = nullptr;
+
+  int add(const AppOps* ops, void* ctx) {
+    if (count >= MAX) return -1;
+    app[count] = { ops, ctx, APP_IDLE, 0, 0, AppStats() };
+    return count++;
+  }
+
+  int  current() const { return cur; }
+  bool inFront(int i) const { return cur == i && next < 0; }
+  void open(int i) { if (i >= 0 && i < count) next = i; }
+  void goHome() { open(home); }
+
+  uint32_t freeNow() const { return heapFree ? heapFree() : 0; }
+  uint32_t nowMs() const { return clockMs ? clockMs() : 0; }
+
+  void suspendCurrent() {
+    if (cur < 0) return;
+    Slot& s = app[cur];
+    PERF_SCOPE("app suspend", PERF_TICK);
+    uint32_t before = freeNow();
+    if (s.ops->suspend) s.ops->suspend(s.ctx);
+    uint32_t after = freeNow();
+    s.run = APP_SUSPENDED;
+    if (heapFree) {
+      if (before < s.low) s.low = before;
+      s.st.held = (int32_t)(s.base - before);
+      s.st.retained = (int32_t)(s.base - after);
+      if (s.st.retained > s.st.retainedMax) s.st.retainedMax = s.st.retained;
+      int32_t peak = (int32_t)(s.base - s.low);
+      if (peak > s.st.peak) s.st.peak = peak;
+      perfOut("app: %s suspended; held %.1f KB, peak %.1f KB, freed %.1f KB, retained %.1f KB\n",
+              s.ops->name, s.st.held / 1024.0, peak / 1024.0, (int32_t)(after - before) / 1024.0,
+              s.st.retained / 1024.0);
+    }
+    cur = -1;
+  }
+
+  // Init if needed, then resume; false when init refused
+  bool resume(int i) {
+    Slot& s = app[i];
+    PERF_SCOPE("app resume", PERF_TICK);
+    uint32_t t0 = nowMs();
+    s.base = s.low = freeNow();
+    if (s.run == APP_IDLE) {
+      if (s.ops->init && !s.ops->init(s.ctx)) { perfOut("app: %s failed to init\n", s.ops->name); return false; }
+      s.st.inits++;
+      s.run = APP_SUSPENDED;
+    }
+    if (s.ops->resume) s.ops->resume(s.ctx);
+    s.run = APP_RUNNING;
+    s.st.opens++;
+    s.st.resumeMs = nowMs() - t0;
+    if (s.st.resumeMs > s.st.resumeMaxMs) s.st.resumeMaxMs = s.st.resumeMs;
+    cur = i;
+    perfOut("app: %s in front after %lu ms%s\n", s.ops->name, (unsigned long)s.st.resumeMs,
+            s.st.resumeMs > RESUME_BUDGET_MS ? " (over budget)" : "");
+    return true;
+  }
+
+  // Switch now; from setup() or when the caller is between ticks
+  void switchTo(int i) {
+    next = -1;
+    if (i < 0 || i >= count || i == cur) return;
+    suspendCurrent();
+    if (!resume(i) && i != home) resume(home);
+  }
+
+  // Close an app for good; it inits again on its next open
+  void teardown(int i) {
+    if (i < 0 || i >= count) return;
+    if (i == cur) { suspendCurrent(); if (i != home) resume(home); }
+    Slot& s = app[i];
+    if (s.run == APP_IDLE) return;
+    uint32_t before = freeNow();
+    if (s.ops->teardown) s.ops->teardown(s.ctx);
+    s.run = APP_IDLE;
+    // What it gave back is not the front app's doing: move that app's base
+    // and low along, or its held and retained would come out negative
+    if (heapFree && cur >= 0) {
+      int32_t freed = (int32_t)(freeNow() - before);
+      app[cur].base += freed;
+      app[cur].low += freed;
+    }
+  }
+
+  // Close every app in the background but home, e.g. when the heap runs
+  // short; returns how many were closed
+  int closeBackground() {
+    int n = 0;
+    for (int i = 0; i < count; ++i)
+      if (i != cur && i != home && app[i].run == APP_SUSPENDED) { teardown(i); n++; }
+    return n;
+  }
+
+  // One pass of the app in front; false when there is none
+  bool tick() {
+    if (next >= 0) switchTo(next);
+    if (cur < 0) return false;
+    Slot& s = app[cur];
+    if (heapFree) { uint32_t f = heapFree(); if (f < s.low) s.low = f; }
+    if (!s.ops->tick(s.ctx) && cur != home) goHome();
+    return true;
+  }
+
+  void report() const {
+    perfOut("---- apps ----\n%-10s %5s %5s %8s %8s %8s %8s\n", "name", "opens", "inits", "resume", "peak", "held", "retained");
+    for (int i = 0; i < count; ++i) {
+      const AppStats& st = app[i].st;
+      perfOut("%-10.10s %5lu %5lu %6lums %6.1fK %6.1fK %6.1fK%s\n", app[i].ops->name,
+              (unsigned long)st.opens, (unsigned long)st.inits, (unsigned long)st.resumeMaxMs,
+              st.peak / 1024.0, st.held / 1024.0, st.retainedMax / 1024.0, i == cur ? "  *" : "");
+    }
+  }
+};
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+// Internal RAM and PSRAM together: sprites and caches may sit in either
+inline uint32_t appHeapFree() { return heap_caps_get_free_size(MALLOC_CAP_8BIT); }
+inline uint32_t appMillis() { return millis(); }
+
+inline void appHostBegin(AppHost& h, int home = 0) {
+  h.heapFree = appHeapFree;
+  h.clockMs = appMillis;
+  h.home = home;
+}
+#endif // ARDUINO
+
+#endif // APPHOST_H
@@ -2,6 +2,7 @@
 #define APPSTATE_H
 
 #include "Config.h"
+#include "CalFeeds.h"
 
 // ---------- Models ----------
 struct CalendarEvent {
@@ -11,6 +12,10 @@ struct CalendarEvent {
   int sh, sm;
   int eh, em;
   bool allDay;
+  uint32_t endYmd;     // DTEND's local date, yyyymmdd (exclusive when all-day); 0 = none
+  uint32_t key;        // hash of UID + RECURRENCE-ID
+  uint32_t seq, mod;   // SEQUENCE, LAST-MODIFIED (CalFeeds.h calStamp)
+  uint32_t sig;        // hash of what the card shows
 };
 
 struct WeatherNow { int t, lo, hi; String cond; };
@@ -28,14 +33,18 @@ struct DayView {
   String password;
   String backup_ssid;
   String backup_password;
-  String calendarUrl;
-  String calendarUrl2;
+  String calendarUrls[CAL_MAX_FEEDS];   // CAL_URL1..CAL_URL8
   String weatherApiKey;
+  String finnhubKey, finnhubBackupKey;     // stocks app (CryptoApp.h)
+  String coindeskKey, coindeskBackupKey;
   String LAT = "";
   String LON = "-";
 
-  CalendarEvent events[160];
+  // Sorted and merged from every feed; sized per refresh, so large blocks
+  // land in PSRAM (FEED_MAX_EVENTS bounds it)
+  std::vector<CalendarEvent> events;
   int eventCount = 0;
+  uint32_t g_eventsRev = 1;      // bumped when a refresh changes events[]
 
   WeatherNow nowWx;
   ForecastDay fcast[7];
@@ -57,17 +66,19 @@ struct DayView {
 
   // Refresh state
   int lastMinute = -1;
+  int lastHour = -1;
   int lastY=-1, lastM=-1, lastD=-1;
   unsigned long lastWxMS = 0;
   const unsigned long WX_PERIOD = 30UL*60UL*1000UL;
 #else
   // Externs for other translation units (not used here, but kept clean)
-  extern String ssid, password, backup_ssid, backup_password, calendarUrl, calendarUrl2, weatherApiKey, LAT, LON;
-  extern CalendarEvent events[160]; extern int eventCount;
+  extern String ssid, password, backup_ssid, backup_password, calendarUrls[CAL_MAX_FEEDS], weatherApiKey, LAT, LON;
+  extern String finnhubKey, finnhubBackupKey, coindeskKey, coindeskBackupKey;
+  extern std::vector<CalendarEvent> events; extern int eventCount; extern uint32_t g_eventsRev;
   extern WeatherNow nowWx; extern ForecastDay fcast[7];
   extern bool g_marqueeTouchActive; extern const unsigned long MARQUEE_STEP_MS; extern const int MARQUEE_SPEED_PX;
   struct Marquee; extern std::vector<Marquee> marquees;
-  extern int lastMinute, lastY, lastM, lastD; extern unsigned long lastWxMS; extern const unsigned long WX_PERIOD;
+  extern int lastMinute, lastHour, lastY, lastM, lastD; extern unsigned long lastWxMS; extern const unsigned long WX_PERIOD;
 #endif
 
 // ---------- Shared helpers ----------
@@ -0,0 +1,405 @@
+#ifndef CALFEEDS_H
+#define CALFEEDS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <algorithm>
+
+// ---------- Calendar feeds ----------
+// Any number of ICS feeds (CAL_URL1..CAL_URL8 in secrets.txt) are fetched
+// by a small pool of worker tasks, so several TLS downloads are in flight
+// at once. Each body is parsed while it streams in and is teed to that
+// feed's SD cache (/calendarN.ics). Each feed has its own deadline. A slow
+// or failing server falls back to its cached copy, and the other feeds do
+// not wait on it.
+//
+// The parser only unfolds RFC 5545 lines and hands each logical line to the
+// sketch, which builds its events from them. This part is plain C++, down
+// to the loop that streams one body, so the pool can be run on a host
+// against local stub servers.
+//
+//   calFetchAll(feeds, n, onIcsLine, onIcsReset, net_isUp());
+
+static const int CAL_MAX_FEEDS = 8;
+static const int CAL_WORKERS   = 3;          // TLS sessions in flight
+
+// Called for every unfolded line; returns true when it closed an event
+typedef bool (*CalLineFn)(void* ctx, const char* line, int len);
+// Drop whatever a feed's context collected (before falling back to the cache)
+typedef void (*CalResetFn)(void* ctx);
+
+// secrets.txt key (upper case) -> feed slot, -1 if it is not a feed.
+// CAL_URL, CALENDAR_URL, CALENDARURL and CAL1 are slot 0; CAL_URL2 / CAL2 slot 1 ...
+inline int calFeedSlot(const char* key) {
+  static const char* prefixes[] = { "CALENDAR_URL", "CALENDARURL", "CAL_URL", "CAL" };
+  for (const char* p : prefixes) {
+    size_t n = strlen(p);
+    if (strncmp(key, p, n)) continue;
+    const char* rest = key + n;
+    if (!*rest) return p[3] ? 0 : -1;                  // bare "CAL" is not a feed
+    char* end;
+    long i = strtol(rest, &end, 10);
+    if (*end || i < 1 || i > CAL_MAX_FEEDS) return -1;
+    return (int)i - 1;
+  }
+  return -1;
+}
+
+// Reassembles folded lines (CRLF followed by a space or tab continues the
+// previous line) from arbitrary chunks. Lines longer than LINE_MAX are cut.
+struct IcsStream {
+  static const int LINE_MAX = 512;
+
+  char      line[LINE_MAX + 1];
+  int       len = 0;
+  bool      held = false;      // a finished line, waiting to see if the next one folds into it
+  uint32_t  events = 0;
+  CalLineFn fn = nullptr;
+  void*     ctx = nullptr;
+
+  void begin(CalLineFn f, void* c) { fn = f; ctx = c; len = 0; held = false; events = 0; }
+
+  void emit() {
+    line[len] = 0;
+    if (fn(ctx, line, len)) events++;
+    len = 0;
+  }
+
+  void feed(const uint8_t* p, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      char c = (char)p[i];
+      if (c == '\r') continue;
+      if (held) {
+        held = false;
+        if (c == ' ' || c == '\t') continue;           // folded: keep appending to this line
+        emit();
+      }
+      if (c == '\n') { held = true; continue; }
+      if (len < LINE_MAX) line[len++] = c;
+    }
+  }
+
+  void finish() {
+    if (held || len) emit();
+    held = false;
+  }
+};
+
+// ---------- Event identity and refresh diff ----------
+// An event is keyed by a hash of UID + RECURRENCE-ID. The same meeting on
+// two feeds is kept once: the copy with the higher SEQUENCE wins, then the
+// later LAST-MODIFIED, then the earlier feed. Each refresh is diffed against
+// the previous one by key and content signature, so only the days it touched
+// need a redraw.
+
+// FNV-1a, chainable: calHash(b, calHash(a))
+inline uint32_t calHash(const char* s, uint32_t h = 2166136261u) {
+  while (*s) { h ^= (uint8_t)*s++; h *= 16777619u; }
+  return h;
+}
+
+inline uint32_t calHashInt(int32_t v, uint32_t h) {
+  for (int i = 0; i < 4; ++i) { h ^= (uint8_t)(v >> (8 * i)); h *= 16777619u; }
+  return h;
+}
+
+// "20250301T101500Z" -> minutes since 2000, monotonic for comparing stamps
+inline uint32_t calStamp(const char* v) {
+  int y = 0, mo = 0, d = 0, hh = 0, mm = 0;
+  if (sscanf(v, "%4d%2d%2dT%2d%2d", &y, &mo, &d, &hh, &mm) < 3 || y < 2000) return 0;
+  return ((((uint32_t)(y - 2000) * 12 + (mo - 1)) * 31 + (d - 1)) * 24 + hh) * 60 + mm;
+}
+
+// Does revision (seq, mod) replace (seq0, mod0)?
+inline bool calNewer(uint32_t seq, uint32_t mod, uint32_t seq0, uint32_t mod0) {
+  return seq != seq0 ? seq > seq0 : mod > mod0;
+}
+
+// One event of one feed, for deduping
+struct CalRef {
+  uint32_t key, seq, mod;
+  uint16_t feed, idx;
+  bool     drop;
+};
+
+// Mark every copy but the winner of each key as dropped; returns how many
+// were dropped. Reorders refs (by key).
+inline int calDedupe(CalRef* refs, int n) {
+  std::sort(refs, refs + n, [](const CalRef& a, const CalRef& b) {
+    return a.key != b.key ? a.key < b.key : a.feed < b.feed;
+  });
+  int dropped = 0;
+  for (int i = 0; i < n; ) {
+    int j = i, win = i;
+    for (; j < n && refs[j].key == refs[i].key; ++j) {
+      refs[j].drop = true;
+      if (calNewer(refs[j].seq, refs[j].mod, refs[win].seq, refs[win].mod)) win = j;
+    }
+    refs[win].drop = false;
+    dropped += j - i - 1;
+    i = j;
+  }
+  return dropped;
+}
+
+// What a refresh showed, per event: identity, content, and start day
+struct CalSig {
+  uint32_t key, sig, ymd;
+};
+
+enum CalChange : uint8_t { CAL_ADDED, CAL_CHANGED, CAL_REMOVED };
+typedef void (*CalChangeFn)(void* ctx, CalChange c, uint32_t ymd);
+
+struct CalDiffCount { int added, changed, removed; };
+
+// Walk two key-sorted refreshes; `fn` gets each touched day (for a moved
+// event both the old and the new day)
+inline CalDiffCount calDiff(const CalSig* prev, int np, const CalSig* cur, int nc,
+                            CalChangeFn fn, void* ctx) {
+  CalDiffCount c = { 0, 0, 0 };
+  int i = 0, j = 0;
+  while (i < np || j < nc) {
+    if (j >= nc || (i < np && prev[i].key < cur[j].key)) {
+      c.removed++; fn(ctx, CAL_REMOVED, prev[i].ymd); i++;
+    } else if (i >= np || cur[j].key < prev[i].key) {
+      c.added++; fn(ctx, CAL_ADDED, cur[j].ymd); j++;
+    } else {
+      if (prev[i].sig != cur[j].sig) {
+        c.changed++;
+        fn(ctx, CAL_CHANGED, prev[i].ymd);
+        if (cur[j].ymd != prev[i].ymd) fn(ctx, CAL_CHANGED, cur[j].ymd);
+      }
+      i++; j++;
+    }
+  }
+  return c;
+}
+
+inline void calSortSigs(CalSig* s, int n) {
+  std::sort(s, s + n, [](const CalSig& a, const CalSig& b) { return a.key < b.key; });
+}
+
+// ---------- One body ----------
+// Where a body comes from: > 0 bytes read, 0 = nothing yet (the source
+// waits a little), < 0 = the connection closed
+typedef int      (*CalReadFn)(void* src, uint8_t* buf, size_t n);
+typedef void     (*CalTeeFn)(void* ctx, const uint8_t* buf, size_t n);
+typedef uint32_t (*CalClockFn)();            // microseconds
+
+struct CalBodyStats { uint32_t bytes, parseUs; bool timedOut; };
+
+// Read `size` bytes (-1: until the server closes) into the parser and the
+// tee, giving up at `deadlineUs`. True when the whole body arrived; the
+// parser is finished then, and left open otherwise.
+inline bool calStreamBody(IcsStream& ics, int size, uint32_t deadlineUs, CalReadFn rd, void* src,
+                          CalTeeFn tee, void* teeCtx, CalClockFn usNow, CalBodyStats& st) {
+  int remaining = size;
+  uint8_t buf[1024];
+  while (remaining != 0) {
+    if ((int32_t)(usNow() - deadlineUs) > 0) { st.timedOut = true; break; }
+    int got = rd(src, buf, sizeof(buf));
+    if (got < 0) break;
+    if (!got) continue;
+    uint32_t t0 = usNow();
+    ics.feed(buf, got);
+    st.parseUs += usNow() - t0;
+    if (tee) tee(teeCtx, buf, got);
+    st.bytes += got;
+    if (remaining > 0) remaining = got >= remaining ? 0 : remaining - got;
+  }
+  bool complete = !st.timedOut && (remaining == 0 || (remaining < 0 && st.bytes > 0));
+  if (complete) ics.finish();
+  return complete;
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <SD.h>
+#include "Perf.h"
+
+static const uint32_t CAL_WORKER_STACK = 16 * 1024;   // TLS handshake runs on it
+
+struct CalFeed {
+  String   url;                // empty: cache only
+  char     cache[24];          // "/calendar1.ics"
+  void*    ctx;                // handed to the line / reset callbacks
+  // Results
+  int      code;               // HTTP code, 0 = not fetched
+  uint32_t bytes, events;
+  uint32_t startUs, fetchMs, parseUs;
+  bool     fromCache, timedOut;
+};
+
+struct CalRun {
+  CalFeed*          feeds;
+  int               n;
+  int               next;
+  portMUX_TYPE      mux;
+  CalLineFn         line;
+  CalResetFn        reset;
+  uint32_t          timeoutMs;
+  SemaphoreHandle_t sd;        // SD is shared by the workers
+  SemaphoreHandle_t done;
+};
+
+inline int calReadWifi(void* src, uint8_t* buf, size_t n) {
+  WiFiClient* s = (WiFiClient*)src;
+  size_t avail = s->available();
+  if (!avail) {
+    if (!s->connected()) return -1;
+    vTaskDelay(pdMS_TO_TICKS(2));
+    return 0;
+  }
+  return s->readBytes(buf, avail < n ? avail : n);
+}
+
+struct CalTee { File* out; SemaphoreHandle_t sd; };
+
+inline void calTeeSd(void* ctx, const uint8_t* buf, size_t n) {
+  CalTee& t = *(CalTee*)ctx;
+  if (!*t.out) return;
+  xSemaphoreTake(t.sd, portMAX_DELAY);
+  t.out->write(buf, n);
+  xSemaphoreGive(t.sd);
+}
+
+inline uint32_t calMicros() { return micros(); }
+
+inline void calParseCache(CalFeed& f, CalRun& r) {
+  IcsStream ics;
+  ics.begin(r.line, f.ctx);
+  uint8_t buf[1024];
+  uint32_t t0 = micros();
+  if (!f.startUs) f.startUs = t0;
+  xSemaphoreTake(r.sd, portMAX_DELAY);
+  File file = SD.open(f.cache, FILE_READ);
+  xSemaphoreGive(r.sd);
+  if (file) {
+    for (;;) {
+      xSemaphoreTake(r.sd, portMAX_DELAY);
+      int got = file.read(buf, sizeof(buf));
+      xSemaphoreGive(r.sd);
+      if (got <= 0) break;
+      ics.feed(buf, got);
+    }
+    xSemaphoreTake(r.sd, portMAX_DELAY);
+    file.close();
+    xSemaphoreGive(r.sd);
+  }
+  ics.finish();
+  f.parseUs = micros() - t0;
+  f.events = ics.events;
+  f.fromCache = true;
+}
+
+// Stream one feed into its parser and a temp cache file; fall back to the
+// previous cache on any failure, timeout or short body
+inline void calFetchOne(CalFeed& f, CalRun& r) {
+  uint32_t start = millis();
+  f.startUs = micros();
+  HTTPClient http;
+  http.useHTTP10(true);                        // no chunking: the stream is the body
+  http.setConnectTimeout(r.timeoutMs);
+  http.setTimeout(r.timeoutMs < 5000 ? r.timeoutMs : 5000);
+  http.begin(f.url);
+  http.addHeader("User-Agent", "PaperS3-Calendar/1.5");
+  f.code = http.GET();
+
+  bool complete = false;
+  if (f.code == HTTP_CODE_OK) {
+    IcsStream ics;
+    ics.begin(r.line, f.ctx);
+    String tmp = String(f.cache) + ".tmp";
+    xSemaphoreTake(r.sd, portMAX_DELAY);
+    File out = SD.open(tmp.c_str(), FILE_WRITE);
+    xSemaphoreGive(r.sd);
+
+    CalTee tee = { &out, r.sd };
+    CalBodyStats st = {};
+    complete = calStreamBody(ics, http.getSize(), f.startUs + r.timeoutMs * 1000, calReadWifi,
+                             http.getStreamPtr(), calTeeSd, &tee, calMicros, st);
+    f.bytes = st.bytes; f.parseUs = st.parseUs; f.timedOut = st.timedOut;
+    if (complete) f.events = ics.events;
+
+    xSemaphoreTake(r.sd, portMAX_DELAY);
+    if (out) out.close();
+    if (complete) { SD.remove(f.cache); SD.rename(tmp.c_str(), f.cache); }
+    else          SD.remove(tmp.c_str());
+    xSemaphoreGive(r.sd);
+  }
+  http.end();
+  f.fetchMs = millis() - start - f.parseUs / 1000;
+
+  if (!complete) {
+    r.reset(f.ctx);
+    f.parseUs = 0;
+    calParseCache(f, r);
+  }
+}
+
+inline void calWorker(void* arg) {
+  CalRun& r = *(CalRun*)arg;
+  for (;;) {
+    portENTER_CRITICAL(&r.mux);
+    int i = r.next++;
+    portEXIT_CRITICAL(&r.mux);
+    if (i >= r.n) break;
+    calFetchOne(r.feeds[i], r);
+  }
+  xSemaphoreGive(r.done);
+  vTaskDelete(NULL);
+}
+
+// Fill every feed's context; returns when all feeds are done. Offline (or
+// with no URL) a feed is parsed from its SD cache.
+inline void calFetchAll(CalFeed* feeds, int n, CalLineFn line, CalResetFn reset,
+                        bool online, uint32_t timeoutMs = 15000) {
+  CalRun r{};
+  r.feeds = feeds; r.n = n; r.next = 0;
+  portMUX_INITIALIZE(&r.mux);
+  r.line = line; r.reset = reset; r.timeoutMs = timeoutMs;
+  r.sd = xSemaphoreCreateMutex();
+  r.done = xSemaphoreCreateCounting(CAL_WORKERS, 0);
+  for (int i = 0; i < n; ++i) {
+    CalFeed& f = feeds[i];
+    f.code = 0; f.bytes = f.events = f.startUs = f.fetchMs = f.parseUs = 0;
+    f.fromCache = f.timedOut = false;
+  }
+
+  uint32_t t0 = millis();
+  int started = 0;
+  if (online) {
+    int want = n < CAL_WORKERS ? n : CAL_WORKERS;
+    for (int k = 0; k < want; ++k)
+      if (xTaskCreate(calWorker, "calfeed", CAL_WORKER_STACK, &r, 1, nullptr) == pdPASS) started++;
+  }
+  if (!started) {
+    // Offline, or no task could be created: one feed at a time right here
+    for (int i = 0; i < n; ++i) {
+      if (online && feeds[i].url.length()) calFetchOne(feeds[i], r);
+      else calParseCache(feeds[i], r);
+    }
+  }
+  // Each worker is bounded by the per-feed deadline (plus connect/read timeouts)
+  for (int k = 0; k < started; ++k) xSemaphoreTake(r.done, portMAX_DELAY);
+  vSemaphoreDelete(r.sd);
+  vSemaphoreDelete(r.done);
+
+  for (int i = 0; i < n; ++i) {
+    const CalFeed& f = feeds[i];
+    Serial.printf("calendar %d: %d%s%s, %lu B, %lu events, fetch %lu ms, parse %lu ms\n",
+                  i + 1, f.code, f.timedOut ? " timeout" : "", f.fromCache ? " (SD cache)" : "",
+                  (unsigned long)f.bytes, (unsigned long)f.events,
+                  (unsigned long)f.fetchMs, (unsigned long)(f.parseUs / 1000));
+    if (f.code) perfLog().span("ics fetch", PERF_NET, f.startUs, f.fetchMs * 1000);
+    perfLog().span("ics parse", PERF_PARSE, f.startUs, f.parseUs);
+  }
+  Serial.printf("calendar: %d feeds in %lu ms\n", n, (unsigned long)(millis() - t0));
+}
+#endif // ARDUINO
+
+#endif // CALFEEDS_H
@@ -4,6 +4,18 @@
 #include "TimeUtil.h"
 #include "Marquee.h"  // for types, not required but safe
 #include "AppState.h"
+#include "WorldClock.h"
+#include "Perf.h"
+#include "CalFeeds.h"
+#include <algorithm>
+
+// Zone table for UTC times; fetchCalendar() builds it before any feed worker runs
+inline const WcTable& calTz(){
+  static WcTable tz;
+  static bool    ready = false;
+  if (!ready) { wcBuild(*wcFind(TZ_ZONE), tz); ready = true; }
+  return tz;
+}
 
 inline void parseICSDateTime(const String& line, bool isEnd, CalendarEvent& ev){
   int p = line.indexOf(':');
@@ -14,6 +26,7 @@ inline void parseICSDateTime(const String& line, bool isEnd, CalendarEvent& ev){
   dt.replace("\r", "");
 
   if (head.indexOf("VALUE=DATE") != -1) {
+    if (isEnd && dt.length() >= 8) ev.endYmd = (uint32_t)dt.substring(0, 8).toInt();
     if (!isEnd) {
       ev.allDay = true;
       if (dt.length() >= 8) {
@@ -53,130 +66,235 @@ inline void parseICSDateTime(const String& line, bool isEnd, CalendarEvent& ev){
       ev.y  = y; ev.m = m; ev.d = d;
       ev.sh = -1; ev.sm = -1;
       ev.eh = -1; ev.em = -1;
+    } else {
+      ev.endYmd = (uint32_t)(y*10000 + m*100 + d);
     }
     return;
   }
 
   if (!hasZ) {
     if (!isEnd) { ev.y = y; ev.m = m; ev.d = d; ev.sh = hh; ev.sm = mm; }
-    else        { ev.eh = hh; ev.em = mm; }
+    else        { ev.eh = hh; ev.em = mm; ev.endYmd = (uint32_t)(y*10000 + m*100 + d); }
     return;
   }
 
-  struct tm tmutc{};
-  tmutc.tm_year = y - 1900;
-  tmutc.tm_mon  = m - 1;
-  tmutc.tm_mday = d;
-  tmutc.tm_hour = hh;
-  tmutc.tm_min  = mm;
-  tmutc.tm_sec  = 0;
-
-  char* prevTZ = getenv("TZ");
-  String prev = prevTZ ? String(prevTZ) : String();
-
-  setenv("TZ", "UTC", 1); tzset();
-  time_t utc_ts = mktime(&tmutc);
-
-  setenv("TZ", TZ_INFO, 1); tzset();
-  struct tm lt = *localtime(&utc_ts);
+  // UTC -> local through the zone's transition table (no TZ swap)
+  WcCivil lt = wcCivil(wcLocalMinute(calTz(), wcEpoch(y, m, d, hh, mm)));
 
   if (!isEnd) {
-    ev.y  = lt.tm_year + 1900;
-    ev.m  = lt.tm_mon + 1;
-    ev.d  = lt.tm_mday;
-    ev.sh = lt.tm_hour;
-    ev.sm = lt.tm_min;
+    ev.y  = lt.year;
+    ev.m  = lt.month;
+    ev.d  = lt.day;
+    ev.sh = lt.hour;
+    ev.sm = lt.min;
   } else {
-    ev.eh = lt.tm_hour;
-    ev.em = lt.tm_min;
+    ev.eh = lt.hour;
+    ev.em = lt.min;
+    ev.endYmd = (uint32_t)(lt.year*10000 + lt.month*100 + lt.day);
   }
+}
+
+// ---------- Calendar feeds ----------
+// Each feed's worker builds its own list from the unfolded lines; the lists
+// are sorted and merged into events[] once every feed is done. Upcoming
+// events past FEED_MAX_EVENTS (per feed and in total) are dropped, latest
+// first; that is months of a busy shared calendar.
+static const int FEED_MAX_EVENTS = 2000;
+
+struct FeedEvents {
+  std::vector<CalendarEvent> list;
+  CalendarEvent cur;
+  bool     inEvent = false;
+  int      depth = 0;            // nested VALARM etc.: their lines are not the event's
+  uint32_t today = 0;            // yyyymmdd; events starting earlier are never drawn
+  uint32_t uid = 0, rid = 0;     // hashes of UID / RECURRENCE-ID
+  bool     hasUid = false;
+};
+
+inline bool eventBefore(const CalendarEvent& a, const CalendarEvent& b){
+  if (a.y != b.y) return a.y < b.y;
+  if (a.m != b.m) return a.m < b.m;
+  if (a.d != b.d) return a.d < b.d;
+  if (a.sh != b.sh) return a.sh < b.sh;
+  return a.sm < b.sm;
+}
 
-  if (prev.length() > 0) { setenv("TZ", prev.c_str(), 1); tzset(); }
-  else                   { setenv("TZ", TZ_INFO, 1);     tzset(); }
+// What a card shows of the event; a change means its day needs a redraw
+inline uint32_t eventSig(const CalendarEvent& ev){
+  uint32_t h = calHash(ev.location.c_str(), calHash(ev.title.c_str()));
+  h = calHashInt(ev.y*10000 + ev.m*100 + ev.d, h);
+  h = calHashInt(((ev.sh*60 + ev.sm)*1440 + ev.eh*60 + ev.em)*2 + ev.allDay, h);
+  h = calHashInt((int32_t)ev.endYmd, h);
+  return h;
 }
 
-inline bool parseAndAddEvents(const String& data, int maxEvents) {
-  int pos = 0;
-  bool success = false;
-  while (pos < data.length() && eventCount < maxEvents) {
-    int s=data.indexOf("BEGIN:VEVENT",pos); if(s<0)break;
-    int e=data.indexOf("END:VEVENT",s); if(e<0)break;
-    String body=data.substring(s,e);
+// "NAME;PARAM=x:value" -> value, if the line is property `name`
+inline const char* icsValue(const char* line, const char* name){
+  size_t n = strlen(name);
+  if (strncmp(line, name, n) || (line[n] != ':' && line[n] != ';')) return nullptr;
+  const char* v = strchr(line + n, ':');
+  return v ? v + 1 : nullptr;
+}
 
+inline bool onIcsLine(void* ctx, const char* line, int /*len*/){
+  FeedEvents& fe = *(FeedEvents*)ctx;
+  if (!fe.inEvent){
+    if (strcmp(line, "BEGIN:VEVENT")) return false;
     CalendarEvent ev;
     ev.title=""; ev.location=""; ev.y=ev.m=ev.d=0;
     ev.sh=ev.sm=-1; ev.eh=ev.em=-1; ev.allDay=false;
-
-    int p=body.indexOf("SUMMARY:");
-    if(p!=-1){
-      int q=body.indexOf("\n",p);
-      ev.title=body.substring(p+8,q);
-      ev.title.trim();
-      ev.title.replace("\r","");
+    ev.key=ev.seq=ev.mod=ev.sig=0; ev.endYmd=0;
+    fe.cur = ev;
+    fe.inEvent = true;
+    fe.depth = 0;
+    fe.uid = fe.rid = 0; fe.hasUid = false;
+    return false;
+  }
+  if (!strcmp(line, "END:VEVENT")){
+    fe.inEvent = false;
+    CalendarEvent& ev = fe.cur;
+    ev.sig = eventSig(ev);
+    // No UID: same title at the same start is the same event
+    ev.key = fe.hasUid ? calHashInt((int32_t)fe.rid, fe.uid)
+                       : calHashInt(ev.y*10000 + ev.m*100 + ev.d, calHashInt(ev.sh*60 + ev.sm, calHash(ev.title.c_str())));
+    if ((uint32_t)(ev.y*10000 + ev.m*100 + ev.d) >= fe.today){
+      fe.list.push_back(ev);
+      // Only the earliest FEED_MAX_EVENTS can be shown: trim as the list grows
+      if ((int)fe.list.size() >= 2*FEED_MAX_EVENTS){
+        std::sort(fe.list.begin(), fe.list.end(), eventBefore);
+        fe.list.resize(FEED_MAX_EVENTS);
+      }
     }
+    return true;
+  }
+  if (!strncmp(line, "BEGIN:", 6)) { fe.depth++; return false; }
+  if (!strncmp(line, "END:", 4))   { if (fe.depth) fe.depth--; return false; }
+  if (fe.depth) return false;
 
-    p=body.indexOf("LOCATION:");
-    if(p!=-1){
-      int q=body.indexOf("\n",p);
-      ev.location=body.substring(p+9,q);
-      ev.location.trim();
-      ev.location.replace("\r","");
-    }
+  const char* v;
+  if ((v = icsValue(line, "SUMMARY")))       { fe.cur.title = v; fe.cur.title.trim(); }
+  else if ((v = icsValue(line, "LOCATION"))) { fe.cur.location = v; fe.cur.location.trim(); }
+  else if (icsValue(line, "DTSTART"))        parseICSDateTime(String(line), false, fe.cur);
+  else if (icsValue(line, "DTEND"))          parseICSDateTime(String(line), true, fe.cur);
+  else if ((v = icsValue(line, "UID")))           { fe.uid = calHash(v); fe.hasUid = true; }
+  else if ((v = icsValue(line, "RECURRENCE-ID"))) fe.rid = calHash(v);
+  else if ((v = icsValue(line, "SEQUENCE")))      fe.cur.seq = strtoul(v, nullptr, 10);
+  else if ((v = icsValue(line, "LAST-MODIFIED"))) fe.cur.mod = calStamp(v);
+  return false;
+}
 
-    p=body.indexOf("DTSTART");
-    if(p!=-1){
-      int q=body.indexOf("\n",p);
-      parseICSDateTime(body.substring(p,q),false,ev);
-    }
+inline void onIcsReset(void* ctx){
+  FeedEvents& fe = *(FeedEvents*)ctx;
+  fe.list.clear();
+  fe.inEvent = false;
+}
 
-    p=body.indexOf("DTEND");
-    if(p!=-1){
-      int q=body.indexOf("\n",p);
-      parseICSDateTime(body.substring(p,q),true,ev);
-    }
+// Visible days touched by a refresh, as a bit per day card
+struct DirtyDays {
+  uint32_t ymd[DAYS_TO_SHOW];
+  uint32_t mask;
+};
 
-    events[eventCount++]=ev;
-    pos=e+10;
-    success = true;
-  }
-  return success;
+inline void markDirtyDay(void* ctx, CalChange, uint32_t ymd){
+  DirtyDays& dd = *(DirtyDays*)ctx;
+  for (int i=0;i<DAYS_TO_SHOW;i++) if (dd.ymd[i] == ymd) dd.mask |= 1u << i;
 }
 
-inline void fetchAndParse(const char* url, const char* filename){
-  if (WiFi.status()!=WL_CONNECTED) return;
-  HTTPClient http;
-  http.begin(url);
-  http.addHeader("User-Agent","PaperS3-Calendar/1.4");
-  int code=http.GET();
-  if (code==HTTP_CODE_OK){
-    String payload=http.getString();
-    File f=SD.open(filename,FILE_WRITE);
-    if(f){ f.print(payload); f.close(); }
-    parseAndAddEvents(payload, 160);
-  } else {
-    File f=SD.open(filename,FILE_READ);
-    if(f){
-      String payload=f.readString();
-      f.close();
-      parseAndAddEvents(payload, 160);
+static std::vector<CalSig> g_calSigs;   // the last refresh, sorted, for the diff
+
+// Refetch (or reload from SD) every feed; returns the day cards whose
+// events changed since the previous call
+inline uint32_t fetchCalendar(){
+  static FeedEvents feedEvents[CAL_MAX_FEEDS];
+  static CalFeed    feeds[CAL_MAX_FEEDS];
+
+  struct tm t{};
+  uint32_t today = readLocal(t) ? (uint32_t)((t.tm_year+1900)*10000 + (t.tm_mon+1)*100 + t.tm_mday) : 0;
+  calTz();                         // build it before the workers share it
+
+  int n = 0;
+  for (int i=0;i<CAL_MAX_FEEDS;i++){
+    if (calendarUrls[i].length() == 0) continue;
+    FeedEvents& fe = feedEvents[n];
+    fe.list.clear(); fe.inEvent = false; fe.today = today;
+    feeds[n].url = calendarUrls[i];
+    snprintf(feeds[n].cache, sizeof(feeds[n].cache), "/calendar%d.ics", i+1);
+    feeds[n].ctx = &fe;
+    n++;
+  }
+  calFetchAll(feeds, n, onIcsLine, onIcsReset, WiFi.status()==WL_CONNECTED);
+
+  // Sort each feed, then merge them in order into events[]
+  PERF_SCOPE("ics merge", PERF_PARSE);
+  for (int k=0;k<n;k++){
+    std::vector<CalendarEvent>& l = feedEvents[k].list;
+    std::stable_sort(l.begin(), l.end(), eventBefore);
+    if ((int)l.size() > FEED_MAX_EVENTS) l.resize(FEED_MAX_EVENTS);
+  }
+
+  // One copy per UID across the feeds: the newest revision wins
+  std::vector<CalRef> refs;
+  for (int k=0;k<n;k++)
+    for (size_t i=0;i<feedEvents[k].list.size();i++){
+      const CalendarEvent& ev = feedEvents[k].list[i];
+      refs.push_back({ ev.key, ev.seq, ev.mod, (uint16_t)k, (uint16_t)i, false });
+    }
+  int dups = calDedupe(refs.data(), (int)refs.size());
+  if (dups){
+    std::vector<uint8_t> drop[CAL_MAX_FEEDS];
+    for (int k=0;k<n;k++) drop[k].assign(feedEvents[k].list.size(), 0);
+    for (const CalRef& r : refs) if (r.drop) drop[r.feed][r.idx] = 1;
+    for (int k=0;k<n;k++){
+      std::vector<CalendarEvent>& l = feedEvents[k].list;
+      size_t w = 0;
+      for (size_t i=0;i<l.size();i++) if (!drop[k][i]) { if (w != i) l[w] = l[i]; w++; }
+      l.resize(w);
     }
   }
-  http.end();
-}
 
-inline void fetchCalendar(){
+  size_t pos[CAL_MAX_FEEDS] = {0}, total = 0;
+  for (int k=0;k<n;k++) total += feedEvents[k].list.size();
+  events.clear();
+  events.reserve(std::min(total, (size_t)FEED_MAX_EVENTS));
   eventCount = 0;
+  while (eventCount < FEED_MAX_EVENTS){
+    int best = -1;
+    for (int k=0;k<n;k++){
+      const std::vector<CalendarEvent>& l = feedEvents[k].list;
+      if (pos[k] < l.size() && (best < 0 || eventBefore(l[pos[k]], feedEvents[best].list[pos[best]]))) best = k;
+    }
+    if (best < 0) break;
+    events.push_back(feedEvents[best].list[pos[best]++]);
+    eventCount++;
+  }
+  for (int k=0;k<n;k++) std::vector<CalendarEvent>().swap(feedEvents[k].list);
 
-  if (calendarUrl.length() > 0) fetchAndParse(calendarUrl.c_str(), "/calendar1.ics");
-  if (calendarUrl2.length() > 0) fetchAndParse(calendarUrl2.c_str(), "/calendar2.ics");
+  // Diff against the previous refresh
+  std::vector<CalSig>& prevSigs = g_calSigs;
+  std::vector<CalSig> sigs(eventCount);
+  for (int i=0;i<eventCount;i++)
+    sigs[i] = { events[i].key, events[i].sig, (uint32_t)(events[i].y*10000 + events[i].m*100 + events[i].d) };
+  calSortSigs(sigs.data(), eventCount);
 
-  for (int i=0;i<eventCount-1;i++)
-    for (int j=0;j<eventCount-i-1;j++){
-      auto&a=events[j]; auto&b=events[j+1];
-      if (a.y!=b.y? a.y>b.y : (a.m!=b.m? a.m>b.m : (a.d!=b.d? a.d>b.d : (a.sh!=b.sh? a.sh>b.sh : a.sm>b.sm)))){
-        auto t=events[j]; events[j]=events[j+1]; events[j+1]=t;
-      }
-    }
+  DirtyDays dd{};
+  for (int i=0;i<DAYS_TO_SHOW;i++){
+    tm dt=t; dt.tm_mday += i; mktime(&dt);
+    dd.ymd[i] = (uint32_t)((dt.tm_year+1900)*10000 + (dt.tm_mon+1)*100 + dt.tm_mday);
+  }
+  CalDiffCount c = calDiff(prevSigs.data(), (int)prevSigs.size(), sigs.data(), eventCount, markDirtyDay, &dd);
+  prevSigs.swap(sigs);
+  if (c.added || c.changed || c.removed) g_eventsRev++;
+  Serial.printf("calendar: %d events, %d duplicates; +%d ~%d -%d, dirty days 0x%02lx\n",
+                eventCount, dups, c.added, c.changed, c.removed, (unsigned long)dd.mask);
+  return dd.mask;
+}
+
+// Events and the last refresh dropped; the next fetchCalendar() starts over
+inline void calendarDrop(){
+  std::vector<CalendarEvent>().swap(events);
+  eventCount = 0;
+  std::vector<CalSig>().swap(g_calSigs);
+  g_eventsRev++;
 }
 
 #endif // CALENDAR_H
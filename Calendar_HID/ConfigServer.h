@@ -0,0 +1,420 @@
+#ifndef CONFIGSERVER_H
+#define CONFIGSERVER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// ---------- Local config server ----------
+// A small HTTP server on the device's own IP. It shows live stats and edits
+// the SD config files, so a watchlist or calendar change no longer means
+// pulling the card and rebooting. Each sketch registers the files it reads,
+// each with a reload hook. A save that changes the file runs only that
+// file's hook, from loop() after the reply has gone out. Nothing else is
+// reloaded.
+//
+//   cfgServe("/Wifi/STOCK.txt", "Watchlist", onWatchlistSaved);
+//   if (net_justConnected()) cfgBegin();     // idempotent
+//   cfgTick();                               // every loop()
+//
+//   GET  /                      index: files, stats link
+//   GET  /stats                 perf stats and memory as JSON
+//   GET  /edit?file=PATH        edit form
+//   GET  /config?file=PATH      raw file
+//   POST /config?file=PATH      replace it (form field "body", or a raw body:
+//                               curl --data-binary @STOCK.txt -H "Content-Type: text/plain" ...)
+//   POST /update url=URL        fetch a firmware patch from URL and restart into
+//                               it (when the sketch registered cfgServeUpdate)
+//
+// Only registered files can be read or written. Every page asks for HTTP
+// basic auth (user "admin") once the sketch has a password from its secrets
+// file (cfgAuth). Without one the server is read-only: saves and /update are
+// refused. Passwords and keys are never sent back as they are; the sketch
+// says where they sit in a file (CfgSecretsFn) and they show as CFG_MASK.
+// The server sleeps along with the radio.
+
+// ---------- Secrets ----------
+// A value shown as CFG_MASK and posted back unchanged keeps what is on the
+// card, so a masked file can be edited and saved as a whole.
+static const char CFG_MASK[] = "********";
+
+// A secret value in a file: bytes [at, at + len), and the name it is matched
+// by when the masked text comes back
+struct CfgSecret { size_t at, len; char name[40]; };
+typedef int (*CfgSecretsFn)(const char* text, size_t n, CfgSecret* out, int max);
+
+inline int cfgAddSecret(CfgSecret* out, int k, int max, size_t at, size_t len, const char* name, size_t nameLen) {
+  if (k >= max) return k;
+  CfgSecret& s = out[k];
+  s.at = at; s.len = len;
+  if (nameLen >= sizeof(s.name)) nameLen = sizeof(s.name) - 1;
+  memcpy(s.name, name, nameLen);
+  s.name[nameLen] = 0;
+  return k + 1;
+}
+
+inline bool cfgHasWord(const char* key, size_t n, const char* word) {
+  size_t w = strlen(word);
+  for (size_t i = 0; i + w <= n; ++i) {
+    size_t j = 0;
+    while (j < w && (key[i + j] & ~0x20) == word[j]) ++j;
+    if (j == w) return true;
+  }
+  return false;
+}
+
+// Passwords, API keys, tokens, and calendar feeds (a private ICS URL is
+// its own key)
+inline bool cfgSecretKey(const char* key, size_t n) {
+  return cfgHasWord(key, n, "PASS") || cfgHasWord(key, n, "KEY") || cfgHasWord(key, n, "TOKEN") ||
+         cfgHasWord(key, n, "SECRET") || (n >= 3 && cfgHasWord(key, 3, "CAL"));
+}
+
+// KEY=value lines, as in secrets.txt
+inline int cfgSecretsKeyValue(const char* text, size_t n, CfgSecret* out, int max) {
+  int k = 0;
+  for (size_t b = 0; b < n;) {
+    size_t e = b;
+    while (e < n && text[e] != '\n') ++e;
+    size_t s = b;
+    while (s < e && (text[s] == ' ' || text[s] == '\t')) ++s;
+    size_t eq = s;
+    while (eq < e && text[eq] != '=') ++eq;
+    if (s < e && text[s] != '#' && eq < e) {
+      size_t ke = eq;
+      while (ke > s && (text[ke - 1] == ' ' || text[ke - 1] == '\t')) --ke;
+      size_t v = eq + 1, ve = e;
+      while (v < ve && (text[v] == ' ' || text[v] == '\t')) ++v;
+      while (ve > v && (text[ve - 1] == '\r' || text[ve - 1] == ' ' || text[ve - 1] == '\t')) --ve;
+      if (cfgSecretKey(text + s, ke - s)) k = cfgAddSecret(out, k, max, v, ve - v, text + s, ke - s);
+    }
+    b = e + 1;
+  }
+  return k;
+}
+
+// WIFI.txt: SSID lines each followed by their password (blank for an open
+// network), then KEY:value lines (APIKEY:, BACKUP:, CFGPASS:, ...)
+inline int cfgSecretsWifiTxt(const char* text, size_t n, CfgSecret* out, int max) {
+  int k = 0;
+  const char* ssid = nullptr;
+  size_t ssidLen = 0;
+  for (size_t b = 0; b < n;) {
+    size_t e = b;
+    while (e < n && text[e] != '\n') ++e;
+    size_t le = e;
+    while (le > b && (text[le - 1] == '\r' || text[le - 1] == ' ')) --le;
+    size_t c = b;
+    while (c < le && text[c] >= 'A' && text[c] <= 'Z') ++c;
+    if (c > b && c < le && text[c] == ':') {
+      k = cfgAddSecret(out, k, max, c + 1, le - c - 1, text + b, c - b);
+      ssid = nullptr;
+    } else if (ssid) {
+      char name[sizeof(out->name)];
+      int m = snprintf(name, sizeof(name), "PASS:%.*s", (int)ssidLen, ssid);
+      k = cfgAddSecret(out, k, max, b, le - b, name, m < (int)sizeof(name) ? (size_t)m : sizeof(name) - 1);
+      ssid = nullptr;
+    } else if (le > b) {
+      ssid = text + b; ssidLen = le - b;
+    }
+    b = e + 1;
+  }
+  return k;
+}
+
+// `text` with every non-empty secret replaced by CFG_MASK
+template <class Str>
+void cfgMaskSecrets(const char* text, size_t n, CfgSecretsFn find, Str& out) {
+  CfgSecret sec[16];
+  int k = find ? find(text, n, sec, 16) : 0;
+  size_t i = 0;
+  for (int j = 0; j <= k; ++j) {
+    size_t stop = j < k ? sec[j].at : n;
+    while (i < stop) out += text[i++];
+    if (j < k && sec[j].len) {
+      for (const char* m = CFG_MASK; *m; ++m) out += *m;
+      i += sec[j].len;
+    }
+  }
+}
+
+// `posted` with each CFG_MASK value put back from `old`, matched by name;
+// a masked value with no match becomes empty. Returns the number restored.
+template <class Str>
+int cfgUnmaskSecrets(const char* posted, size_t pn, const char* old, size_t on, CfgSecretsFn find, Str& out) {
+  CfgSecret ps[16], os[16];
+  int pk = find ? find(posted, pn, ps, 16) : 0;
+  int ok = find ? find(old, on, os, 16) : 0;
+  size_t mlen = sizeof(CFG_MASK) - 1;
+  int restored = 0;
+  size_t i = 0;
+  for (int j = 0; j <= pk; ++j) {
+    size_t stop = j < pk ? ps[j].at : pn;
+    while (i < stop) out += posted[i++];
+    if (j == pk || ps[j].len != mlen || memcmp(posted + ps[j].at, CFG_MASK, mlen)) continue;
+    i += mlen;
+    for (int o = 0; o < ok; ++o) {
+      if (strcmp(os[o].name, ps[j].name)) continue;
+      for (size_t c = 0; c < os[o].len; ++c) out += old[os[o].at + c];
+      restored++;
+      break;
+    }
+  }
+  return restored;
+}
+
+typedef void (*CfgReloadFn)();
+typedef bool (*CfgUpdateFn)(const char* url);   // true: applied, restart
+
+struct CfgFile {
+  const char*  path;
+  const char*  label;
+  CfgReloadFn  reload;
+  CfgSecretsFn secrets;      // null: nothing to mask
+  bool         pending;      // saved, hook not run yet
+};
+
+struct CfgRegistry {
+  static const int MAX = 8;
+  CfgFile file[MAX];
+  int     count = 0;
+
+  bool add(const char* path, const char* label, CfgReloadFn reload, CfgSecretsFn secrets) {
+    if (find(path) || count >= MAX) return false;
+    file[count++] = { path, label, reload, secrets, false };
+    return true;
+  }
+
+  CfgFile* find(const char* path) {
+    for (int i = 0; i < count; ++i) if (!strcmp(file[i].path, path)) return &file[i];
+    return nullptr;
+  }
+};
+
+inline CfgRegistry& cfgFiles() { static CfgRegistry r; return r; }
+
+inline bool cfgServe(const char* path, const char* label, CfgReloadFn reload, CfgSecretsFn secrets = nullptr) {
+  return cfgFiles().add(path, label, reload, secrets);
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WebServer.h>
+#include <SD.h>
+#include "Perf.h"
+
+static WebServer*  g_cfgServer = nullptr;
+static CfgUpdateFn g_cfgUpdate = nullptr;
+static String      g_cfgUpdateUrl;              // queued by POST /update, run from cfgTick()
+static String      g_cfgPass;                   // empty: read-only
+static const char  CFG_USER[] = "admin";
+
+inline void cfgServeUpdate(CfgUpdateFn fn) { g_cfgUpdate = fn; }
+
+// From the sketch's secrets loader; an empty password makes the server read-only
+inline void cfgAuth(const String& pass) { g_cfgPass = pass; }
+
+// Login when there is a password; writes need one. False: reply already sent.
+inline bool cfgAllowed(bool write) {
+  if (!g_cfgPass.length()) {
+    if (!write) return true;
+    g_cfgServer->send(403, "text/plain", "read-only: set a config password on the SD card first\n");
+    return false;
+  }
+  if (g_cfgServer->authenticate(CFG_USER, g_cfgPass.c_str())) return true;
+  g_cfgServer->requestAuthentication(BASIC_AUTH, "PaperS3");
+  return false;
+}
+
+inline String cfgReadFile(const char* path) {
+  File f = SD.open(path, FILE_READ);
+  if (!f) return String();
+  String s = f.readString();
+  f.close();
+  return s;
+}
+
+// Write through a temp file so a failed write leaves the old config intact
+inline bool cfgWriteFile(const char* path, const String& body) {
+  String tmp = String(path) + ".tmp";
+  SD.remove(tmp.c_str());
+  File f = SD.open(tmp.c_str(), FILE_WRITE);
+  if (!f) return false;
+  size_t n = f.print(body);
+  f.close();
+  if (n != body.length()) { SD.remove(tmp.c_str()); return false; }
+  SD.remove(path);
+  return SD.rename(tmp.c_str(), path);
+}
+
+// What is shown of a file: its secrets masked
+inline String cfgShownFile(const CfgFile* f) {
+  String s = cfgReadFile(f->path);
+  if (!f->secrets) return s;
+  String out;
+  out.reserve(s.length());
+  cfgMaskSecrets(s.c_str(), s.length(), f->secrets, out);
+  return out;
+}
+
+inline String cfgHtmlEscape(const String& s) {
+  String out;
+  out.reserve(s.length() + 16);
+  for (size_t i = 0; i < s.length(); ++i) {
+    char c = s[i];
+    if (c == '&')      out += "&amp;";
+    else if (c == '<') out += "&lt;";
+    else if (c == '>') out += "&gt;";
+    else if (c == '"') out += "&quot;";
+    else               out += c;
+  }
+  return out;
+}
+
+// Registered file named by ?file=, or a 404 already sent
+inline CfgFile* cfgArgFile() {
+  CfgFile* f = cfgFiles().find(g_cfgServer->arg("file").c_str());
+  if (!f) g_cfgServer->send(404, "text/plain", "not a config file\n");
+  return f;
+}
+
+inline void cfgHandleIndex() {
+  if (!cfgAllowed(false)) return;
+  CfgRegistry& r = cfgFiles();
+  String html = F("<!DOCTYPE html><html><head><meta name=viewport content='width=device-width'>"
+                  "<title>PaperS3</title></head><body><h2>PaperS3 config</h2><ul>");
+  for (int i = 0; i < r.count; ++i) {
+    html += "<li><a href='/edit?file="; html += r.file[i].path; html += "'>";
+    html += r.file[i].label; html += "</a> <small>"; html += r.file[i].path; html += "</small></li>";
+  }
+  html += F("</ul><p><a href='/stats'>stats</a></p>");
+  if (!g_cfgPass.length())
+    html += F("<p>Read-only: saving and updates need a config password in the secrets file.</p>");
+  else if (g_cfgUpdate)
+    html += F("<form method=post action='/update'>Firmware patch URL <input name=url size=40> "
+              "<input type=submit value=Update></form>");
+  html += F("</body></html>");
+  g_cfgServer->send(200, "text/html", html);
+}
+
+inline void cfgHandleStats() {
+  if (!cfgAllowed(false)) return;
+  PerfLog& p = perfLog();
+  perfMem();
+  String js = "{\"uptimeMs\":" + String(millis());
+  js += ",\"heapFree\":" + String(p.heapFree) + ",\"heapLow\":" + String(p.heapMin);
+  js += ",\"psramFree\":" + String(p.psramFree) + ",\"psramLow\":" + String(p.psramMin);
+  js += ",\"rssi\":" + String(WiFi.RSSI()) + ",\"stats\":[";
+  for (int i = 0; i < p.nstat; ++i) {
+    const PerfStat& s = p.stat[i];
+    if (i) js += ",";
+    js += "{\"name\":\""; js += s.name; js += "\",\"cat\":\""; js += perfCatName(s.cat);
+    js += "\",\"n\":" + String(s.n) + ",\"totalUs\":" + String((unsigned long long)s.totalUs);
+    js += ",\"maxUs\":" + String(s.maxUs) + ",\"lastUs\":" + String(s.lastUs) + "}";
+  }
+  js += "]}";
+  g_cfgServer->send(200, "application/json", js);
+}
+
+inline void cfgHandleEdit() {
+  if (!cfgAllowed(false)) return;
+  CfgFile* f = cfgArgFile();
+  if (!f) return;
+  String html = F("<!DOCTYPE html><html><head><meta name=viewport content='width=device-width'>"
+                  "<title>PaperS3</title></head><body><h3>");
+  html += f->label; html += " <small>"; html += f->path; html += "</small></h3>";
+  html += "<form method=post action='/config?file="; html += f->path; html += "'>";
+  html += "<textarea name=body rows=24 cols=60>";
+  html += cfgHtmlEscape(cfgShownFile(f));
+  html += F("</textarea><br><input type=submit value=Save> <a href='/'>back</a></form></body></html>");
+  g_cfgServer->send(200, "text/html", html);
+}
+
+inline void cfgHandleGet() {
+  if (!cfgAllowed(false)) return;
+  CfgFile* f = cfgArgFile();
+  if (!f) return;
+  g_cfgServer->send(200, "text/plain", cfgShownFile(f));
+}
+
+inline void cfgHandlePost() {
+  if (!cfgAllowed(true)) return;
+  CfgFile* f = cfgArgFile();
+  if (!f) return;
+  bool form = g_cfgServer->hasArg("body");
+  if (!form && !g_cfgServer->hasArg("plain")) { g_cfgServer->send(400, "text/plain", "no body\n"); return; }
+  String body = g_cfgServer->arg(form ? "body" : "plain");
+  body.replace("\r\n", "\n");                 // textareas post CRLF
+
+  String old = cfgReadFile(f->path);
+  if (f->secrets) {
+    String full;
+    full.reserve(body.length() + 64);
+    cfgUnmaskSecrets(body.c_str(), body.length(), old.c_str(), old.length(), f->secrets, full);
+    body = full;
+  }
+  const char* result = "unchanged";          // re-saving the same text reloads nothing
+  if (old != body) {
+    if (!cfgWriteFile(f->path, body)) { g_cfgServer->send(500, "text/plain", "SD write failed\n"); return; }
+    f->pending = true;
+    result = "saved";
+  }
+  Serial.printf("config: %s %s (%u B)\n", f->path, result, (unsigned)body.length());
+  if (form) {
+    g_cfgServer->sendHeader("Location", String("/edit?file=") + f->path);
+    g_cfgServer->send(303, "text/plain", result);
+  } else {
+    g_cfgServer->send(200, "text/plain", String(result) + "\n");
+  }
+}
+
+inline void cfgHandleUpdate() {
+  if (!cfgAllowed(true)) return;
+  if (!g_cfgUpdate) { g_cfgServer->send(404, "text/plain", "updates not enabled\n"); return; }
+  String url = g_cfgServer->arg("url");
+  if (!url.startsWith("http://") && !url.startsWith("https://")) { g_cfgServer->send(400, "text/plain", "no url\n"); return; }
+  g_cfgUpdateUrl = url;
+  Serial.printf("config: update from %s queued\n", url.c_str());
+  g_cfgServer->send(202, "text/plain", "updating; the device restarts when the patch is applied\n");
+}
+
+inline void cfgBegin(uint16_t port = 80) {
+  if (!g_cfgServer) {
+    g_cfgServer = new WebServer(port);
+    g_cfgServer->on("/", HTTP_GET, cfgHandleIndex);
+    g_cfgServer->on("/stats", HTTP_GET, cfgHandleStats);
+    g_cfgServer->on("/edit", HTTP_GET, cfgHandleEdit);
+    g_cfgServer->on("/config", HTTP_GET, cfgHandleGet);
+    g_cfgServer->on("/config", HTTP_POST, cfgHandlePost);
+    g_cfgServer->on("/update", HTTP_POST, cfgHandleUpdate);
+    g_cfgServer->onNotFound([] { g_cfgServer->send(404, "text/plain", "not found\n"); });
+    g_cfgServer->begin();
+  }
+  Serial.printf("config: http://%s/\n", WiFi.localIP().toString().c_str());
+}
+
+// Serve pending requests, then run the reload hooks of files saved since
+// and a queued update
+inline void cfgTick() {
+  if (!g_cfgServer) return;
+  g_cfgServer->handleClient();
+  CfgRegistry& r = cfgFiles();
+  for (int i = 0; i < r.count; ++i) {
+    CfgFile& f = r.file[i];
+    if (!f.pending) continue;
+    f.pending = false;
+    PERF_SCOPE("config reload", PERF_TICK);
+    Serial.printf("config: reloading %s\n", f.path);
+    if (f.reload) f.reload();
+  }
+  if (g_cfgUpdateUrl.length()) {
+    String url = g_cfgUpdateUrl;
+    g_cfgUpdateUrl = "";
+    if (g_cfgUpdate(url.c_str())) { Serial.println("config: update applied, restarting"); delay(200); ESP.restart(); }
+  }
+}
+#endif // ARDUINO
+
+#endif // CONFIGSERVER_H
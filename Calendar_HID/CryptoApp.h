@@ -0,0 +1,634 @@
+#ifndef CRYPTOAPP_H
+#define CRYPTOAPP_H
+
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <strings.h>
+#include <M5Unified.h>
+#include <SD.h>
+#include "WiFiManager.h"
+#include "TouchInput.h"
+#include "InstrumentTable.h"
+#include "WatchGrid.h"
+#include "GrayRender.h"
+#include "QuoteDecode.h"
+#include "KvCache.h"
+#include "FieldView.h"
+#include "PollPolicy.h"
+#include "AlertEngine.h"
+#include "AlarmAudio.h"
+#include "LastKnown.h"
+#include "WorldClock.h"
+#include "Perf.h"
+
+// ---------- Stocks app ----------
+// The watchlist menu and detail view, driven by the app host (AppHost.h).
+// M5_PaperS3_CryptoStock_V2 runs it as its home app; Calendar_HID opens it
+// from the calendar header. Everything it keeps lives in one CryptoState on
+// the heap:
+//   crypto_init()      the tables and caches, the watchlist and alerts from SD
+//   crypto_resume()    the page cache, then the menu
+//   crypto_tick()      touch, the selected quote, name/news, the alert banner;
+//                      false once the exit button is tapped
+//   crypto_suspend()   page cache and headlines freed, quotes kept
+//   crypto_teardown()  the whole state freed
+// The watchlist and alerts are /Wifi/STOCK.txt and /Wifi/ALERTS.txt. The
+// API keys come from wherever the sketch keeps them, through g_cryptoCfg.
+
+static const int CX_BTN_W = 200, CX_BTN_H = 50, CX_GAP_X = 20, CX_GAP_Y = 12;
+static const int CX_LEFT = 40, CX_TOP = 60, CX_COLS = 4;
+static const int CX_ROWS = (540 - CX_TOP - 100) / (CX_BTN_H + CX_GAP_Y);
+static const int CX_PAGE_Y = CX_TOP + CX_ROWS * (CX_BTN_H + CX_GAP_Y) + 4;
+static const int CX_PAGE_W = 70, CX_PAGE_H = 40;
+static const int CX_RET_Y = 440;                       // Return on the detail view
+static const int CX_BANNER_X = 560, CX_BANNER_W = 400;
+static const uint32_t CX_BANNER_MS = 60000;
+static const size_t   CX_NEWS_SHOWN = 2;
+static const uint32_t CX_PROFILE_TTL_S = 30 * 86400;
+static const uint32_t CX_NEWS_TTL_S    = 30 * 60;
+static const char*    CX_COINDESK_MARKET = "cadli";
+
+static const GridLayout CX_GRID = { CX_LEFT, CX_TOP, CX_BTN_W, CX_BTN_H,
+                                    CX_BTN_W + CX_GAP_X, CX_BTN_H + CX_GAP_Y, CX_COLS, CX_ROWS };
+
+// What the sketch supplies before the first open
+struct CryptoConfig {
+  const char* zone = "America/New_York";   // top bar clock (WorldClock.h key)
+  const char* exitLabel = "Home";          // the menu button that leaves the app
+  String finnhubKey, finnhubBackupKey;     // backups are tried when a call fails
+  String coindeskKey, coindeskBackupKey;
+};
+
+static CryptoConfig g_cryptoCfg;
+
+enum CryptoView : uint8_t { CX_MENU, CX_DETAIL };
+enum CryptoField { CF_PRICE, CF_HIGH, CF_LOW, CF_OPEN, CF_PREV, CF_CHANGE, CF_VOLUME, CF_COUNT };
+
+struct CryptoState {
+  InstrumentTable instr;
+  PollState       poll[InstrumentTable::CAP];
+  AlertBook       alerts;
+  KvCache         kv;                   // company names, today's headlines
+  LastKnown       last;                 // last good quote per symbol
+  WcTable         tz;                   // top bar clock
+  GridPageCache   pages;
+  FieldWidget     field[CF_COUNT], stale;
+  FlushStats      flush;
+  std::vector<String> news;
+  uint8_t  view = CX_MENU;
+  int      page = 0, selected = 0;
+  int      quotePending = -1, extrasPending = -1;
+  int32_t  shownMinute = -1;
+  uint32_t shownMs = 0;                 // touches older than this belong to the last view
+  char     banner[48] = "";
+  uint32_t bannerUntil = 0;
+  epd_mode_t epdMode = epd_mode_t::epd_fastest;   // the host's, put back on suspend
+};
+
+static CryptoState* g_crypto = nullptr;
+
+// ---------- Formatting ----------
+// Commas in the integer part of a decimal string
+inline String cryptoCommas(const String& s){
+  int dot = s.indexOf('.');
+  int end = dot < 0 ? s.length() : dot;
+  int start = s.startsWith("-") ? 1 : 0;
+  String out;
+  int cnt = 0;
+  for (int i = end - 1; i >= start; --i){
+    out = String(s[i]) + out;
+    if (++cnt == 3 && i > start){ out = "," + out; cnt = 0; }
+  }
+  return s.substring(0, start) + out + (dot < 0 ? String() : s.substring(dot));
+}
+
+inline String cryptoMoney(double v, bool crypto){ return "$" + cryptoCommas(String(v, crypto ? 5 : 2)); }
+
+inline String cryptoWhole(double v){
+  long long n = (long long)(v + (v >= 0 ? 0.5 : -0.5));
+  return cryptoCommas(String(n));
+}
+
+inline void cryptoButton(int x, int y, int w, int h, const char* label, uint16_t bg, uint16_t fg){
+  M5.Display.fillRoundRect(x, y, w, h, 25, bg);
+  M5.Display.setTextColor(fg);
+  M5.Display.setCursor(x + (w - M5.Display.textWidth(label)) / 2, y + (h + M5.Display.fontHeight()) / 4 - 9);
+  M5.Display.print(label);
+}
+
+// The exit button, bottom right of the menu
+inline void cryptoExitRect(int& x, int& y, int& w, int& h){
+  w = CX_BTN_W; h = CX_BTN_H;
+  x = 960 - CX_LEFT - w;
+  y = 540 - h - 24;
+}
+
+// ---------- SD ----------
+// /Wifi/STOCK.txt, one symbol per line, sorted case-insensitively; quotes
+// start from the last known ones so views never open on zeros
+inline void cryptoLoadWatchlist(){
+  CryptoState& c = *g_crypto;
+  std::vector<String> items;
+  File f = SD.open("/Wifi/STOCK.txt");
+  while (f && f.available() && items.size() < (size_t)InstrumentTable::CAP){
+    String sym = f.readStringUntil('\n'); sym.trim();
+    if (sym.length()) items.push_back(sym);
+  }
+  if (f) f.close();
+  std::sort(items.begin(), items.end(), [](const String& a, const String& b){ return strcasecmp(a.c_str(), b.c_str()) < 0; });
+
+  c.instr.clear();
+  for (PollState& p : c.poll) pollReset(p);
+  for (const String& s : items)
+    if (c.instr.add(s.c_str()) < 0) Serial.printf("stocks: skipping %s\n", s.c_str());
+  for (int id = 0; id < c.instr.count; ++id){
+    Quote q; uint32_t at;
+    if (!c.last.get(LK_QUOTE, c.instr.symbol[id], &q, sizeof(q), &at)) continue;
+    c.instr.setQuote(id, q.price, q.high, q.low, q.open, q.prevClose, q.changePct, q.volume, at);
+    c.instr.clean(id);
+  }
+  c.page = 0;
+  c.pages.invalidate();
+  alertsLoadFromSD(c.alerts, c.instr);
+}
+
+// ---------- Top bar ----------
+inline void cryptoTopBar(){
+  CryptoState& c = *g_crypto;
+  static const char* DAYS[]   = { "Sun","Mon","Tue","Wed","Thu","Fri","Sat" };
+  static const char* MONTHS[] = { "Jan","Feb","Mar","Apr","May","Jun","Jul","Aug","Sep","Oct","Nov","Dec" };
+  M5.Display.fillRect(0, 0, 960, 30, WHITE);
+  M5.Display.setTextColor(BLACK);
+  M5.Display.setCursor(10, 5);
+  M5.Display.printf("Battery: %d%%", M5.Power.getBatteryLevel());
+  time_t now = time(nullptr);
+  M5.Display.setCursor(300, 5);
+  if (now < 1700000000) M5.Display.print("    --");
+  else {
+    c.shownMinute = wcLocalMinute(c.tz, (uint32_t)now);
+    WcCivil t = wcCivil(c.shownMinute);
+    M5.Display.printf("    %s %s %2d %02d:%02d %s", DAYS[t.wday], MONTHS[t.month - 1], t.day,
+                      (t.hour + 11) % 12 + 1, t.min, t.hour < 12 ? "AM" : "PM");
+  }
+  if (c.banner[0]){ M5.Display.setCursor(CX_BANNER_X, 5); M5.Display.print(c.banner); }
+}
+
+// Alert text alone, flushed with a fast update
+inline void cryptoBanner(){
+  CryptoState& c = *g_crypto;
+  auto prev = M5.Display.getEpdMode();
+  M5.Display.setEpdMode(epd_mode_t::epd_fast);
+  M5.Display.fillRect(CX_BANNER_X, 0, CX_BANNER_W, 30, WHITE);
+  if (c.banner[0]){
+    M5.Display.setTextColor(BLACK);
+    M5.Display.setCursor(CX_BANNER_X, 5);
+    M5.Display.print(c.banner);
+  }
+  M5.Display.display(CX_BANNER_X, 0, CX_BANNER_W, 30);
+  M5.Display.setEpdMode(prev);
+}
+
+inline void cryptoCheckAlerts(int id, float price, float changePct){
+  CryptoState& c = *g_crypto;
+  AlertHit hits[4];
+  int n = c.alerts.onQuote(id, price, changePct, hits, 4);
+  if (!n) return;
+  for (int i = 0; i < n; ++i)
+    Serial.printf("alert %s %s %g: %g\n", c.instr.symbol[id], alertKindName(hits[i].kind), hits[i].level, hits[i].value);
+  const AlertHit& h = hits[n - 1];
+  if (h.kind == ALERT_MOVE) snprintf(c.banner, sizeof(c.banner), "! %s %+.1f%%", c.instr.label[id], h.value);
+  else snprintf(c.banner, sizeof(c.banner), "! %s %s %g", c.instr.label[id], h.dir > 0 ? "^" : "v", h.level);
+  c.bannerUntil = millis() + CX_BANNER_MS;
+  cryptoBanner();
+  if (!audio_busy()) audio_play(TONE_CHIME, 3, 2);
+}
+
+// ---------- Menu ----------
+inline void cryptoMenuCell(LovyanGFX& g, int i, int x, int y, int w, int h){
+  InstrumentTable& t = g_crypto->instr;
+  bool sel = i == g_crypto->selected;
+  g.fillRoundRect(x, y, w, h, 25, sel ? BLACK : GRAY_LIGHT);
+  if (!sel) g.drawRoundRect(x, y, w, h, 25, BLACK);   // the fill packs to white at 1 bpp
+  g.setTextColor(sel ? WHITE : BLACK);
+  if (!t.labelW[i]) t.labelW[i] = g.textWidth(t.label[i]);
+  g.setCursor(x + (w - t.labelW[i]) / 2, y + (h + g.fontHeight()) / 3 - 9);
+  g.print(t.label[i]);
+}
+
+// "<  2/5  >" under the grid, only with more than one page
+inline void cryptoPageControls(){
+  CryptoState& c = *g_crypto;
+  int pages = CX_GRID.pageCount(c.instr.count);
+  M5.Display.fillRect(CX_LEFT, CX_PAGE_Y, 3 * CX_PAGE_W + 40, CX_PAGE_H, WHITE);
+  if (pages <= 1) return;
+  cryptoButton(CX_LEFT, CX_PAGE_Y, CX_PAGE_W, CX_PAGE_H, "<", c.page > 0 ? BLACK : GRAY_LIGHT, WHITE);
+  cryptoButton(CX_LEFT + 2 * CX_PAGE_W + 40, CX_PAGE_Y, CX_PAGE_W, CX_PAGE_H, ">",
+               c.page + 1 < pages ? BLACK : GRAY_LIGHT, WHITE);
+  M5.Display.setTextColor(BLACK);
+  M5.Display.setCursor(CX_LEFT + CX_PAGE_W + 28, CX_PAGE_Y + 10);
+  M5.Display.printf("%d/%d", c.page + 1, pages);
+}
+
+inline void cryptoShowPage(int page){
+  CryptoState& c = *g_crypto;
+  if (page < 0 || page >= CX_GRID.pageCount(c.instr.count)) return;
+  c.page = page;
+  c.pages.show(CX_GRID, page, c.instr.count, cryptoMenuCell);
+  cryptoPageControls();
+  c.pages.prefetch(CX_GRID, page, c.instr.count, cryptoMenuCell);
+}
+
+inline void cryptoDrawMenu(){
+  PERF_SCOPE("drawMenu", PERF_RENDER);
+  CryptoState& c = *g_crypto;
+  M5.Display.setFont(&fonts::FreeMonoBold12pt7b);
+  M5.Display.setTextSize(1);
+  c.view = CX_MENU;
+  c.shownMs = millis();
+  M5.Display.clear();
+  cryptoTopBar();
+  cryptoShowPage(CX_GRID.pageOf(c.selected));
+
+  M5.Display.setTextColor(BLACK);
+  M5.Display.setCursor(10, 500);
+  if (c.instr.count)
+    M5.Display.print("Touch stock/crypto to view.\n                                            Programmed By: Javicar31");
+  else M5.Display.print("No symbols in /Wifi/STOCK.txt");
+
+  int x, y, w, h; cryptoExitRect(x, y, w, h);
+  M5.Display.fillRoundRect(x, y, w, h, 25, GRAY_LIGHT);
+  M5.Display.drawRoundRect(x, y, w, h, 25, BLACK);
+  M5.Display.setTextColor(BLACK);
+  const char* label = g_cryptoCfg.exitLabel;
+  M5.Display.setCursor(x + (w - M5.Display.textWidth(label)) / 2, y + (h + M5.Display.fontHeight()) / 3 - 9);
+  M5.Display.print(label);
+}
+
+// ---------- Detail ----------
+inline void cryptoDateKey(char* buf, size_t n){
+  time_t now = time(nullptr);
+  struct tm lt; localtime_r(&now, &lt);
+  strftime(buf, n, "%Y-%m-%d", &lt);
+}
+
+// Headlines are cached joined with \x1e, which never appears in one
+inline String cryptoJoinNews(const std::vector<String>& v){
+  String out;
+  for (size_t i = 0; i < v.size(); ++i){ if (i) out += '\x1e'; out += v[i]; }
+  return out;
+}
+
+inline void cryptoSplitNews(const String& s, std::vector<String>& out){
+  out.clear();
+  int start = 0;
+  while (start < (int)s.length()){
+    int sep = s.indexOf('\x1e', start);
+    if (sep < 0) sep = s.length();
+    out.push_back(s.substring(start, sep));
+    start = sep + 1;
+  }
+}
+
+// false = missing or stale, refresh it
+inline bool cryptoCachedName(int id, String& name){
+  CryptoState& c = *g_crypto;
+  if (c.instr.isCrypto(id)){ name = c.instr.label[id]; return true; }
+  char key[KvCache::KEY_LEN];
+  snprintf(key, sizeof(key), "P:%s", c.instr.symbol[id]);
+  KvResult r = c.kv.get(key, name, (uint32_t)time(nullptr));
+  if (r == KV_MISS) name = c.instr.symbol[id];
+  return r == KV_FRESH;
+}
+
+inline bool cryptoCachedNews(int id){
+  CryptoState& c = *g_crypto;
+  char key[KvCache::KEY_LEN], day[11];
+  cryptoDateKey(day, sizeof(day));
+  snprintf(key, sizeof(key), "N:%s:%s", c.instr.symbol[id], day);
+  String joined;
+  KvResult r = c.kv.get(key, joined, (uint32_t)time(nullptr));
+  if (r == KV_MISS) c.news.clear();
+  else cryptoSplitNews(joined, c.news);
+  return r == KV_FRESH;
+}
+
+inline void cryptoDrawName(int id, const String& name){
+  M5.Display.fillRect(30, 50, 930, 24, WHITE);
+  M5.Display.setTextColor(BLACK);
+  M5.Display.setCursor(30, 50);
+  M5.Display.printf("%s (%s)", name.c_str(), g_crypto->instr.symbol[id]);
+}
+
+inline void cryptoDrawNews(){
+  const int newsX = 390, newsY = 50 + M5.Display.fontHeight() + 10;
+  const int newsW = 960 - newsX - 10, lineH = 20;
+  M5.Display.fillRect(newsX, newsY, 960 - newsX, CX_RET_Y - newsY, WHITE);
+  M5.Display.setTextColor(BLACK);
+  M5.Display.setCursor(newsX, newsY);
+  M5.Display.print("Latest News:");
+  int y = newsY + lineH;
+  for (size_t n = 0; n < CX_NEWS_SHOWN && n < g_crypto->news.size(); ++n){
+    const String& head = g_crypto->news[n];
+    String line, word;
+    for (size_t i = 0; i < head.length(); ++i){
+      char ch = head[i];
+      bool last = i == head.length() - 1;
+      if (ch != ' ' && !last){ word += ch; continue; }
+      if (ch != ' ') word += ch;
+      String test = line + (line.length() ? " " : "") + word;
+      if (M5.Display.textWidth(test) > newsW){
+        M5.Display.setCursor(newsX, y); M5.Display.print(line);
+        y += lineH; line = word;
+      } else line = test;
+      word = "";
+    }
+    if (line.length()){ M5.Display.setCursor(newsX, y); M5.Display.print(line); y += lineH; }
+    y += 15;
+  }
+}
+
+// "Price       : $1,234.56" etc.; "--" before the first quote
+inline void cryptoFieldText(int id, int f, char* buf, size_t n){
+  static const char* LABELS[CF_COUNT] = {
+    "Price       : ", "High        : ", "Low         : ", "Open        : ",
+    "Prev Close  : ", "Change %    : ", "Volume      : " };
+  const InstrumentTable& t = g_crypto->instr;
+  if (!t.updated[id]){ snprintf(buf, n, "%s--", LABELS[f]); return; }
+  bool cr = t.isCrypto(id);
+  String v;
+  switch (f){
+    case CF_PRICE:  v = cryptoMoney(t.price[id], cr);     break;
+    case CF_HIGH:   v = cryptoMoney(t.high[id], cr);      break;
+    case CF_LOW:    v = cryptoMoney(t.low[id], cr);       break;
+    case CF_OPEN:   v = cryptoMoney(t.open[id], cr);      break;
+    case CF_PREV:   v = cryptoMoney(t.prevClose[id], cr); break;
+    case CF_CHANGE: v = String(t.change[id], 4) + "%";    break;
+    case CF_VOLUME: v = cryptoWhole(t.volume[id]);        break;
+  }
+  snprintf(buf, n, "%s%s", LABELS[f], v.c_str());
+}
+
+// Empty while the quote is current; otherwise when it was last good
+inline void cryptoStaleText(int id, char* buf, size_t n){
+  buf[0] = 0;
+  uint32_t at = g_crypto->instr.updated[id], now = (uint32_t)time(nullptr);
+  if (!at) return;
+  if (net_isUp() && now - at <= g_crypto->poll[id].interval + 60) return;   // one missed poll
+  char since[24];
+  lkStaleLabel(since, sizeof(since), at);
+  snprintf(buf, n, "[stale %s]", since);
+}
+
+// Repaint the fields whose text changed; flush = false while the whole view is drawn
+inline void cryptoDrawFields(int id, bool flush){
+  CryptoState& c = *g_crypto;
+  c.flush.begin();
+  char text[40];
+  for (int f = 0; f < CF_COUNT; ++f){
+    cryptoFieldText(id, f, text, sizeof(text));
+    fieldShow(c.field[f], text, c.flush, flush);
+  }
+  cryptoStaleText(id, text, sizeof(text));
+  fieldShow(c.stale, text, c.flush, flush);
+  if (!flush || !c.flush.rects) return;
+  Serial.printf("detail: %u rects, %lu px flushed (%u/%u to full refresh)\n",
+                c.flush.rects, (unsigned long)c.flush.pixels, c.flush.sinceClean, FlushStats::GHOST_EVERY);
+  if (c.flush.ghostDue()) fieldsCleanRefresh(c.flush);
+}
+
+inline void cryptoDrawDetail(int id){
+  PERF_SCOPE("drawDetail", PERF_RENDER);
+  CryptoState& c = *g_crypto;
+  M5.Display.setFont(&fonts::FreeMonoBold12pt7b);
+  M5.Display.setTextSize(1);
+  if (c.view != CX_DETAIL) c.shownMs = millis();
+  c.view = CX_DETAIL;
+  M5.Display.clear();
+  cryptoTopBar();
+  c.flush.sinceClean = 0;
+
+  // Name and headlines from the cache; tick() fetches what is missing or stale
+  bool cr = c.instr.isCrypto(id);
+  String name;
+  bool fresh = cryptoCachedName(id, name);
+  if (!cr) fresh = cryptoCachedNews(id) && fresh;
+  if (!fresh) c.extrasPending = id;
+  cryptoDrawName(id, name);
+
+  for (int f = 0; f < CF_COUNT; ++f) fieldReset(c.field[f], 30, 100 + 30 * f, 340, 24);
+  fieldReset(c.stale, 30, 100 + 30 * CF_COUNT, 340, 24);
+  cryptoDrawFields(id, false);
+  c.instr.clean(id);
+  if (!c.instr.updated[id] || (uint32_t)time(nullptr) >= c.poll[id].nextAt) c.quotePending = id;
+
+  if (!cr) cryptoDrawNews();
+  int w = M5.Display.textWidth("Return") + 60;
+  cryptoButton(30, CX_RET_Y, w, 50, "Return", BLACK, WHITE);
+}
+
+// ---------- Network ----------
+// Finnhub with the backup key on failure; Coindesk the same for crypto
+inline Quote cryptoFetchQuote(int id){
+  const char* sym = g_crypto->instr.symbol[id];
+  const CryptoConfig& k = g_cryptoCfg;
+  Quote q{};
+  if (g_crypto->instr.isCrypto(id)){
+    auto url = [&](const String& key){
+      return String("https://data-api.coindesk.com/index/cc/v1/latest/tick?market=") + CX_COINDESK_MARKET +
+             "&instruments=" + sym + "&apply_mapping=true&api_key=" + key;
+    };
+    if (decodeCoindeskTick(url(k.coindeskKey), sym, q) != 200 && k.coindeskBackupKey.length()){
+      q = Quote{};
+      decodeCoindeskTick(url(k.coindeskBackupKey), sym, q);
+    }
+    return q;
+  }
+  String url = String("https://finnhub.io/api/v1/quote?symbol=") + sym + "&token=";
+  if (decodeFinnhubQuote(url + k.finnhubKey, q) != 200 && k.finnhubBackupKey.length()){
+    q = Quote{};
+    decodeFinnhubQuote(url + k.finnhubBackupKey, q);
+  }
+  if (q.price == 0.0f) return q;
+
+  // Today's volume from the daily candle
+  time_t now = time(nullptr);
+  struct tm lt; localtime_r(&now, &lt);
+  lt.tm_hour = 0; lt.tm_min = 0; lt.tm_sec = 0;
+  time_t day0 = mktime(&lt);
+  String candle = String("https://finnhub.io/api/v1/stock/candle?symbol=") + sym + "&resolution=D&from=" +
+                  String((uint32_t)day0) + "&to=" + String((uint32_t)(day0 + 86399)) + "&token=";
+  if (decodeFinnhubLastVolume(candle + k.finnhubKey, q.volume) != 200 && k.finnhubBackupKey.length())
+    decodeFinnhubLastVolume(candle + k.finnhubBackupKey, q.volume);
+  return q;
+}
+
+// Fetch the selected quote and redraw only the fields that moved
+inline void cryptoRefreshQuote(int id){
+  CryptoState& c = *g_crypto;
+  Quote q = cryptoFetchQuote(id);
+  uint32_t now = (uint32_t)time(nullptr);
+  bool cr = c.instr.isCrypto(id);
+  if (q.price == 0.0f){               // both keys failed; keep what is on screen
+    c.poll[id].nextAt = now + POLL_FIXED_S;
+    cryptoDrawFields(id, true);       // badge it as stale
+    return;
+  }
+  c.instr.setQuote(id, q.price, q.high, q.low, q.open, q.prevClose, q.changePct, q.volume, now);
+  if (c.instr.dirty[id]) c.last.put(LK_QUOTE, c.instr.symbol[id], &q, sizeof(q), now);
+  cryptoCheckAlerts(id, q.price, q.changePct);
+
+  struct tm et; nyseLocalTime((time_t)now, et);
+  MarketSession sess = nyseSession(et);
+  PollState& st = c.poll[id];
+  pollObserve(st, q.price, now, cr, sess, nyseSecondsToChange(et));
+  cryptoDrawFields(id, true);
+  c.instr.clean(id);
+  Serial.printf("poll %s: %s, next in %lus (%u unchanged), saved %ld\n", c.instr.symbol[id],
+                cr ? "24h" : sessionName(sess), (unsigned long)st.interval, st.unchanged, (long)pollSaved(st, now));
+}
+
+// Company name and headlines behind a detail view that went up without them
+inline void cryptoRefreshExtras(int id){
+  CryptoState& c = *g_crypto;
+  if (c.instr.isCrypto(id)) return;   // the name is the label, no news feed
+  const char* sym = c.instr.symbol[id];
+  const CryptoConfig& k = g_cryptoCfg;
+  uint32_t now = (uint32_t)time(nullptr);
+  char key[KvCache::KEY_LEN], day[11];
+
+  String name = sym;
+  String url = String("https://finnhub.io/api/v1/stock/profile2?symbol=") + sym + "&token=";
+  if (decodeFinnhubName(url + k.finnhubKey, name) != 200 && k.finnhubBackupKey.length())
+    decodeFinnhubName(url + k.finnhubBackupKey, name);
+  if (name != sym){                   // the symbol back = lookup failed, keep the old entry
+    snprintf(key, sizeof(key), "P:%s", sym);
+    c.kv.put(key, name, CX_PROFILE_TTL_S, now);
+    cryptoDrawName(id, name);
+  }
+
+  cryptoDateKey(day, sizeof(day));
+  url = String("https://finnhub.io/api/v1/company-news?symbol=") + sym + "&from=" + day + "&to=" + day + "&token=";
+  int code = decodeFinnhubHeadlines(url + k.finnhubKey, c.news, CX_NEWS_SHOWN);
+  if (code != 200 && k.finnhubBackupKey.length()) code = decodeFinnhubHeadlines(url + k.finnhubBackupKey, c.news, CX_NEWS_SHOWN);
+  if (code == 200){
+    snprintf(key, sizeof(key), "N:%s:%s", sym, day);
+    c.kv.put(key, cryptoJoinNews(c.news), CX_NEWS_TTL_S, now);
+    cryptoDrawNews();
+  }
+  c.kv.logStats();
+}
+
+// ---------- Touch ----------
+// The menu acts on release, so a swipe that starts on a button does not open it
+inline bool cryptoMenuTouch(const TouchEvent& e){
+  CryptoState& c = *g_crypto;
+  if (e.type == TOUCH_SWIPE){
+    if (e.dx <= -60)     cryptoShowPage(c.page + 1);
+    else if (e.dx >= 60) cryptoShowPage(c.page - 1);
+    return true;
+  }
+  if (!touchIsTap(e)) return true;
+  int hx, hy, hw, hh; cryptoExitRect(hx, hy, hw, hh);
+  if (e.x >= hx && e.x <= hx + hw && e.y >= hy && e.y <= hy + hh) return false;
+  if (e.y >= CX_PAGE_Y && e.y <= CX_PAGE_Y + CX_PAGE_H){
+    if (e.x >= CX_LEFT && e.x <= CX_LEFT + CX_PAGE_W){ cryptoShowPage(c.page - 1); return true; }
+    int nx = CX_LEFT + 2 * CX_PAGE_W + 40;
+    if (e.x >= nx && e.x <= nx + CX_PAGE_W){ cryptoShowPage(c.page + 1); return true; }
+  }
+  int i = CX_GRID.hitIndex(e.x, e.y, c.page, c.instr.count);
+  if (i < 0) return true;
+  c.selected = i;
+  c.pages.invalidate();               // the highlight moved
+  cryptoDrawDetail(i);
+  return true;
+}
+
+inline void cryptoDetailTouch(const TouchEvent& e){
+  if (!touchIsTap(e)) return;
+  int w = M5.Display.textWidth("Return") + 60;
+  if (e.x >= 30 && e.x <= 30 + w && e.y >= CX_RET_Y && e.y <= CX_RET_Y + 50) cryptoDrawMenu();
+}
+
+// ---------- App lifecycle ----------
+// The whole screen again, from what is in memory
+inline void crypto_redraw(){
+  CryptoState& c = *g_crypto;
+  if (c.view == CX_DETAIL && c.selected < c.instr.count) cryptoDrawDetail(c.selected);
+  else cryptoDrawMenu();
+}
+
+inline bool crypto_init(){
+  g_crypto = new (std::nothrow) CryptoState();
+  if (!g_crypto) return false;
+  wcBuild(*wcFind(g_cryptoCfg.zone), g_crypto->tz);
+  g_crypto->kv.begin();
+  g_crypto->last.begin();
+  cryptoLoadWatchlist();
+  return true;
+}
+
+inline void crypto_resume(){
+  CryptoState& c = *g_crypto;
+  c.epdMode = M5.Display.getEpdMode();
+  M5.Display.setEpdMode(epd_mode_t::epd_fast);
+  c.pages.begin(CX_COLS * (CX_BTN_W + CX_GAP_X), CX_ROWS * (CX_BTN_H + CX_GAP_Y));
+  crypto_redraw();
+}
+
+inline bool crypto_tick(){
+  CryptoState& c = *g_crypto;
+  static bool silenced = false;       // the press that stopped a chime does nothing else
+  TouchEvent e;
+  while (touchPoll(e)){
+    if (e.ms < c.shownMs) continue;
+    if (e.type == TOUCH_DOWN){
+      silenced = audio_busy();
+      if (silenced){ audio_stop(); continue; }
+    }
+    if (silenced) continue;
+    if (c.view == CX_MENU){ if (!cryptoMenuTouch(e)) return false; }
+    else cryptoDetailTouch(e);
+  }
+
+  time_t now = time(nullptr);
+  if (now >= 1700000000 && wcLocalMinute(c.tz, (uint32_t)now) != c.shownMinute) cryptoTopBar();
+
+  if (c.view == CX_DETAIL && net_isUp()){
+    int id = c.selected;
+    if (c.quotePending == id || (uint32_t)now >= c.poll[id].nextAt){ c.quotePending = -1; cryptoRefreshQuote(id); }
+    if (c.extrasPending == id){ c.extrasPending = -1; cryptoRefreshExtras(id); }
+  }
+
+  if (c.banner[0] && (int32_t)(millis() - c.bannerUntil) >= 0){ c.banner[0] = 0; cryptoBanner(); }
+  return true;
+}
+
+inline void crypto_suspend(){
+  CryptoState& c = *g_crypto;
+  c.pages.end();
+  c.news.clear(); c.news.shrink_to_fit();
+  c.quotePending = c.extrasPending = -1;
+  M5.Display.setEpdMode(c.epdMode);
+}
+
+inline void crypto_teardown(){
+  delete g_crypto;
+  g_crypto = nullptr;
+}
+
+// STOCK.txt or ALERTS.txt saved on the config page; read on the next init
+// when the app is closed
+inline void crypto_reload(bool inFront){
+  if (!g_crypto) return;
+  CryptoState& c = *g_crypto;
+  char sel[InstrumentTable::SYM_LEN] = "";
+  if (c.selected < c.instr.count) strcpy(sel, c.instr.symbol[c.selected]);
+  cryptoLoadWatchlist();
+  int id = c.instr.find(sel);
+  c.selected = id >= 0 ? id : 0;
+  if (inFront) cryptoDrawMenu();
+  else c.view = CX_MENU;
+}
+
+#endif // CRYPTOAPP_H
@@ -4,6 +4,14 @@
 #include "AppState.h"
 #include "Marquee.h"
 #include "TimeUtil.h"
+#include "Weather.h"
+#include "GrayRender.h"
+#include "Perf.h"
+#include "Agenda.h"
+#include "WeekGrid.h"
+#include "WorldClock.h"
+#include "GlyphFont.h"
+#include "TouchInput.h"
 
 inline void badge(int x,int y,const String& s){
   M5.Display.setTextSize(2);
@@ -16,15 +24,15 @@ inline void badge(int x,int y,const String& s){
   M5.Display.print(s);
 }
 
-inline int wrapInsideBox(int x,int y,int w,int bottom,const String& text,int sz){
-  M5.Display.setTextSize(sz);
-  int lineH = M5.Display.fontHeight();
+// Word-wrap `text` into a box on any target; returns the y below it. With
+// draw false it only measures (agenda row heights).
+inline int wrapText(LovyanGFX& g,int x,int y,int w,int bottom,const String& text,int sz,bool draw){
+  int lineH = uiLineH(g, sz);
   String word, line; int cy = y;
 
   auto flushLine = [&](){
     if (cy + lineH > bottom) return false;
-    M5.Display.setCursor(x, cy);
-    M5.Display.print(line);
+    if (draw) uiText(g, x, cy, line, sz, TEXT);
     cy += lineH + 2; line = "";
     return true;
   };
@@ -33,7 +41,7 @@ inline int wrapInsideBox(int x,int y,int w,int bottom,const String& text,int sz)
     char c = (i < text.length()) ? text[i] : ' ';
     if (c == ' ' || c == '\n' || i == text.length()){
       String prospect = line.length() ? (line + " " + word) : word;
-      if (M5.Display.textWidth(prospect.c_str()) <= w) line = prospect;
+      if (uiTextWidth(g, prospect, sz) <= w) line = prospect;
       else { if (!flushLine()) return bottom; line = word; }
       word = "";
       if (c == '\n'){ if (!flushLine()) return bottom; }
@@ -41,15 +49,40 @@ inline int wrapInsideBox(int x,int y,int w,int bottom,const String& text,int sz)
   }
 
   if (line.length()){
-    if (M5.Display.textWidth(line.c_str()) > w){
-      while (line.length() && M5.Display.textWidth((line+"…").c_str()) > w) line.remove(line.length()-1);
+    if (uiTextWidth(g, line, sz) > w){
+      // Trim whole codepoints so a multi-byte character is never cut in half
+      while (line.length() && uiTextWidth(g, line+"…", sz) > w) line.remove(utf8DropLast(line.c_str(), line.length()));
       line += "…";
     }
-    if (y + lineH <= bottom){ M5.Display.setCursor(x, cy); cy += lineH + 2; }
+    flushLine();
   }
   return cy;
 }
 
+inline int wrapInsideBox(int x,int y,int w,int bottom,const String& text,int sz){
+  return wrapText(M5.Display, x, y, w, bottom, text, sz, true);
+}
+
+// The other apps, opened from the header's bottom-right corner, right to left
+static const char* HEADER_APPS[] = { "HID", "Clock", "Stocks" };
+static const int HEADER_APP_COUNT = 3;
+
+inline void headerAppRect(int i, int& x, int& y, int& w, int& h){
+  w = 80; h = 30;
+  x = SCREEN_W - 90 - i * 90;
+  y = HEADER_H - h - 6;
+}
+
+// Index into HEADER_APPS of the button at (x, y), -1 for none
+inline int headerAppAt(int x, int y){
+  for (int i = 0; i < HEADER_APP_COUNT; ++i){
+    int bx, by, bw, bh;
+    headerAppRect(i, bx, by, bw, bh);
+    if (x >= bx && x < bx + bw && y >= by && y < by + bh) return i;
+  }
+  return -1;
+}
+
 inline void drawHeader(const tm& t){
   M5.Display.fillRect(0, 0, SCREEN_W, HEADER_H, SUBTLE);
   M5.Display.drawLine(0, HEADER_H, SCREEN_W, HEADER_H, DARKLINE);
@@ -99,15 +132,25 @@ inline void drawHeader(const tm& t){
   M5.Display.setCursor(x, 86);
   M5.Display.printf("%s  %d%%", charging ? "CHG" : "BATT", pct);
 
-  // HID button
-  const int hidBtnW = 80, hidBtnH = 30;
-  const int hidBtnX = SCREEN_W - 90;
-  const int hidBtnY = HEADER_H - hidBtnH - 6;
-  M5.Display.fillRoundRect(hidBtnX, hidBtnY, hidBtnW, hidBtnH, 8, 0x001F /*blue*/);
-  M5.Display.drawRoundRect(hidBtnX, hidBtnY, hidBtnW, hidBtnH, 8, DARKLINE);
-  M5.Display.setTextColor(BG);
+  // Weather older than one missed refresh (e.g. booted offline)
+  if (g_wxAt && time(nullptr) > 1700000000 && time(nullptr) - g_wxAt > (time_t)(WX_PERIOD / 1000) + 300){
+    char since[24];
+    lkStaleLabel(since, sizeof(since), g_wxAt);
+    M5.Display.setTextSize(2);
+    M5.Display.setCursor(360, 112);
+    M5.Display.printf("weather %s", since);
+  }
+
+  // App buttons
   M5.Display.setTextDatum(textdatum_t::middle_center);
-  M5.Display.drawString("HID", hidBtnX + hidBtnW/2, hidBtnY + hidBtnH/2);
+  for (int i = 0; i < HEADER_APP_COUNT; ++i){
+    int bx, by, bw, bh;
+    headerAppRect(i, bx, by, bw, bh);
+    M5.Display.fillRoundRect(bx, by, bw, bh, 8, 0x001F /*blue*/);
+    M5.Display.drawRoundRect(bx, by, bw, bh, 8, DARKLINE);
+    M5.Display.setTextColor(BG);
+    M5.Display.drawString(HEADER_APPS[i], bx + bw/2, by + bh/2);
+  }
 
   // restore defaults for the rest of the UI
   M5.Display.setTextDatum(textdatum_t::top_left);
@@ -132,6 +175,47 @@ inline void drawForecastRibbon(int x,int y,int w){
   }
 }
 
+// Next 24 hours: temperature every 3 h, a line for the temperature and
+// bars for the chance of precipitation
+inline void drawHourlyStrip(int x,int y,int w,int h){
+  const int HOURS = 24, labelH = 18;
+  M5.Display.setTextColor(TEXT, BG);
+  M5.Display.setFont(&fonts::Font0);
+  M5.Display.fillRect(x, y, w, h, BG);
+  int i0 = g_wx.indexAt((uint32_t)time(nullptr));
+  if (i0 < 0) return;
+  int n = std::min(HOURS, (int)g_wx.count - i0);
+  if (n < 2) return;
+  const WxHour* hr = &g_wx.hour[i0];
+
+  int lo = hr[0].temp10, hi = hr[0].temp10;
+  for (int i = 1; i < n; i++){ lo = std::min(lo, (int)hr[i].temp10); hi = std::max(hi, (int)hr[i].temp10); }
+  if (hi - lo < 50) { hi += 25; lo -= 25; }        // a flat day stays a flat line
+
+  const float cellW = (float)w / HOURS;
+  const int gy = y + labelH, gh = h - labelH - 2;
+  M5.Display.setTextSize(2);
+  int px = 0, py = 0;
+  for (int i = 0; i < n; i++){
+    int cx = x + (int)(i * cellW);
+    int bh = hr[i].pop * gh / 100;
+    if (bh) M5.Display.fillRect(cx + 1, gy + gh - bh, std::max(1, (int)cellW - 2), bh, SUBTLE);
+    int tx = cx + (int)(cellW / 2);
+    int ty = gy + gh - 1 - (hr[i].temp10 - lo) * (gh - 2) / (hi - lo);
+    if (i) { M5.Display.drawLine(px, py, tx, ty, TEXT); M5.Display.drawLine(px, py + 1, tx, ty + 1, TEXT); }
+    px = tx; py = ty;
+
+    time_t ts = g_wx.timeOf(i0 + i);
+    struct tm lt = *localtime(&ts);
+    if (lt.tm_hour % 3 == 0 && cx + 6 * 12 <= x + w){
+      M5.Display.setCursor(cx + 2, y);
+      M5.Display.printf("%d%c %d%c", (lt.tm_hour % 12) ? lt.tm_hour % 12 : 12, lt.tm_hour < 12 ? 'a' : 'p',
+                        wxDeg(hr[i].temp10), DEG);
+    }
+  }
+  M5.Display.drawLine(x, y + h - 1, x + w, y + h - 1, LINE);
+}
+
 inline void drawEventBlock(int x,int y,int w,int bottom,const CalendarEvent& ev,int &nextY) {
   int cy = y;
 
@@ -149,16 +233,14 @@ inline void drawEventBlock(int x,int y,int w,int bottom,const CalendarEvent& ev,
   int textX = x + 10;
   int textW = w - 20;
 
-  M5.Display.setTextSize(2);
-  int lhTitle = M5.Display.fontHeight();
-  int titleW  = M5.Display.textWidth(ev.title.c_str());
+  int lhTitle = uiLineH(M5.Display, 2);
+  int titleW  = uiTextWidth(M5.Display, ev.title, 2);
   if (titleW > textW && (cy + lhTitle + 2) <= bottom) {
     addMarquee(textX, cy, textW, lhTitle + 2, ev.title, 2);
     cy += lhTitle + 6;
   } else {
     if (cy + lhTitle <= bottom) {
-      M5.Display.setCursor(textX, cy);
-      M5.Display.print(ev.title);
+      uiText(M5.Display, textX, cy, ev.title, 2, TEXT);
       cy += lhTitle + 4;
     }
   }
@@ -216,7 +298,270 @@ inline void drawDayCard(int x,int y,int w,int h,const DayView& dv,bool isToday){
   }
 }
 
-inline void drawAll(){
+// Day i (0 = today) and the events on it
+inline void buildDays(const tm& t, DayView* days){
+  for (int i = 0; i < DAYS_TO_SHOW; i++){
+    tm dt = t;
+    dt.tm_mday += i;
+    mktime(&dt);
+    days[i].y = dt.tm_year + 1900;
+    days[i].m = dt.tm_mon + 1;
+    days[i].d = dt.tm_mday;
+    days[i].wday = dt.tm_wday;
+    for (int j = 0; j < eventCount; j++)
+      if (events[j].y==days[i].y && events[j].m==days[i].m && events[j].d==days[i].d)
+        days[i].idx.push_back(j);
+  }
+}
+
+// Today's card stands 4 px proud of the others
+inline void dayCardRect(int i, int& x, int& y, int& w, int& h){
+  const int gap = 8;
+  int colW = (SCREEN_W - 20 - (DAYS_TO_SHOW-1)*gap) / DAYS_TO_SHOW;
+  x = 10 + i*(colW + gap);
+  y = TOP_AREA_H;
+  w = colW;
+  h = SCREEN_H - TOP_AREA_H - 10;
+  if (i == 0) { x -= 4; y -= 4; w += 8; h += 8; }
+}
+
+// ---------- Agenda view ----------
+// Tap a day card for every event from today on as one list, opened at that
+// day. Drag to scroll; tap the header to go back to the cards.
+struct AgendaRow { int16_t ev; int16_t y; int8_t m, d, wday; };   // ev < 0: day heading
+static std::vector<AgendaRow> g_agendaRows;
+static AgendaView g_agenda;
+static bool g_agendaOpen = false;
+static uint32_t g_agendaRev = 0;      // g_eventsRev it was laid out for
+
+static const int AGENDA_HEAD_H = 44;
+static const int AGENDA_TIME_W = 170;
+static const int AGENDA_PAD    = 10;
+static const unsigned long AGENDA_STEP_MS = 150;   // batch drag movement into one fast update
+
+inline int agendaTextW(){ return g_agenda.w - AGENDA_TIME_W - 2*AGENDA_PAD; }
+
+inline int agendaRowH(int i){
+  const AgendaRow& r = g_agendaRows[i];
+  if (r.ev < 0) return AGENDA_HEAD_H;
+  const CalendarEvent& ev = events[r.ev];
+  LovyanGFX& g = *g_agenda.canvas;
+  int cy = wrapText(g, 0, 0, agendaTextW(), INT16_MAX, ev.title, 2, false);
+  if (ev.location.length()) cy = wrapText(g, 0, cy, agendaTextW(), INT16_MAX, ev.location, 1, false);
+  return std::max(cy, 36) + 2*AGENDA_PAD;      // at least the two time lines
+}
+
+inline void drawAgendaRow(LovyanGFX& g, int i, int y, int w){
+  static const char* DOW[]={"SUN","MON","TUE","WED","THU","FRI","SAT"};
+  const AgendaRow& r = g_agendaRows[i];
+  int h = g_agenda.layout.rowH(i);
+  g.setTextColor(TEXT);
+  if (r.ev < 0){
+    g.fillRect(0, y + 4, w, h - 8, SUBTLE);
+    g.setTextSize(2);
+    g.setCursor(AGENDA_PAD, y + 14);
+    g.printf("%s %d/%d", DOW[r.wday], r.m, r.d);
+    return;
+  }
+  const CalendarEvent& ev = events[r.ev];
+  g.setTextSize(2);
+  g.setCursor(AGENDA_PAD, y + AGENDA_PAD);
+  g.print(ev.allDay ? String("All-day") : time12(ev.sh, ev.sm));
+  if (!ev.allDay && ev.eh >= 0){
+    g.setCursor(AGENDA_PAD, y + AGENDA_PAD + 20);
+    g.print(time12(ev.eh, ev.em));
+  }
+  int tx = AGENDA_TIME_W + AGENDA_PAD;
+  int cy = wrapText(g, tx, y + AGENDA_PAD, agendaTextW(), y + h, ev.title, 2, true);
+  if (ev.location.length()) wrapText(g, tx, cy, agendaTextW(), y + h, ev.location, 1, true);
+  g.drawLine(AGENDA_PAD, y + h - 1, w - AGENDA_PAD, y + h - 1, LINE);
+}
+
+// Rows from events[] (already sorted), measured once per refresh
+inline void agendaLayout(){
+  PERF_SCOPE("agenda layout", PERF_RENDER);
+  g_agendaRows.clear();
+  for (int j = 0; j < eventCount; j++){
+    const CalendarEvent& ev = events[j];
+    if (g_agendaRows.empty() || g_agendaRows.back().y != ev.y || g_agendaRows.back().m != ev.m || g_agendaRows.back().d != ev.d){
+      tm dt{}; dt.tm_year = ev.y - 1900; dt.tm_mon = ev.m - 1; dt.tm_mday = ev.d; dt.tm_hour = 12;
+      mktime(&dt);
+      g_agendaRows.push_back({ -1, (int16_t)ev.y, (int8_t)ev.m, (int8_t)ev.d, (int8_t)dt.tm_wday });
+    }
+    g_agendaRows.push_back({ (int16_t)j, (int16_t)ev.y, (int8_t)ev.m, (int8_t)ev.d, 0 });
+  }
+  g_agenda.layout.build((int)g_agendaRows.size(), agendaRowH);
+  g_agendaRev = g_eventsRev;
+}
+
+// First row on or after the day
+inline int agendaRowOfDay(int y, int m, int d){
+  uint32_t key = (uint32_t)(y*10000 + m*100 + d);
+  auto it = std::lower_bound(g_agendaRows.begin(), g_agendaRows.end(), key,
+    [](const AgendaRow& r, uint32_t k){ return (uint32_t)(r.y*10000 + r.m*100 + r.d) < k; });
+  return (int)(it - g_agendaRows.begin());
+}
+
+// ---------- Week view ----------
+// Tap the forecast ribbon to switch between the day cards and an hour grid
+// of the next seven days. Overlapping events sit side by side (WeekGrid.h).
+// Events past midnight continue on the next day's column; all-day and
+// day-long events span their days in a band above the grid. The layout is
+// cached until events[] or the date changes. Tap a day for its agenda.
+static const int WEEK_DAYS    = 7;
+static const int WEEK_FIRST_H = 7, WEEK_LAST_H = 22;   // hours on the grid; earlier / later events are clamped
+static const int WEEK_AXIS_W  = 44;
+static const int WEEK_HEAD_H  = 28;
+static const int WEEK_BAND_H  = 40;                    // all-day band: two rows of spans
+static const int WEEK_BAND_ROWS = 2;
+static const int WEEK_MIN_MIN = 20;                    // shortest block drawn, in minutes
+
+struct WeekDay {
+  int y, m, d, wday;
+  std::vector<GridItem> timed;
+  uint8_t bandMore;                             // spans the last band row's "+ N more" stands for
+};
+static WeekDay  g_week[WEEK_DAYS];
+static std::vector<GridItem> g_weekBand;        // start/end are columns, col is the row
+static uint32_t g_weekRev = 0, g_weekYmd = 0;
+static bool     g_weekView = false;
+
+inline void weekLayout(const tm& t){
+  uint32_t ymd = (uint32_t)((t.tm_year+1900)*10000 + (t.tm_mon+1)*100 + t.tm_mday);
+  if (g_weekRev == g_eventsRev && g_weekYmd == ymd) return;
+  PERF_SCOPE("week layout", PERF_RENDER);
+  std::vector<GridItem> timed[WEEK_DAYS];
+  for (int i=0;i<WEEK_DAYS;i++){
+    tm dt=t; dt.tm_mday += i; mktime(&dt);
+    WeekDay& wd = g_week[i];
+    wd.y = dt.tm_year+1900; wd.m = dt.tm_mon+1; wd.d = dt.tm_mday; wd.wday = dt.tm_wday;
+  }
+  g_weekBand.clear();
+  const int32_t day0 = wcDays(g_week[0].y, g_week[0].m, g_week[0].d);
+  const WeekHours hrs = { (int16_t)(WEEK_FIRST_H*60), (int16_t)(WEEK_LAST_H*60), (int16_t)WEEK_MIN_MIN };
+  for (int j=0;j<eventCount;j++){
+    const CalendarEvent& ev = events[j];
+    WeekSpan sp;
+    sp.startDay = wcDays(ev.y, ev.m, ev.d);
+    sp.allDay = ev.allDay || ev.sh < 0;
+    sp.idx = (uint16_t)j;
+    sp.startMin = (int16_t)(sp.allDay ? 0 : ev.sh*60 + ev.sm);
+    if (sp.allDay){
+      // DTEND is the day after the last; none = one day
+      sp.endDay = ev.endYmd ? wcDays(ev.endYmd/10000, ev.endYmd/100%100, ev.endYmd%100) - 1 : sp.startDay;
+      sp.endMin = 0;
+    } else if (ev.endYmd){
+      sp.endDay = wcDays(ev.endYmd/10000, ev.endYmd/100%100, ev.endYmd%100);
+      sp.endMin = (int16_t)(ev.eh >= 0 ? ev.eh*60 + ev.em : 0);
+    } else {
+      sp.endDay = sp.startDay;                   // no DTEND: an hour
+      sp.endMin = (int16_t)(ev.eh >= 0 ? ev.eh*60 + ev.em : sp.startMin + 60);
+    }
+    weekPlace(sp, day0, WEEK_DAYS, hrs, g_weekBand, timed);
+  }
+  for (int i=0;i<WEEK_DAYS;i++){
+    gridLayout(timed[i].data(), (int)timed[i].size());
+    g_week[i].timed = std::move(timed[i]);
+  }
+  gridLayout(g_weekBand.data(), (int)g_weekBand.size());
+  uint8_t more[WEEK_DAYS];
+  weekBandMore(g_weekBand.data(), (int)g_weekBand.size(), WEEK_BAND_ROWS, more, WEEK_DAYS);
+  for (int i=0;i<WEEK_DAYS;i++) g_week[i].bandMore = more[i];
+  g_weekRev = g_eventsRev;
+  g_weekYmd = ymd;
+}
+
+inline void weekColumnRect(int i, int& x, int& w){
+  w = (SCREEN_W - 20 - WEEK_AXIS_W) / WEEK_DAYS;
+  x = 10 + WEEK_AXIS_W + i*w;
+}
+
+inline void drawWeekGrid(const tm& t){
+  static const char* DOW[]={"SUN","MON","TUE","WED","THU","FRI","SAT"};
+  weekLayout(t);
+  PERF_SCOPE("week grid", PERF_RENDER);
+  const int top = TOP_AREA_H, bottom = SCREEN_H - 10;
+  const int gridTop = top + WEEK_HEAD_H + WEEK_BAND_H;
+  const int first = WEEK_FIRST_H*60;
+  const float pxPerMin = (bottom - gridTop) / float((WEEK_LAST_H - WEEK_FIRST_H)*60);
+  int x0, colW;
+  weekColumnRect(0, x0, colW);
+  const int right = x0 + WEEK_DAYS*colW;
+
+  M5.Display.setTextColor(TEXT);
+  M5.Display.setTextSize(1);
+  for (int h=WEEK_FIRST_H; h<=WEEK_LAST_H; h++){
+    int y = gridTop + (int)((h*60 - first) * pxPerMin);
+    M5.Display.drawFastHLine(x0, y, right - x0, LINE);
+    M5.Display.setCursor(10, y - 3);
+    M5.Display.printf("%d%s", h % 12 ? h % 12 : 12, h < 12 ? "a" : "p");
+  }
+
+  for (int i=0;i<WEEK_DAYS;i++){
+    const WeekDay& wd = g_week[i];
+    int x, w;
+    weekColumnRect(i, x, w);
+    if (i == 0) M5.Display.fillRect(x, top, w, WEEK_HEAD_H, TODAY_BG);
+    M5.Display.drawFastVLine(x, top, bottom - top, DARKLINE);
+    M5.Display.setTextSize(2);
+    M5.Display.setCursor(x + 6, top + 6);
+    M5.Display.printf("%s %d", DOW[wd.wday], wd.d);
+
+    M5.Display.setTextSize(1);
+    if (wd.bandMore){
+      M5.Display.setCursor(x + 6, top + WEEK_HEAD_H + 2 + (WEEK_BAND_ROWS-1)*18 + 5);
+      M5.Display.printf("+ %d more", wd.bandMore);
+    }
+
+    // Timed blocks, side by side where they overlap; a block carried over
+    // from the day before shows when it ends
+    uint32_t ymd = (uint32_t)(wd.y*10000 + wd.m*100 + wd.d);
+    for (const GridItem& it : wd.timed){
+      const CalendarEvent& ev = events[it.idx];
+      int y0 = gridTop + (int)((it.start - first) * pxPerMin);
+      int y1 = gridTop + (int)((it.end - first) * pxPerMin);
+      int slotW = (w - 4) / it.cols;
+      int bx = x + 2 + it.col * slotW;
+      int bw = slotW - 2;
+      M5.Display.fillRect(bx, y0 + 1, bw, y1 - y0 - 2, SUBTLE);
+      M5.Display.drawRect(bx, y0 + 1, bw, y1 - y0 - 2, DARKLINE);
+      M5.Display.setClipRect(bx + 1, y0 + 2, bw - 2, y1 - y0 - 4);
+      M5.Display.setCursor(bx + 3, y0 + 4);
+      if ((uint32_t)(ev.y*10000 + ev.m*100 + ev.d) == ymd) M5.Display.print(time12(ev.sh, ev.sm));
+      else if (ev.eh >= 0) M5.Display.printf("to %s", time12(ev.eh, ev.em).c_str());
+      wrapText(M5.Display, bx + 3, y0 + 14, bw - 6, y1 - 2, ev.title, 1, true);
+      M5.Display.clearClipRect();
+    }
+  }
+
+  // Band: each span across the columns it covers. The last row gives way
+  // to "+ N more" in columns that have more spans than rows.
+  for (const GridItem& sp : g_weekBand){
+    if (sp.col >= WEEK_BAND_ROWS) continue;
+    int by = top + WEEK_HEAD_H + 2 + sp.col*18;
+    bool lastRow = sp.col == WEEK_BAND_ROWS - 1;
+    for (int i = sp.start; i < sp.end; ){
+      if (lastRow && g_week[i].bandMore) { i++; continue; }
+      int j = i;
+      while (j < sp.end && !(lastRow && g_week[j].bandMore)) j++;
+      int xa, wa, xb, wb;
+      weekColumnRect(i, xa, wa);
+      weekColumnRect(j - 1, xb, wb);
+      M5.Display.fillRoundRect(xa + 3, by, xb + wb - xa - 6, 16, 4, BADGE_FILL);
+      M5.Display.setClipRect(xa + 3, by, xb + wb - xa - 6, 16);
+      uiText(M5.Display, xa + 6, by + 4, events[sp.idx].title, 1, TEXT);
+      M5.Display.clearClipRect();
+      i = j;
+    }
+  }
+  M5.Display.drawFastVLine(right, top, bottom - top, DARKLINE);
+  M5.Display.drawFastHLine(x0, top + WEEK_HEAD_H, right - x0, DARKLINE);
+  M5.Display.drawFastHLine(x0, gridTop, right - x0, DARKLINE);
+}
+
+// Everything but the hourly strip and forecast ribbon (drawCharts());
+// false when those are not on screen either
+inline bool drawFrame(){
   // Normalize draw state for a clean full redraw
   M5.Display.setTextWrap(false);
   M5.Display.setTextDatum(textdatum_t::top_left);
@@ -228,41 +573,160 @@ inline void drawAll(){
   clearMarquees();
 
   struct tm t{};
-  if (!readLocal(t)) return;
+  if (!readLocal(t)) return false;
 
   drawHeader(t);
-  drawForecastRibbon(10, HEADER_H + 4, SCREEN_W - 20);
+  if (g_agendaOpen){
+    if (g_agendaRev != g_eventsRev) agendaLayout();
+    g_agenda.paint();
+    return false;
+  }
+  if (g_weekView) { drawWeekGrid(t); return true; }
 
   DayView days[DAYS_TO_SHOW];
+  buildDays(t, days);
   for (int i = 0; i < DAYS_TO_SHOW; i++){
-    tm dt = t;
-    dt.tm_mday += i;
-    mktime(&dt);
-    days[i].y = dt.tm_year + 1900;
-    days[i].m = dt.tm_mon + 1;
-    days[i].d = dt.tm_mday;
-    days[i].wday = dt.tm_wday;
-    for (int j = 0; j < eventCount; j++)
-      if (events[j].y==days[i].y && events[j].m==days[i].m && events[j].d==days[i].d)
-        days[i].idx.push_back(j);
+    int x, y, w, hh;
+    dayCardRect(i, x, y, w, hh);
+    drawDayCard(x, y, w, hh, days[i], i == 0);
   }
+  return true;
+}
 
-  int top = TOP_AREA_H;
-  int h   = SCREEN_H - top - 10;
+// The shaded parts that are a chart: the only content drawn in the grays
+inline void drawCharts(){
+  drawHourlyStrip(10, HEADER_H + 4, SCREEN_W - 20, HOURLY_H);
+  drawForecastRibbon(10, HEADER_H + 4 + HOURLY_H, SCREEN_W - 20);
+}
 
-  const int gap = 8;
-  int colW = (SCREEN_W - 20 - (DAYS_TO_SHOW-1)*gap) / DAYS_TO_SHOW;
+// Full redraw in two batches: text and cards in the fast black/white
+// waveform, then the strip and ribbon on their own in quality
+inline void drawAll(){
+  auto prevMode = grayUse(GC_TEXT);
+  bool charts;
+  M5.Display.startWrite();
+  { PERF_SCOPE("drawAll", PERF_RENDER); charts = drawFrame(); }
+  { PERF_SCOPE("panel flush", PERF_FLUSH); M5.Display.endWrite(); }
+  if (charts){
+    grayUse(GC_CHART);
+    M5.Display.startWrite();
+    { PERF_SCOPE("charts", PERF_RENDER); drawCharts(); }
+    { PERF_SCOPE("panel flush", PERF_FLUSH); M5.Display.endWrite(); }
+  }
+  M5.Display.setEpdMode(prevMode);
+  uiFontsReport();
+}
+
+// Hour rollover: "now" moves one slot along the timeline. Only the strip
+// is redrawn here; the header picks the new reading up on its next minute.
+inline void drawHourly(){
+  applyWeather();
+  if (g_agendaOpen) return;
+  auto prevMode = grayUse(GC_CHART);
+  PERF_SCOPE("hourly strip", PERF_RENDER);
+  M5.Display.startWrite();
+  drawHourlyStrip(10, HEADER_H + 4, SCREEN_W - 20, HOURLY_H);
+  M5.Display.endWrite();
+  M5.Display.setEpdMode(prevMode);
+}
 
+// Redraw only the day cards in `mask` (bit i = day i), each flushed on its own
+inline void drawDayCards(uint32_t mask){
+  if (g_agendaOpen){
+    if (g_agendaRev != g_eventsRev) { agendaLayout(); g_agenda.redraw(); }
+    return;
+  }
+  if (g_weekView){
+    if (g_weekRev != g_eventsRev) drawAll();    // the grid spans a week, not the 5 cards
+    return;
+  }
+  struct tm t{};
+  if (!mask || !readLocal(t)) return;
+  DayView days[DAYS_TO_SHOW];
+  buildDays(t, days);
+  auto prevMode = grayUse(GC_TEXT);
+  PERF_SCOPE("day cards", PERF_RENDER);
+  M5.Display.setTextSize(1.0f);
+  M5.Display.setTextColor(TEXT, BG);
+  M5.Display.setFont(&fonts::Font0);
   for (int i = 0; i < DAYS_TO_SHOW; i++){
-    int x = 10 + i*(colW + gap);
-    int y = top;
-    int w = colW;
-    int hh = h;
+    if (!(mask & (1u << i))) continue;
+    int x, y, w, hh;
+    dayCardRect(i, x, y, w, hh);
+    clearMarqueesIn(x, y, w, hh);
+    M5.Display.startWrite();
+    drawDayCard(x, y, w, hh, days[i], i == 0);
+    M5.Display.endWrite();
+  }
+  M5.Display.setEpdMode(prevMode);
+}
+
+inline void openAgenda(const DayView& day){
+  if (!g_agenda.begin(0, HEADER_H, SCREEN_W, SCREEN_H - HEADER_H, BG, drawAgendaRow)) return;
+  agendaLayout();
+  int row = agendaRowOfDay(day.y, day.m, day.d);
+  g_agenda.scroll = row < g_agenda.layout.count() ? g_agenda.layout.rowTop(row) : g_agenda.layout.total();
+  g_agendaOpen = true;
+  drawAll();
+}
 
-    bool isToday = (i == 0);
-    if (isToday) { x -= 4; y -= 4; w += 8; hh += 8; }
+inline void closeAgenda(){
+  g_agendaOpen = false;
+  drawAll();
+}
+
+// The calendar leaving the front (AppHost.h): sprites, the agenda canvas,
+// the week layout and the SD fonts go. Events and weather stay, so the next
+// drawAll() needs no fetch. The agenda is closed; the week view is kept.
+inline void calendarRelease(){
+  clearMarquees();
+  marquees.shrink_to_fit();
+  g_agenda.end();
+  g_agendaOpen = false;
+  g_agendaRows.clear(); g_agendaRows.shrink_to_fit();
+  g_agendaRev = 0;
+  for (WeekDay& wd : g_week) { wd.timed.clear(); wd.timed.shrink_to_fit(); }
+  g_weekBand.clear(); g_weekBand.shrink_to_fit();
+  g_weekRev = 0;
+  uiFontsEnd();
+}
 
-    drawDayCard(x, y, w, hh, days[i], isToday);
+inline void agendaTouch(const TouchEvent& e){
+  static int32_t pending = 0;
+  static uint32_t lastMs = 0;
+  if (touchIsTap(e) && e.y < HEADER_H) { pending = 0; closeAgenda(); return; }
+  if (e.type == TOUCH_DRAG) pending -= e.dy;
+  if (pending && (e.ms - lastMs >= AGENDA_STEP_MS || e.type == TOUCH_UP)){
+    g_agenda.scrollBy(pending);
+    pending = 0;
+    lastMs = e.ms;
+  }
+}
+
+// Tap on the forecast ribbon: cards <-> week grid. Tap on a day (card or
+// week column): open the agenda at that day
+inline void viewTap(const TouchEvent& e, const tm& t){
+  if (!touchIsTap(e) || e.y < HEADER_H) return;
+  if (e.y < TOP_AREA_H) { g_weekView = !g_weekView; drawAll(); return; }
+  if (g_weekView){
+    weekLayout(t);
+    for (int i = 0; i < WEEK_DAYS; i++){
+      int x, w;
+      weekColumnRect(i, x, w);
+      if (e.x < x || e.x >= x + w) continue;
+      DayView dv;
+      dv.y = g_week[i].y; dv.m = g_week[i].m; dv.d = g_week[i].d; dv.wday = g_week[i].wday;
+      openAgenda(dv);
+      return;
+    }
+    return;
+  }
+  DayView days[DAYS_TO_SHOW];
+  buildDays(t, days);
+  for (int i = 0; i < DAYS_TO_SHOW; i++){
+    int x, y, w, hh;
+    dayCardRect(i, x, y, w, hh);
+    if (e.x >= x && e.x < x + w) { openAgenda(days[i]); return; }
   }
 }
 
@@ -0,0 +1,202 @@
+#ifndef GRAYRENDER_H
+#define GRAYRENDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ---------- Grayscale for the e-ink panel ----------
+// The UI uses four gray levels. Each one is a level the panel drives
+// exactly, so a flat fill is never dithered. An 8-bit gray render
+// (a canvas) is packed to 2 bpp for quality updates or 1 bpp for the fast
+// black/white modes, where the two grays become solid black (dark) and
+// white (light) rather than a halftone. Values between two levels go
+// through a 4x4 clustered-dot ordered dither. Clustered dots suit e-ink:
+// a lone pixel in a fast waveform often does not switch fully, but a clump
+// does. Neighbour pixels also bleed into each other (dot gain), so a
+// halftone looks darker than its value; the threshold is pulled slightly
+// towards white to make up for that. This part is plain C++.
+//
+//   GrayLut lut; grayBuildLut(lut, 2);
+//   grayPack(lut, canvasBytes, w, w, h, packed);   // w a multiple of 8
+
+static const uint8_t  GRAY_V_BLACK = 0x00, GRAY_V_DARK = 0x66, GRAY_V_LIGHT = 0xCC, GRAY_V_WHITE = 0xFF;
+
+// The same levels as RGB565, for the draw calls
+static const uint16_t GRAY_BLACK = 0x0000;
+static const uint16_t GRAY_DARK  = 0x632C;
+static const uint16_t GRAY_LIGHT = 0xCE79;
+static const uint16_t GRAY_WHITE = 0xFFFF;
+
+// Any of the panel's sixteen levels (0x00, 0x11 .. 0xFF) as RGB565, for
+// direct draws that need more shades apart than a packed frame carries
+constexpr uint16_t gray565(uint8_t v) {
+  return (uint16_t)(((v >> 3) << 11) | ((v >> 2) << 5) | (v >> 3));
+}
+
+// Spiral clustered-dot thresholds (0..15): dots grow out from the centre
+static const uint8_t GRAY_CLUSTER[4][4] = {
+  { 12,  5,  6, 13 },
+  {  4,  0,  1,  7 },
+  { 11,  3,  2,  8 },
+  { 15, 10,  9, 14 },
+};
+
+// Per input gray: the level below it and how far (0..15) towards the next one
+struct GrayLut {
+  uint8_t bpp;
+  uint8_t base[256];
+  uint8_t frac[256];
+};
+
+inline void grayBuildLut(GrayLut& lut, uint8_t bpp) {
+  static const uint8_t lv2[] = { GRAY_V_BLACK, GRAY_V_DARK, GRAY_V_LIGHT, GRAY_V_WHITE };
+  static const uint8_t lv1[] = { GRAY_V_BLACK, GRAY_V_WHITE };
+  const uint8_t* lv = bpp == 2 ? lv2 : lv1;
+  int top = bpp == 2 ? 3 : 1;
+  lut.bpp = bpp;
+  int i = 0;
+  for (int g = 0; g < 256; ++g) {
+    while (i < top - 1 && g >= lv[i + 1]) ++i;
+    if (g >= lv[top]) { lut.base[g] = (uint8_t)top; lut.frac[g] = 0; continue; }
+    int f = (g - lv[i]) * 16 / (lv[i + 1] - lv[i]);   // 0..15
+    f += f * (16 - f) / 48;                            // dot gain: up to +1.3 near the middle
+    lut.base[g] = (uint8_t)i;
+    lut.frac[g] = (uint8_t)(f > 15 ? 15 : f);
+  }
+  if (bpp == 1) {   // flat gray fills stay flat
+    lut.base[GRAY_V_DARK] = 0;  lut.frac[GRAY_V_DARK] = 0;
+    lut.base[GRAY_V_LIGHT] = 1; lut.frac[GRAY_V_LIGHT] = 0;
+  }
+}
+
+inline uint8_t grayLuma565(uint16_t c) {
+  uint32_t r = (c >> 11) * 255 / 31, g = ((c >> 5) & 63) * 255 / 63, b = (c & 31) * 255 / 31;
+  return (uint8_t)((r * 77 + g * 150 + b * 29) >> 8);
+}
+
+// Nearest of the four levels, for colours picked before this existed
+inline uint16_t grayNearest565(uint16_t c) {
+  uint8_t y = grayLuma565(c);
+  if (y < (GRAY_V_BLACK + GRAY_V_DARK) / 2)  return GRAY_BLACK;
+  if (y < (GRAY_V_DARK + GRAY_V_LIGHT) / 2)  return GRAY_DARK;
+  if (y < (GRAY_V_LIGHT + GRAY_V_WHITE) / 2) return GRAY_LIGHT;
+  return GRAY_WHITE;
+}
+
+inline size_t grayPackedSize(int w, int h, uint8_t bpp) {
+  return ((size_t)w * h * bpp + 7) / 8;
+}
+
+// One row of 8-bit gray -> palette indices, MSB first. `y` is the row's
+// panel position so the dither pattern lines up across pushes.
+inline void grayPackRow(const GrayLut& lut, const uint8_t* src, int w, int y, uint8_t* dst) {
+  const uint8_t* th = GRAY_CLUSTER[y & 3];
+  if (lut.bpp == 2) {
+    for (int x = 0; x < w; x += 4) {
+      uint8_t b = 0;
+      for (int k = 0; k < 4; ++k) {
+        uint8_t g = src[x + k];
+        b = (uint8_t)(b << 2) | (uint8_t)(lut.base[g] + (lut.frac[g] > th[k]));
+      }
+      *dst++ = b;
+    }
+  } else {
+    for (int x = 0; x < w; x += 8) {
+      uint8_t b = 0;
+      for (int k = 0; k < 8; ++k) {
+        uint8_t g = src[x + k];
+        b = (uint8_t)(b << 1) | (uint8_t)(lut.base[g] + (lut.frac[g] > th[k & 3]));
+      }
+      *dst++ = b;
+    }
+  }
+}
+
+// Whole `w` x `h` image with row `stride`; `w` must be a multiple of 8
+inline void grayPack(const GrayLut& lut, const uint8_t* src, int stride, int w, int h,
+                     uint8_t* dst, int y0 = 0) {
+  size_t rowBytes = (size_t)w * lut.bpp / 8;
+  for (int y = 0; y < h; ++y)
+    grayPackRow(lut, src + (size_t)y * stride, w, y0 + y, dst + y * rowBytes);
+}
+
+#ifdef ARDUINO
+#include <M5Unified.h>
+#include "Perf.h"
+
+// ---------- Content routing ----------
+// Text and buttons go out in the fastest black/white waveform at 1 bpp.
+// Cards and headers keep to that too; charts need the grays, so they use
+// 2 bpp and the quality waveform.
+enum GrayContent : uint8_t { GC_TEXT, GC_CHART };
+
+inline m5gfx::epd_mode_t grayEpdMode(GrayContent c) {
+  return c == GC_CHART ? m5gfx::epd_mode_t::epd_quality : m5gfx::epd_mode_t::epd_fastest;
+}
+
+inline uint8_t grayBpp(GrayContent c) { return c == GC_CHART ? 2 : 1; }
+
+// Switch the panel to the mode for `c`; returns the mode to restore
+inline m5gfx::epd_mode_t grayUse(GrayContent c) {
+  auto prevMode = M5.Display.getEpdMode();
+  M5.Display.setEpdMode(grayEpdMode(c));
+  return prevMode;
+}
+
+static const uint32_t GRAY_PAL2[4] = { 0x000000, 0x666666, 0xCCCCCC, 0xFFFFFF };
+static const uint32_t GRAY_PAL1[2] = { 0x000000, 0xFFFFFF };
+
+inline const GrayLut& grayLut(uint8_t bpp) {
+  static GrayLut l1, l2;
+  GrayLut& l = bpp == 2 ? l2 : l1;
+  if (l.bpp != bpp) grayBuildLut(l, bpp);
+  return l;
+}
+
+// A packed frame in PSRAM, ready to push
+struct GrayFrame {
+  uint8_t*    bits = nullptr;
+  int         w = 0, h = 0;
+  GrayContent content = GC_TEXT;
+
+  bool alloc(int width, int height, GrayContent c) {
+    w = width; h = height; content = c;
+    bits = (uint8_t*)ps_malloc(grayPackedSize(w, h, grayBpp(c)));
+    return bits != nullptr;
+  }
+
+  void release() { free(bits); bits = nullptr; }
+
+  // Pack an 8-bit grayscale canvas of the same size, drawn for panel row y0
+  void capture(M5Canvas& src, int y0 = 0) {
+    PERF_SCOPE("gray pack", PERF_RENDER);
+    const uint8_t* p = (const uint8_t*)src.getBuffer();
+    int stride = src.bufferLength() / src.height();
+    grayPack(grayLut(grayBpp(content)), p, stride, w, h, bits, y0);
+  }
+
+  // Push at (x, y) and flush that rect in this content's mode
+  void push(int x, int y) const {
+    PERF_SCOPE("gray push", PERF_FLUSH);
+    auto prevMode = grayUse(content);
+    if (content == GC_CHART)
+      M5.Display.pushImage(x, y, w, h, bits, lgfx::color_depth_t::palette_2bit, GRAY_PAL2);
+    else
+      M5.Display.pushImage(x, y, w, h, bits, lgfx::color_depth_t::palette_1bit, GRAY_PAL1);
+    M5.Display.display(x, y, w, h);
+    M5.Display.setEpdMode(prevMode);
+  }
+};
+
+// 8-bit grayscale canvas to draw a frame into before packing it
+inline M5Canvas* grayCanvas(int w, int h) {
+  M5Canvas* c = new M5Canvas(&M5.Display);
+  c->setColorDepth(lgfx::color_depth_t::grayscale_8bit);
+  c->setPsram(true);
+  if (!c->createSprite(w, h)) { delete c; return nullptr; }
+  return c;
+}
+#endif // ARDUINO
+
+#endif // GRAYRENDER_H
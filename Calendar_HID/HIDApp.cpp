@@ -10,13 +10,10 @@
 #include <USBHIDMouse.h>
 
 #include "Config.h"  // for colors BG/TEXT, etc.
+#include "TouchInput.h"
 
 namespace {
 
-// --- Public-facing flags  ---
-static bool g_hidActive     = false;
-static bool g_hidJustExited = false;
-
 // --- HID devices ---
 static USBHIDKeyboard sKeyboard;
 static USBHIDMouse    sMouse;
@@ -75,17 +72,8 @@ static int ROW_H  = 80;
 
 static const lgfx::IFont* FONT = &fonts::Font4;
 
-// --- Touchpad state ---
-struct TouchpadState {
-  bool isPressed = false;
-  int lastX = 0, lastY = 0;
-  bool wasDragging = false;
-  unsigned long lastTapTime = 0;
-  int tapCount = 0;
-  static const unsigned long DOUBLE_TAP_TIMEOUT = 300; // ms
-  static const int MOUSE_SENSITIVITY = 3;
-};
-static TouchpadState touch;
+// --- Touchpad ---
+static const int MOUSE_SENSITIVITY = 3;
 
 // --- Keys ---
 enum ArrowDir : uint8_t { AR_NONE=0, AR_L, AR_D, AR_U, AR_R };
@@ -106,7 +94,6 @@ static bool kShift = false;
 static bool kCtrl  = false;
 static bool kAlt   = false;
 static bool kCaps  = false;
-static bool wasPressed = false;
 static int  lastIdx = -1;
 
 // ===================== Helpers =====================
@@ -406,32 +393,26 @@ inline bool hitTouchpadModeBtn(int x, int y) {
   return (x>=btnX && x<btnX+btnW && y>=btnY && y<btnY+btnH);
 }
 
-// touchpad logic
-inline void touchpadInput(int x, int y, bool isPressed) {
-  unsigned long now = millis();
-
-  if (isPressed && !touch.isPressed) {
-    touch.lastX = x; touch.lastY = y;
-    touch.wasDragging = false; touch.isPressed = true;
-  } else if (isPressed && touch.isPressed) {
-    int dx = (x - touch.lastX) * TouchpadState::MOUSE_SENSITIVITY;
-    int dy = (y - touch.lastY) * TouchpadState::MOUSE_SENSITIVITY;
-    if (abs(dx) > 2 || abs(dy) > 2) { sMouse.move(dx, dy); touch.wasDragging = true; }
-    touch.lastX = x; touch.lastY = y;
-  } else if (!isPressed && touch.isPressed) {
-    touch.isPressed = false;
-    if (!touch.wasDragging) {
-      if (now - touch.lastTapTime < TouchpadState::DOUBLE_TAP_TIMEOUT) {
-        touch.tapCount++;
-        if (touch.tapCount == 2) { sMouse.click(MOUSE_RIGHT); touch.tapCount=0; }
-      } else {
-        sMouse.click(MOUSE_LEFT);
-        touch.tapCount = 1;
-        touch.lastTapTime = now;
-      }
+// touchpad logic: drag moves the pointer, tap clicks, double tap right-clicks
+inline void touchpadInput(const TouchEvent& e) {
+  if (e.type == TOUCH_DRAG)            sMouse.move(e.dx * MOUSE_SENSITIVITY, e.dy * MOUSE_SENSITIVITY);
+  else if (e.type == TOUCH_TAP)        sMouse.click(MOUSE_LEFT);
+  else if (e.type == TOUCH_DOUBLE_TAP) sMouse.click(MOUSE_RIGHT);
+}
+
+// keys go down with the finger and come back up with it
+inline void keyboardInput(const TouchEvent& e) {
+  if (e.type == TOUCH_DOWN) {
+    int idx = hitKey(e.x, e.y);
+    lastIdx = idx;
+    if (idx >= 0) {
+      drawKey(keys[idx], true);
+      sendKey(keys[idx]);
     }
+  } else if (e.type == TOUCH_UP) {
+    if (lastIdx >= 0) drawKey(keys[lastIdx], false);
+    lastIdx = -1;
   }
-  if (now - touch.lastTapTime > TouchpadState::DOUBLE_TAP_TIMEOUT) touch.tapCount = 0;
 }
 
 // build keyboard layout
@@ -548,15 +529,8 @@ inline void buildLayout() {
   }
 }
 
-// one-time draw on activation
+// draw on activation
 inline void enterApp() {
-  static bool usbStarted = false;
-  if (!usbStarted) {
-    USB.begin();
-    sKeyboard.begin();
-    sMouse.begin();
-    usbStarted = true;
-  }
   if (M5.Display.isEPD()) M5.Display.setEpdMode(epd_mode_t::epd_fastest);
 
   M5.Display.setTextWrap(false);
@@ -572,78 +546,56 @@ inline void enterApp() {
 } 
 
 // ===================== Public API =====================
-void hid_begin() {
-  static bool inited = false;
-  if (inited) return;
-  inited = true;
-  USB.begin(); 
+void hid_init() {
+  static bool usbStarted = false;
+  if (usbStarted) return;
+  USB.begin();
+  sKeyboard.begin();
+  sMouse.begin();
+  usbStarted = true;
 }
 
-void hid_setActive(bool on) { g_hidActive = on; }
-bool hid_isActive()         { return g_hidActive; }
-
-bool hid_justExited() {
-  bool v = g_hidJustExited;
-  g_hidJustExited = false;
-  return v;
+void hid_resume() {
+  enterApp();
 }
 
 bool hid_tick() {
-  if (!g_hidActive) return false;
-
   SCR_W = M5.Display.width();
   SCR_H = M5.Display.height();
 
-  static bool shown = false;
-  if (!shown) { enterApp(); shown = true; }
-
-  M5.update();
-  auto t = M5.Touch.getDetail();
-  bool pressed = t.isPressed();
+  TouchEvent e;
+  while (touchPoll(e)) {
+    // Exit to Calendar? On the tap, so the rest of the press stays here
+    if (touchIsTap(e) && hitExit(e.x, e.y)) return false;
 
-  // Exit to Calendar?
-  if (pressed && hitExit(t.x, t.y)) {
-    g_hidActive = false;
-    shown = false;
-
-    if (M5.Display.isEPD()) M5.Display.setEpdMode(epd_mode_t::epd_fastest);
-    M5.Display.setTextWrap(false);
-    M5.Display.setTextDatum(textdatum_t::top_left);
-    M5.Display.setTextSize(1.0f);
-    M5.Display.setTextColor(TEXT, BG);
-    M5.Display.setFont(&fonts::Font0);
-    M5.Display.fillScreen(BG);
-
-    g_hidJustExited = true;
-    return false;
+    if (sMode == MODE_KEYBOARD) keyboardInput(e);
+    else if (touchIsTap(e) && hitTouchpadModeBtn(e.x, e.y)) { sMode = MODE_KEYBOARD; drawAll(true); }
+    else touchpadInput(e);
   }
+  return true;
+}
 
-  if (sMode == MODE_KEYBOARD) {
-    if (pressed && !wasPressed) {
-      int idx = hitKey(t.x, t.y);
-      lastIdx = idx;
-      if (idx >= 0) {
-        drawKey(keys[idx], true);
-        sendKey(keys[idx]);
-      }
-    } else if (!pressed && wasPressed) {
-      if (lastIdx >= 0) drawKey(keys[lastIdx], false);
-      lastIdx = -1;
-    }
-    wasPressed = pressed;
-  } else {
-    if (pressed) {
-      if (hitTouchpadModeBtn(t.x, t.y)) {
-        sMode = MODE_KEYBOARD;
-        drawAll(true);
-      } else {
-        touchpadInput(t.x, t.y, true);
-      }
-    } else {
-      touchpadInput(t.x, t.y, false);
-    }
-  }
+void hid_suspend() {
+  // Nothing stays pressed on the host while we are away
+  sKeyboard.releaseAll();
+  sMouse.release(MOUSE_ALL);
+  kShift = kCtrl = kAlt = false;
+  lastIdx = -1;
+  keys.clear();
+  keys.shrink_to_fit();
+
+  // Hand the display back the way the calendar draws
+  if (M5.Display.isEPD()) M5.Display.setEpdMode(epd_mode_t::epd_fastest);
+  M5.Display.setTextWrap(false);
+  M5.Display.setTextDatum(textdatum_t::top_left);
+  M5.Display.setTextSize(1.0f);
+  M5.Display.setTextColor(TEXT, BG);
+  M5.Display.setFont(&fonts::Font0);
+}
 
-  delay(5);
-  return true;  // HID handled the frame
+void hid_teardown() {
+  // USB cannot be stopped cleanly and stays enumerated; hid_init() finds it
+  // running. The next open starts as a fresh one would.
+  sMode = MODE_KEYBOARD;
+  kCaps = false;
 }
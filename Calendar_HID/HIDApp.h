@@ -3,16 +3,14 @@
 
 #include <M5Unified.h>
 
-// Public API for the USB HID Keyboard + Touchpad app
-// Call hid_begin() once from setup() (after M5.begin).
-// In loop(): if (hid_tick()) return;  // HID handled this frame
-// To enter:  hid_setActive(true);
-// To know if it just exited (so you can redraw calendar once): if (hid_justExited()) { /* redraw */ }
+// USB HID Keyboard + Touchpad app, driven by the app host (AppHost.h):
+// hid_init() on the first open, then hid_resume() / hid_tick() / hid_suspend()
+// each time it comes to the front and leaves it, hid_teardown() on close.
 
-void hid_begin();                 // init USB once (idempotent)
-void hid_setActive(bool on);      // enter/exit HID app
-bool hid_isActive();              // current active state
-bool hid_justExited();            // true once after exiting back to calendar
-bool hid_tick();                  // draw + input; returns true if HID handled the frame
+void hid_init();                  // start USB keyboard + mouse (once)
+void hid_resume();                // build the key layout and draw it
+bool hid_tick();                  // input; false once Exit is tapped
+void hid_suspend();               // release held keys, free the layout
+void hid_teardown();              // back to keyboard mode, toggles cleared
 
 #endif // HIDAPP_H
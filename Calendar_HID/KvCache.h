@@ -0,0 +1,206 @@
+#ifndef KVCACHE_H
+#define KVCACHE_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include <map>
+
+// ---------- Key/value cache (RAM LRU over an SD log) ----------
+// Small string values (company names, a day's headlines) keyed like
+// "P:AAPL" or "N:AAPL:2026-10-19". Lookups hit a RAM LRU first, then the
+// append-only log on SD, where the last record for a key wins. Each record
+// carries its own expiry. Expired values are still returned, flagged stale,
+// so a view can draw them right away and refresh behind them.
+//
+// Keys looked up on SD and not found are remembered (a small ring of key
+// hashes), so a symbol with no cached entry costs one log scan, not one per
+// lookup; put() forgets them. Until the clock is set nothing counts as
+// fresh, and a compaction the log needs waits until then, so records are
+// not judged expired against 1970.
+//
+// Log line:  <expires epoch>\t<key>\t<value>\n
+//
+//   String v;
+//   int r = kv.get("P:AAPL", v, now);   // KV_FRESH / KV_STALE / KV_MISS
+//   kv.put("P:AAPL", name, 30 * 86400, now);
+
+enum KvResult : int8_t { KV_MISS = -1, KV_STALE = 0, KV_FRESH = 1 };
+
+struct KvCache {
+  static const int      SLOTS        = 24;
+  static const int      KEY_LEN      = 32;
+  static const uint32_t GRACE_S      = 7 * 86400;   // stale records kept this long
+  static const uint32_t COMPACT_SIZE = 32 * 1024;   // rewrite the log past this
+  static const int      MISS_SLOTS   = 16;          // keys known not to be on SD
+  static const uint32_t VALID_EPOCH  = 1700000000;  // earlier = SNTP not done yet
+
+  struct Slot { char key[KEY_LEN]; String value; uint32_t expires; uint32_t used; };
+
+  Slot        slot[SLOTS];
+  uint32_t    tick = 0;
+  const char* path = "/cache/kv.log";
+  uint32_t    missHash[MISS_SLOTS];
+  int         missNext = 0;
+  bool        compactDue = false;
+  uint32_t    hits = 0, stale = 0, sdHits = 0, misses = 0, knownMisses = 0;
+
+  void begin(const char* logPath = "/cache/kv.log") {
+    path = logPath;
+    for (int i = 0; i < SLOTS; ++i) { slot[i].key[0] = 0; slot[i].used = 0; }
+    for (int i = 0; i < MISS_SLOTS; ++i) missHash[i] = 0;
+    if (!SD.exists("/cache")) SD.mkdir("/cache");
+    File f = SD.open(path, FILE_READ);
+    size_t sz = f ? f.size() : 0;
+    if (f) f.close();
+    compactDue = sz > COMPACT_SIZE;     // done by the first get/put with a set clock
+  }
+
+  static uint32_t hashKey(const char* key) {      // FNV-1a; 0 marks an empty slot
+    uint32_t h = 2166136261u;
+    while (*key) { h ^= (uint8_t)*key++; h *= 16777619u; }
+    return h ? h : 1;
+  }
+
+  bool knownMiss(uint32_t h) const {
+    for (int i = 0; i < MISS_SLOTS; ++i) if (missHash[i] == h) return true;
+    return false;
+  }
+
+  void forgetMiss(uint32_t h) {
+    for (int i = 0; i < MISS_SLOTS; ++i) if (missHash[i] == h) missHash[i] = 0;
+  }
+
+  void maybeCompact(uint32_t now) {
+    if (!compactDue || now < VALID_EPOCH) return;
+    compactDue = false;
+    compact(now);
+  }
+
+  int findSlot(const char* key) const {
+    for (int i = 0; i < SLOTS; ++i) if (slot[i].key[0] && !strcmp(slot[i].key, key)) return i;
+    return -1;
+  }
+
+  int victimSlot() const {
+    int v = 0;
+    for (int i = 0; i < SLOTS; ++i) {
+      if (!slot[i].key[0]) return i;
+      if (slot[i].used < slot[v].used) v = i;
+    }
+    return v;
+  }
+
+  void remember(const char* key, const String& value, uint32_t expires) {
+    int i = findSlot(key);
+    if (i < 0) { i = victimSlot(); strlcpy(slot[i].key, key, KEY_LEN); }
+    slot[i].value = value;
+    slot[i].expires = expires;
+    slot[i].used = ++tick;
+  }
+
+  // Splits "<exp>\t<key>\t<value>"; value may itself contain tabs
+  static bool parseLine(const String& line, uint32_t& exp, String& key, String& value) {
+    int a = line.indexOf('\t');
+    int b = a < 0 ? -1 : line.indexOf('\t', a + 1);
+    if (b < 0) return false;
+    exp = (uint32_t)strtoul(line.c_str(), nullptr, 10);
+    key = line.substring(a + 1, b);
+    value = line.substring(b + 1);
+    return true;
+  }
+
+  // Latest record for `key` in the log
+  bool sdLookup(const char* key, String& value, uint32_t& expires) {
+    File f = SD.open(path, FILE_READ);
+    if (!f) return false;
+    bool found = false;
+    String k, v; uint32_t e;
+    while (f.available()) {
+      String line = f.readStringUntil('\n');
+      if (!parseLine(line, e, k, v) || k != key) continue;
+      value = v; expires = e; found = true;
+    }
+    f.close();
+    return found;
+  }
+
+  KvResult get(const char* key, String& out, uint32_t now) {
+    maybeCompact(now);
+    int i = findSlot(key);
+    uint32_t exp = 0;
+    if (i >= 0) {
+      slot[i].used = ++tick;
+      out = slot[i].value; exp = slot[i].expires;
+    } else {
+      uint32_t h = hashKey(key);
+      if (knownMiss(h)) { knownMisses++; return KV_MISS; }
+      if (!sdLookup(key, out, exp)) {
+        missHash[missNext] = h;
+        missNext = (missNext + 1) % MISS_SLOTS;
+        misses++;
+        return KV_MISS;
+      }
+      remember(key, out, exp);
+      sdHits++;
+    }
+    if (now >= VALID_EPOCH && now < exp) { hits++; return KV_FRESH; }
+    stale++;
+    return KV_STALE;
+  }
+
+  void put(const char* key, String value, uint32_t ttlS, uint32_t now) {
+    value.replace('\n', ' '); value.replace('\r', ' ');
+    uint32_t exp = now + ttlS;
+    remember(key, value, exp);
+    forgetMiss(hashKey(key));
+    File f = SD.open(path, FILE_APPEND);
+    if (!f) return;
+    f.printf("%lu\t%s\t", (unsigned long)exp, key);
+    f.print(value);
+    f.print('\n');
+    size_t sz = f.size();
+    f.close();
+    if (sz > COMPACT_SIZE) compactDue = true;
+    maybeCompact(now);
+  }
+
+  // Rewrite the log with only the latest record per key, dropping records
+  // that expired more than GRACE_S ago
+  void compact(uint32_t now) {
+    std::map<String, uint32_t> last;     // key -> line number of its latest record
+    File f = SD.open(path, FILE_READ);
+    if (!f) return;
+    String k, v; uint32_t e, n = 0;
+    while (f.available()) {
+      String line = f.readStringUntil('\n');
+      if (parseLine(line, e, k, v)) last[k] = n;
+      n++;
+    }
+    f.close();
+
+    String tmp = String(path) + ".tmp";
+    SD.remove(tmp.c_str());
+    File in = SD.open(path, FILE_READ);
+    File out = SD.open(tmp.c_str(), FILE_WRITE);
+    if (!in || !out) { if (in) in.close(); if (out) out.close(); return; }
+    uint32_t kept = 0; n = 0;
+    while (in.available()) {
+      String line = in.readStringUntil('\n');
+      bool keep = parseLine(line, e, k, v) && last[k] == n && e + GRACE_S > now;
+      if (keep) { out.print(line); out.print('\n'); kept++; }
+      n++;
+    }
+    in.close(); out.close();
+    SD.remove(path);
+    SD.rename(tmp.c_str(), path);
+    Serial.printf("kv: compacted %lu -> %lu records\n", (unsigned long)n, (unsigned long)kept);
+  }
+
+  void logStats() const {
+    Serial.printf("kv: %lu fresh, %lu stale, %lu from SD, %lu miss (%lu more without a scan)\n",
+                  (unsigned long)hits, (unsigned long)stale, (unsigned long)sdHits,
+                  (unsigned long)misses, (unsigned long)knownMisses);
+  }
+};
+
+#endif // KVCACHE_H
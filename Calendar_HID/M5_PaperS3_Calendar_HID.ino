@@ -10,12 +10,204 @@
 #include "Drawing.h"
 #include "Secrets.h"
 #include "WiFiUtil.h"
+#include "BootLog.h"
 #include "HIDApp.h"
+#include "Perf.h"
+#include "ConfigServer.h"
+#include "TouchInput.h"
+#include "DeltaOta.h"
+#include "AppHost.h"
+#include "CryptoApp.h"
+#include "ClockApp.h"
+
+// Boot is staged so the slow parts overlap: the WiFi join runs in the WiFi
+// task while we parse the cached calendars from SD and draw the first frame.
+// Weather, fresh calendars and the RTC sync happen from loop() once the
+// link comes up.
+static bool g_onlineOnce   = false;
+static bool g_rtcSynced    = false;
+static bool g_fetchPending = false;   // link came up while the HID app was in front
+
+void onNetworkUp() {
+  if (!g_onlineOnce) bootMark("network up");
+  Serial.println("Fetching weather...");
+  bool wx = fetchWeather();
+  if (wx) saveWeather();
+  lastWxMS = millis();
+  Serial.println("Fetching calendar...");
+  uint32_t dirty = fetchCalendar();
+  // Without new weather only the days whose events changed are repainted
+  if (wx || !g_onlineOnce) drawAll();
+  else                     drawDayCards(dirty);
+  if (!g_onlineOnce) { bootMark("online frame"); bootSummary(); }
+  g_onlineOnce = true;
+}
+
+// The stocks app's API keys live in secrets.txt here
+void cryptoKeysFromSecrets() {
+  g_cryptoCfg.finnhubKey        = finnhubKey;
+  g_cryptoCfg.finnhubBackupKey  = finnhubBackupKey;
+  g_cryptoCfg.coindeskKey       = coindeskKey;
+  g_cryptoCfg.coindeskBackupKey = coindeskBackupKey;
+}
+
+// secrets.txt edited on the config page (ConfigServer.h): new feeds, keys
+// and networks apply without a reboot; the link stays up
+void onSecretsSaved() {
+  loadSecretsFromSD();
+  cryptoKeysFromSecrets();
+  net_update(wifiCredsFromSecrets());
+  if (net_isUp()) g_fetchPending = true;   // refetch + redraw once the calendar is in front
+}
+
+// ---------- Apps ----------
+// The calendar, the HID keyboard/touchpad, the stocks watchlist and the
+// clock are apps of one AppHost (AppHost.h), opened from the buttons in the
+// calendar's header. The calendar is home: Exit, Home or Return in the
+// others comes back to it. Alarms ring over whichever one is in front.
+static AppHost g_apps;
+static int APP_CALENDAR = -1, APP_HID = -1, APP_STOCKS = -1, APP_CLOCK = -1;
+
+// Below this much internal heap the apps in the background are closed;
+// TLS for the next fetch needs it more than their caches do
+static const uint32_t APP_HEAP_FLOOR = 48 * 1024;
+
+// Pause between loop passes, outside every tick's timing; the touchpad
+// polls faster so a drag follows the finger
+static const uint32_t LOOP_MS = 30, HID_LOOP_MS = 5;
+
+// First open: the SD copies of the calendars and weather (RTC time until
+// NTP lands)
+bool calendarInit(void*) {
+  fetchCalendar();
+  bootMark("calendar cache parsed");
+  struct tm t{};
+  readLocal(t);
+  lastMinute = -1;
+  lastHour = t.tm_hour;
+  lastY = t.tm_year + 1900;
+  lastM = t.tm_mon + 1;
+  lastD = t.tm_mday;
+  lastWxMS = millis();
+  if (loadWeather()) Serial.println("Weather from SD until the network is up");
+  return true;
+}
+
+// Back in front: everything drawn comes from what is in memory
+void calendarResume(void*) {
+  touchClear();                       // presses made on the other app's screen
+  uiFontsBegin();
+  Serial.println("Drawing display...");
+  drawAll();
+  if (g_apps.app[APP_CALENDAR].st.opens) g_apps.report();
+}
+
+bool calendarTick(void*) {
+  PerfScope tick("loop", PERF_TICK);
+  if (g_fetchPending) { g_fetchPending = false; onNetworkUp(); }
+
+  struct tm t{};
+  bool haveTime = readLocal(t);
+
+  // Write NTP time back to the RTC once SNTP has actually synced
+  if (!g_rtcSynced && net_isUp() && time(nullptr) > 1700000000) {
+    syncRTCFromNTP();
+    g_rtcSynced = true;
+    bootMark("rtc synced");
+  }
+
+  // Touch events since the last pass
+  TouchEvent te;
+  while (touchPoll(te)) {
+    // App buttons in the header, in HEADER_APPS order
+    int btn = touchIsTap(te) ? headerAppAt(te.x, te.y) : -1;
+    if (btn >= 0) {
+      const int apps[HEADER_APP_COUNT] = { APP_HID, APP_CLOCK, APP_STOCKS };
+      g_apps.open(apps[btn]);
+      return true;   // switched at the start of the next tick
+    }
+    if (g_agendaOpen) agendaTouch(te);
+    else if (haveTime) viewTap(te, t);
+  }
+
+  // Marquees scroll while the panel is being touched
+  uint32_t pressMs = touchLastMs();
+  g_marqueeTouchActive = pressMs && millis() - pressMs < 1200;
+
+  updateMarquees();
+
+  // Hourly strip: slide along once per hour (before the header, which shows the same hour)
+  if (haveTime && t.tm_hour != lastHour) {
+    if (lastHour >= 0) drawHourly();
+    lastHour = t.tm_hour;
+  }
+
+  // Header clock: redraw once per minute
+  if (haveTime && t.tm_min != lastMinute) {
+    lastMinute = t.tm_min;
+    M5.Display.fillRect(0, 0, SCREEN_W, HEADER_H, SUBTLE);
+    drawHeader(t);
+  }
+
+  // Calendar: refresh at midnight
+  if (haveTime) {
+    int y = t.tm_year + 1900, m = t.tm_mon + 1, d = t.tm_mday;
+    if (y != lastY || m != lastM || d != lastD) {
+      lastY = y; lastM = m; lastD = d;
+      fetchCalendar();   // falls back to the SD copies when offline
+      drawAll();
+    }
+  }
+
+  // Weather: refresh every 30 minutes
+  if (millis() - lastWxMS > WX_PERIOD) {
+    if (WiFi.status() == WL_CONNECTED && fetchWeather()) saveWeather();
+    lastWxMS = millis();
+    drawAll();
+  }
+
+  tick.end();
+  return true;
+}
+
+void calendarSuspend(void*)  { calendarRelease(); }
+void calendarTeardown(void*) { calendarDrop(); }
+
+static const AppOps CALENDAR_APP = { "calendar", calendarInit, calendarResume, calendarTick, calendarSuspend, calendarTeardown };
+
+bool hidAppInit(void*)     { hid_init(); return true; }
+void hidAppResume(void*)   { touchClear(); hid_resume(); }
+bool hidAppTick(void*)     { PERF_SCOPE("hid_tick", PERF_TICK); return hid_tick(); }
+void hidAppSuspend(void*)  { hid_suspend(); }
+void hidAppTeardown(void*) { hid_teardown(); }
+
+static const AppOps HID_APP = { "hid", hidAppInit, hidAppResume, hidAppTick, hidAppSuspend, hidAppTeardown };
+
+bool stocksAppInit(void*)     { return crypto_init(); }
+void stocksAppResume(void*)   { touchClear(); crypto_resume(); }
+bool stocksAppTick(void*)     { PERF_SCOPE("stocks_tick", PERF_TICK); return crypto_tick(); }
+void stocksAppSuspend(void*)  { crypto_suspend(); }
+void stocksAppTeardown(void*) { crypto_teardown(); }
+
+static const AppOps STOCKS_APP = { "stocks", stocksAppInit, stocksAppResume, stocksAppTick, stocksAppSuspend, stocksAppTeardown };
+
+bool clockAppInit(void*)     { return clock_init(); }
+void clockAppResume(void*)   { touchClear(); clock_resume(); }
+bool clockAppTick(void*)     { PERF_SCOPE("clock_tick", PERF_TICK); return clock_tick(); }
+void clockAppSuspend(void*)  { clock_suspend(); }
+void clockAppTeardown(void*) { clock_teardown(); }
+
+static const AppOps CLOCK_APP = { "clock", clockAppInit, clockAppResume, clockAppTick, clockAppSuspend, clockAppTeardown };
+
+// Watchlist, alert, alarm and world-clock files saved on the config page
+void onWatchlistSaved() { crypto_reload(g_apps.inFront(APP_STOCKS)); }
+void onAlarmsSaved()    { alarmsReload(); }
+void onClocksSaved()    { clock_reloadZones(); }
 
 void setup() {
   Serial.begin(115200);
-  delay(1000);
   Serial.println("\n\n=== M5Paper S3 Calendar Starting ===");
+  bootMark("reset");
 
   auto cfg = M5.config();
   cfg.clear_display = true;
@@ -28,6 +220,8 @@ void setup() {
   M5.Display.setRotation(1);
   M5.Display.setTextColor(TEXT);
   M5.Display.fillScreen(BG);
+  touchBegin();
+  bootMark("display");
 
   // Initialize SD card
   Serial.println("Initializing SD card...");
@@ -44,6 +238,8 @@ void setup() {
   }
 
   Serial.println("SD card initialized successfully");
+  bootMark("sd mounted");
+  if (otaFromSd("/update/calendar_hid.dlt")) ESP.restart();   // a firmware patch left on the card
 
   // Load credentials from SD card
   if (!loadSecretsFromSD("/secrets.txt")) {
@@ -55,112 +251,57 @@ void setup() {
     M5.Display.print("Please create secrets.txt on SD card");
     return;  // Cannot continue without credentials
   }
+  bootMark("config");
+  cryptoKeysFromSecrets();
+  cfgServe("/secrets.txt", "Calendars, WiFi and keys", onSecretsSaved, cfgSecretsKeyValue);
+  cfgServe("/Wifi/STOCK.txt", "Watchlist", onWatchlistSaved);
+  cfgServe("/Wifi/ALERTS.txt", "Price alerts", onWatchlistSaved);
+  cfgServe("/Wifi/ALARMS.txt", "Alarms", onAlarmsSaved);
+  cfgServe("/Wifi/CLOCKS.txt", "World clocks", onClocksSaved);
+  alarmsBegin();
+  cfgServeUpdate(otaFromUrl);
 
-  // Connect to WiFi
-  Serial.println("Connecting to WiFi...");
-  if (!connectWiFiWithFallback(15000)) {
-    Serial.println("WARNING: WiFi connection failed - continuing with limited functionality");
-    M5.Display.setTextSize(2);
-    M5.Display.setCursor(20, 20);
-    M5.Display.print("WiFi connection failed");
-    M5.Display.setCursor(20, 50);
-    M5.Display.print("Check credentials in secrets.txt");
-    delay(3000);
-  }
-
-  // Setup time
+  // Start joining WiFi; net_tick() in loop() finishes it
+  net_begin(wifiCredsFromSecrets());
   setupTime();
-  delay(1200);
-  syncRTCFromNTP();
-
-  // Fetch data
-  lastWxMS = millis();
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("Fetching weather...");
-    fetchWeather();
-    Serial.println("Fetching calendar...");
-    fetchCalendar();
-  } else {
-    Serial.println("Skipping data fetch - no WiFi connection");
-  }
-
-  struct tm t{};
-  readLocal(t);
-  lastMinute = -1;
-  lastY = t.tm_year + 1900;
-  lastM = t.tm_mon + 1;
-  lastD = t.tm_mday;
+  bootMark("wifi + sntp started");
 
-  Serial.println("Drawing display...");
-  drawAll();
+  // The calendar is home and comes up first; the others set up on their
+  // first open (the HID app starts USB then). The clock keeps to the RTC
+  // until NTP lands, as the calendar header does.
+  g_cryptoCfg.zone = TZ_ZONE;
+  g_clockCfg.zone = TZ_ZONE;
+  g_clockCfg.localTime = readLocal;
+  g_clockCfg.syncTime = syncRTCFromNTP;
+  appHostBegin(g_apps);
+  APP_CALENDAR = g_apps.add(&CALENDAR_APP, nullptr);
+  APP_HID      = g_apps.add(&HID_APP, nullptr);
+  APP_STOCKS   = g_apps.add(&STOCKS_APP, nullptr);
+  APP_CLOCK    = g_apps.add(&CLOCK_APP, nullptr);
+  g_apps.switchTo(APP_CALENDAR);
+  bootMark("first frame");
   Serial.println("Setup complete!");
-
-  // Start USB HID 
-  hid_begin();
 }
 
 void loop() {
-  // If HID app is active, let it handle UI for this frame
-  if (hid_tick()) return;
-// If HID just exited, clear+redraw calendar once (no fetch)
-if (hid_justExited()) {
-  clearMarquees();
-  drawAll();
-  return;
-}
-
-  struct tm t{};
-  bool haveTime = readLocal(t);
+  // Keep the link alive whichever app owns the screen
+  net_tick();
+  if (net_justConnected()) { g_fetchPending = true; cfgBegin(); }
+  cfgTick();
 
-  M5.update();
-  auto td = M5.Touch.getDetail();
-
-  // Tap-to-open HID button in the header
-  bool justTapped = td.wasPressed();   // single-edge tap detection
-  const int hidBtnW = 80, hidBtnH = 30;
-  const int hidBtnX = SCREEN_W - 90;
-  const int hidBtnY = HEADER_H - hidBtnH - 6;
-  if (justTapped &&
-      td.x >= hidBtnX && td.x < hidBtnX + hidBtnW &&
-      td.y >= hidBtnY && td.y < hidBtnY + hidBtnH) {
-    hid_setActive(true);
-    return; // next loop call, hid_tick() will draw HID UI
-  }
+  alarmsService();
 
-  // Marquee touch activation
-  static unsigned long touchExpire = 0;
-  if (td.isPressed() || td.wasPressed()) {
-    g_marqueeTouchActive = true;
-    touchExpire = millis() + 1200;
-  } else if (millis() > touchExpire) {
-    g_marqueeTouchActive = false;
-  }
-
-  updateMarquees();
-
-  // Header clock: redraw once per minute
-  if (haveTime && t.tm_min != lastMinute) {
-    lastMinute = t.tm_min;
-    M5.Display.fillRect(0, 0, SCREEN_W, HEADER_H, SUBTLE);
-    drawHeader(t);   // NOTE: drawHeader() should include the HID button drawing
+  // Stats overlay: when it closes, repaint the app under it
+  if (perfPoll()) {
+    if (g_apps.inFront(APP_CALENDAR))    drawAll();
+    else if (g_apps.inFront(APP_STOCKS)) crypto_redraw();
+    else if (g_apps.inFront(APP_CLOCK))  clock_redraw();
+    else if (g_apps.inFront(APP_HID))    hid_resume();
   }
 
-  // Calendar: refresh at midnight
-  if (haveTime) {
-    int y = t.tm_year + 1900, m = t.tm_mon + 1, d = t.tm_mday;
-    if (y != lastY || m != lastM || d != lastD) {
-      lastY = y; lastM = m; lastD = d;
-      if (WiFi.status() == WL_CONNECTED) fetchCalendar();
-      drawAll();
-    }
-  }
-
-  // Weather: refresh every 30 minutes
-  if (millis() - lastWxMS > WX_PERIOD) {
-    if (WiFi.status() == WL_CONNECTED) fetchWeather();
-    lastWxMS = millis();
-    drawAll();
-  }
+  if (ESP.getFreeHeap() < APP_HEAP_FLOOR && g_apps.closeBackground())
+    Serial.printf("low heap: background apps closed, %u B free\n", (unsigned)ESP.getFreeHeap());
 
-  delay(30);
+  g_apps.tick();
+  delay(g_apps.inFront(APP_HID) ? HID_LOOP_MS : LOOP_MS);
 }
@@ -2,6 +2,8 @@
 #define MARQUEE_H
 
 #include "AppState.h"
+#include "Perf.h"
+#include "GlyphFont.h"
 
 inline void clearMarquees() {
   for (auto &m : marquees) {
@@ -10,6 +12,17 @@ inline void clearMarquees() {
   marquees.clear();
 }
 
+// Drop the marquees inside one day card before it is redrawn
+inline void clearMarqueesIn(int x,int y,int w,int h) {
+  for (size_t i = 0; i < marquees.size(); ) {
+    Marquee& m = marquees[i];
+    if (m.x >= x && m.x < x + w && m.y >= y && m.y < y + h) {
+      if (m.sp) { m.sp->deleteSprite(); delete m.sp; }
+      marquees.erase(marquees.begin() + i);
+    } else ++i;
+  }
+}
+
 inline void addMarquee(int x,int y,int w,int h,const String& text,int textSize) {
   M5Canvas* sp = new M5Canvas(&M5.Display);
   sp->setColorDepth(8);
@@ -18,19 +31,17 @@ inline void addMarquee(int x,int y,int w,int h,const String& text,int textSize)
   sp->setTextWrap(false);
   sp->setTextSize(textSize);
 
-  int textW = sp->textWidth(text.c_str());
-  int lh    = sp->fontHeight();
+  int textW = uiTextWidth(*sp, text, textSize);
+  int lh    = uiLineH(*sp, textSize);
   int gap   = 32;
   int loopW = textW + gap + w;
 
   if (textW <= w) {
     sp->deleteSprite();
     delete sp;
-    M5.Display.setTextSize(textSize);
     M5.Display.setTextColor(TEXT, BG);
-    M5.Display.setCursor(x, y);
     M5.Display.setClipRect(x, y, w, lh + 2);
-    M5.Display.print(text);
+    uiText(M5.Display, x, y, text, textSize, TEXT);
     M5.Display.clearClipRect();
     return;
   }
@@ -40,8 +51,8 @@ inline void addMarquee(int x,int y,int w,int h,const String& text,int textSize)
   sp->fillSprite(BG);
   sp->setTextColor(TEXT, BG);
   sp->setTextSize(textSize);
-  sp->setCursor(0, 0);                 sp->print(text);
-  sp->setCursor(textW + gap, 0);       sp->print(text);
+  uiText(*sp, 0, 0, text, textSize, TEXT);
+  uiText(*sp, textW + gap, 0, text, textSize, TEXT);
 
   Marquee m;
   m.x = x; m.y = y; m.w = w; m.h = lh + 2;
@@ -72,6 +83,7 @@ inline void updateMarquees() {
     if (!m.sp) continue;
     if (now - m.lastMs < MARQUEE_STEP_MS) continue;
     m.lastMs = now;
+    PERF_SCOPE("marquee step", PERF_RENDER);
 
     m.offset += m.speed;
     if (m.offset >= m.loopW) m.offset -= m.loopW;
@@ -0,0 +1,211 @@
+#ifndef POLLPOLICY_H
+#define POLLPOLICY_H
+
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+// ---------- Quote polling policy ----------
+// How long to wait before asking for a symbol's quote again. Stocks follow
+// the NYSE session (pre-market, regular, after-hours, closed incl.
+// holidays); crypto trades around the clock. Inside a session the interval
+// shrinks when the price is moving and doubles every time it comes back
+// unchanged. Plain C++: pass New York local time and epoch seconds, so a
+// host build can replay a recorded price tape against a simulated clock.
+//
+//   MarketSession s = nyseSession(etLocalTm);
+//   pollObserve(st, price, now, isCrypto, s, nyseSecondsToChange(etLocalTm));
+//   if (now >= st.nextAt) ...fetch again...
+
+enum MarketSession : uint8_t { SESS_CLOSED, SESS_PRE, SESS_REGULAR, SESS_AFTER };
+
+inline const char* sessionName(MarketSession s) {
+  switch (s) {
+    case SESS_PRE:     return "pre";
+    case SESS_REGULAR: return "regular";
+    case SESS_AFTER:   return "after";
+    default:           return "closed";
+  }
+}
+
+// ---------- NYSE calendar ----------
+inline int pp_dow(int y, int m, int d) {           // 0 = Sunday (Sakamoto)
+  static const int t[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+  if (m < 3) y -= 1;
+  return (y + y / 4 - y / 100 + y / 400 + t[m - 1] + d) % 7;
+}
+
+// n-th (1-based) weekday `dow` of month; n = -1 for the last one
+inline int pp_nthDow(int y, int m, int dow, int n) {
+  static const int mdays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  int len = mdays[m - 1] + (m == 2 && ((y % 4 == 0 && y % 100 != 0) || y % 400 == 0));
+  if (n > 0) {
+    int first = pp_dow(y, m, 1);
+    return 1 + (dow - first + 7) % 7 + (n - 1) * 7;
+  }
+  int last = pp_dow(y, m, len);
+  return len - (last - dow + 7) % 7;
+}
+
+inline void pp_easter(int y, int& m, int& d) {      // Anonymous Gregorian
+  int a = y % 19, b = y / 100, c = y % 100, d1 = b / 4, e = b % 4;
+  int f = (b + 8) / 25, g = (b - f + 1) / 3, h = (19 * a + b - d1 - g + 15) % 30;
+  int i = c / 4, k = c % 4, l = (32 + 2 * e + 2 * i - h - k) % 7;
+  int mm = (a + 11 * h + 22 * l) / 451;
+  m = (h + l - 7 * mm + 114) / 31;
+  d = ((h + l - 7 * mm + 114) % 31) + 1;
+}
+
+// Fixed-date holiday observed on Friday when it falls on Saturday and on
+// Monday when it falls on Sunday
+inline bool pp_observed(int y, int m, int d, int hm, int hd) {
+  int w = pp_dow(y, hm, hd);
+  if (m == hm && d == hd) return w != 0 && w != 6;
+  if (w == 6) { // Saturday -> Friday before
+    int pm = hm, pd = hd - 1;
+    return pd >= 1 && m == pm && d == pd;
+  }
+  if (w == 0) return m == hm && d == hd + 1;
+  return false;
+}
+
+inline bool nyseHoliday(int y, int m, int d) {
+  // New Year's Day: a Saturday New Year is not made up on Dec 31
+  if (m == 1 && d == 1 && pp_dow(y, 1, 1) != 6 && pp_dow(y, 1, 1) != 0) return true;
+  if (m == 1 && d == 2 && pp_dow(y, 1, 1) == 0) return true;
+  if (m == 1 && d == pp_nthDow(y, 1, 1, 3)) return true;     // MLK Day
+  if (m == 2 && d == pp_nthDow(y, 2, 1, 3)) return true;     // Presidents' Day
+  int em, ed; pp_easter(y, em, ed);                          // Good Friday
+  ed -= 2; if (ed < 1) { em -= 1; ed += 31; }                // March has 31 days
+  if (m == em && d == ed) return true;
+  if (m == 5 && d == pp_nthDow(y, 5, 1, -1)) return true;    // Memorial Day
+  if (y >= 2022 && pp_observed(y, m, d, 6, 19)) return true; // Juneteenth
+  if (pp_observed(y, m, d, 7, 4)) return true;               // Independence Day
+  if (m == 9 && d == pp_nthDow(y, 9, 1, 1)) return true;     // Labor Day
+  if (m == 11 && d == pp_nthDow(y, 11, 4, 4)) return true;   // Thanksgiving
+  if (pp_observed(y, m, d, 12, 25)) return true;             // Christmas
+  return false;
+}
+
+// 13:00 close: July 3, the day after Thanksgiving, Christmas Eve (weekdays)
+inline bool nyseEarlyClose(int y, int m, int d) {
+  int w = pp_dow(y, m, d);
+  if (w == 0 || w == 6) return false;
+  if (m == 7 && d == 3 && !nyseHoliday(y, m, d)) return true;
+  if (m == 11 && d == pp_nthDow(y, 11, 4, 4) + 1) return true;
+  if (m == 12 && d == 24 && !nyseHoliday(y, m, d)) return true;
+  return false;
+}
+
+// `et` is New York local time (tm_year/tm_mon as from localtime)
+inline MarketSession nyseSession(const struct tm& et) {
+  int y = et.tm_year + 1900, m = et.tm_mon + 1, d = et.tm_mday;
+  int w = pp_dow(y, m, d);
+  if (w == 0 || w == 6 || nyseHoliday(y, m, d)) return SESS_CLOSED;
+  int mins = et.tm_hour * 60 + et.tm_min;
+  int close = nyseEarlyClose(y, m, d) ? 13 * 60 : 16 * 60;
+  if (mins >= 4 * 60 && mins < 9 * 60 + 30) return SESS_PRE;
+  if (mins >= 9 * 60 + 30 && mins < close) return SESS_REGULAR;
+  if (mins >= close && mins < close + 4 * 60) return SESS_AFTER;
+  return SESS_CLOSED;
+}
+
+// Seconds from `et` until nyseSession() next changes (or midnight, where
+// the next day is looked at again). A poll backed off through a quiet night
+// is brought forward to the pre-market open instead of sleeping through it.
+inline uint32_t nyseSecondsToChange(const struct tm& et) {
+  int y = et.tm_year + 1900, m = et.tm_mon + 1, d = et.tm_mday;
+  int w = pp_dow(y, m, d);
+  int mins = et.tm_hour * 60 + et.tm_min;
+  int next = 24 * 60;
+  if (w != 0 && w != 6 && !nyseHoliday(y, m, d)) {
+    int close = nyseEarlyClose(y, m, d) ? 13 * 60 : 16 * 60;
+    const int edges[] = { 4 * 60, 9 * 60 + 30, close, close + 4 * 60 };
+    for (int e : edges) if (e > mins) { next = e; break; }
+  }
+  return (uint32_t)((next - mins) * 60 - et.tm_sec);
+}
+
+// New York local time from UTC epoch, for callers whose clock is not set to
+// Eastern (DST: second Sunday of March to first Sunday of November, 2:00)
+inline void nyseLocalTime(time_t utc, struct tm& et) {
+  time_t t = utc - 5 * 3600;
+  gmtime_r(&t, &et);
+  int y = et.tm_year + 1900, m = et.tm_mon + 1, d = et.tm_mday;
+  int start = pp_nthDow(y, 3, 0, 2), end = pp_nthDow(y, 11, 0, 1);
+  bool dst = (m > 3 && m < 11) ||
+             (m == 3  && (d > start || (d == start && et.tm_hour >= 2))) ||
+             (m == 11 && (d < end   || (d == end   && et.tm_hour < 1)));
+  if (dst) { t += 3600; gmtime_r(&t, &et); }
+}
+
+// ---------- Per-instrument state ----------
+struct PollState {
+  float    lastPrice;
+  float    vol;          // EWMA of |return| per poll
+  uint32_t interval;     // seconds until the next poll
+  uint32_t nextAt;       // epoch of the next poll, 0 = poll now
+  uint32_t firstAt;      // first poll, for the requests-saved report
+  uint32_t polls;
+  uint8_t  unchanged;    // consecutive identical prices
+};
+
+struct PollLimits { uint32_t base, floor, ceil; };
+
+static const uint32_t POLL_FIXED_S = 30;   // what the sketches used to do
+
+inline PollLimits pollLimits(bool crypto, MarketSession s) {
+  if (crypto)               return { 30,   15,   300 };
+  switch (s) {
+    case SESS_REGULAR:      return { 30,   15,   300 };
+    case SESS_PRE:
+    case SESS_AFTER:        return { 120,  60,   900 };
+    default:                return { 1800, 1800, 6 * 3600 };   // closed: the last print will not move
+  }
+}
+
+inline void pollReset(PollState& st) {
+  st.lastPrice = 0; st.vol = 0; st.interval = 0; st.nextAt = 0;
+  st.firstAt = 0; st.polls = 0; st.unchanged = 0;
+}
+
+// Feed every fetched price; sets st.interval and st.nextAt. `untilChange`
+// (nyseSecondsToChange, 0 = unknown) caps the wait at the session edge.
+inline void pollObserve(PollState& st, float price, uint32_t now, bool crypto, MarketSession sess,
+                        uint32_t untilChange = 0) {
+  PollLimits lim = pollLimits(crypto, sess);
+  if (!st.firstAt) st.firstAt = now;
+  st.polls++;
+
+  if (st.lastPrice > 0 && price == st.lastPrice) {
+    if (st.unchanged < 255) st.unchanged++;
+  } else {
+    if (st.lastPrice > 0) {
+      float r = fabsf(price - st.lastPrice) / st.lastPrice;
+      st.vol = st.vol * 0.7f + r * 0.3f;
+    }
+    st.unchanged = 0;
+  }
+  st.lastPrice = price;
+
+  uint32_t iv = lim.base;
+  if (st.vol > 0.004f)      iv /= 2;                 // > 0.4 % per poll: busy tape
+  else if (st.vol < 0.0005f) iv = iv * 3 / 2;        // barely moving
+  for (uint8_t i = 0; i < st.unchanged && iv < lim.ceil; ++i) iv *= 2;
+  if (iv < lim.floor) iv = lim.floor;
+  if (iv > lim.ceil)  iv = lim.ceil;
+  if (!crypto && untilChange && iv > untilChange) iv = untilChange;
+
+  st.interval = iv;
+  st.nextAt = now + iv;
+}
+
+// Polls a fixed POLL_FIXED_S cadence would have made since the first one,
+// minus what we actually made
+inline int32_t pollSaved(const PollState& st, uint32_t now) {
+  if (!st.firstAt) return 0;
+  int32_t fixed = (int32_t)((now - st.firstAt) / POLL_FIXED_S) + 1;
+  return fixed - (int32_t)st.polls;
+}
+
+#endif // POLLPOLICY_H
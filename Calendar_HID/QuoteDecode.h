@@ -0,0 +1,209 @@
+#ifndef QUOTEDECODE_H
+#define QUOTEDECODE_H
+
+#include <math.h>
+#include <ArduinoJson.h>
+
+// ---------- Streaming quote decoding ----------
+// Every API call parses straight off the socket into a small fixed-size
+// document. A filter keeps only the fields we show, so the body is never
+// copied into a String and never fully materialised on the heap.
+// useHTTP10() turns off chunked transfer so getStream() is the raw JSON.
+//
+// Each call logs how much heap it took while the response was live:
+//   json quote: 200, doc 96/256 B, heap -3140 B (min free 161204)
+//
+// The filters, document sizes and field mapping need only ArduinoJson, so
+// test/ replays recorded responses through the same code on a host.
+
+struct Quote {
+  float price, high, low, open, prevClose, changePct, volume;
+};
+
+static const int JSON_PARSE_FAILED = -100;   // returned in place of an HTTP code
+
+// ---------- Decoders ----------
+// Finnhub /quote -> c h l o pc (and v, when the feed has it)
+typedef StaticJsonDocument<128> FinnhubQuoteFilter;
+typedef StaticJsonDocument<192> FinnhubQuoteDoc;
+
+inline void finnhubQuoteFilter(JsonDocument& filter) {
+  filter["c"] = true; filter["h"] = true; filter["l"] = true; filter["o"] = true; filter["pc"] = true;
+  filter["v"] = true;
+}
+
+inline void finnhubQuoteFrom(const JsonDocument& doc, Quote& q) {
+  q.price     = doc["c"]  | 0.0f;
+  q.high      = doc["h"]  | 0.0f;
+  q.low       = doc["l"]  | 0.0f;
+  q.open      = doc["o"]  | 0.0f;
+  q.prevClose = doc["pc"] | 0.0f;
+  q.volume    = doc["v"]  | 0.0f;
+  q.changePct = (q.prevClose != 0.0f) ? ((q.price - q.prevClose) / q.prevClose) * 100.0f : 0.0f;
+}
+
+// Coindesk latest/tick -> Data.<instrument>.{VALUE, CURRENT_DAY_*}
+typedef StaticJsonDocument<384> CoindeskTickFilter;
+typedef StaticJsonDocument<512> CoindeskTickDoc;
+
+inline void coindeskTickFilter(JsonDocument& filter, const char* instrument) {
+  JsonObject f = filter["Data"].createNestedObject(instrument);
+  f["VALUE"] = true;
+  f["CURRENT_DAY_HIGH"] = true; f["CURRENT_DAY_LOW"] = true; f["CURRENT_DAY_OPEN"] = true;
+  f["CURRENT_DAY_VOLUME"] = true; f["CURRENT_DAY_CHANGE_PERCENTAGE"] = true;
+}
+
+// False when the reply has no record for the instrument
+inline bool coindeskTickFrom(const JsonDocument& doc, const char* instrument, Quote& q) {
+  JsonVariantConst rec = doc["Data"][instrument];
+  if (rec.isNull()) return false;
+  q.price     = rec["VALUE"] | 0.0f;
+  q.high      = rec["CURRENT_DAY_HIGH"] | 0.0f;
+  q.low       = rec["CURRENT_DAY_LOW"] | 0.0f;
+  q.open      = rec["CURRENT_DAY_OPEN"] | 0.0f;
+  q.prevClose = q.open;   // no separate prev close in this feed
+  q.volume    = rec["CURRENT_DAY_VOLUME"] | 0.0f;
+  if (rec.containsKey("CURRENT_DAY_CHANGE_PERCENTAGE")) {
+    q.changePct = rec["CURRENT_DAY_CHANGE_PERCENTAGE"].as<float>();
+    // If API returns a fraction instead of %, normalize:
+    if (fabs(q.changePct) < 1.0f) q.changePct *= 100.0f;
+  } else {
+    q.changePct = (q.open != 0.0f) ? ((q.price - q.open) / q.open) * 100.0f : 0.0f;
+  }
+  return true;
+}
+
+// Finnhub /stock/candle -> last entry of "v"
+typedef StaticJsonDocument<32>  FinnhubCandleFilter;
+typedef StaticJsonDocument<256> FinnhubCandleDoc;
+
+inline void finnhubCandleFilter(JsonDocument& filter) { filter["v"] = true; }
+
+inline float finnhubLastVolumeFrom(const JsonDocument& doc) {
+  JsonArrayConst V = doc["v"].as<JsonArrayConst>();
+  return (!V.isNull() && V.size() > 0) ? V[V.size() - 1].as<float>() : 0.0f;
+}
+
+// Finnhub /stock/profile2 -> name; and one /company-news element -> headline
+typedef StaticJsonDocument<32>   FinnhubNameFilter;
+typedef StaticJsonDocument<256>  FinnhubNameDoc;
+typedef StaticJsonDocument<32>   FinnhubHeadlineFilter;
+typedef StaticJsonDocument<1024> FinnhubNewsItemDoc;
+
+inline void finnhubNameFilter(JsonDocument& filter) { filter["name"] = true; }
+inline void finnhubHeadlineFilter(JsonDocument& filter) { filter["headline"] = true; }
+
+// The /company-news array walked one element at a time off `s`, up to
+// `maxItems` headlines into `out`. Reading stops as soon as we have enough,
+// so a busy news day costs no more than a quiet one. `s` is an Arduino
+// Stream on the device; anything with find(), findUntil(), read() and
+// readBytes() does.
+template <class S, class Out>
+inline void finnhubHeadlinesFrom(S& s, JsonDocument& item, Out& out, size_t maxItems) {
+  FinnhubHeadlineFilter filter;
+  finnhubHeadlineFilter(filter);
+  if (!s.find("[")) return;
+  do {
+    if (deserializeJson(item, s, DeserializationOption::Filter(filter))) break;
+    const char* h = item["headline"] | "";
+    if (*h) out.emplace_back(h);
+  } while (out.size() < maxItems && s.findUntil(",", "]"));
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <vector>
+#include "Perf.h"
+
+inline void jsonLogHeap(const char* tag, int code, const JsonDocument& doc, uint32_t before, uint32_t during) {
+  Serial.printf("json %s: %d, doc %u/%u B, heap -%ld B (min free %u)\n", tag, code,
+                (unsigned)doc.memoryUsage(), (unsigned)doc.capacity(),
+                (long)before - (long)during, (unsigned)ESP.getMinFreeHeap());
+}
+
+// GET `url` and deserialize the body through `filter` into `doc`.
+// Returns the HTTP code, or JSON_PARSE_FAILED when a 200 body did not parse.
+inline int jsonGet(const String& url, JsonDocument& doc, const JsonDocument& filter, const char* tag) {
+  HTTPClient http;
+  http.useHTTP10(true);
+  http.begin(url);
+  uint32_t before = ESP.getFreeHeap();
+  PerfScope net("http get", PERF_NET);
+  int code = http.GET();
+  net.end();
+  if (code == 200) {
+    PERF_SCOPE("json parse", PERF_PARSE);   // includes reading the body off the socket
+    DeserializationError err = deserializeJson(doc, http.getStream(), DeserializationOption::Filter(filter));
+    if (err) {
+      Serial.printf("json %s: %s\n", tag, err.c_str());
+      code = JSON_PARSE_FAILED;
+    }
+  }
+  uint32_t during = ESP.getFreeHeap();
+  http.end();
+  jsonLogHeap(tag, code, doc, before, during);
+  return code;
+}
+
+inline int decodeFinnhubQuote(const String& url, Quote& q) {
+  FinnhubQuoteFilter filter;
+  finnhubQuoteFilter(filter);
+  FinnhubQuoteDoc doc;
+  int code = jsonGet(url, doc, filter, "quote");
+  if (code != 200) return code;
+  finnhubQuoteFrom(doc, q);
+  return code;
+}
+
+inline int decodeCoindeskTick(const String& url, const String& instrument, Quote& q) {
+  CoindeskTickFilter filter;
+  coindeskTickFilter(filter, instrument.c_str());
+  CoindeskTickDoc doc;
+  int code = jsonGet(url, doc, filter, "tick");
+  if (code != 200) return code;
+  return coindeskTickFrom(doc, instrument.c_str(), q) ? code : JSON_PARSE_FAILED;
+}
+
+inline int decodeFinnhubLastVolume(const String& url, float& volume) {
+  FinnhubCandleFilter filter;
+  finnhubCandleFilter(filter);
+  FinnhubCandleDoc doc;
+  int code = jsonGet(url, doc, filter, "candle");
+  if (code != 200) return code;
+  volume = finnhubLastVolumeFrom(doc);
+  return code;
+}
+
+inline int decodeFinnhubName(const String& url, String& name) {
+  FinnhubNameFilter filter;
+  finnhubNameFilter(filter);
+  FinnhubNameDoc doc;
+  int code = jsonGet(url, doc, filter, "profile");
+  if (code != 200) return code;
+  const char* n = doc["name"] | "";
+  if (*n) name = n;
+  return code;
+}
+
+// Finnhub /company-news -> first `maxItems` headlines; the connection is
+// dropped as soon as finnhubHeadlinesFrom() has them.
+inline int decodeFinnhubHeadlines(const String& url, std::vector<String>& out, size_t maxItems) {
+  out.clear();
+  PERF_SCOPE("news", PERF_NET);
+  HTTPClient http;
+  http.useHTTP10(true);
+  http.begin(url);
+  uint32_t before = ESP.getFreeHeap();
+  int code = http.GET();
+
+  FinnhubNewsItemDoc item;
+  if (code == 200) finnhubHeadlinesFrom(http.getStream(), item, out, maxItems);
+  uint32_t during = ESP.getFreeHeap();
+  http.end();
+  jsonLogHeap("news", code, item, before, during);
+  return code;
+}
+#endif // ARDUINO
+
+#endif // QUOTEDECODE_H
@@ -0,0 +1,159 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ---------- Timer wheel ----------
+// Jobs are keyed on absolute epoch seconds, not on "is it :00 right now".
+// advance(now) walks every second since the previous call, so a loop that was
+// stuck in a slow HTTP request still fires what came due meanwhile (late, but
+// never skipped). No Arduino dependencies: the caller supplies the clock, so
+// the same code runs on the host against a virtual one.
+//
+//   int id = wheel.add(due, periodS, fn, ctx);   // periodS = 0 -> one-shot
+//   wheel.advance(time(nullptr));                 // from loop()
+//   wheel.cancel(id);
+
+typedef void (*TimerFn)(void* ctx, int64_t due, int64_t now);
+
+struct TimerJob {
+  int64_t  due;
+  uint32_t period;     // seconds, 0 = one-shot
+  TimerFn  fn;
+  void*    ctx;
+  int16_t  next;       // next job in the same slot, -1 = end
+  uint16_t gen;        // bumped on free so stale ids do not cancel new jobs
+  bool     used;
+};
+
+struct TimerWheel {
+  static const int SLOTS    = 64;   // one slot per second, wraps every 64 s
+  static const int MAX_JOBS = 24;
+
+  TimerJob jobs[MAX_JOBS];
+  int16_t  slots[SLOTS];
+  int64_t  cursor = -1;             // last second already processed
+
+  TimerWheel() { clear(); }
+
+  void clear() {
+    memset(jobs, 0, sizeof(jobs));
+    for (int i = 0; i < SLOTS; ++i) slots[i] = -1;
+    cursor = -1;
+  }
+
+  static int slotOf(int64_t t) { return (int)(((t % SLOTS) + SLOTS) % SLOTS); }
+
+  // Ids carry a generation so a cancelled-and-reused slot is not hit twice
+  static int  makeId(int idx, uint16_t gen) { return (int)(((uint32_t)gen << 8) | (uint32_t)idx); }
+  int  indexOf(int id) const {
+    if (id < 0) return -1;
+    int idx = id & 0xFF;
+    if (idx >= MAX_JOBS || !jobs[idx].used || jobs[idx].gen != (uint16_t)(id >> 8)) return -1;
+    return idx;
+  }
+
+  void link(int idx) {
+    // Anything already behind the cursor would never be scanned again
+    if (cursor >= 0 && jobs[idx].due <= cursor) jobs[idx].due = cursor + 1;
+    int s = slotOf(jobs[idx].due);
+    jobs[idx].next = slots[s];
+    slots[s] = (int16_t)idx;
+  }
+
+  void unlink(int idx) {
+    int s = slotOf(jobs[idx].due);
+    int16_t* p = &slots[s];
+    while (*p != -1) {
+      if (*p == idx) { *p = jobs[idx].next; return; }
+      p = &jobs[*p].next;
+    }
+  }
+
+  int add(int64_t due, uint32_t periodS, TimerFn fn, void* ctx) {
+    for (int i = 0; i < MAX_JOBS; ++i) {
+      if (jobs[i].used) continue;
+      uint16_t gen = (uint16_t)(jobs[i].gen + 1);
+      jobs[i] = { due, periodS, fn, ctx, -1, gen, true };
+      link(i);
+      return makeId(i, gen);
+    }
+    return -1;
+  }
+
+  bool cancel(int id) {
+    int idx = indexOf(id);
+    if (idx < 0) return false;
+    unlink(idx);
+    jobs[idx].used = false;
+    return true;
+  }
+
+  bool reschedule(int id, int64_t due) {
+    int idx = indexOf(id);
+    if (idx < 0) return false;
+    unlink(idx);
+    jobs[idx].due = due;
+    link(idx);
+    return true;
+  }
+
+  int64_t dueOf(int id) const { int idx = indexOf(id); return idx < 0 ? -1 : jobs[idx].due; }
+
+  // Earliest pending deadline, -1 if nothing is scheduled (for sleep planning)
+  int64_t nextDue() const {
+    int64_t best = -1;
+    for (int i = 0; i < MAX_JOBS; ++i)
+      if (jobs[i].used && (best < 0 || jobs[i].due < best)) best = jobs[i].due;
+    return best;
+  }
+
+  // Fire everything due in (cursor, now]. Returns the number of jobs run.
+  // The first call (and one after the clock went back) looks at every slot:
+  // jobs added before it were not clamped to a cursor and may be overdue
+  // in any of them.
+  int advance(int64_t now) {
+    bool rebase = cursor < 0 || now < cursor;
+    if (rebase) cursor = now - 1;
+    int64_t steps = now - cursor;
+    if (steps <= 0) return 0;
+
+    // Collect first: callbacks are free to add, cancel or reschedule
+    int16_t fired[MAX_JOBS]; int n = 0;
+    int scan = rebase || steps >= SLOTS ? SLOTS : (int)steps;
+    for (int k = 1; k <= scan; ++k) {
+      int s = slotOf(cursor + k);
+      for (int16_t i = slots[s]; i != -1; i = jobs[i].next)
+        if (jobs[i].due <= now && n < MAX_JOBS) fired[n++] = i;
+    }
+    cursor = now;
+
+    // Oldest deadline first
+    for (int a = 1; a < n; ++a)
+      for (int b = a; b > 0 && jobs[fired[b]].due < jobs[fired[b-1]].due; --b) {
+        int16_t t = fired[b]; fired[b] = fired[b-1]; fired[b-1] = t;
+      }
+
+    int ran = 0;
+    for (int k = 0; k < n; ++k) {
+      int idx = fired[k];
+      if (!jobs[idx].used || jobs[idx].due > now) continue;   // touched by an earlier callback
+      TimerJob job = jobs[idx];
+      unlink(idx);
+      if (job.period) {
+        // Skip the periods we slept through, keep the phase
+        int64_t late = now - job.due;
+        jobs[idx].due = job.due + ((late / job.period) + 1) * (int64_t)job.period;
+        link(idx);
+      } else {
+        jobs[idx].used = false;
+      }
+      if (job.fn) job.fn(job.ctx, job.due, now);
+      ran++;
+    }
+    return ran;
+  }
+};
+
+#endif // SCHEDULER_H
@@ -2,6 +2,7 @@
 #define SECRETS_H
 
 #include "AppState.h"
+#include "ConfigServer.h"
 
 inline void trim_inplace(String &s){
   int i=0;
@@ -14,8 +15,11 @@ inline void trim_inplace(String &s){
 
 inline bool loadSecretsFromSD(const char* path="/secrets.txt"){
   ssid = ""; password = ""; backup_ssid = ""; backup_password = "";
-  calendarUrl = ""; calendarUrl2 = ""; weatherApiKey = "";
+  for (int i=0;i<CAL_MAX_FEEDS;i++) calendarUrls[i] = "";
+  weatherApiKey = "";
+  finnhubKey = ""; finnhubBackupKey = ""; coindeskKey = ""; coindeskBackupKey = "";
   LAT = "25.7617"; LON = "-80.1918";
+  cfgAuth("");
 
   if (!SD.exists(path)) {
     Serial.println("WARNING: secrets.txt not found on SD card!");
@@ -50,9 +54,13 @@ inline bool loadSecretsFromSD(const char* path="/secrets.txt"){
     else if (key == "PASSWORD" || key == "PASS") { password = val; Serial.println("  PASSWORD: [set]"); }
     else if (key == "BACKUP_SSID" || key == "SSID2") { backup_ssid = val; Serial.println("  BACKUP_SSID: " + backup_ssid); }
     else if (key == "BACKUP_PASSWORD" || key == "PASS2") { backup_password = val; Serial.println("  BACKUP_PASSWORD: [set]"); }
-    else if (key == "CAL_URL1" || key == "CALENDARURL" || key == "CALENDAR_URL" || key == "CAL1") { calendarUrl = val; Serial.println("  CAL_URL1: [set]"); }
-    else if (key == "CAL_URL2" || key == "CALENDARURL2" || key == "CALENDAR_URL2" || key == "CAL2") { calendarUrl2 = val; Serial.println("  CAL_URL2: [set]"); }
+    else if (calFeedSlot(key.c_str()) >= 0) { int slot = calFeedSlot(key.c_str()); calendarUrls[slot] = val; Serial.printf("  CAL_URL%d: [set]\n", slot+1); }
     else if (key == "WEATHER_API_KEY" || key == "WEATHERAPIKEY" || key == "API_KEY" || key == "OWM_KEY") { weatherApiKey = val; Serial.println("  WEATHER_API_KEY: [set]"); }
+    else if (key == "FINNHUB_KEY") { finnhubKey = val; Serial.println("  FINNHUB_KEY: [set]"); }
+    else if (key == "FINNHUB_KEY2") { finnhubBackupKey = val; Serial.println("  FINNHUB_KEY2: [set]"); }
+    else if (key == "COINDESK_KEY") { coindeskKey = val; Serial.println("  COINDESK_KEY: [set]"); }
+    else if (key == "COINDESK_KEY2") { coindeskBackupKey = val; Serial.println("  COINDESK_KEY2: [set]"); }
+    else if (key == "CFG_PASS") { cfgAuth(val); Serial.println("  CFG_PASS: [set]"); }
     else if (key == "LAT") { LAT = val; Serial.println("  LAT: " + LAT); }
     else if (key == "LON") { LON = val; Serial.println("  LON: " + LON); }
   }
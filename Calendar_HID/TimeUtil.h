@@ -2,6 +2,7 @@
 #define TIMEUTIL_H
 
 #include "AppState.h"
+#include "TouchInput.h"
 
 inline void setupTime(){
   configTime(0, 0, ntpServer);
@@ -10,11 +11,12 @@ inline void setupTime(){
 }
 
 inline bool readLocal(struct tm &out){
-  if (getLocalTime(&out)) return true;
+  // Short wait only: before NTP has synced this is called every loop
+  if (getLocalTime(&out, 10)) return true;
 
   if (M5.In_I2C.isEnabled()){
     m5::rtc_time_t rt; m5::rtc_date_t rd;
-    M5.Rtc.getTime(&rt); M5.Rtc.getDate(&rd);
+    { I2cBusLock bus; M5.Rtc.getTime(&rt); M5.Rtc.getDate(&rd); }
     if (rd.year > 2000){
       memset(&out, 0, sizeof(out));
       out.tm_year = rd.year - 1900;
@@ -31,10 +33,10 @@ inline bool readLocal(struct tm &out){
 
 inline void syncRTCFromNTP(){
   struct tm ti{};
-  if (getLocalTime(&ti)){
+  if (getLocalTime(&ti, 10)){
     m5::rtc_time_t t; t.hours=ti.tm_hour; t.minutes=ti.tm_min; t.seconds=ti.tm_sec;
     m5::rtc_date_t d; d.date=ti.tm_mday; d.month=ti.tm_mon+1; d.year=ti.tm_year+1900;
-    if (M5.In_I2C.isEnabled()){ M5.Rtc.setTime(&t); M5.Rtc.setDate(&d); }
+    if (M5.In_I2C.isEnabled()){ I2cBusLock bus; M5.Rtc.setTime(&t); M5.Rtc.setDate(&d); }
   }
 }
 
@@ -0,0 +1,122 @@
+#ifndef WEEKGRID_H
+#define WEEKGRID_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <functional>
+
+// ---------- Week grid layout ----------
+// Column assignment for one day of an hour grid. Events that overlap in
+// time sit side by side. A sweep over the events sorted by start keeps the
+// running ones in a min-heap on end time, and each new event takes the
+// lowest free column. A cluster is a run of events linked by overlaps. When
+// it ends (nothing is running) every event in it gets the cluster's column
+// count as its width divisor. O(n log n) per day. Past 255 side by side
+// the extra events share the last column. This part is plain C++.
+//
+//   GridItem it[] = { { 540, 600, 0, 0, 0 }, { 570, 630, 1, 0, 0 } };   // minutes of the day
+//   gridLayout(it, 2);            // it[0]: col 0 of 2, it[1]: col 1 of 2
+
+struct GridItem {
+  int16_t  start, end;         // minutes from midnight (band: columns), end > start
+  uint16_t idx;                // caller's event index
+  uint8_t  col, cols;          // result: column and columns in its cluster
+};
+
+// Sorts `items` by start; returns the widest cluster's column count
+inline int gridLayout(GridItem* items, int n) {
+  std::sort(items, items + n, [](const GridItem& a, const GridItem& b) {
+    return a.start != b.start ? a.start < b.start : a.end > b.end;
+  });
+  typedef std::pair<int16_t, uint8_t> Running;     // end, col
+  std::priority_queue<Running, std::vector<Running>, std::greater<Running>> running;
+  std::priority_queue<uint8_t, std::vector<uint8_t>, std::greater<uint8_t>> spare;
+  int clusterStart = 0, clusterCols = 0, nextCol = 0, widest = 0;
+
+  auto closeCluster = [&](int end) {
+    for (int k = clusterStart; k < end; ++k) items[k].cols = (uint8_t)clusterCols;
+    widest = std::max(widest, clusterCols);
+    clusterStart = end; clusterCols = 0; nextCol = 0;
+    spare = decltype(spare)();
+  };
+
+  for (int i = 0; i < n; ++i) {
+    GridItem& it = items[i];
+    while (!running.empty() && running.top().first <= it.start) {
+      spare.push(running.top().second);
+      running.pop();
+    }
+    if (running.empty() && i > clusterStart) closeCluster(i);
+    uint8_t col;
+    if (spare.empty()) col = (uint8_t)std::min(nextCol++, 254);   // cols stays within uint8_t
+    else { col = spare.top(); spare.pop(); }
+    it.col = col;
+    running.push(Running(it.end, col));
+    clusterCols = std::max(clusterCols, col + 1);
+  }
+  closeCluster(n);
+  return widest;
+}
+
+// ---------- Events over the week ----------
+// An event in day numbers (any epoch, e.g. wcDays) and minutes. A timed
+// event ends at (endDay, endMin), exclusive; an all-day one covers
+// startDay..endDay. weekPlace() cuts it into what a grid of `days` columns
+// from `day0` draws. All-day events and events of 24 h or more become one
+// span in the band above the grid: a GridItem whose start/end are column
+// indices (end exclusive), so gridLayout() over the band stacks them, and
+// col is the row. Shorter events become a block on each day they touch,
+// cut at midnight, clamped to the grid hours and at least minLen long.
+
+struct WeekSpan {
+  int32_t  startDay, endDay;
+  int16_t  startMin, endMin;
+  bool     allDay;
+  uint16_t idx;
+};
+
+struct WeekHours { int16_t first, last, minLen; };   // minutes from midnight
+
+// `timed` has `days` lists, one per column
+inline void weekPlace(const WeekSpan& ev, int32_t day0, int days, const WeekHours& hrs,
+                      std::vector<GridItem>& band, std::vector<GridItem>* timed) {
+  const int32_t DAY = 24 * 60;
+  int32_t s = ev.startDay * DAY + ev.startMin, e = ev.endDay * DAY + ev.endMin;
+  if (ev.allDay) { s = ev.startDay * DAY; e = (std::max(ev.endDay, ev.startDay) + 1) * DAY; }
+  else if (e <= s) e = (ev.startDay + 1) * DAY;     // no usable end: to midnight
+  const int32_t lo = day0 * DAY, hi = (day0 + days) * DAY;
+  if (e <= lo || s >= hi) return;
+  if (ev.allDay || e - s >= DAY) {
+    int c0 = (int)((std::max(s, lo) - lo) / DAY);
+    int c1 = (int)((std::min(e, hi) - lo + DAY - 1) / DAY);
+    band.push_back({ (int16_t)c0, (int16_t)c1, ev.idx, 0, 0 });
+    return;
+  }
+  for (int32_t t = std::max(s, lo), stop = std::min(e, hi); t < stop; ) {
+    int32_t day = t / DAY, next = (day + 1) * DAY;
+    int a = (int)(t - day * DAY), b = (int)(std::min(stop, next) - day * DAY);
+    a = std::min(std::max(a, (int)hrs.first), hrs.last - hrs.minLen);
+    b = std::min(std::max(b, a + hrs.minLen), (int)hrs.last);
+    timed[day - day0].push_back({ (int16_t)a, (int16_t)b, ev.idx, 0, 0 });
+    t = next;
+  }
+}
+
+// Band after gridLayout: per column, 0 when its spans fit in `rows`, else
+// how many the last row's "+ N more" stands for
+inline void weekBandMore(const GridItem* band, int n, int rows, uint8_t* more, int days) {
+  for (int c = 0; c < days; ++c) {
+    int hidden = 0, last = 0;
+    for (int k = 0; k < n; ++k) {
+      if (band[k].start > c || band[k].end <= c) continue;
+      if (band[k].col >= rows) hidden++;
+      if (band[k].col >= rows - 1) last++;
+    }
+    more[c] = (uint8_t)(hidden ? std::min(last, 255) : 0);
+  }
+}
+
+#endif // WEEKGRID_H
@@ -0,0 +1,257 @@
+#ifndef WXHOURLY_H
+#define WXHOURLY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <utility>
+#include <ArduinoJson.h>
+
+// ---------- Hourly weather ----------
+// One /forecast request (3-hour slots, five days) becomes a timeline of
+// hours, 8 bytes each. Temperature is interpolated between slots. The other
+// fields take the value of the slot the hour falls in. The current reading,
+// the daily hi/lo and the hourly strip are all read from this one array. It
+// is saved as-is to SD. This part is plain C++; the decoding needs only
+// ArduinoJson, so test/ replays recorded replies through the same code.
+//
+//   tl.begin(); tl.addSlot(dt, hour); ...; tl.finish();
+//   const WxHour* h = tl.at(time(nullptr));
+//   WxDay days[7]; int n = wxDays(tl, days, 7);
+
+// OpenWeatherMap "main" groups; the condition id maps onto these
+enum WxCond : uint8_t {
+  WX_NONE, WX_THUNDER, WX_DRIZZLE, WX_RAIN, WX_SNOW, WX_MIST, WX_SMOKE, WX_HAZE,
+  WX_DUST, WX_FOG, WX_SAND, WX_ASH, WX_SQUALL, WX_TORNADO, WX_CLEAR, WX_CLOUDS
+};
+
+inline uint8_t wxCondOf(int id) {
+  switch (id / 100) {
+    case 2: return WX_THUNDER;
+    case 3: return WX_DRIZZLE;
+    case 5: return WX_RAIN;
+    case 6: return WX_SNOW;
+    case 7:
+      switch (id) {
+        case 711: return WX_SMOKE;  case 721: return WX_HAZE;   case 731: case 761: return WX_DUST;
+        case 741: return WX_FOG;    case 751: return WX_SAND;   case 762: return WX_ASH;
+        case 771: return WX_SQUALL; case 781: return WX_TORNADO;
+        default:  return WX_MIST;
+      }
+    case 8: return id == 800 ? WX_CLEAR : WX_CLOUDS;
+    default: return WX_NONE;
+  }
+}
+
+// The text the API would have given as "main"
+inline const char* wxCondName(uint8_t c) {
+  static const char* NAMES[] = { "", "Thunderstorm", "Drizzle", "Rain", "Snow", "Mist", "Smoke", "Haze",
+                                 "Dust", "Fog", "Sand", "Ash", "Squall", "Tornado", "Clear", "Clouds" };
+  return c < sizeof(NAMES) / sizeof(NAMES[0]) ? NAMES[c] : "";
+}
+
+struct WxHour {
+  int16_t  temp10;             // tenths of a degree
+  uint8_t  pop;                // precipitation probability, %
+  uint8_t  cond;               // WxCond
+  uint16_t precip100;          // rain + snow in the hour, hundredths of a mm
+  uint8_t  wind;               // wind speed, API units
+  uint8_t  clouds;             // cloud cover, %
+};
+static_assert(sizeof(WxHour) == 8, "WxHour is packed to 8 bytes");
+
+inline int wxDeg(int16_t temp10) { return temp10 >= 0 ? (temp10 + 5) / 10 : -((5 - temp10) / 10); }
+
+struct WxTimeline {
+  static const int SLOT_H = 3;
+  static const int HOURS  = 5 * 24 + SLOT_H;   // five days of slots, plus the last slot's hours
+  uint32_t start = 0;          // epoch of hour[0], on the hour
+  uint32_t fetchedAt = 0;
+  int16_t  count = 0;
+  WxHour   hour[HOURS];
+
+  // Slot being spread over its hours once the next one is known
+  uint32_t slotTs = 0;
+  WxHour   slot;
+  bool     haveSlot = false;
+
+  void begin() { start = 0; count = 0; haveSlot = false; }
+
+  // Hours [slotTs, until) from the pending slot, temperature ramped to `next`
+  void spread(uint32_t until, int16_t nextTemp) {
+    uint32_t span = until > slotTs ? until - slotTs : 3600;
+    for (uint32_t t = slotTs; t < until && count < HOURS; t += 3600) {
+      if (t < start + (uint32_t)count * 3600) continue;   // overlaps what is there
+      WxHour h = slot;
+      h.temp10 = (int16_t)(slot.temp10 + (int32_t)(nextTemp - slot.temp10) * (int32_t)(t - slotTs) / (int32_t)span);
+      h.precip100 = (uint16_t)(slot.precip100 / SLOT_H);
+      hour[count++] = h;
+    }
+  }
+
+  // Slots in time order; `h.precip100` is the slot total
+  void addSlot(uint32_t ts, const WxHour& h) {
+    ts -= ts % 3600;
+    if (!count && !haveSlot) start = ts;
+    if (haveSlot) {
+      if (ts <= slotTs) return;
+      spread(ts, h.temp10);
+    }
+    slotTs = ts; slot = h; haveSlot = true;
+  }
+
+  void finish() {
+    if (haveSlot) spread(slotTs + SLOT_H * 3600, slot.temp10);
+    haveSlot = false;
+  }
+
+  // Hour covering `ts`, clamped to the timeline; null when empty
+  int indexAt(uint32_t ts) const {
+    if (!count) return -1;
+    if (ts < start) return 0;
+    uint32_t i = (ts - start) / 3600;
+    return i < (uint32_t)count ? (int)i : count - 1;
+  }
+  const WxHour* at(uint32_t ts) const { int i = indexAt(ts); return i < 0 ? nullptr : &hour[i]; }
+  uint32_t timeOf(int i) const { return start + (uint32_t)i * 3600; }
+};
+
+struct WxDay {
+  int     y, m, d;
+  int     hi, lo;              // whole degrees
+  uint8_t cond, pop;           // condition around midday (else the first hour), wettest hour
+};
+
+// Local days covered by the timeline, in order
+inline int wxDays(const WxTimeline& tl, WxDay* out, int maxDays) {
+  int n = -1;
+  int16_t hi = 0, lo = 0;
+  for (int i = 0; i < tl.count; ++i) {
+    time_t ts = tl.timeOf(i);
+    struct tm lt; localtime_r(&ts, &lt);
+    const WxHour& h = tl.hour[i];
+    if (n < 0 || out[n].y != lt.tm_year + 1900 || out[n].m != lt.tm_mon + 1 || out[n].d != lt.tm_mday) {
+      if (n + 1 >= maxDays) break;
+      ++n;
+      out[n] = { lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday, 0, 0, h.cond, h.pop };
+      hi = lo = h.temp10;
+    }
+    if (h.temp10 > hi) hi = h.temp10;
+    if (h.temp10 < lo) lo = h.temp10;
+    out[n].hi = wxDeg(hi); out[n].lo = wxDeg(lo);
+    if (lt.tm_hour == 12) out[n].cond = h.cond;
+    if (h.pop > out[n].pop) out[n].pop = h.pop;
+  }
+  return n + 1;
+}
+
+// ---------- /forecast decoding ----------
+static const size_t WX_DOC_BYTES = 24 * 1024;   // 40 filtered slots with room to spare
+
+inline void wxForecastFilter(JsonDocument& filter) {
+  JsonObject f = filter["list"].createNestedObject();
+  f["dt"] = true;
+  f["main"]["temp"] = true;
+  f["pop"] = true;
+  f["weather"][0]["id"] = true;
+  f["rain"]["3h"] = true;
+  f["snow"]["3h"] = true;
+  f["wind"]["speed"] = true;
+  f["clouds"]["all"] = true;
+}
+
+// A /forecast reply straight off a Stream (or from memory); the filter
+// keeps only the fields stored, so the document stays small
+template <class In>
+inline bool wxParseForecast(In&& in, WxTimeline& tl) {
+  StaticJsonDocument<256> filter;
+  wxForecastFilter(filter);
+  DynamicJsonDocument doc(WX_DOC_BYTES);
+  if (deserializeJson(doc, std::forward<In>(in), DeserializationOption::Filter(filter))) return false;
+  tl.begin();
+  for (JsonObject it : doc["list"].as<JsonArray>()) {
+    WxHour h;
+    float t = it["main"]["temp"].as<float>();
+    h.temp10    = (int16_t)(t * 10 + (t >= 0 ? 0.5f : -0.5f));
+    h.pop       = (uint8_t)(it["pop"].as<float>() * 100 + 0.5f);
+    h.cond      = wxCondOf(it["weather"][0]["id"].as<int>());
+    float mm    = it["rain"]["3h"].as<float>() + it["snow"]["3h"].as<float>();
+    h.precip100 = (uint16_t)std::min(mm * 100 + 0.5f, 65535.0f);
+    h.wind      = (uint8_t)std::min(it["wind"]["speed"].as<float>() + 0.5f, 255.0f);
+    h.clouds    = it["clouds"]["all"].as<uint8_t>();
+    tl.addSlot(it["dt"].as<uint32_t>(), h);
+  }
+  tl.finish();
+  return tl.count > 0;
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <SD.h>
+#include "Perf.h"
+
+// Counts what the parser pulls off the socket
+struct WxCountingStream : public Stream {
+  Stream& in;
+  size_t  bytes = 0;
+  explicit WxCountingStream(Stream& s) : in(s) {}
+  int available() override { return in.available(); }
+  int read() override { int c = in.read(); if (c >= 0) bytes++; return c; }
+  int peek() override { return in.peek(); }
+  size_t readBytes(char* buf, size_t len) override { size_t k = in.readBytes(buf, len); bytes += k; return k; }
+  size_t write(uint8_t) override { return 0; }
+};
+
+// One request: GET, parse while it downloads, log size and cost
+inline bool wxFetch(const String& url, WxTimeline& tl) {
+  HTTPClient http;
+  http.useHTTP10(true);                  // no chunked encoding, so the stream is plain JSON
+  http.begin(url);
+  uint32_t t0 = perfNowUs();
+  int code;
+  { PERF_SCOPE("wx get", PERF_NET); code = http.GET(); }
+  if (code != HTTP_CODE_OK) { http.end(); return false; }
+  WxCountingStream in(http.getStream());
+  uint32_t t1 = perfNowUs();
+  bool ok;
+  { PERF_SCOPE("wx parse", PERF_PARSE); ok = wxParseForecast(in, tl); }
+  uint32_t t2 = perfNowUs();
+  http.end();
+  Serial.printf("weather: 1 request, %u B, %d hours, get %lu ms, read+parse %lu ms%s\n",
+                (unsigned)in.bytes, tl.count, (unsigned long)((t1 - t0) / 1000),
+                (unsigned long)((t2 - t1) / 1000), ok ? "" : " (failed)");
+  return ok;
+}
+
+static const uint32_t WX_FILE_MAGIC = 0x31485857;   // "WXH1"
+
+// Through a temp file, so a failed write keeps the last good timeline
+inline bool wxSave(const char* path, const WxTimeline& tl) {
+  String tmp = String(path) + ".tmp";
+  SD.remove(tmp.c_str());
+  File f = SD.open(tmp.c_str(), FILE_WRITE);
+  if (!f) return false;
+  size_t n = f.write((const uint8_t*)&WX_FILE_MAGIC, 4);
+  n += f.write((const uint8_t*)&tl, sizeof(tl));
+  f.close();
+  if (n != 4 + sizeof(tl)) { SD.remove(tmp.c_str()); return false; }
+  SD.remove(path);
+  return SD.rename(tmp.c_str(), path);
+}
+
+inline bool wxLoad(const char* path, WxTimeline& tl) {
+  File f = SD.open(path, FILE_READ);
+  if (!f) return false;
+  uint32_t magic = 0;
+  bool ok = f.size() == 4 + sizeof(tl) && f.read((uint8_t*)&magic, 4) == 4 && magic == WX_FILE_MAGIC &&
+            f.read((uint8_t*)&tl, sizeof(tl)) == (int)sizeof(tl);
+  f.close();
+  if (!ok || tl.count < 0 || tl.count > WxTimeline::HOURS) { tl.begin(); return false; }
+  return true;
+}
+#endif // ARDUINO
+
+#endif // WXHOURLY_H
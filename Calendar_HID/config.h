@@ -20,23 +20,27 @@
 // ---------- Time ----------
 static const char* ntpServer = "pool.ntp.org";
 static const char* TZ_INFO   = "EST5EDT,M3.2.0/2,M11.1.0/2";
+static const char* TZ_ZONE   = "America/New_York";   // same zone, for WorldClock.h
 
 // ---------- UI ----------
 static const int SCREEN_W = 960;
 static const int SCREEN_H = 540;
 static const int HEADER_H = 140;         
+static const int HOURLY_H = 40;
 static const int FORECAST_H = 56;
-static const int TOP_AREA_H = HEADER_H + FORECAST_H + 8;
+static const int TOP_AREA_H = HEADER_H + HOURLY_H + FORECAST_H + 8;
 static const int DAYS_TO_SHOW = 5;
 
 // Colors
 static const uint16_t BG         = 0xFFFF;
 static const uint16_t TEXT       = 0x0000;
-static const uint16_t SUBTLE     = 0xDEFB;
-static const uint16_t LINE       = 0xC618;
+// Grays are panel levels (gray565() in GrayRender.h), one each so the
+// header, rules, badges and today's card stay apart
+static const uint16_t SUBTLE     = 0xDEFB;   // 0xDD
+static const uint16_t LINE       = 0xBDD7;   // 0xBB
 static const uint16_t DARKLINE   = 0x0000;
-static const uint16_t BADGE_FILL = 0xE71C;
-static const uint16_t TODAY_BG   = 0xCEDC;
+static const uint16_t BADGE_FILL = 0xEF7D;   // 0xEE
+static const uint16_t TODAY_BG   = 0xCE79;   // 0xCC, GRAY_LIGHT
 
 constexpr char DEG = (char)248;
 
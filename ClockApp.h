@@ -0,0 +1,478 @@
+#ifndef CLOCKAPP_H
+#define CLOCKAPP_H
+
+#include <new>
+#include <vector>
+#include <M5Unified.h>
+#include <SD.h>
+#include "WiFiManager.h"
+#include "TouchInput.h"
+#include "Scheduler.h"
+#include "Alarms.h"
+#include "AlarmAudio.h"
+#include "GrayRender.h"
+#include "WorldClock.h"
+#include "Perf.h"
+
+// ---------- Alarms ----------
+// /Wifi/ALARMS.txt on one timer wheel, serviced from loop() whichever app is
+// in front: an alarm has to ring over the calendar too. A press anywhere
+// silences it, and that press does nothing else. The clock app below is
+// only where they are edited.
+static Alarm      g_alarms[MAX_ALARMS];
+static TimerWheel g_alarmWheel;
+static time_t     g_alarmTick = 0;       // last serviced second, 0 = clock not valid yet
+static bool       g_alarmRinging = false;
+static uint32_t   g_alarmRangMs = 0;
+
+inline void clockAlarmFired(int slot);   // the clock app, when its alarm screen is up
+inline void clockAlarmsReloaded();
+
+inline void alarmArm(Alarm& a);
+
+inline void onAlarmJob(void* ctx, int64_t due, int64_t now){
+  Alarm& a = *(Alarm*)ctx;
+  a.jobId = -1;
+  Serial.printf("Alarm %02d:%02d triggered (%lds late)\n", a.hour, a.minute, (long)(now - due));
+  audio_play(TONE_ALARM, 2, 5);
+  g_alarmRinging = true;
+  g_alarmRangMs = millis();
+  if (a.days == ALARM_ONCE){
+    a.enabled = false;                 // one-shot alarms switch themselves off
+    saveAlarmsToSD(g_alarms, MAX_ALARMS);
+    clockAlarmFired((int)(&a - g_alarms));
+  } else {
+    alarmArm(a);
+  }
+}
+
+inline void alarmArm(Alarm& a){
+  g_alarmWheel.cancel(a.jobId);
+  a.jobId = -1;
+  time_t now = time(nullptr);
+  if (!a.enabled || now < 1700000000) return;
+  time_t at = alarmNextFire(a, now);
+  if (at > 0) a.jobId = g_alarmWheel.add(at, 0, onAlarmJob, &a);
+}
+
+inline void alarmsBegin(){
+  loadAlarmsFromSD(g_alarms);
+  audio_begin();
+}
+
+// Nothing is armed until the clock is valid; after that the wheel catches up
+// on anything that came due while loop() was blocked
+inline void alarmsService(){
+  if (g_alarmRinging){
+    if (!audio_busy()) g_alarmRinging = false;
+    else if ((int32_t)(touchLastMs() - g_alarmRangMs) > 0){
+      audio_stop();
+      touchClear();
+      g_alarmRinging = false;
+    }
+  }
+  time_t now = time(nullptr);
+  if (now < 1700000000) return;
+  bool jumped = g_alarmTick != 0 && (now - g_alarmTick > 120 || now < g_alarmTick);
+  if (!g_alarmTick) for (Alarm& a : g_alarms) alarmArm(a);
+  g_alarmTick = now;
+  g_alarmWheel.advance(now);
+  if (jumped) for (Alarm& a : g_alarms) alarmArm(a);   // NTP moved the clock: realign
+}
+
+// ALARMS.txt saved on the config page
+inline void alarmsReload(){
+  for (Alarm& a : g_alarms) g_alarmWheel.cancel(a.jobId);
+  loadAlarmsFromSD(g_alarms);
+  for (Alarm& a : g_alarms) alarmArm(a);
+  clockAlarmsReloaded();
+}
+
+// ---------- Clock app ----------
+// The clock and alarm screens, driven by the app host (AppHost.h). The
+// CryptoStock menu and the Calendar_HID header both open it:
+//   clock_init()      world clock zones from /Wifi/CLOCKS.txt
+//   clock_resume()    the VLW face from SD (/font/ftime.vlw), the clock screen
+//   clock_tick()      touch, the minute; false once Return is tapped
+//   clock_suspend()   font bytes and the world clock canvas freed
+//   clock_teardown()  the rest
+static const int CK_TIME_SIZE = 7;          // big time, built-in font fallback
+static const int CK_DATE_SIZE = 2;
+static const int CK_BTN_Y     = 470;
+static const int CK_WORLD_MAX = 4;
+static const int CK_WORLD_X = 30, CK_WORLD_Y = 50, CK_WORLD_CELL_W = 225, CK_WORLD_H = 36;
+
+// What the sketch supplies before the first open. Without localTime the
+// clock reads the zone table once SNTP has set the clock; a sketch with an
+// RTC points it at the RTC, and syncTime at what writes SNTP time back to it.
+struct ClockConfig {
+  const char* zone = "America/New_York";
+  bool (*localTime)(struct tm& t) = nullptr;
+  void (*syncTime)() = nullptr;            // Sync Time, once SNTP has answered
+};
+
+static ClockConfig g_clockCfg;
+
+enum ClockView : uint8_t { CK_CLOCK, CK_ALARM_SET };
+
+struct ClockZone { const WcZone* zone; WcTable tz; int32_t shown; };
+
+struct ClockState {
+  WcTable   tz;                            // the big clock, without a localTime hook
+  ClockZone world[CK_WORLD_MAX];
+  int       worldCount = 0;
+  M5Canvas* strip = nullptr;               // world clocks, so the VLW stays loaded on the panel
+  std::vector<uint8_t> font;               // VLW bytes; loadFont() keeps pointing into them
+  bool      fontLoaded = false;
+  Alarm     draft[MAX_ALARMS];             // what the alarm screen edits; Save commits it
+  int       edit = 0;
+  int       btnX = 0, btnY = 0, btnW = 0, btnH = 0;   // Alarm ON/OFF pill
+  int16_t   act[3][4];                     // Return, Sync Time, Set Alarm: x, y, w, h
+  uint8_t   view = CK_CLOCK;
+  bool      inFront = false;
+  int       shownMinute = -1;
+  uint32_t  shownMs = 0;
+  epd_mode_t epdMode = epd_mode_t::epd_fastest;
+};
+
+static ClockState* g_clock = nullptr;
+
+// One zone key per line (see WorldClock.h); London/Tokyo/Sydney if absent
+inline void clockLoadZones(){
+  static const char* DEFAULTS[] = { "Europe/London", "Asia/Tokyo", "Australia/Sydney" };
+  ClockState& c = *g_clock;
+  c.worldCount = 0;
+  File f = SD.open("/Wifi/CLOCKS.txt");
+  while (f && f.available() && c.worldCount < CK_WORLD_MAX){
+    String key = f.readStringUntil('\n'); key.trim();
+    if (!key.length()) continue;
+    if (const WcZone* z = wcFind(key.c_str())) c.world[c.worldCount++].zone = z;
+    else Serial.printf("world clock: unknown zone %s\n", key.c_str());
+  }
+  if (f) f.close();
+  if (!c.worldCount) for (const char* k : DEFAULTS) c.world[c.worldCount++].zone = wcFind(k);
+  for (int i = 0; i < c.worldCount; ++i){ wcBuild(*c.world[i].zone, c.world[i].tz); c.world[i].shown = -1; }
+}
+
+// Local wall time; false until there is one
+inline bool clockLocal(struct tm& t){
+  if (g_clockCfg.localTime){
+    if (!g_clockCfg.localTime(t)) return false;
+    struct tm w = t;
+    mktime(&w);                            // an RTC read leaves tm_wday unset
+    t.tm_wday = w.tm_wday;
+    return true;
+  }
+  time_t now = time(nullptr);
+  if (now < 1700000000) return false;
+  WcCivil c = wcCivil(wcLocalMinute(g_clock->tz, (uint32_t)now));
+  t = tm{};
+  t.tm_year = c.year - 1900; t.tm_mon = c.month - 1; t.tm_mday = c.day;
+  t.tm_hour = c.hour; t.tm_min = c.min; t.tm_wday = c.wday;
+  return true;
+}
+
+inline bool clockLoadFont(){
+  ClockState& c = *g_clock;
+  File f = SD.open("/font/ftime.vlw", FILE_READ);
+  if (!f) return false;
+  c.font.resize(f.size());
+  size_t n = c.font.empty() ? 0 : f.read(c.font.data(), c.font.size());
+  f.close();
+  if (!n || n != c.font.size()){
+    Serial.printf("clock font: read %u of %u B\n", (unsigned)n, (unsigned)c.font.size());
+    c.font.clear(); c.font.shrink_to_fit();
+    return false;
+  }
+  return true;
+}
+
+inline void clockButton(int x, int y, int w, int h, const char* label, uint16_t bg, uint16_t fg){
+  M5.Display.fillRoundRect(x, y, w, h, 25, bg);
+  M5.Display.setTextColor(fg);
+  M5.Display.setCursor(x + (w - M5.Display.textWidth(label)) / 2, y + (h + M5.Display.fontHeight()) / 4 - 9);
+  M5.Display.print(label);
+}
+
+inline void clockTopBar(){
+  M5.Display.fillRect(0, 0, 960, 30, WHITE);
+  M5.Display.setFont(&fonts::FreeMonoBold12pt7b);
+  M5.Display.setTextSize(1);
+  M5.Display.setTextColor(BLACK);
+  M5.Display.setCursor(10, 5);
+  M5.Display.printf("Battery: %d%%", M5.Power.getBatteryLevel());
+}
+
+// Redraw the strip when any zone's local minute moved
+inline void clockDrawWorld(bool force){
+  ClockState& c = *g_clock;
+  time_t now = time(nullptr);
+  if (now < 1700000000 || !c.worldCount) return;
+  bool changed = force;
+  int32_t minute[CK_WORLD_MAX];
+  for (int i = 0; i < c.worldCount; ++i){
+    minute[i] = wcLocalMinute(c.world[i].tz, (uint32_t)now);
+    if (minute[i] != c.world[i].shown) changed = true;
+  }
+  if (!changed) return;
+
+  const int stripW = CK_WORLD_CELL_W * CK_WORLD_MAX;
+  if (!c.strip){
+    c.strip = new M5Canvas(&M5.Display);
+    c.strip->setColorDepth(8);
+    c.strip->setPsram(true);
+    if (!c.strip->createSprite(stripW, CK_WORLD_H)){ delete c.strip; c.strip = nullptr; return; }
+    c.strip->setFont(&fonts::FreeMonoBold9pt7b);
+    c.strip->setTextColor(BLACK);
+  }
+  static const char* DAYS[] = { "Sun","Mon","Tue","Wed","Thu","Fri","Sat" };
+  c.strip->fillScreen(WHITE);
+  for (int i = 0; i < c.worldCount; ++i){
+    WcCivil t = wcCivil(minute[i]);
+    c.strip->setCursor(i * CK_WORLD_CELL_W, 10);
+    c.strip->printf("%s %s %02d:%02d", c.world[i].zone->label, DAYS[t.wday], t.hour, t.min);
+    c.world[i].shown = minute[i];
+  }
+  auto prev = M5.Display.getEpdMode();
+  M5.Display.setEpdMode(epd_mode_t::epd_fast);
+  c.strip->pushSprite(CK_WORLD_X, CK_WORLD_Y);
+  M5.Display.display(CK_WORLD_X, CK_WORLD_Y, stripW, CK_WORLD_H);
+  M5.Display.setEpdMode(prev);
+}
+
+// The time, alone, with a fast partial update
+inline void clockDrawTime(const tm& t){
+  ClockState& c = *g_clock;
+  if (!c.fontLoaded && !c.font.empty()) c.fontLoaded = M5.Display.loadFont(c.font.data());
+  if (c.fontLoaded) M5.Display.setTextSize(2);
+  else { M5.Display.setFont(&fonts::FreeMonoBold12pt7b); M5.Display.setTextSize(CK_TIME_SIZE); }
+
+  const int cx = 960 / 2, cy = 540 / 2 - 6, pad = 16;
+  int w = M5.Display.textWidth("88:88"), h = M5.Display.fontHeight();
+  int bx = cx - w / 2 - pad, by = cy - h / 2 - pad, bw = w + 2 * pad, bh = h + 2 * pad;
+  auto prev = M5.Display.getEpdMode();
+  M5.Display.setEpdMode(epd_mode_t::epd_fast);
+  M5.Display.fillRect(bx, by, bw, bh, WHITE);
+  M5.Display.display(bx, by, bw, bh);
+  char buf[8];
+  snprintf(buf, sizeof(buf), "%02d:%02d", (t.tm_hour + 11) % 12 + 1, t.tm_min);
+  M5.Display.setTextColor(BLACK);
+  M5.Display.setTextDatum(textdatum_t::middle_center);
+  M5.Display.drawString(buf, cx, cy);
+  M5.Display.setTextDatum(textdatum_t::top_left);
+  M5.Display.display(bx, by, bw, bh);
+  M5.Display.setEpdMode(prev);
+  c.shownMinute = t.tm_min;
+}
+
+// Date and buttons once, then the time
+inline void clockDrawScreen(){
+  PERF_SCOPE("drawClock", PERF_RENDER);
+  ClockState& c = *g_clock;
+  if (c.fontLoaded){ M5.Display.unloadFont(); c.fontLoaded = false; }
+  if (c.view != CK_CLOCK) c.shownMs = millis();
+  c.view = CK_CLOCK;
+  M5.Display.clear();
+  clockTopBar();
+
+  static const char* DAYS[]   = { "Sun","Mon","Tue","Wed","Thu","Fri","Sat" };
+  static const char* MONTHS[] = { "Jan","Feb","Mar","Apr","May","Jun","Jul","Aug","Sep","Oct","Nov","Dec" };
+  struct tm t{};
+  bool haveTime = clockLocal(t);
+  M5.Display.setTextSize(CK_DATE_SIZE);
+  char date[16] = "-- --- --";
+  if (haveTime){
+    snprintf(date, sizeof(date), "%s %s %2d", DAYS[t.tm_wday], MONTHS[t.tm_mon], t.tm_mday);
+  }
+  int dw = M5.Display.textWidth(date), dh = M5.Display.fontHeight();
+  M5.Display.setTextColor(BLACK);
+  M5.Display.setCursor(960 - dw - 14, 440 - dh - 12 + dh / 3);
+  M5.Display.print(date);
+
+  // Return, Sync Time and Set Alarm along the bottom; taps test the rects kept here
+  static const char* LABELS[] = { "Return", "Sync Time", "Set Alarm" };
+  for (int i = 0, x = 30; i < 3; ++i){
+    int w = M5.Display.textWidth(LABELS[i]) + 60;
+    clockButton(x, CK_BTN_Y, w, 50, LABELS[i], BLACK, WHITE);
+    c.act[i][0] = x; c.act[i][1] = CK_BTN_Y; c.act[i][2] = w; c.act[i][3] = 50;
+    x += w + 20;
+  }
+
+  if (haveTime) clockDrawTime(t);
+  clockDrawWorld(true);
+}
+
+inline void clockDrawAlarm(){
+  ClockState& c = *g_clock;
+  if (c.fontLoaded){ M5.Display.unloadFont(); c.fontLoaded = false; }
+  if (c.view != CK_ALARM_SET) c.shownMs = millis();
+  c.view = CK_ALARM_SET;
+  M5.Display.clear();
+  clockTopBar();
+  const Alarm& a = c.draft[c.edit];
+
+  M5.Display.setTextSize(2);
+  M5.Display.setCursor(250, 150);
+  M5.Display.printf("Set Alarm %d/%d", c.edit + 1, MAX_ALARMS);
+
+  char buf[8];
+  snprintf(buf, sizeof(buf), "%02d:%02d", a.hour, a.minute);
+  M5.Display.setTextSize(5);
+  M5.Display.setCursor((960 - M5.Display.textWidth(buf)) / 2, 200);
+  M5.Display.print(buf);
+
+  const char* state = a.enabled ? "Alarm ON" : "Alarm OFF";
+  M5.Display.setTextSize(2);
+  c.btnW = M5.Display.textWidth(state) + 48;
+  c.btnH = M5.Display.fontHeight() + 20;
+  c.btnX = (960 - c.btnW) / 2;
+  c.btnY = 320;
+  M5.Display.fillRoundRect(c.btnX, c.btnY, c.btnW, c.btnH, c.btnH / 2, a.enabled ? BLACK : GRAY_LIGHT);
+  M5.Display.setTextColor(a.enabled ? WHITE : BLACK);
+  M5.Display.setTextDatum(textdatum_t::middle_center);
+  M5.Display.drawString(state, c.btnX + c.btnW / 2, c.btnY + c.btnH / 2);
+  M5.Display.setTextDatum(textdatum_t::top_left);
+
+  clockButton(30, 190, 50, 50, "+H", BLACK, WHITE);
+  clockButton(30, 270, 50, 50, "-H", BLACK, WHITE);
+  clockButton(960 - 80, 190, 50, 50, "+M", BLACK, WHITE);
+  clockButton(960 - 80, 270, 50, 50, "-M", BLACK, WHITE);
+  clockButton(30, 80, 50, 50, "<", BLACK, WHITE);
+  clockButton(960 - 80, 80, 50, 50, ">", BLACK, WHITE);
+  char rep[32];
+  clockButton(30, 430, 260, 50, alarmRepeatLabel(a.days, rep, sizeof(rep)), GRAY_LIGHT, BLACK);
+  clockButton(960 / 2 - 100, 430, 200, 50, "Save", BLACK, WHITE);
+  clockButton(960 - 230, 430, 200, 50, "Cancel", GRAY_LIGHT, BLACK);
+}
+
+// Edits go to a copy of the alarms until Save
+inline void clockOpenAlarm(){
+  memcpy(g_clock->draft, g_alarms, sizeof(g_clock->draft));
+  clockDrawAlarm();
+}
+
+inline void clockAlarmFired(int slot){
+  if (!g_clock) return;
+  g_clock->draft[slot].enabled = false;
+  if (g_clock->inFront && g_clock->view == CK_ALARM_SET) clockDrawAlarm();
+}
+
+// ALARMS.txt reloaded: the file wins over an open draft
+inline void clockAlarmsReloaded(){
+  if (g_clock && g_clock->inFront && g_clock->view == CK_ALARM_SET) clockOpenAlarm();
+}
+
+inline bool clockHit(int x, int y, int rx, int ry, int rw, int rh){
+  return x >= rx && x <= rx + rw && y >= ry && y <= ry + rh;
+}
+
+// false: Return
+inline bool clockTap(int x, int y){
+  ClockState& c = *g_clock;
+  if (c.view == CK_CLOCK){
+    auto on = [&](int i){ return clockHit(x, y, c.act[i][0], c.act[i][1], c.act[i][2], c.act[i][3]); };
+    if (on(0)) return false;
+    if (on(1)){
+      // SNTP is already running; wait for it, then let the sketch keep it
+      struct tm t{};
+      if (net_waitUp(5000)) for (int i = 0; i < 10 && !getLocalTime(&t, 500); ++i) {}
+      if (g_clockCfg.syncTime) g_clockCfg.syncTime();
+      clockDrawScreen();
+      return true;
+    }
+    if (on(2)) clockOpenAlarm();
+    return true;
+  }
+
+  Alarm& a = c.draft[c.edit];
+  if (clockHit(x, y, 30, 80, 50, 50))              c.edit = (c.edit + MAX_ALARMS - 1) % MAX_ALARMS;
+  else if (clockHit(x, y, 960 - 80, 80, 50, 50))   c.edit = (c.edit + 1) % MAX_ALARMS;
+  else if (clockHit(x, y, 30, 190, 50, 50))        a.hour = (a.hour + 1) % 24;
+  else if (clockHit(x, y, 30, 270, 50, 70))        a.hour = (a.hour + 23) % 24;
+  else if (clockHit(x, y, 960 - 80, 190, 50, 50))  a.minute = (a.minute + 1) % 60;
+  else if (clockHit(x, y, 960 - 80, 270, 50, 70))  a.minute = (a.minute + 59) % 60;
+  else if (clockHit(x, y, c.btnX, c.btnY, c.btnW, c.btnH)) a.enabled = !a.enabled;
+  else if (clockHit(x, y, 30, 420, 260, 60))       a.days = alarmNextRepeatPreset(a.days);
+  else if (clockHit(x, y, 960 / 2 - 100, 420, 200, 50)){
+    // Save: the draft becomes the alarms
+    for (int i = 0; i < MAX_ALARMS; ++i){
+      int armed = g_alarms[i].jobId;     // alarmArm() cancels it
+      g_alarms[i] = c.draft[i];
+      g_alarms[i].jobId = armed;
+      alarmArm(g_alarms[i]);
+    }
+    saveAlarmsToSD(g_alarms, MAX_ALARMS);
+    clockDrawScreen();
+    return true;
+  }
+  else if (clockHit(x, y, 960 - 230, 420, 200, 60)){ clockDrawScreen(); return true; }
+  else return true;
+  clockDrawAlarm();
+  return true;
+}
+
+// ---------- App lifecycle ----------
+inline void clock_redraw(){
+  if (g_clock->view == CK_ALARM_SET) clockDrawAlarm();
+  else clockDrawScreen();
+}
+
+inline bool clock_init(){
+  g_clock = new (std::nothrow) ClockState();
+  if (!g_clock) return false;
+  wcBuild(*wcFind(g_clockCfg.zone), g_clock->tz);
+  clockLoadZones();
+  return true;
+}
+
+inline void clock_resume(){
+  ClockState& c = *g_clock;
+  c.inFront = true;
+  c.epdMode = M5.Display.getEpdMode();
+  M5.Display.setEpdMode(epd_mode_t::epd_fast);
+  if (!clockLoadFont()) Serial.println("clock font: /font/ftime.vlw not found, built-in font");
+  clock_redraw();
+}
+
+inline bool clock_tick(){
+  ClockState& c = *g_clock;
+  TouchEvent e;
+  while (touchPoll(e)){
+    if (e.ms < c.shownMs || !touchIsTap(e)) continue;
+    if (!clockTap(e.x, e.y)) return false;
+  }
+  if (c.view == CK_CLOCK){
+    struct tm t{};
+    if (clockLocal(t) && t.tm_min != c.shownMinute) clockDrawTime(t);
+    clockDrawWorld(false);
+  }
+  return true;
+}
+
+inline void clock_suspend(){
+  ClockState& c = *g_clock;
+  c.inFront = false;
+  if (c.fontLoaded){ M5.Display.unloadFont(); c.fontLoaded = false; }
+  c.font.clear(); c.font.shrink_to_fit();
+  delete c.strip;
+  c.strip = nullptr;
+  for (int i = 0; i < c.worldCount; ++i) c.world[i].shown = -1;
+  c.view = CK_CLOCK;                   // an unsaved alarm draft is dropped
+  M5.Display.setFont(&fonts::Font0);
+  M5.Display.setTextSize(1);
+  M5.Display.setEpdMode(c.epdMode);
+}
+
+inline void clock_teardown(){
+  delete g_clock;
+  g_clock = nullptr;
+}
+
+// CLOCKS.txt saved on the config page
+inline void clock_reloadZones(){
+  if (!g_clock) return;
+  clockLoadZones();
+  if (g_clock->inFront && g_clock->view == CK_CLOCK) clockDrawScreen();
+}
+
+#endif // CLOCKAPP_H
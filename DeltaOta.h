@@ -0,0 +1,476 @@
+#ifndef DELTAOTA_H
+#define DELTAOTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ---------- Delta firmware update ----------
+// A patch rebuilds the new app image from the one that is running, so only
+// the difference travels. The patch is streamed from SD or a local HTTP
+// server into the inactive OTA partition. RAM stays bounded: a 256-byte
+// window onto the old image and a 512-byte output buffer, whatever the image
+// size. The patch names the image it was made against (size and CRC-32).
+// That is checked before anything is written. The output's size and CRC-32
+// are checked before the boot partition is switched. The core's own image
+// check (esp_ota_end) then runs on top. The format and the patcher are
+// plain C++. On a host, deltaMake() builds patches and deltaApply() checks
+// them against the images; tools/delta.cpp wraps both.
+//
+//   if (otaFromSd("/update/calendar.dlt")) ESP.restart();   // setup(), after SD.begin()
+//   cfgServeUpdate(otaFromUrl);        // POST /update url=http://host/calendar.dlt
+//
+// POST /update is behind the config server's login and is refused while no
+// config password is set (ConfigServer.h), like every other write.
+//
+// Patch: a 24-byte header, then ops; varints are LEB128.
+//   DELTA_COPY   n          n bytes of the old image at the cursor
+//   DELTA_ADD    n, diffs   n bytes of the old image, each plus a diff byte.
+//                           Diffs go in groups of 8: a mask byte (bit i =
+//                           byte i differs), then the non-zero diffs.
+//   DELTA_INSERT n, bytes   n literal bytes; the cursor moves past n old bytes
+//   DELTA_SEEK   d          move the cursor by d (zigzag varint)
+//   DELTA_END
+// ADD suits code that moved: most bytes are the same, and the ones that
+// differ are addresses.
+
+static const uint32_t DELTA_MAGIC = 0x31544C44;   // "DLT1"
+
+enum DeltaOp : uint8_t { DELTA_END, DELTA_COPY, DELTA_ADD, DELTA_INSERT, DELTA_SEEK };
+
+struct DeltaHeader {
+  uint32_t magic;
+  uint32_t oldSize, oldCrc;    // the image the patch applies to
+  uint32_t newSize, newCrc;    // what it must produce
+  uint32_t reserved;
+};
+
+inline uint32_t deltaCrc(const uint8_t* p, size_t n, uint32_t crc = 0) {
+  static const uint32_t T[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C };
+  crc = ~crc;
+  while (n--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ T[crc & 15];
+    crc = (crc >> 4) ^ T[crc & 15];
+  }
+  return ~crc;
+}
+
+typedef bool (*DeltaReadFn)(void* ctx, uint32_t off, uint8_t* buf, size_t n);    // old image
+typedef bool (*DeltaWriteFn)(void* ctx, const uint8_t* buf, size_t n);           // new image
+
+// Patch bytes in (any chunking), new image out through `write`
+struct DeltaPatcher {
+  enum State : uint8_t { S_HEADER, S_OP, S_ARG, S_DATA, S_DONE, S_FAIL };
+
+  DeltaHeader  hdr;
+  DeltaReadFn  read = nullptr;
+  DeltaWriteFn write = nullptr;
+  void*        ctx = nullptr;
+  const char*  error = nullptr;
+
+  State    state = S_HEADER;
+  uint8_t  op = 0, shift = 0;
+  uint32_t arg = 0;            // varint being read
+  uint32_t left = 0;           // bytes of the current op still to produce
+  uint32_t cursor = 0;         // in the old image
+  uint32_t produced = 0, crc = 0;
+  uint8_t  mask = 0, group = 0;     // DELTA_ADD: current mask, bytes left in its group
+  uint8_t  hdrBuf[sizeof(DeltaHeader)];
+  uint8_t  hdrLen = 0;
+
+  uint8_t  win[256];           // window onto the old image
+  uint32_t winAt = 0, winLen = 0;
+  uint8_t  out[512];
+  size_t   outLen = 0;
+
+  void begin(DeltaReadFn r, DeltaWriteFn w, void* c) {
+    read = r; write = w; ctx = c; error = nullptr;
+    state = S_HEADER; hdrLen = 0; cursor = produced = crc = 0;
+    winLen = 0; outLen = 0;
+  }
+
+  bool fail(const char* why) { if (!error) error = why; state = S_FAIL; return false; }
+  bool done() const { return state == S_DONE; }
+
+  bool flush() {
+    if (!outLen) return true;
+    crc = deltaCrc(out, outLen, crc);
+    produced += outLen;
+    bool ok = write(ctx, out, outLen);
+    outLen = 0;
+    return ok || fail("write failed");
+  }
+
+  bool put(uint8_t b) {
+    if (produced + outLen >= hdr.newSize) return fail("output too long");
+    out[outLen++] = b;
+    return outLen < sizeof(out) || flush();
+  }
+
+  bool oldByte(uint8_t& b) {
+    if (cursor >= hdr.oldSize) return fail("read past old image");
+    if (cursor < winAt || cursor >= winAt + winLen) {
+      winAt = cursor;
+      winLen = hdr.oldSize - cursor < sizeof(win) ? hdr.oldSize - cursor : sizeof(win);
+      if (!read(ctx, winAt, win, winLen)) { winLen = 0; return fail("old image read failed"); }
+    }
+    b = win[cursor++ - winAt];
+    return true;
+  }
+
+  // COPY runs without input; ADD runs until it needs the next input byte
+  bool run() {
+    while (left && state == S_DATA) {
+      uint8_t b;
+      if (op == DELTA_COPY) {
+        if (!oldByte(b) || !put(b)) return false;
+        --left;
+        continue;
+      }
+      if (op != DELTA_ADD) return true;          // INSERT waits for input
+      if (!group) return true;                   // needs a mask byte
+      if (mask & 1) return true;                 // needs a diff byte
+      if (!oldByte(b) || !put(b)) return false;
+      mask >>= 1; --group; --left;
+    }
+    if (!left && state == S_DATA) state = S_OP;
+    return true;
+  }
+
+  bool startOp(uint32_t n) {
+    if (op == DELTA_SEEK) {
+      int32_t d = (int32_t)(n >> 1) ^ -(int32_t)(n & 1);
+      cursor += d;
+      state = S_OP;
+      return true;
+    }
+    left = n; group = 0;
+    state = n ? S_DATA : S_OP;
+    return run();
+  }
+
+  bool finish() {
+    if (!flush()) return false;
+    if (produced != hdr.newSize) return fail("output size differs");
+    if (crc != hdr.newCrc) return fail("output CRC differs");
+    state = S_DONE;
+    return true;
+  }
+
+  bool feed(const uint8_t* p, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      uint8_t c = p[i];
+      switch (state) {
+        case S_HEADER:
+          hdrBuf[hdrLen++] = c;
+          if (hdrLen < sizeof(hdr)) break;
+          memcpy(&hdr, hdrBuf, sizeof(hdr));
+          if (hdr.magic != DELTA_MAGIC) return fail("not a patch");
+          state = S_OP;
+          break;
+        case S_OP:
+          op = c;
+          if (op == DELTA_END) { if (!finish()) return false; break; }
+          if (op > DELTA_SEEK) return fail("bad op");
+          arg = 0; shift = 0;
+          state = S_ARG;
+          break;
+        case S_ARG:
+          if (shift > 28) return fail("bad varint");
+          arg |= (uint32_t)(c & 0x7F) << shift;
+          shift += 7;
+          if (!(c & 0x80) && !startOp(arg)) return false;
+          break;
+        case S_DATA:
+          if (op == DELTA_INSERT) {
+            if (!put(c)) return false;
+            ++cursor;
+            if (!--left) state = S_OP;
+            break;
+          }
+          // DELTA_ADD: a mask byte, or the diff for a set bit
+          if (!group) {
+            mask = c;
+            group = left < 8 ? (uint8_t)left : 8;
+          } else {
+            uint8_t b;
+            if (!oldByte(b) || !put((uint8_t)(b + c))) return false;
+            mask >>= 1; --group; --left;
+          }
+          if (!run()) return false;
+          break;
+        case S_DONE:
+          return fail("data after end");
+        case S_FAIL:
+          return false;
+      }
+    }
+    return true;
+  }
+};
+
+#ifndef ARDUINO
+// ---------- Host side ----------
+// Patch generation: a greedy pass over the new image against the old one.
+// At each point, in order of preference:
+//   1. an exact run at the cursor (COPY);
+//   2. a mostly-equal stretch at the cursor (ADD);
+//   3. an exact run found anywhere through an 8-byte hash (SEEK + COPY);
+//   4. a literal byte (INSERT).
+#include <vector>
+
+inline void deltaVarint(std::vector<uint8_t>& o, uint32_t v) {
+  while (v >= 0x80) { o.push_back((uint8_t)(v | 0x80)); v >>= 7; }
+  o.push_back((uint8_t)v);
+}
+
+inline void deltaOp(std::vector<uint8_t>& o, uint8_t op, uint32_t arg) { o.push_back(op); deltaVarint(o, arg); }
+
+inline void deltaMake(const uint8_t* a, uint32_t an, const uint8_t* b, uint32_t bn, std::vector<uint8_t>& o) {
+  const int K = 8, MIN_COPY = 8, WIN = 16;
+  DeltaHeader h = { DELTA_MAGIC, an, deltaCrc(a, an), bn, deltaCrc(b, bn), 0 };
+  o.assign((const uint8_t*)&h, (const uint8_t*)&h + sizeof(h));
+
+  const uint32_t BITS = 20;
+  std::vector<uint32_t> index(1u << BITS, UINT32_MAX);
+  auto hashAt = [](const uint8_t* p) {
+    uint64_t v; memcpy(&v, p, 8);
+    return (uint32_t)((v * 0x9E3779B97F4A7C15ull) >> (64 - BITS));
+  };
+  for (uint32_t i = 0; i + K <= an; ++i) {
+    uint32_t& slot = index[hashAt(a + i)];
+    if (slot == UINT32_MAX) slot = i;           // earliest wins
+  }
+
+  auto exact = [&](uint32_t ap, uint32_t bp) {
+    uint32_t n = 0;
+    while (ap + n < an && bp + n < bn && a[ap + n] == b[bp + n]) ++n;
+    return n;
+  };
+  auto similar = [&](uint32_t ap, uint32_t bp) {   // equal bytes in the next WIN
+    int n = 0;
+    for (int k = 0; k < WIN; ++k) {
+      if (ap + k >= an || bp + k >= bn) return 0;
+      n += a[ap + k] == b[bp + k];
+    }
+    return n;
+  };
+
+  std::vector<uint8_t> lit;
+  uint32_t cur = 0;
+  auto flushLit = [&]() {
+    if (lit.empty()) return;
+    deltaOp(o, DELTA_INSERT, (uint32_t)lit.size());
+    o.insert(o.end(), lit.begin(), lit.end());
+    lit.clear();
+  };
+  auto seekTo = [&](uint32_t to) {
+    if (to == cur) return;
+    int32_t d = (int32_t)(to - cur);
+    deltaOp(o, DELTA_SEEK, (uint32_t)((d << 1) ^ (d >> 31)));
+    cur = to;
+  };
+
+  for (uint32_t i = 0; i < bn; ) {
+    uint32_t n = cur < an ? exact(cur, i) : 0;
+    if (n >= (uint32_t)MIN_COPY) {
+      flushLit();
+      deltaOp(o, DELTA_COPY, n);
+      cur += n; i += n;
+      continue;
+    }
+    if (cur < an && similar(cur, i) >= WIN / 2) {
+      flushLit();
+      uint32_t j = i;                           // until similarity drops or an exact run starts
+      while (cur + (j - i) < an && j < bn) {
+        uint32_t ap = cur + (j - i);
+        if (j > i && exact(ap, j) >= (uint32_t)MIN_COPY) break;
+        if (similar(ap, j) < WIN / 2) { j += exact(ap, j); break; }
+        ++j;
+      }
+      uint32_t len = j - i;
+      deltaOp(o, DELTA_ADD, len);
+      for (uint32_t g = 0; g < len; g += 8) {
+        uint8_t mask = 0, d[8]; int nd = 0;
+        for (uint32_t k = 0; k < 8 && g + k < len; ++k) {
+          uint8_t diff = (uint8_t)(b[i + g + k] - a[cur + g + k]);
+          if (diff) { mask |= 1 << k; d[nd++] = diff; }
+        }
+        o.push_back(mask);
+        o.insert(o.end(), d, d + nd);
+      }
+      cur += len; i += len;
+      continue;
+    }
+    if (i + K <= bn) {
+      uint32_t c = index[hashAt(b + i)];
+      if (c != UINT32_MAX && (n = exact(c, i)) >= (uint32_t)MIN_COPY) {
+        flushLit();
+        seekTo(c);
+        deltaOp(o, DELTA_COPY, n);
+        cur += n; i += n;
+        continue;
+      }
+    }
+    lit.push_back(b[i++]);
+    ++cur;
+  }
+  flushLit();
+  o.push_back(DELTA_END);
+}
+
+// Rebuild the new image in memory; null on success, else the reason
+inline const char* deltaApply(const uint8_t* a, uint32_t an, const uint8_t* patch, size_t pn,
+                              std::vector<uint8_t>& out) {
+  struct Io {
+    const uint8_t* a; uint32_t an; std::vector<uint8_t>* out;
+    static bool rd(void* c, uint32_t off, uint8_t* buf, size_t n) {
+      Io* io = (Io*)c;
+      if (off + n > io->an) return false;
+      memcpy(buf, io->a + off, n);
+      return true;
+    }
+    static bool wr(void* c, const uint8_t* buf, size_t n) {
+      ((Io*)c)->out->insert(((Io*)c)->out->end(), buf, buf + n);
+      return true;
+    }
+  } io = { a, an, &out };
+  out.clear();
+  DeltaPatcher* p = new DeltaPatcher;
+  p->begin(Io::rd, Io::wr, &io);
+  const char* err = nullptr;
+  if (pn >= sizeof(DeltaHeader)) {
+    DeltaHeader h; memcpy(&h, patch, sizeof(h));
+    if (h.magic == DELTA_MAGIC && (h.oldSize != an || h.oldCrc != deltaCrc(a, an))) err = "patch is for another image";
+  }
+  if (!err && (!p->feed(patch, pn) || !p->done())) err = p->error ? p->error : "patch truncated";
+  delete p;
+  return err;
+}
+#endif // !ARDUINO
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <SD.h>
+#include <HTTPClient.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include "Perf.h"
+
+struct OtaTarget {
+  const esp_partition_t* running;
+  esp_ota_handle_t       handle;
+};
+
+inline bool otaReadRunning(void* ctx, uint32_t off, uint8_t* buf, size_t n) {
+  return esp_partition_read(((OtaTarget*)ctx)->running, off, buf, n) == ESP_OK;
+}
+
+inline bool otaWriteNext(void* ctx, const uint8_t* buf, size_t n) {
+  return esp_ota_write(((OtaTarget*)ctx)->handle, buf, n) == ESP_OK;
+}
+
+// CRC-32 of the running image's first n bytes
+inline bool otaRunningCrc(const esp_partition_t* p, uint32_t n, uint32_t& crc) {
+  if (n > p->size) return false;
+  uint8_t buf[1024];
+  crc = 0;
+  for (uint32_t off = 0; off < n; off += sizeof(buf)) {
+    uint32_t k = n - off < sizeof(buf) ? n - off : sizeof(buf);
+    if (esp_partition_read(p, off, buf, k) != ESP_OK) return false;
+    crc = deltaCrc(buf, k, crc);
+  }
+  return true;
+}
+
+// Apply `len` bytes of patch from `in` to the inactive partition and make
+// it the boot partition. Nothing is switched unless every check passes; the
+// caller restarts.
+inline bool otaApply(Stream& in, size_t len) {
+  OtaTarget t;
+  t.running = esp_ota_get_running_partition();
+  const esp_partition_t* next = esp_ota_get_next_update_partition(nullptr);
+  if (!t.running || !next) { Serial.println("ota: no OTA partition"); return false; }
+
+  DeltaHeader hdr;
+  if (len < sizeof(hdr) || in.readBytes((char*)&hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != DELTA_MAGIC) {
+    Serial.println("ota: not a patch");
+    return false;
+  }
+  uint32_t crc;
+  if (!otaRunningCrc(t.running, hdr.oldSize, crc) || crc != hdr.oldCrc) {
+    Serial.println("ota: patch is for another build, skipped");
+    return false;
+  }
+  if (hdr.newSize > next->size) { Serial.println("ota: new image too large"); return false; }
+  if (esp_ota_begin(next, hdr.newSize, &t.handle) != ESP_OK) { Serial.println("ota: begin failed"); return false; }
+
+  uint32_t t0 = millis();
+  DeltaPatcher* p = new DeltaPatcher;
+  p->begin(otaReadRunning, otaWriteNext, &t);
+  bool ok = p->feed((const uint8_t*)&hdr, sizeof(hdr));
+  uint8_t buf[512];
+  size_t left = len - sizeof(hdr), lastPct = 0;
+  {
+    PERF_SCOPE("ota patch", PERF_NET);
+    while (ok && left) {
+      size_t k = in.readBytes((char*)buf, left < sizeof(buf) ? left : sizeof(buf));
+      if (!k) { p->fail("patch stream ended"); ok = false; break; }
+      ok = p->feed(buf, k);
+      left -= k;
+      size_t pct = (len - left) * 10 / len;
+      if (pct != lastPct) { lastPct = pct; Serial.printf("ota: %u%%\n", (unsigned)pct * 10); }
+    }
+  }
+  ok = ok && p->done();
+  const char* err = ok ? nullptr : (p->error ? p->error : "patch truncated");
+  uint32_t produced = p->produced;
+  delete p;
+
+  if (!ok) { esp_ota_abort(t.handle); Serial.printf("ota: %s\n", err); return false; }
+  if (esp_ota_end(t.handle) != ESP_OK) { Serial.println("ota: new image failed validation"); return false; }
+  if (esp_ota_set_boot_partition(next) != ESP_OK) { Serial.println("ota: could not switch partition"); return false; }
+  Serial.printf("ota: %u B patch -> %u B image in %lu ms, boots from %s next\n",
+                (unsigned)len, (unsigned)produced, (unsigned long)(millis() - t0), next->label);
+  return true;
+}
+
+// A patch left on SD. It is renamed afterwards (.done or .failed), so a bad
+// patch is tried once and not on every boot.
+inline bool otaFromSd(const char* path) {
+  if (!SD.exists(path)) return false;
+  File f = SD.open(path, FILE_READ);
+  if (!f) return false;
+  Serial.printf("ota: applying %s\n", path);
+  bool ok = otaApply(f, f.size());
+  f.close();
+  String to = String(path) + (ok ? ".done" : ".failed");
+  SD.remove(to.c_str());
+  SD.rename(path, to.c_str());
+  return ok;
+}
+
+// A patch served over HTTP on the LAN
+inline bool otaFromUrl(const char* url) {
+  HTTPClient http;
+  http.useHTTP10(true);
+  http.setTimeout(15000);
+  http.begin(url);
+  int code = http.GET();
+  int len = http.getSize();
+  if (code != HTTP_CODE_OK || len <= 0) {
+    Serial.printf("ota: GET %s -> %d (%d B)\n", url, code, len);
+    http.end();
+    return false;
+  }
+  Serial.printf("ota: applying %s\n", url);
+  bool ok = otaApply(http.getStream(), (size_t)len);
+  http.end();
+  return ok;
+}
+#endif // ARDUINO
+
+#endif // DELTAOTA_H
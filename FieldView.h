@@ -0,0 +1,66 @@
+#ifndef FIELDVIEW_H
+#define FIELDVIEW_H
+
+#include <M5Unified.h>
+#include "Perf.h"
+
+// ---------- Field widgets ----------
+// One line of text in a fixed rect that remembers what it last showed.
+// fieldShow() is a no-op when the text is unchanged; otherwise it repaints
+// and flushes just that rect with a fast EPD update. The panel collects
+// ghosting from repeated fast updates, so after GHOST_EVERY flushes the
+// owner should call fieldsCleanRefresh() for one full quality pass.
+
+struct FieldWidget {
+  int16_t x, y, w, h;
+  char    shown[40];   // last rendered text, "" = nothing yet
+};
+
+struct FlushStats {
+  static const uint16_t GHOST_EVERY = 40;   // fast flushes before a full refresh
+
+  uint16_t rects = 0;      // this refresh
+  uint32_t pixels = 0;
+  uint16_t sinceClean = 0; // since the last full refresh
+
+  void begin() { rects = 0; pixels = 0; }
+  void add(int w, int h) { rects++; pixels += (uint32_t)w * h; sinceClean++; }
+  bool ghostDue() const { return sinceClean >= GHOST_EVERY; }
+};
+
+inline void fieldReset(FieldWidget& f, int x, int y, int w, int h) {
+  f.x = x; f.y = y; f.w = w; f.h = h; f.shown[0] = 0;
+}
+
+// Draw `text` into the field if it differs from what is on the panel.
+// `flush` = false while a whole view is being built (one flush at the end).
+inline bool fieldShow(FieldWidget& f, const char* text, FlushStats& st, bool flush = true) {
+  if (!strncmp(f.shown, text, sizeof(f.shown) - 1)) return false;
+  strlcpy(f.shown, text, sizeof(f.shown));
+
+  auto prevMode = M5.Display.getEpdMode();
+  if (flush) M5.Display.setEpdMode(m5gfx::epd_mode_t::epd_fast);
+  M5.Display.fillRect(f.x, f.y, f.w, f.h, WHITE);
+  M5.Display.setTextColor(BLACK);
+  M5.Display.setCursor(f.x, f.y);
+  M5.Display.print(text);
+  if (flush) {
+    PERF_SCOPE("field flush", PERF_FLUSH);
+    M5.Display.display(f.x, f.y, f.w, f.h);
+    M5.Display.setEpdMode(prevMode);
+    st.add(f.w, f.h);
+  }
+  return true;
+}
+
+// Full-panel quality pass to clear ghosting left by fast partial updates
+inline void fieldsCleanRefresh(FlushStats& st) {
+  PERF_SCOPE("clean refresh", PERF_FLUSH);
+  auto prevMode = M5.Display.getEpdMode();
+  M5.Display.setEpdMode(m5gfx::epd_mode_t::epd_quality);
+  M5.Display.display(0, 0, M5.Display.width(), M5.Display.height());
+  M5.Display.setEpdMode(prevMode);
+  st.sinceClean = 0;
+}
+
+#endif // FIELDVIEW_H
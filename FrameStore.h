@@ -0,0 +1,334 @@
+#ifndef FRAMESTORE_H
+#define FRAMESTORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ---------- Saved frame ----------
+// The last composed frame, kept on SD so a wake or reset can put it back
+// into the panel buffer instead of rendering it again. The panel itself
+// keeps the image through deep sleep; only the buffer behind it is lost.
+// The image is stored as run-length coded 4-bit gray levels, because the
+// calendar draws in grays. With it go one hash per screen region, taken
+// from that region's inputs. At restore, only the regions whose hash moved
+// need drawing. PSRAM does not survive deep sleep and RTC memory (8 KB) is
+// too small for a frame, so the copy lives on SD.
+//
+//   FrameRegion r[] = { { 0, 0, 960, 111, headerHash() }, { 0, 111, 960, 429, bodyHash() } };
+//   frameSave("/cache/frame.bin", r, 2);                 // before deep sleep
+//   uint32_t redraw = frameRestore("/cache/frame.bin", r, 2);   // bit i = region i
+//
+// Run token (1 or 3 bytes): high nibble = level, low nibble c.
+//   c < 15:  run of c + 1 pixels
+//   c = 15:  run of 16 + the u16 (little-endian) that follows
+// Runs continue across rows. A frame with few runs (a dithered photo)
+// codes larger than the levels themselves; it is stored raw instead, two
+// pixels a byte, high nibble first, the last byte padded. This part is
+// plain C++.
+
+static const uint32_t FRAME_MAGIC   = 0x314D5246;   // "FRM1"
+static const int      FRAME_REGIONS = 8;
+static const uint32_t FRAME_ALL     = 0xFFFFFFFFu;
+
+enum : uint8_t { FRAME_RLE = 0, FRAME_RAW = 1 };    // FrameHeader::mode
+
+// Payload size of a raw frame; more than this coded means store it raw
+inline uint32_t frameRawBytes(int w, int h) { return ((uint32_t)w * h + 1) / 2; }
+
+struct FrameRegion {
+  int16_t  x, y, w, h;
+  uint32_t hash;               // of everything drawn in it
+};
+
+// File header, little-endian; a u32 payload length and u32 FNV-1a of the
+// payload follow the payload
+struct FrameHeader {
+  uint32_t magic;
+  uint16_t w, h;
+  uint8_t  rotation, regions;
+  uint8_t  mode, reserved;     // FRAME_RLE or FRAME_RAW
+  uint32_t hash[FRAME_REGIONS];
+};
+
+inline uint32_t frameFnv(const uint8_t* p, size_t n, uint32_t h) {
+  while (n--) { h ^= *p++; h *= 16777619u; }
+  return h;
+}
+
+typedef bool (*FrameSinkFn)(void* ctx, const uint8_t* p, size_t n);
+typedef void (*FrameRunFn)(void* ctx, int x, int y, int len, uint8_t level);
+
+// Pixels in, tokens (or with `raw`, packed levels) out through `sink` in
+// chunks of the buffer size
+struct FrameRleEncoder {
+  uint8_t     buf[1024];
+  size_t      len = 0;
+  int         level = -1;
+  uint32_t    run = 0;
+  uint32_t    bytes = 0, sum = 2166136261u;
+  bool        ok = true, raw = false;
+  FrameSinkFn sink = nullptr;
+  void*       ctx = nullptr;
+
+  void begin(FrameSinkFn fn, void* c, bool asRaw = false) {
+    sink = fn; ctx = c; raw = asRaw;
+    len = 0; level = -1; run = 0; bytes = 0; sum = 2166136261u; ok = true;
+  }
+
+  // Bytes out so far, the buffered ones included
+  uint32_t size() const { return bytes + (uint32_t)len; }
+
+  void drain() {
+    if (!len) return;
+    sum = frameFnv(buf, len, sum);
+    bytes += len;
+    if (ok && !sink(ctx, buf, len)) ok = false;
+    len = 0;
+  }
+
+  void emit() {
+    while (run) {
+      if (len + 3 > sizeof(buf)) drain();
+      uint32_t r = run > 16 + 65535u ? 16 + 65535u : run;
+      if (r < 16) buf[len++] = (uint8_t)(level << 4 | (r - 1));
+      else {
+        buf[len++] = (uint8_t)(level << 4 | 15);
+        buf[len++] = (uint8_t)(r - 16);
+        buf[len++] = (uint8_t)((r - 16) >> 8);
+      }
+      run -= r;
+    }
+  }
+
+  // n pixels, one level (0..15) each
+  void pixels(const uint8_t* lv, int n) {
+    if (raw) { packed(lv, n); return; }
+    for (int i = 0; i < n; ) {
+      if (lv[i] == level) {
+        int j = i;
+        while (j < n && lv[j] == level) ++j;
+        run += j - i; i = j;
+        continue;
+      }
+      emit();
+      level = lv[i] & 15;
+      run = 0;
+    }
+  }
+
+  // Raw: `level` holds the high nibble of a byte still waiting for its pair
+  void packed(const uint8_t* lv, int n) {
+    for (int i = 0; i < n; ++i) {
+      if (level < 0) { level = lv[i] & 15; continue; }
+      if (len == sizeof(buf)) drain();
+      buf[len++] = (uint8_t)(level << 4 | (lv[i] & 15));
+      level = -1;
+    }
+  }
+
+  bool finish() {
+    if (raw && level >= 0) {
+      if (len == sizeof(buf)) drain();
+      buf[len++] = (uint8_t)(level << 4);
+      level = -1;
+    }
+    emit(); drain(); return ok;
+  }
+};
+
+// Tokens (or with `raw`, packed levels) in, any chunking; runs out clipped
+// to rows of a w-wide image
+struct FrameRleDecoder {
+  int      w = 0, h = 0, x = 0, y = 0;
+  uint8_t  tok[3];
+  int      have = 0;
+  uint32_t sum = 2166136261u;
+  bool     raw = false;
+
+  void begin(int width, int height, bool asRaw = false) {
+    w = width; h = height; raw = asRaw; x = y = 0; have = 0; sum = 2166136261u;
+  }
+  bool done() const { return y >= h; }
+
+  void runOf(uint32_t n, uint8_t level, FrameRunFn fn, void* ctx) {
+    while (n && y < h) {
+      int k = (int)(n < (uint32_t)(w - x) ? n : (uint32_t)(w - x));
+      fn(ctx, x, y, k, level);
+      x += k; n -= k;
+      if (x == w) { x = 0; ++y; }
+    }
+  }
+
+  // Raw levels, equal neighbours joined into one run per call
+  bool packed(const uint8_t* p, size_t n, FrameRunFn fn, void* ctx) {
+    uint32_t left = (uint32_t)(h - y) * w - x, run = 0;
+    uint8_t level = 0;
+    for (size_t i = 0; i < n; ++i) {
+      for (int k = 0; k < 2; ++k) {
+        uint8_t v = k ? p[i] & 15 : p[i] >> 4;
+        if (run == left) {
+          if (k && i == n - 1) break;          // the pad nibble
+          runOf(run, level, fn, ctx);
+          return false;
+        }
+        if (run && v != level) { runOf(run, level, fn, ctx); left -= run; run = 0; }
+        level = v; ++run;
+      }
+    }
+    runOf(run, level, fn, ctx);
+    return true;
+  }
+
+  // False on a run past the end of the image
+  bool feed(const uint8_t* p, size_t n, FrameRunFn fn, void* ctx) {
+    sum = frameFnv(p, n, sum);
+    if (raw) return packed(p, n, fn, ctx);
+    for (size_t i = 0; i < n; ++i) {
+      tok[have++] = p[i];
+      if ((tok[0] & 15) == 15 && have < 3) continue;
+      if (done()) return false;
+      uint32_t run = (tok[0] & 15) < 15 ? (tok[0] & 15) + 1u
+                                        : 16u + (tok[1] | (uint32_t)tok[2] << 8);
+      runOf(run, tok[0] >> 4, fn, ctx);
+      have = 0;
+    }
+    return true;
+  }
+};
+
+// Bit i set where region i's saved hash differs from `cur`
+inline uint32_t frameStale(const FrameHeader& hdr, const FrameRegion* cur, int n) {
+  if (hdr.magic != FRAME_MAGIC || hdr.regions != n || n > FRAME_REGIONS) return FRAME_ALL;
+  uint32_t mask = 0;
+  for (int i = 0; i < n; ++i) if (hdr.hash[i] != cur[i].hash) mask |= 1u << i;
+  return mask;
+}
+
+#ifdef ARDUINO
+#include <M5Unified.h>
+#include <SD.h>
+#include "Perf.h"
+
+inline uint8_t frameLevelOf(const lgfx::rgb888_t& c) {
+  return (uint8_t)((c.r * 77 + c.g * 150 + c.b * 29) >> 12);
+}
+
+inline bool frameSinkFile(void* ctx, const uint8_t* p, size_t n) {
+  return ((File*)ctx)->write(p, n) == n;
+}
+
+inline void frameRunDraw(void*, int x, int y, int len, uint8_t level) {
+  uint8_t v = level * 17;
+  M5.Display.drawFastHLine(x, y, len, M5.Display.color888(v, v, v));
+}
+
+// Read the panel buffer back and write it with the region hashes. Through
+// a temp file, so a failed write keeps the previous frame.
+inline bool frameSave(const char* path, const FrameRegion* r, int n) {
+  if (n > FRAME_REGIONS) return false;
+  int w = M5.Display.width(), h = M5.Display.height();
+  lgfx::rgb888_t* row = (lgfx::rgb888_t*)malloc(sizeof(lgfx::rgb888_t) * w);
+  uint8_t* lv = (uint8_t*)malloc(w);
+  if (!row || !lv) { free(row); free(lv); return false; }
+
+  String tmp = String(path) + ".tmp";
+  FrameHeader hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = FRAME_MAGIC; hdr.w = w; hdr.h = h;
+  hdr.rotation = M5.Display.getRotation(); hdr.regions = n;
+  for (int i = 0; i < n; ++i) hdr.hash[i] = r[i].hash;
+
+  // Run-coded first; once that outgrows the raw size, start over raw
+  uint32_t t0 = perfNowUs(), raw = frameRawBytes(w, h);
+  FrameRleEncoder* enc = new FrameRleEncoder;
+  File f;
+  bool ok = false;
+  for (uint8_t mode = FRAME_RLE; mode <= FRAME_RAW; ++mode) {
+    SD.remove(tmp.c_str());
+    f = SD.open(tmp.c_str(), FILE_WRITE);
+    if (!f) break;
+    hdr.mode = mode;
+    f.write((const uint8_t*)&hdr, sizeof(hdr));
+    enc->begin(frameSinkFile, &f, mode == FRAME_RAW);
+    PERF_SCOPE("frame encode", PERF_RENDER);
+    int y = 0;
+    for (; y < h && enc->size() <= raw; ++y) {
+      M5.Display.readRect(0, y, w, 1, row);
+      for (int x = 0; x < w; ++x) lv[x] = frameLevelOf(row[x]);
+      enc->pixels(lv, w);
+    }
+    ok = y == h && enc->finish();
+    if (mode == FRAME_RAW || (ok && enc->bytes <= raw)) break;
+    f.close();
+  }
+  if (!f) { delete enc; free(row); free(lv); return false; }
+  uint32_t bytes = enc->bytes, sum = enc->sum;
+  delete enc;
+  free(row); free(lv);
+  ok = ok && f.write((const uint8_t*)&bytes, 4) == 4 && f.write((const uint8_t*)&sum, 4) == 4;
+  f.close();
+  uint32_t dt = perfNowUs() - t0;
+  if (!ok) { SD.remove(tmp.c_str()); Serial.println("frame: save failed"); return false; }
+  SD.remove(path);
+  SD.rename(tmp.c_str(), path);
+  Serial.printf("frame: saved %u B %s (%.1f%% of 1 bpp) in %lu ms, %.1f Mpx/s\n",
+                (unsigned)bytes, hdr.mode == FRAME_RAW ? "raw" : "run-coded",
+                bytes * 800.0f / ((float)w * h), (unsigned long)(dt / 1000),
+                dt ? (float)w * h / dt : 0.0f);
+  return true;
+}
+
+// Decode the saved frame into the panel buffer without flushing it. Returns
+// the regions to redraw (FRAME_ALL when nothing usable was saved; the
+// buffer may then hold part of a frame, so draw everything). The next
+// flush covers the restored pixels too; where they match the panel the
+// update leaves them as they are.
+inline uint32_t frameRestore(const char* path, const FrameRegion* r, int n) {
+  File f = SD.open(path, FILE_READ);
+  if (!f) return FRAME_ALL;
+  FrameHeader hdr;
+  size_t size = f.size();
+  if (size < sizeof(hdr) + 8 || f.read((uint8_t*)&hdr, sizeof(hdr)) != (int)sizeof(hdr) ||
+      hdr.w != M5.Display.width() || hdr.h != M5.Display.height() ||
+      hdr.rotation != M5.Display.getRotation() || hdr.mode > FRAME_RAW) { f.close(); return FRAME_ALL; }
+  uint32_t mask = frameStale(hdr, r, n);
+  if (mask == FRAME_ALL || mask == (1u << n) - 1) { f.close(); return FRAME_ALL; }
+
+  uint32_t trailer[2];
+  f.seek(size - 8);
+  f.read((uint8_t*)trailer, 8);
+  f.seek(sizeof(hdr));
+  if (trailer[0] != size - sizeof(hdr) - 8) { f.close(); return FRAME_ALL; }
+
+  uint32_t t0 = perfNowUs();
+  FrameRleDecoder dec;
+  dec.begin(hdr.w, hdr.h, hdr.mode == FRAME_RAW);
+  uint8_t buf[1024];
+  bool ok = true;
+  {
+    PERF_SCOPE("frame decode", PERF_RENDER);
+    M5.Display.setAutoDisplay(false);          // the caller decides what to flush
+    M5.Display.startWrite();
+    for (uint32_t left = trailer[0]; ok && left; ) {
+      int k = f.read(buf, left < sizeof(buf) ? left : sizeof(buf));
+      if (k <= 0) { ok = false; break; }
+      ok = dec.feed(buf, k, frameRunDraw, nullptr);
+      left -= k;
+    }
+    M5.Display.endWrite();
+    M5.Display.setAutoDisplay(true);
+  }
+  f.close();
+  uint32_t dt = perfNowUs() - t0;
+  if (!ok || !dec.done() || dec.sum != trailer[1]) { Serial.println("frame: saved frame corrupt"); return FRAME_ALL; }
+  Serial.printf("frame: restored %u B in %lu ms, %.1f Mpx/s, redraw mask 0x%lx\n",
+                (unsigned)trailer[0], (unsigned long)(dt / 1000),
+                dt ? (float)hdr.w * hdr.h / dt : 0.0f, (unsigned long)mask);
+  return mask;
+}
+
+inline void frameForget(const char* path) { SD.remove(path); }
+#endif // ARDUINO
+
+#endif // FRAMESTORE_H
@@ -0,0 +1,355 @@
+#ifndef GLYPHFONT_H
+#define GLYPHFONT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "Perf.h"
+
+// ---------- SD fonts with a glyph cache ----------
+// Event titles come in any script, but the built-in fonts are ASCII. A
+// VLW font (the Processing / TFT_eSPI format) on SD can cover thousands of
+// glyphs. Only its index is read at load: codepoint, metrics and bitmap
+// offset per glyph. Bitmaps are read from the card on first use into a
+// fixed pool of slots (LRU). Memory stays bounded however large the font
+// is, and widths come from the index without touching a bitmap. Hits,
+// misses and the cost of each load go to Perf.h. This part is plain C++:
+// the file read is a callback.
+//
+//   GlyphFont f; f.begin(header, 24); ... f.addGlyph(rec28) ...; f.finish(64 * 1024, load, ctx);
+//   int w = f.width("Café 会议");
+
+// ---------- UTF-8 ----------
+// Next codepoint from `p` (advanced past it); malformed bytes give U+FFFD
+inline uint32_t utf8Next(const char*& p) {
+  uint8_t c = (uint8_t)*p++;
+  if (c < 0x80) return c;
+  int n = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : -1;
+  if (n < 0 || c >= 0xF8) return 0xFFFD;
+  uint32_t cp = c & (0x3F >> n);
+  for (int i = 0; i < n; ++i) {
+    uint8_t b = (uint8_t)*p;
+    if ((b & 0xC0) != 0x80) return 0xFFFD;       // truncated: leave p on the next lead byte
+    cp = (cp << 6) | (b & 0x3F);
+    p++;
+  }
+  return cp;
+}
+
+// Length of `s` (n bytes) without its last codepoint
+inline size_t utf8DropLast(const char* s, size_t n) {
+  if (!n) return 0;
+  size_t i = n - 1;
+  while (i > 0 && ((uint8_t)s[i] & 0xC0) == 0x80) --i;
+  return i;
+}
+
+// ---------- VLW ----------
+// Header: 6 big-endian int32 (glyph count, version, size, 0, ascent,
+// descent). Then 7 int32 per glyph (codepoint, height, width, advance, dY,
+// dX, 0), then the 8-bit alpha bitmaps in glyph order.
+inline int32_t vlwInt(const uint8_t* p) {
+  return (int32_t)((uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]);
+}
+
+static const int VLW_HEADER = 24, VLW_RECORD = 28;
+
+struct GlyphInfo {
+  uint32_t code;
+  uint32_t off;                // bitmap offset in the file
+  uint8_t  w, h;
+  int8_t   adv, dX;
+  int16_t  dY;                 // glyph top above the baseline
+};
+
+typedef bool (*GlyphLoadFn)(void* ctx, uint32_t off, uint8_t* dst, uint32_t len);
+
+#ifdef ARDUINO
+#define GLYPH_ALLOC(n) ps_malloc(n)
+#else
+#define GLYPH_ALLOC(n) malloc(n)
+#endif
+
+struct GlyphFont {
+  // Index
+  GlyphInfo* glyph = nullptr;
+  int        count = 0, added = 0;
+  int        ascent = 0, descent = 0, lineH = 0;
+  uint32_t   nextOff = 0;
+  int        spaceAdv = 0;
+  // Cache
+  uint8_t*   pool = nullptr;
+  int        slots = 0, slotBytes = 0;
+  int32_t*   slotGlyph = nullptr;     // glyph in each slot, -1 free
+  int16_t*   slotOf = nullptr;        // per glyph: its slot, -1 not loaded
+  int16_t*   prev = nullptr;
+  int16_t*   next = nullptr;
+  int16_t    head = -1, tail = -1;    // most / least recently used
+  GlyphLoadFn load = nullptr;
+  void*      ctx = nullptr;
+  // Stats
+  uint32_t   hits = 0, misses = 0, failed = 0;
+  uint64_t   loadUs = 0;
+
+  bool ready() const { return pool != nullptr; }
+
+  bool begin(const uint8_t* hdr, size_t n) {
+    if (n < (size_t)VLW_HEADER) return false;
+    int32_t c = vlwInt(hdr);
+    if (c <= 0 || c > 65535) return false;
+    count = c;
+    ascent = vlwInt(hdr + 16);
+    descent = vlwInt(hdr + 20);
+    lineH = ascent + descent;
+    glyph = (GlyphInfo*)GLYPH_ALLOC(sizeof(GlyphInfo) * count);
+    added = 0;
+    nextOff = VLW_HEADER + (uint32_t)VLW_RECORD * count;
+    return glyph != nullptr;
+  }
+
+  void addGlyph(const uint8_t* rec) {
+    if (added >= count) return;
+    GlyphInfo& g = glyph[added++];
+    g.code = (uint32_t)vlwInt(rec);
+    int h = vlwInt(rec + 4), w = vlwInt(rec + 8);
+    g.h = (uint8_t)std::min(std::max(h, 0), 255);
+    g.w = (uint8_t)std::min(std::max(w, 0), 255);
+    g.adv = (int8_t)vlwInt(rec + 12);
+    g.dY  = (int16_t)vlwInt(rec + 16);
+    g.dX  = (int8_t)vlwInt(rec + 20);
+    g.off = nextOff;
+    nextOff += (uint32_t)w * h;
+  }
+
+  // Sort the index and carve `cacheBytes` into slots of the largest glyph
+  bool finish(uint32_t cacheBytes, GlyphLoadFn fn, void* c) {
+    count = added;
+    std::sort(glyph, glyph + count, [](const GlyphInfo& a, const GlyphInfo& b) { return a.code < b.code; });
+    slotBytes = 1;
+    for (int i = 0; i < count; ++i) slotBytes = std::max(slotBytes, glyph[i].w * glyph[i].h);
+    slots = std::min((int)(cacheBytes / slotBytes), 32767);
+    if (slots < 1) slots = 1;
+    pool = (uint8_t*)GLYPH_ALLOC((size_t)slots * slotBytes);
+    slotGlyph = (int32_t*)GLYPH_ALLOC(sizeof(int32_t) * slots);
+    prev = (int16_t*)GLYPH_ALLOC(sizeof(int16_t) * slots);
+    next = (int16_t*)GLYPH_ALLOC(sizeof(int16_t) * slots);
+    slotOf = (int16_t*)GLYPH_ALLOC(sizeof(int16_t) * (count ? count : 1));
+    if (!pool || !slotGlyph || !prev || !next || !slotOf) { end(); return false; }
+    for (int i = 0; i < count; ++i) slotOf[i] = -1;
+    // All slots free, chained in order
+    for (int s = 0; s < slots; ++s) { slotGlyph[s] = -1; prev[s] = (int16_t)(s - 1); next[s] = (int16_t)(s + 1); }
+    next[slots - 1] = -1;
+    head = 0; tail = (int16_t)(slots - 1);
+    load = fn; ctx = c;
+    int sp = find(' ');
+    spaceAdv = sp >= 0 ? glyph[sp].adv : lineH / 3;
+    return true;
+  }
+
+  void end() {
+    free(glyph); free(pool); free(slotGlyph); free(prev); free(next); free(slotOf);
+    glyph = nullptr; pool = nullptr; slotGlyph = nullptr; prev = next = slotOf = nullptr;
+    count = slots = 0;
+  }
+
+  int find(uint32_t code) const {
+    int lo = 0, hi = count - 1;
+    while (lo <= hi) {
+      int mid = (lo + hi) / 2;
+      if (glyph[mid].code < code) lo = mid + 1;
+      else if (glyph[mid].code > code) hi = mid - 1;
+      else return mid;
+    }
+    return -1;
+  }
+
+  void unlink(int s) {
+    if (prev[s] >= 0) next[prev[s]] = next[s]; else head = next[s];
+    if (next[s] >= 0) prev[next[s]] = prev[s]; else tail = prev[s];
+  }
+
+  void pushFront(int s) {
+    prev[s] = -1; next[s] = head;
+    if (head >= 0) prev[head] = (int16_t)s;
+    head = (int16_t)s;
+    if (tail < 0) tail = (int16_t)s;
+  }
+
+  // Bitmap of glyph gi (w * h alpha bytes), loading it into the LRU slot
+  const uint8_t* bitmap(int gi) {
+    int s = slotOf[gi];
+    if (s >= 0) {
+      hits++;
+      if (s != head) { unlink(s); pushFront(s); }
+      return pool + (size_t)s * slotBytes;
+    }
+    misses++;
+    s = tail;
+    unlink(s);
+    if (slotGlyph[s] >= 0) slotOf[slotGlyph[s]] = -1;
+    const GlyphInfo& g = glyph[gi];
+    uint8_t* dst = pool + (size_t)s * slotBytes;
+    uint32_t t0 = perfNowUs();
+    bool ok = load(ctx, g.off, dst, (uint32_t)g.w * g.h);
+    uint32_t dt = perfNowUs() - t0;
+    loadUs += dt;
+    perfLog().span("glyph load", PERF_PARSE, t0, dt);
+    if (!ok) {
+      failed++;
+      slotGlyph[s] = -1;
+      prev[s] = tail; next[s] = -1;            // back to the end, still free
+      if (tail >= 0) next[tail] = (int16_t)s; else head = (int16_t)s;
+      tail = (int16_t)s;
+      return nullptr;
+    }
+    slotGlyph[s] = gi;
+    slotOf[gi] = (int16_t)s;
+    pushFront(s);
+    return dst;
+  }
+
+  int advance(uint32_t code) const {
+    if (code == ' ') return spaceAdv;
+    int gi = find(code);
+    return gi >= 0 ? glyph[gi].adv : spaceAdv;   // missing glyphs keep their place
+  }
+
+  int width(const char* s) const {
+    int w = 0;
+    while (*s) w += advance(utf8Next(s));
+    return w;
+  }
+
+  // Hit rate and load cost, e.g. for the serial log
+  void report(const char* name) const {
+    uint32_t n = hits + misses;
+    perfOut("font %s: %d glyphs, %d slots x %d B, hits %lu/%lu (%.1f%%), %lu loads %.2f ms avg, %lu failed\n",
+            name, count, slots, slotBytes, (unsigned long)hits, (unsigned long)n,
+            n ? hits * 100.0 / n : 0.0, (unsigned long)misses,
+            misses ? loadUs / 1000.0 / misses : 0.0, (unsigned long)failed);
+  }
+};
+
+#ifdef ARDUINO
+#include <M5Unified.h>
+#include <SD.h>
+
+// A GlyphFont over an open SD file
+struct SdFont {
+  GlyphFont font;
+  File      file;
+  char      name[24];
+
+  static bool readAt(void* ctx, uint32_t off, uint8_t* dst, uint32_t len) {
+    File& f = ((SdFont*)ctx)->file;
+    return f.seek(off) && f.read(dst, len) == (int)len;
+  }
+
+  bool open(const char* path, uint32_t cacheBytes) {
+    PERF_SCOPE("font index", PERF_PARSE);
+    file = SD.open(path, FILE_READ);
+    if (!file) return false;
+    strncpy(name, path, sizeof(name) - 1); name[sizeof(name) - 1] = 0;
+    uint8_t hdr[VLW_HEADER];
+    if (file.read(hdr, sizeof(hdr)) != (int)sizeof(hdr) || !font.begin(hdr, sizeof(hdr))) { file.close(); return false; }
+    uint8_t rec[VLW_RECORD * 32];
+    for (int i = 0; i < font.count; ) {
+      int n = std::min(32, font.count - i);
+      if (file.read(rec, VLW_RECORD * n) != VLW_RECORD * n) break;
+      for (int k = 0; k < n; ++k) font.addGlyph(rec + VLW_RECORD * k);
+      i += n;
+    }
+    if (!font.finish(cacheBytes, readAt, this)) { file.close(); return false; }
+    Serial.printf("font %s: %d glyphs, line %d px, %d cache slots\n", path, font.count, font.lineH, font.slots);
+    return true;
+  }
+
+  void close() { font.end(); if (file) file.close(); }
+
+  int width(const String& s) const { return font.width(s.c_str()); }
+
+  // Draw `s` with its top at y. Alpha >= 50% is ink: crisp in the fast
+  // 1-bit waveforms and on the gray levels alike.
+  int draw(LovyanGFX& g, int x, int y, const String& s, uint16_t color) {
+    int base = y + font.ascent;
+    const char* p = s.c_str();
+    while (*p) {
+      uint32_t cp = utf8Next(p);
+      int gi = cp == ' ' ? -1 : font.find(cp);
+      if (gi < 0) { x += font.advance(cp); continue; }
+      const GlyphInfo& gl = font.glyph[gi];
+      const uint8_t* bm = font.bitmap(gi);
+      if (bm) {
+        int gx = x + gl.dX, gy = base - gl.dY;
+        for (int r = 0; r < gl.h; ++r) {
+          const uint8_t* row = bm + r * gl.w;
+          for (int c = 0; c < gl.w; ) {
+            if (row[c] < 128) { c++; continue; }
+            int c0 = c;
+            while (c < gl.w && row[c] >= 128) c++;
+            g.drawFastHLine(gx + c0, gy + r, c - c0, color);
+          }
+        }
+      }
+      x += gl.adv;
+    }
+    return x;
+  }
+};
+
+// ---------- UI text ----------
+// Event text at size 2 uses /fonts/large.vlw and at size 1 /fonts/small.vlw,
+// when those are on the card. Otherwise the target's built-in font is used,
+// as before. Callers set the text colour as usual; SD glyphs take `color`.
+inline SdFont& uiFontSlot(int sz) { static SdFont f[2]; return f[sz >= 2 ? 1 : 0]; }
+
+inline SdFont* uiFont(int sz) {
+  SdFont& f = uiFontSlot(sz);
+  return f.font.ready() ? &f : nullptr;
+}
+
+inline void uiFontsBegin(uint32_t cacheBytes = 96 * 1024) {
+  if (SD.exists("/fonts/large.vlw")) uiFontSlot(2).open("/fonts/large.vlw", cacheBytes);
+  if (SD.exists("/fonts/small.vlw")) uiFontSlot(1).open("/fonts/small.vlw", cacheBytes);
+}
+
+// Index and cache freed, files closed; uiFontsBegin() opens them again
+inline void uiFontsEnd() {
+  for (int k = 0; k < 2; ++k) if (uiFontSlot(k * 2).font.ready()) uiFontSlot(k * 2).close();
+}
+
+inline int uiTextWidth(LovyanGFX& g, const String& s, int sz) {
+  if (SdFont* f = uiFont(sz)) return f->width(s);
+  g.setTextSize(sz);
+  return g.textWidth(s.c_str());
+}
+
+inline int uiLineH(LovyanGFX& g, int sz) {
+  if (SdFont* f = uiFont(sz)) return f->font.lineH;
+  g.setTextSize(sz);
+  return g.fontHeight();
+}
+
+inline void uiText(LovyanGFX& g, int x, int y, const String& s, int sz, uint16_t color) {
+  if (SdFont* f = uiFont(sz)) { f->draw(g, x, y, s, color); return; }
+  g.setTextSize(sz);
+  g.setCursor(x, y);
+  g.print(s);
+}
+
+// Log each loaded font's cache stats when they moved since the last call
+inline void uiFontsReport() {
+  static uint32_t seen[2] = { 0, 0 };
+  for (int k = 0; k < 2; ++k) {
+    SdFont& f = uiFontSlot(k * 2);
+    uint32_t n = f.font.hits + f.font.misses;
+    if (!f.font.ready() || n == seen[k]) continue;
+    seen[k] = n;
+    f.font.report(f.name);
+  }
+}
+#endif // ARDUINO
+
+#endif // GLYPHFONT_H
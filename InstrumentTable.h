@@ -0,0 +1,105 @@
+#ifndef INSTRUMENTTABLE_H
+#define INSTRUMENTTABLE_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ---------- Instrument table ----------
+// Watchlist state as parallel columns indexed by a small interned id (the row
+// number). Symbol type and display label are worked out once in add(), so
+// drawing and hit-testing just walk the arrays: no String per frame.
+//
+//   int id = gInstr.add("BTC-USD");     // -> INSTR_CRYPTO, label "BTC"
+//   gInstr.setQuote(id, price, ..., time(nullptr));
+//   if (gInstr.dirty[id] & INSTR_DIRTY_PRICE) { ...redraw...; gInstr.clean(id); }
+//
+// Plain C++ only, so the same file builds on the host.
+
+enum InstrType : uint8_t { INSTR_STOCK, INSTR_CRYPTO };
+
+enum : uint8_t {
+  INSTR_DIRTY_PRICE = 1 << 0,   // last price changed
+  INSTR_DIRTY_STATS = 1 << 1,   // high/low/open/prevClose/volume changed
+};
+
+struct InstrumentTable {
+  static const int CAP     = 200;
+  static const int SYM_LEN = 16;    // "DOGE-USD", "BRK.B", ... plus NUL
+
+  int count = 0;
+
+  // Hot columns: touched on every menu draw / touch
+  uint8_t  type[CAP];
+  uint8_t  dirty[CAP];
+  uint16_t labelW[CAP];             // label pixel width, cached by the sketch
+  char     label[CAP][SYM_LEN];     // what the menu shows ("BTC")
+
+  // Cold columns: only the detail view and refresh read these
+  char     symbol[CAP][SYM_LEN];    // what the APIs want ("BTC-USD")
+  float    price[CAP], high[CAP], low[CAP], open[CAP], prevClose[CAP];
+  float    change[CAP], volume[CAP];
+  uint32_t updated[CAP];            // epoch of the last quote, 0 = never
+
+  void clear() { count = 0; }
+
+  static char up(char c) { return (c >= 'a' && c <= 'z') ? (char)(c - 32) : c; }
+
+  static bool endsWithNoCase(const char* s, const char* suf) {
+    size_t n = strlen(s), m = strlen(suf);
+    if (m > n) return false;
+    for (size_t i = 0; i < m; ++i) if (up(s[n - m + i]) != up(suf[i])) return false;
+    return true;
+  }
+
+  // "BTC-USD" style (Coindesk instrument) -> crypto; anything else is a stock
+  static InstrType classify(const char* s) {
+    const char* dash = strchr(s, '-');
+    return (dash && dash != s && endsWithNoCase(s, "-USD")) ? INSTR_CRYPTO : INSTR_STOCK;
+  }
+
+  int find(const char* sym) const {
+    for (int i = 0; i < count; ++i) {
+      const char* a = symbol[i]; const char* b = sym;
+      while (*a && up(*a) == up(*b)) { ++a; ++b; }
+      if (*a == 0 && *b == 0) return i;
+    }
+    return -1;
+  }
+
+  // Interns a symbol; returns its id, the existing id for duplicates, or -1
+  // when the table is full or the symbol does not fit
+  int add(const char* sym) {
+    size_t n = strlen(sym);
+    if (n == 0 || n >= (size_t)SYM_LEN) return -1;
+    int id = find(sym);
+    if (id >= 0) return id;
+    if (count >= CAP) return -1;
+    id = count++;
+    memcpy(symbol[id], sym, n + 1);
+    type[id] = classify(sym);
+    size_t ln = (type[id] == INSTR_CRYPTO) ? n - 4 : n;   // strip "-USD"
+    memcpy(label[id], sym, ln); label[id][ln] = 0;
+    labelW[id] = 0;
+    dirty[id] = 0;
+    price[id] = high[id] = low[id] = open[id] = prevClose[id] = 0;
+    change[id] = volume[id] = 0;
+    updated[id] = 0;
+    return id;
+  }
+
+  bool isCrypto(int id) const { return type[id] == INSTR_CRYPTO; }
+
+  void setQuote(int id, float p, float h, float l, float o, float pc,
+                float chg, float vol, uint32_t now) {
+    if (p != price[id]) dirty[id] |= INSTR_DIRTY_PRICE;
+    if (h != high[id] || l != low[id] || o != open[id] || pc != prevClose[id] || vol != volume[id])
+      dirty[id] |= INSTR_DIRTY_STATS;
+    price[id] = p; high[id] = h; low[id] = l; open[id] = o; prevClose[id] = pc;
+    change[id] = chg; volume[id] = vol;
+    updated[id] = now;
+  }
+
+  void clean(int id, uint8_t bits = 0xFF) { dirty[id] &= (uint8_t)~bits; }
+};
+
+#endif // INSTRUMENTTABLE_H
@@ -0,0 +1,152 @@
+#ifndef LASTKNOWN_H
+#define LASTKNOWN_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include <time.h>
+
+// ---------- Last known good data ----------
+// The last successful result of each fetch (a quote, the weather), kept as
+// raw bytes with the epoch it arrived. Records are appended to a binary
+// journal on SD and replayed into RAM at boot, so a view can draw straight
+// away without the network and badge the data "stale since HH:MM".
+//
+// Journal record (little-endian, 25 + len bytes):
+//   u16 magic 'LK' | u8 kind | u8 len | u32 at | char key[16] | data[len] | u8 sum
+// A torn record at the tail (power cut mid-write) fails the checksum; the
+// replay stops there and the journal is rewritten from what was good.
+//
+//   gLast.put(LK_QUOTE, "AAPL", &q, sizeof(q), now);
+//   uint32_t at; if (gLast.get(LK_QUOTE, "AAPL", &q, sizeof(q), &at)) ...
+
+enum LkKind : uint8_t { LK_QUOTE = 1, LK_WEATHER = 2 };
+
+struct LastKnown {
+  static const int      SLOTS        = 48;
+  static const int      KEY_LEN      = 16;
+  static const int      MAX_DATA     = 128;
+  static const uint16_t MAGIC        = 0x4B4C;       // "LK"
+  static const uint32_t COMPACT_SIZE = 16 * 1024;    // rewrite the journal past this
+
+  struct Rec { uint8_t kind, len; uint32_t at; char key[KEY_LEN]; uint8_t data[MAX_DATA]; };
+
+  Rec         rec[SLOTS];
+  int         count = 0;
+  const char* path = "/cache/last.bin";
+
+  static uint8_t sum(const Rec& r) {
+    uint8_t s = r.kind + r.len;
+    for (int i = 0; i < 4; ++i) s += (uint8_t)(r.at >> (8 * i));
+    for (int i = 0; i < KEY_LEN; ++i) s += (uint8_t)r.key[i];
+    for (int i = 0; i < r.len; ++i) s += r.data[i];
+    return s;
+  }
+
+  int find(uint8_t kind, const char* key) const {
+    for (int i = 0; i < count; ++i)
+      if (rec[i].kind == kind && !strncmp(rec[i].key, key, KEY_LEN)) return i;
+    return -1;
+  }
+
+  // Slot for kind/key: existing, free, or the one holding the oldest data
+  int slotFor(uint8_t kind, const char* key) {
+    int i = find(kind, key);
+    if (i >= 0) return i;
+    if (count < SLOTS) return count++;
+    int v = 0;
+    for (i = 1; i < SLOTS; ++i) if (rec[i].at < rec[v].at) v = i;
+    return v;
+  }
+
+  void store(const Rec& r) {
+    int i = slotFor(r.kind, r.key);
+    rec[i] = r;
+  }
+
+  static void writeRec(File& f, const Rec& r) {
+    uint8_t hdr[8 + KEY_LEN];
+    hdr[0] = (uint8_t)MAGIC; hdr[1] = (uint8_t)(MAGIC >> 8);
+    hdr[2] = r.kind; hdr[3] = r.len;
+    for (int i = 0; i < 4; ++i) hdr[4 + i] = (uint8_t)(r.at >> (8 * i));
+    memcpy(hdr + 8, r.key, KEY_LEN);
+    f.write(hdr, sizeof(hdr));
+    f.write(r.data, r.len);
+    f.write(sum(r));
+  }
+
+  static bool readRec(File& f, Rec& r) {
+    uint8_t hdr[8 + KEY_LEN];
+    if (f.read(hdr, sizeof(hdr)) != (int)sizeof(hdr)) return false;
+    if ((hdr[0] | (hdr[1] << 8)) != MAGIC || hdr[3] > MAX_DATA) return false;
+    r.kind = hdr[2]; r.len = hdr[3];
+    r.at = (uint32_t)hdr[4] | ((uint32_t)hdr[5] << 8) | ((uint32_t)hdr[6] << 16) | ((uint32_t)hdr[7] << 24);
+    memcpy(r.key, hdr + 8, KEY_LEN);
+    if (f.read(r.data, r.len) != r.len) return false;
+    int s = f.read();
+    return s >= 0 && (uint8_t)s == sum(r);
+  }
+
+  void begin(const char* journal = "/cache/last.bin") {
+    path = journal;
+    count = 0;
+    if (!SD.exists("/cache")) SD.mkdir("/cache");
+    File f = SD.open(path, FILE_READ);
+    if (!f) return;
+    size_t size = f.size(), good = 0;
+    uint32_t n = 0;
+    Rec r;
+    while (readRec(f, r)) { store(r); good = f.position(); n++; }
+    f.close();
+    Serial.printf("last known: %lu records, %d keys\n", (unsigned long)n, count);
+    if (good != size) Serial.printf("last known: bad record at %u of %u, rewriting\n", (unsigned)good, (unsigned)size);
+    if (good != size || size > COMPACT_SIZE) compact();
+  }
+
+  bool get(uint8_t kind, const char* key, void* out, size_t len, uint32_t* at = nullptr) const {
+    int i = find(kind, key);
+    if (i < 0 || rec[i].len != len) return false;
+    memcpy(out, rec[i].data, len);
+    if (at) *at = rec[i].at;
+    return true;
+  }
+
+  void put(uint8_t kind, const char* key, const void* data, size_t len, uint32_t at) {
+    if (len > (size_t)MAX_DATA) return;
+    Rec r;
+    r.kind = kind; r.len = (uint8_t)len; r.at = at;
+    memset(r.key, 0, KEY_LEN);
+    strncpy(r.key, key, KEY_LEN - 1);
+    memcpy(r.data, data, len);
+    store(r);
+    File f = SD.open(path, FILE_APPEND);
+    if (!f) return;
+    writeRec(f, r);
+    size_t size = f.size();
+    f.close();
+    if (size > COMPACT_SIZE) compact();
+  }
+
+  // Rewrite the journal with one record per key
+  void compact() {
+    String tmp = String(path) + ".tmp";
+    SD.remove(tmp.c_str());
+    File f = SD.open(tmp.c_str(), FILE_WRITE);
+    if (!f) return;
+    for (int i = 0; i < count; ++i) writeRec(f, rec[i]);
+    f.close();
+    SD.remove(path);
+    SD.rename(tmp.c_str(), path);
+  }
+};
+
+// "since 14:05" today, "since Mon 14:05" otherwise
+inline void lkStaleLabel(char* buf, size_t n, uint32_t at, time_t now = time(nullptr)) {
+  time_t a = at;
+  struct tm ta, tn;
+  localtime_r(&a, &ta);
+  localtime_r(&now, &tn);
+  bool today = ta.tm_yday == tn.tm_yday && ta.tm_year == tn.tm_year;
+  strftime(buf, n, today ? "since %H:%M" : "since %a %H:%M", &ta);
+}
+
+#endif // LASTKNOWN_H
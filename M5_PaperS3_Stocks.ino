@@ -5,6 +5,20 @@
 #include <SD.h>
 #include <SPI.h>
 #include <time.h>
+#include "WiFiManager.h"
+#include "BootLog.h"
+#include "InstrumentTable.h"
+#include "WatchGrid.h"
+#include "GrayRender.h"
+#include "QuoteDecode.h"
+#include "KvCache.h"
+#include "PollPolicy.h"
+#include "WorldClock.h"
+#include "LastKnown.h"
+#include "Perf.h"
+#include "ConfigServer.h"
+#include "TouchInput.h"
+#include "DeltaOta.h"
 
 #define SD_CS 47
 #define SD_SCK 39
@@ -16,12 +30,35 @@ String apiKey = "";
 String backupApiKey = "";
 const int buttonHeight = 50;
 std::vector<String> newsHeadlines;
-std::vector<String> stocks;
+const size_t newsShown = 2;   // the detail view has room for two
+static InstrumentTable stocks;
 int selectedStock = 0;
 bool inDetailView = false;
-unsigned long lastStockRefresh = 0;
-String lastTimeStr = "";
-float cachedPrice = -1;
+static PollState stockPoll[InstrumentTable::CAP];   // per-symbol quote cadence
+static LastKnown lastKnown;                         // last good quotes, journaled on SD
+static WcTable nyTz;              // header clock, DST from the table not the libc TZ
+static int32_t shownMinute = -1;  // local minute the header was drawn for
+
+// Stock buttons: 4 columns x 5 rows per page, 250 px column pitch.
+// Buttons are label width + 60, so cellW is only the widest a button gets.
+static const GridLayout stockGrid = { 30, 60, 220, 50, 250, 70, 4, (540 - 60 - 100) / 70 };
+int stockPage = 0;
+
+// Pages are packed ahead into PSRAM (WatchGrid.h) so a flip is one push.
+// The band runs to the panel's right edge, rounded down to a multiple of 8.
+static GridPageCache stockPages;
+static const int stockBandW = (960 - stockGrid.left) / 8 * 8;
+
+// "<  2/5  >" under the grid; both arrows are buttons
+static const int pageY = stockGrid.top + stockGrid.height() + 4;
+static const int pageW = 70, pageH = 40;
+static const int pageNextX = stockGrid.left + 2 * pageW + 40;
+
+// Company names and today's headlines, cached in RAM and /cache/kv.log
+KvCache kv;
+const uint32_t profileTtl = 30 * 86400;
+const uint32_t newsTtl = 30 * 60;
+int extrasPending = -1;   // detail id whose name/news need a refresh
 
 void showMessage(const String& message) {
   M5.Display.clear();
@@ -38,53 +75,31 @@ void loadCredentialsFromSD() {
     return;
   }
 
-  std::vector<std::pair<String, String>> wifiList;
-  String apiPrimary, apiBackup;
+  std::vector<WiFiCred> wifiList;
+  String apiPrimary, apiBackup, cfgPass;
 
   while (file.available()) {
     String ssid = file.readStringUntil('\n'); ssid.trim();
-    if (!file.available()) break;
-    String pass = file.readStringUntil('\n'); pass.trim();
-
     if (ssid.startsWith("APIKEY:")) {
       apiPrimary = ssid.substring(7);
-      if (file.available()) {
-        String maybeBackup = file.readStringUntil('\n'); maybeBackup.trim();
-        if (maybeBackup.startsWith("BACKUP:")) {
-          apiBackup = maybeBackup.substring(7);
-        }
+      while (file.available()) {               // BACKUP: and CFGPASS: follow it
+        String line = file.readStringUntil('\n'); line.trim();
+        if (line.startsWith("BACKUP:"))       apiBackup = line.substring(7);
+        else if (line.startsWith("CFGPASS:")) cfgPass   = line.substring(8);
       }
       break;
     }
+    if (!file.available()) break;
+    String pass = file.readStringUntil('\n'); pass.trim();
 
     wifiList.push_back({ssid, pass});
   }
   file.close();
+  cfgAuth(cfgPass);
 
-  for (auto& creds : wifiList) {
-    showMessage("Connecting to WiFi: " + creds.first + " ...");
-    if (creds.second.length() == 0) {
-      WiFi.begin(creds.first.c_str());
-    } else {
-      WiFi.begin(creds.first.c_str(), creds.second.c_str());
-    }
-
-    int retries = 20;
-    while (WiFi.status() != WL_CONNECTED && retries-- > 0) {
-      delay(500);
-    }
-
-    if (WiFi.status() == WL_CONNECTED) {
-      showMessage("Connected to: " + creds.first);
-      delay(1000);
-      break;
-    }
-  }
-
-  if (WiFi.status() != WL_CONNECTED) {
-    showMessage("WiFi connection failed.");
-    delay(2000);
-  }
+  // Joining happens in the background; net_tick() in loop() drives it.
+  // A reload from the config page keeps an up link.
+  net_update(wifiList);
 
   apiKey = apiPrimary;
   backupApiKey = apiBackup;
@@ -92,35 +107,53 @@ void loadCredentialsFromSD() {
 
 void loadStocksFromSD() {
   stocks.clear();
+  for (PollState& p : stockPoll) pollReset(p);
   File file = SD.open("/Wifi/STOCK.txt");
   if (file) {
     while (file.available()) {
       String symbol = file.readStringUntil('\n');
       symbol.trim();
-      if (symbol.length() > 0) {
-        stocks.push_back(symbol);
+      if (symbol.length() > 0 && stocks.add(symbol.c_str()) < 0) {
+        Serial.printf("Skipping symbol: %s\n", symbol.c_str());
       }
     }
     file.close();
   }
+  for (int id = 0; id < stocks.count; ++id) {
+    Quote q; uint32_t at;
+    if (!lastKnown.get(LK_QUOTE, stocks.symbol[id], &q, sizeof(q), &at)) continue;
+    stocks.setQuote(id, q.price, q.high, q.low, q.open, q.prevClose, q.changePct, q.volume, at);
+    stocks.clean(id);
+  }
 }
 
 void fetchTime() {
   configTime(-14400, 0, "pool.ntp.org", "time.nist.gov");  // UTC-4 Eastern
 }
 
+// New York local minute counter, -1 until SNTP has set the clock
+int32_t headerMinute() {
+  time_t now = time(nullptr);
+  return now < 1700000000 ? -1 : wcLocalMinute(nyTz, (uint32_t)now);
+}
+
 String getFormattedTime() {
-  struct tm timeinfo;
-  if (!getLocalTime(&timeinfo)) return "--:--";
+  static const char* days[]   = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+  static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                  "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+  int32_t m = headerMinute();
+  if (m < 0) return "--:--";
+  WcCivil c = wcCivil(m);
   char buf[30];
-  strftime(buf, sizeof(buf), "%a %b %e %I:%M %p", &timeinfo);
+  snprintf(buf, sizeof(buf), "%s %s %2d %02d:%02d %s", days[c.wday], months[c.month - 1], c.day,
+           (c.hour + 11) % 12 + 1, c.min, c.hour < 12 ? "AM" : "PM");
   return String(buf);
 }
 
 void updateHeader() {
   int battery = M5.Power.getBatteryLevel();
   String timeStr = getFormattedTime();
-  lastTimeStr = timeStr;
+  shownMinute = headerMinute();
 
   M5.Display.fillRect(0, 0, 540, 30, WHITE);
   M5.Display.setCursor(10, 5);
@@ -130,48 +163,55 @@ void updateHeader() {
   M5.Display.print(timeStr);
 }
 
+// One stock button, label width + 60 wide, into the page cache's canvas
+// (or the display when PSRAM is short)
+void drawStockCell(LovyanGFX& g, int i, int x, int y, int w, int h) {
+  bool selected = (i == selectedStock);
+  const char* label = stocks.label[i];
+  if (!stocks.labelW[i]) stocks.labelW[i] = g.textWidth(label);
+  int textWidth = stocks.labelW[i];
+  int buttonWidth = textWidth + 60;
+  int textX = x + (buttonWidth - textWidth) / 2;
+  int textY = y + (h + g.fontHeight()) / 3 - 9;
+
+  g.fillRoundRect(x, y, buttonWidth, h, 25, selected ? BLACK : GRAY_LIGHT);
+  if (!selected) g.drawRoundRect(x, y, buttonWidth, h, 25, BLACK);   // the fill packs to white
+  g.setTextColor(selected ? WHITE : BLACK);
+  g.setCursor(textX, textY);
+  g.print(label);
+}
+
+void drawPageButton(int x, const char* label, bool enabled) {
+  M5.Display.fillRoundRect(x, pageY, pageW, pageH, 20, enabled ? BLACK : GRAY_LIGHT);
+  M5.Display.setTextColor(WHITE);
+  M5.Display.setCursor(x + (pageW - M5.Display.textWidth(label)) / 2, pageY + (pageH + M5.Display.fontHeight()) / 4 - 9);
+  M5.Display.print(label);
+}
+
+// Flip to `page`: the grid band from the cache, then the page controls
+void showStockPage(int page) {
+  int pages = stockGrid.pageCount(stocks.count);
+  if (page < 0 || page >= pages) return;
+  stockPage = page;
+  stockPages.show(stockGrid, page, stocks.count, drawStockCell);
+
+  M5.Display.fillRect(stockGrid.left, pageY, 3 * pageW + 40, pageH, WHITE);
+  if (pages > 1) {
+    drawPageButton(stockGrid.left, "<", page > 0);
+    drawPageButton(pageNextX, ">", page + 1 < pages);
+    M5.Display.setTextColor(BLACK);
+    M5.Display.setCursor(stockGrid.left + pageW + 28, pageY + 10);
+    M5.Display.printf("%d/%d", page + 1, pages);
+  }
+  stockPages.prefetch(stockGrid, page, stocks.count, drawStockCell);
+}
+
 void drawMenu() {
+  PERF_SCOPE("drawMenu", PERF_RENDER);
   inDetailView = false;
   M5.Display.clear();
   updateHeader();
-
-  int buttonHeight = 50;
-  int rowSpacing = 20;
-  int colSpacing = 30;
-  int topMargin = 60;
-  int leftMargin = 30;
-  int screenHeight = 540;
-  int screenWidth = 960;
-  int usableHeight = screenHeight - topMargin - 100;  
-
-  int maxRows = usableHeight / (buttonHeight + rowSpacing);
-  int col = 0;
-  int row = 0;
-
-  for (size_t i = 0; i < stocks.size(); ++i) {
-    if (row >= maxRows) {
-      row = 0;
-      col++;
-    }
-
-    int y = topMargin + row * (buttonHeight + rowSpacing);
-    int x = leftMargin + col * 250;  
-
-    bool selected = (i == selectedStock);
-    String label = stocks[i];
-    int textWidth = M5.Display.textWidth(label);
-    int buttonWidth = textWidth + 60;
-    int textHeight = M5.Display.fontHeight();
-    int textX = x + (buttonWidth - textWidth) / 2;
-    int textY = y + (buttonHeight + textHeight) / 3 - 9;
-
-    M5.Display.fillRoundRect(x, y, buttonWidth, buttonHeight, 25, selected ? BLACK : LIGHTGREY);
-    M5.Display.setTextColor(selected ? WHITE : BLACK);
-    M5.Display.setCursor(textX, textY);
-    M5.Display.print(label);
-
-    row++;
-  }
+  showStockPage(stockPage);   // swipe or tap the arrows for the others
 
   M5.Display.setTextColor(BLACK);
   M5.Display.setCursor(10, 500);  
@@ -180,40 +220,26 @@ void drawMenu() {
 
 void fetchStockDetail(const String& symbol, float& price, float& high, float& low,
                       float& open, float& prevClose, float& change, float& volume) {
-  HTTPClient http;
+  Quote q{};
   String url = "https://finnhub.io/api/v1/quote?symbol=" + symbol + "&token=" + apiKey;
-  http.begin(url);
-  int httpCode = http.GET();
+  int httpCode = decodeFinnhubQuote(url, q);
 
   if (httpCode != 200 && backupApiKey.length() > 0) {
-    http.end();
     url = "https://finnhub.io/api/v1/quote?symbol=" + symbol + "&token=" + backupApiKey;
-    http.begin(url);
-    httpCode = http.GET();
-  }
-
-  if (httpCode == 200) {
-    String payload = http.getString();
-    DynamicJsonDocument doc(1024);
-    deserializeJson(doc, payload);
-    price = doc["c"];
-    high = doc["h"];
-    low = doc["l"];
-    open = doc["o"];
-    prevClose = doc["pc"];
-    volume = doc["v"];
-    if (prevClose != 0) change = ((price - prevClose) / prevClose) * 100.0;
-  } else {
-    price = high = low = open = prevClose = change = volume = 0;
+    q = Quote{};
+    httpCode = decodeFinnhubQuote(url, q);
   }
 
-  http.end();
+  price = q.price;
+  high = q.high;
+  low = q.low;
+  open = q.open;
+  prevClose = q.prevClose;
+  change = q.changePct;
+  volume = q.volume;
 }
 
-void fetchNewsHeadlines(const String& symbol) {
-  newsHeadlines.clear();
-
-  HTTPClient http;
+bool fetchNewsHeadlines(const String& symbol) {
   time_t now = time(nullptr);
   struct tm* t = localtime(&now);
   char dateBuf[11];
@@ -221,81 +247,62 @@ void fetchNewsHeadlines(const String& symbol) {
 
   String today = String(dateBuf);
   String url = "https://finnhub.io/api/v1/company-news?symbol=" + symbol + "&from=" + today + "&to=" + today + "&token=" + apiKey;
-  http.begin(url);
-  int httpCode = http.GET();
+  int httpCode = decodeFinnhubHeadlines(url, newsHeadlines, newsShown);
 
   if (httpCode != 200 && backupApiKey.length() > 0) {
-    http.end();
     url = "https://finnhub.io/api/v1/company-news?symbol=" + symbol + "&from=" + today + "&to=" + today + "&token=" + backupApiKey;
-    http.begin(url);
-    httpCode = http.GET();
+    httpCode = decodeFinnhubHeadlines(url, newsHeadlines, newsShown);
   }
-
-  if (httpCode == 200) {
-    String payload = http.getString();
-    DynamicJsonDocument doc(8192);
-    deserializeJson(doc, payload);
-
-    int count = 0;
-    for (JsonObject article : doc.as<JsonArray>()) {
-      if (article.containsKey("headline") && count < 5) {
-        newsHeadlines.push_back(article["headline"].as<String>());
-        count++;
-      }
-    }
-  }
-
-  http.end();
+  return httpCode == 200;
 }
 String fetchCompanyName(const String& symbol) {
-  HTTPClient http;
+  String name = symbol;  // fallback to symbol
   String url = "https://finnhub.io/api/v1/stock/profile2?symbol=" + symbol + "&token=" + apiKey;
-  http.begin(url);
-  int httpCode = http.GET();
+  int httpCode = decodeFinnhubName(url, name);
 
   if (httpCode != 200 && backupApiKey.length() > 0) {
-    http.end();
     url = "https://finnhub.io/api/v1/stock/profile2?symbol=" + symbol + "&token=" + backupApiKey;
-    http.begin(url);
-    httpCode = http.GET();
+    decodeFinnhubName(url, name);
   }
-
-  String name = symbol;  // fallback to symbol
-  if (httpCode == 200) {
-    String payload = http.getString();
-    DynamicJsonDocument doc(2048);
-    deserializeJson(doc, payload);
-    if (doc.containsKey("name") && doc["name"].as<String>() != "") {
-      name = doc["name"].as<String>();
-    }
-  }
-
-  http.end();
   return name;
 }
 
-void drawDetail(const String &symbol) {
-  inDetailView = true;
-  M5.Display.clear();
-  updateHeader();
+String newsKey(const String& symbol) {
+  time_t now = time(nullptr);
+  char day[11];
+  strftime(day, sizeof(day), "%Y-%m-%d", localtime(&now));
+  return "N:" + symbol + ":" + day;
+}
+
+bool cachedCompanyName(const String& symbol, String& name) {
+  KvResult r = kv.get(("P:" + symbol).c_str(), name, (uint32_t)time(nullptr));
+  if (r == KV_MISS) name = symbol;
+  return r == KV_FRESH;
+}
 
-  float price, high, low, open, prevClose, change, volume;
-  fetchStockDetail(symbol, price, high, low, open, prevClose, change, volume);
-  cachedPrice = price;
+// Headlines are stored joined with \x1e
+bool cachedNews(const String& symbol) {
+  String joined;
+  KvResult r = kv.get(newsKey(symbol).c_str(), joined, (uint32_t)time(nullptr));
+  newsHeadlines.clear();
+  int start = 0;
+  while (r != KV_MISS && start < (int)joined.length()) {
+    int sep = joined.indexOf('\x1e', start);
+    if (sep < 0) sep = joined.length();
+    newsHeadlines.push_back(joined.substring(start, sep));
+    start = sep + 1;
+  }
+  return r == KV_FRESH;
+}
 
+void drawCompanyName(const String& name, const String& symbol) {
+  M5.Display.fillRect(30, 50, 350, 24, WHITE);
   M5.Display.setTextColor(BLACK);
   M5.Display.setCursor(30, 50);
-  String companyName = fetchCompanyName(symbol);
-M5.Display.printf("%s (%s)", companyName.c_str(), symbol.c_str());
-
-  M5.Display.setCursor(30, 100); M5.Display.printf("Price       : $%.2f", price);
-  M5.Display.setCursor(30, 130); M5.Display.printf("High        : $%.2f", high);
-  M5.Display.setCursor(30, 160); M5.Display.printf("Low         : $%.2f", low);
-  M5.Display.setCursor(30, 190); M5.Display.printf("Open        : $%.2f", open);
-  M5.Display.setCursor(30, 220); M5.Display.printf("Prev Close  : $%.2f", prevClose);
-  M5.Display.setCursor(30, 250); M5.Display.printf("Change %%    : %.2f%%", change);
-  M5.Display.setCursor(30, 280); M5.Display.printf("Volume      : %.0f", volume);
+  M5.Display.printf("%s (%s)", name.c_str(), symbol.c_str());
+}
 
+void drawNews() {
   int newsX = 390;
   int newsY = 50;
   int newsWidth = 960 - newsX - 10;
@@ -337,6 +344,106 @@ M5.Display.printf("%s (%s)", companyName.c_str(), symbol.c_str());
 
     cursorY += 15;
   }
+}
+
+// Fetch whatever drawDetail() found missing or stale, then redraw it
+void serviceExtras() {
+  if (extrasPending < 0) return;
+  int id = extrasPending;
+  extrasPending = -1;
+  if (!inDetailView || id != selectedStock || !net_isUp()) return;
+
+  String symbol = stocks.symbol[id];
+  uint32_t now = (uint32_t)time(nullptr);
+
+  String name = fetchCompanyName(symbol);
+  if (name != symbol) {
+    kv.put(("P:" + symbol).c_str(), name, profileTtl, now);
+    drawCompanyName(name, symbol);
+  }
+
+  if (fetchNewsHeadlines(symbol)) {
+    String joined;
+    for (size_t i = 0; i < newsHeadlines.size(); ++i) {
+      if (i) joined += '\x1e';
+      joined += newsHeadlines[i];
+    }
+    kv.put(newsKey(symbol).c_str(), joined, newsTtl, now);
+    M5.Display.fillRect(390, 50, 570, 370, WHITE);
+    drawNews();
+  }
+  kv.logStats();
+}
+
+// The clock runs on fixed UTC-4, so the session comes from UTC instead
+void pollObserveStock(int id, float price) {
+  time_t now = time(nullptr);
+  struct tm et;
+  nyseLocalTime(now, et);
+  MarketSession sess = nyseSession(et);
+  PollState& st = stockPoll[id];
+  pollObserve(st, price, (uint32_t)now, false, sess, nyseSecondsToChange(et));
+  Serial.printf("poll %s: %s, next in %lus (%u unchanged), saved %ld\n", stocks.symbol[id],
+                sessionName(sess), (unsigned long)st.interval, st.unchanged,
+                (long)pollSaved(st, (uint32_t)now));
+}
+
+// Full quote into the table and the SD journal
+void storeQuote(int id, const Quote& q) {
+  uint32_t now = (uint32_t)time(nullptr);
+  stocks.setQuote(id, q.price, q.high, q.low, q.open, q.prevClose, q.changePct, q.volume, now);
+  if (stocks.dirty[id]) lastKnown.put(LK_QUOTE, stocks.symbol[id], &q, sizeof(q), now);
+  stocks.clean(id);
+}
+
+// "[stale since 14:05]" under the quote while it is not from this fetch
+bool staleShown = false;
+
+void drawStaleBadge(int id, bool stale) {
+  if (!stale && !staleShown) return;
+  staleShown = stale;
+  M5.Display.fillRect(30, 310, 340, 24, WHITE);
+  if (!stale || !stocks.updated[id]) return;
+  char since[24];
+  lkStaleLabel(since, sizeof(since), stocks.updated[id]);
+  M5.Display.setTextColor(BLACK);
+  M5.Display.setCursor(30, 310);
+  M5.Display.printf("[stale %s]", since);
+}
+
+void drawDetail(int id) {
+  PERF_SCOPE("drawDetail", PERF_RENDER);
+  inDetailView = true;
+  M5.Display.clear();
+  staleShown = false;
+  updateHeader();
+
+  // Fresh quote when we can get one, otherwise the last known
+  String symbol = stocks.symbol[id];
+  Quote q{};
+  if (net_isUp()) fetchStockDetail(symbol, q.price, q.high, q.low, q.open, q.prevClose, q.changePct, q.volume);
+  bool fresh = q.price != 0.0f;
+  if (fresh) storeQuote(id, q);
+  float price = stocks.price[id], high = stocks.high[id], low = stocks.low[id], open = stocks.open[id];
+  float prevClose = stocks.prevClose[id], change = stocks.change[id], volume = stocks.volume[id];
+
+  // Name and news from the cache; loop() refreshes whatever is stale
+  String companyName;
+  bool extrasFresh = cachedCompanyName(symbol, companyName);
+  extrasFresh = cachedNews(symbol) && extrasFresh;
+  if (!extrasFresh) extrasPending = id;
+  drawCompanyName(companyName, symbol);
+
+  M5.Display.setCursor(30, 100); M5.Display.printf("Price       : $%.2f", price);
+  M5.Display.setCursor(30, 130); M5.Display.printf("High        : $%.2f", high);
+  M5.Display.setCursor(30, 160); M5.Display.printf("Low         : $%.2f", low);
+  M5.Display.setCursor(30, 190); M5.Display.printf("Open        : $%.2f", open);
+  M5.Display.setCursor(30, 220); M5.Display.printf("Prev Close  : $%.2f", prevClose);
+  M5.Display.setCursor(30, 250); M5.Display.printf("Change %%    : %.2f%%", change);
+  M5.Display.setCursor(30, 280); M5.Display.printf("Volume      : %.0f", volume);
+  drawStaleBadge(id, !fresh);
+
+  drawNews();
 
   // Return button
   String label = "Return";
@@ -353,15 +460,25 @@ M5.Display.printf("%s (%s)", companyName.c_str(), symbol.c_str());
   M5.Display.setCursor(textX, textY);
   M5.Display.print(label);
 
-  lastStockRefresh = millis();
+  if (fresh) pollObserveStock(id, price);
+  else stockPoll[id].nextAt = (uint32_t)time(nullptr) + POLL_FIXED_S;
 }
 
-void updateStockPriceIfNeeded(const String& symbol) {
-  float price, dummy1, dummy2, dummy3, dummy4, dummy5, dummy6;
-  fetchStockDetail(symbol, price, dummy1, dummy2, dummy3, dummy4, dummy5, dummy6);
+void updateStockPriceIfNeeded(int id) {
+  Quote q{};
+  if (net_isUp()) fetchStockDetail(stocks.symbol[id], q.price, q.high, q.low, q.open, q.prevClose, q.changePct, q.volume);
+  if (q.price == 0.0f) {               // fetch failed: badge it, retry at the old fixed rate
+    stockPoll[id].nextAt = (uint32_t)time(nullptr) + POLL_FIXED_S;
+    drawStaleBadge(id, true);
+    return;
+  }
+  float price = q.price;
+  pollObserveStock(id, price);
+  drawStaleBadge(id, false);
 
-  if (price != cachedPrice) {
-    cachedPrice = price;
+  bool moved = price != stocks.price[id];
+  storeQuote(id, q);
+  if (moved) {
     M5.Display.fillRect(30, 100, 300, 20, WHITE);
     M5.Display.setCursor(30, 100);
     M5.Display.setTextColor(BLACK);
@@ -369,12 +486,19 @@ void updateStockPriceIfNeeded(const String& symbol) {
   }
 }
 
+// One gesture per call. Events made before the last screen change are
+// dropped, so a tap cannot land on the screen that replaced its own.
 void handleTouch() {
-  auto detail = M5.Touch.getDetail();
-  int x = detail.x;
-  int y = detail.y;
+  static uint32_t screenMs = 0;
+  TouchEvent e;
+  do {
+    if (!touchPoll(e)) return;
+  } while (e.ms < screenMs || (e.type != TOUCH_SWIPE && !touchIsTap(e)));
+  int x = e.x;
+  int y = e.y;
 
   if (inDetailView) {
+    if (!touchIsTap(e)) return;
     String label = "Return";
     int textWidth = M5.Display.textWidth(label);
     int buttonWidth = textWidth + 60;
@@ -383,48 +507,59 @@ void handleTouch() {
 
     if (x >= buttonX && x <= buttonX + buttonWidth &&
         y >= buttonY && y <= buttonY + buttonHeight) {
-      delay(300);  
+      screenMs = millis();
       drawMenu();
       return;
     }
   } else {
-    // --- MULTI-COLUMN BUTTON SUPPORT ---
-    int rowSpacing = 20;
-    int colSpacing = 30;
-    int topMargin = 60;
-    int leftMargin = 30;
-    int maxRows = (540 - topMargin - 100) / (buttonHeight + rowSpacing);
-    int col = 0;
-    int row = 0;
-
-    for (size_t i = 0; i < stocks.size(); ++i) {
-      if (row >= maxRows) {
-        row = 0;
-        col++;
-      }
-
-      int btnX = leftMargin + col * 250;
-      int btnY = topMargin + row * (buttonHeight + rowSpacing);
-      String label = stocks[i];
-      int textWidth = M5.Display.textWidth(label);
-      int buttonWidth = textWidth + 60;
-
-      if (x >= btnX && x <= btnX + buttonWidth &&
-          y >= btnY && y <= btnY + buttonHeight) {
-        selectedStock = i;
-        fetchNewsHeadlines(stocks[selectedStock]);
-        delay(300);  // debounce
-        drawDetail(stocks[selectedStock]);
-        return;
+    // Swipe or the arrows flip pages; only the grid band and arrows repaint
+    int page = stockPage;
+    if (e.type == TOUCH_SWIPE) page += e.dx <= -60 ? 1 : e.dx >= 60 ? -1 : 0;
+    else if (y >= pageY && y <= pageY + pageH) {
+      if (x >= stockGrid.left && x <= stockGrid.left + pageW) page--;
+      else if (x >= pageNextX && x <= pageNextX + pageW) page++;
+    }
+    if (page != stockPage) {
+      if (page >= 0 && page < stockGrid.pageCount(stocks.count)) {
+        screenMs = millis();
+        showStockPage(page);
       }
-      row++;
+      return;
     }
+    if (e.type == TOUCH_SWIPE) return;
+
+    int i = stockGrid.hitIndex(x, y, stockPage, stocks.count);
+    if (i < 0) return;
+    int col0 = stockGrid.left + ((i % stockGrid.perPage()) / stockGrid.rows) * stockGrid.pitchX;
+    if (x > col0 + stocks.labelW[i] + 60) return;   // right of a short button
+
+    selectedStock = i;
+    stockPages.invalidate();          // the highlight moved
+    screenMs = millis();
+    drawDetail(selectedStock);
   }
 }
 
+// Watchlist edited on the config page (ConfigServer.h): keep the selection
+// if the symbol survived, and repaint
+void onWatchlistSaved() {
+  char sel[InstrumentTable::SYM_LEN] = "";
+  if (selectedStock < stocks.count) strcpy(sel, stocks.symbol[selectedStock]);
+  loadStocksFromSD();
+  int id = stocks.find(sel);
+  selectedStock = id >= 0 ? id : 0;
+  stockPage = stockGrid.pageOf(selectedStock);
+  stockPages.invalidate();
+  drawMenu();
+}
+
 void setup() {
+  Serial.begin(115200);
+  bootMark("reset");
+
   auto cfg = M5.config();
   M5.begin(cfg);
+  touchBegin();
   M5.Display.setRotation(1);
   M5.Display.setTextSize(1);
   M5.Display.setFont(&fonts::FreeMonoBold12pt7b);
@@ -438,26 +573,47 @@ void setup() {
     delay(3000);
     return;
   }
+  bootMark("sd mounted");
+  if (otaFromSd("/update/stocks.dlt")) ESP.restart();   // a firmware patch left on the card
+  kv.begin();
+  lastKnown.begin();
 
-  loadCredentialsFromSD();  // Load Wi-Fi + API keys
+  loadCredentialsFromSD();  // Load Wi-Fi + API keys, start joining
   loadStocksFromSD();       // Load stock list
-  fetchTime();
+  cfgServe("/Wifi/STOCK.txt", "Watchlist", onWatchlistSaved);
+  cfgServe("/Wifi/WIFI.txt",  "WiFi and API keys", loadCredentialsFromSD, cfgSecretsWifiTxt);
+  cfgServeUpdate(otaFromUrl);
+  fetchTime();              // SNTP syncs in the background
+  wcBuild(*wcFind("America/New_York"), nyTz);
+  bootMark("config + wifi/sntp started");
+  stockPages.begin(stockBandW, stockGrid.height());   // false: pages draw straight to the panel
   drawMenu();
+  bootMark("first frame");
 }
 
 void loop() {
-  M5.update();
+  PerfScope tick("loop", PERF_TICK);   // CPU time per pass; 's' on serial prints it
+  net_tick();
+  if (net_justConnected()) {
+    static bool onlineOnce = false;
+    if (!onlineOnce) { bootMark("network up"); bootSummary(); onlineOnce = true; }
+    cfgBegin();
+  }
+
   handleTouch();
+  cfgTick();
+  serviceExtras();
+
+  if (headerMinute() != shownMinute) updateHeader();
 
-  String currentTimeStr = getFormattedTime();
-  if (currentTimeStr != lastTimeStr) {
-    updateHeader();
+  if (inDetailView && (uint32_t)time(nullptr) >= stockPoll[selectedStock].nextAt) {
+    updateStockPriceIfNeeded(selectedStock);
   }
 
-  if (inDetailView && millis() - lastStockRefresh > 30000) {
-    updateStockPriceIfNeeded(stocks[selectedStock]);
-    lastStockRefresh = millis();
+  if (perfPoll()) {                    // stats overlay closed: repaint what was under it
+    if (inDetailView) drawDetail(selectedStock); else drawMenu();
   }
+  tick.end();                          // excluding the delay
 
   delay(100);
 }
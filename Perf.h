@@ -0,0 +1,254 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+// ---------- Performance counters ----------
+// Scoped timers and plain counters. Everything lives in fixed tables, with
+// no heap. Each name gets running stats (count, total, max, last). Spans of
+// PERF_TRACE_MIN_US or longer also go into a ring that can be dumped as
+// Chrome trace JSON; load it in chrome://tracing or ui.perfetto.dev. Names
+// must be string literals (only the pointer is kept). Outside ARDUINO the
+// clock is std::chrono and output goes to stdout, so host builds work too.
+//
+//   { PERF_SCOPE("ics parse", PERF_PARSE); parseAndAddEvents(body, 160); }
+//   perfCount("quote fetch");
+//   perfMem();                       // heap / PSRAM low-water marks (device)
+//
+// Serial commands, via perfPoll() in loop():
+//   o  toggle the on-screen stats overlay   s  print the stats
+//   t  dump the trace ring                  r  reset
+
+#ifdef ARDUINO
+#include <Arduino.h>
+inline uint32_t perfNowUs() { return micros(); }
+#else
+#include <chrono>
+inline uint32_t perfNowUs() {
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+inline void perfOut(const char* fmt, ...) {
+  char buf[192];
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+#ifdef ARDUINO
+  Serial.print(buf);
+#else
+  fputs(buf, stdout);
+#endif
+}
+
+enum PerfCat : uint8_t { PERF_BOOT, PERF_NET, PERF_PARSE, PERF_RENDER, PERF_FLUSH, PERF_TICK, PERF_COUNT, PERF_CATS };
+
+inline const char* perfCatName(uint8_t c) {
+  static const char* names[PERF_CATS] = { "boot", "net", "parse", "render", "flush", "tick", "count" };
+  return c < PERF_CATS ? names[c] : "?";
+}
+
+static const uint32_t PERF_TRACE_MIN_US = 1000;    // shorter spans only update the stats
+static const uint32_t PERF_INSTANT      = 0xFFFFFFFF;
+
+struct PerfEvent { const char* name; uint32_t ts, dur; uint8_t cat; };
+
+struct PerfStat {
+  const char* name;
+  uint8_t     cat;
+  uint32_t    n;
+  uint64_t    totalUs;
+  uint32_t    maxUs, lastUs;
+};
+
+struct PerfLog {
+  static const int RING  = 128;
+  static const int STATS = 32;
+
+  PerfEvent ring[RING];
+  uint32_t  written = 0;               // events ever recorded; ring holds the last RING
+  PerfStat  stat[STATS];
+  int       nstat = 0;
+  uint32_t  heapFree = 0, heapMin = 0, psramFree = 0, psramMin = 0;
+  bool      overlay = false;
+
+  void reset() { written = 0; nstat = 0; heapMin = heapFree; psramMin = psramFree; }
+
+  PerfStat* statFor(const char* name, uint8_t cat) {
+    for (int i = 0; i < nstat; ++i)
+      if (stat[i].name == name || !strcmp(stat[i].name, name)) return &stat[i];
+    if (nstat >= STATS) return nullptr;
+    PerfStat& s = stat[nstat++];
+    s.name = name; s.cat = cat; s.n = 0; s.totalUs = 0; s.maxUs = 0; s.lastUs = 0;
+    return &s;
+  }
+
+  void trace(const char* name, uint8_t cat, uint32_t ts, uint32_t dur) {
+    ring[written % RING] = { name, ts, dur, cat };
+    written++;
+  }
+
+  void span(const char* name, uint8_t cat, uint32_t ts, uint32_t dur) {
+    if (PerfStat* s = statFor(name, cat)) {
+      s->n++; s->totalUs += dur; s->lastUs = dur;
+      if (dur > s->maxUs) s->maxUs = dur;
+    }
+    if (dur >= PERF_TRACE_MIN_US) trace(name, cat, ts, dur);
+  }
+
+  void count(const char* name, uint32_t d) {
+    if (PerfStat* s = statFor(name, PERF_COUNT)) { s->n += d; s->lastUs = d; }
+  }
+
+  void mem(uint32_t heap, uint32_t heapLow, uint32_t psram, uint32_t psramLow) {
+    heapFree = heap; psramFree = psram;
+    if (!heapMin  || heapLow  < heapMin)  heapMin  = heapLow;
+    if (!psramMin || psramLow < psramMin) psramMin = psramLow;
+  }
+
+  // One stats line for the overlay / serial: name, calls, avg, max, last
+  void format(int i, char* buf, size_t n) const {
+    const PerfStat& s = stat[i];
+    if (s.cat == PERF_COUNT)
+      snprintf(buf, n, "%-14.14s %6lu", s.name, (unsigned long)s.n);
+    else
+      snprintf(buf, n, "%-14.14s %6lu %7.1f %7.1f %7.1f", s.name, (unsigned long)s.n,
+               s.n ? s.totalUs / 1000.0 / s.n : 0.0, s.maxUs / 1000.0, s.lastUs / 1000.0);
+  }
+
+  void printStats() const {
+    perfOut("---- perf (ms) ----\n%-14s %6s %7s %7s %7s\n", "name", "n", "avg", "max", "last");
+    char line[64];
+    for (int i = 0; i < nstat; ++i) { format(i, line, sizeof(line)); perfOut("%s\n", line); }
+    perfOut("heap %lu KB free, low %lu KB; psram %lu KB free, low %lu KB\n",
+            (unsigned long)heapFree / 1024, (unsigned long)heapMin / 1024,
+            (unsigned long)psramFree / 1024, (unsigned long)psramMin / 1024);
+  }
+
+  // Chrome trace-event JSON between marker lines, oldest event first
+  void dumpTrace() const {
+    uint32_t n = written < (uint32_t)RING ? written : (uint32_t)RING;
+    perfOut("---- trace begin ----\n{\"traceEvents\":[\n");
+    for (uint32_t k = 0; k < n; ++k) {
+      const PerfEvent& e = ring[(written - n + k) % RING];
+      if (e.dur == PERF_INSTANT)
+        perfOut("{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%lu,\"pid\":1,\"tid\":1},\n",
+                e.name, perfCatName(e.cat), (unsigned long)e.ts);
+      else
+        perfOut("{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":1,\"tid\":1},\n",
+                e.name, perfCatName(e.cat), (unsigned long)e.ts, (unsigned long)e.dur);
+    }
+    perfOut("{\"name\":\"memory\",\"ph\":\"C\",\"ts\":%lu,\"pid\":1,\"args\":{\"heapLowKB\":%lu,\"psramLowKB\":%lu}}\n",
+            (unsigned long)perfNowUs(), (unsigned long)heapMin / 1024, (unsigned long)psramMin / 1024);
+    perfOut("]}\n---- trace end ----\n");
+  }
+};
+
+// One log per program, shared by every translation unit
+inline PerfLog& perfLog() { static PerfLog log; return log; }
+
+inline void perfCount(const char* name, uint32_t d = 1) { perfLog().count(name, d); }
+inline void perfInstant(const char* name, uint8_t cat = PERF_BOOT) { perfLog().trace(name, cat, perfNowUs(), PERF_INSTANT); }
+
+struct PerfScope {
+  const char* name;
+  uint8_t     cat;
+  uint32_t    t0;
+  bool        open = true;
+
+  PerfScope(const char* n, uint8_t c) : name(n), cat(c), t0(perfNowUs()) {}
+  ~PerfScope() { end(); }
+
+  // Stop early (e.g. before a delay at the end of loop())
+  void end() {
+    if (!open) return;
+    open = false;
+    perfLog().span(name, cat, t0, perfNowUs() - t0);
+  }
+};
+
+#define PERF_JOIN2(a, b) a##b
+#define PERF_JOIN(a, b)  PERF_JOIN2(a, b)
+#define PERF_SCOPE(name, cat) PerfScope PERF_JOIN(perfScope_, __LINE__)(name, cat)
+
+#ifdef ARDUINO
+#include <M5Unified.h>
+
+inline void perfMem() {
+  perfLog().mem(ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getFreePsram(), ESP.getMinFreePsram());
+}
+
+// ---------- Overlay ----------
+// Stats box in the bottom-right corner, drawn through a 1-bit canvas so the
+// sketch's font and colours are left alone, and flushed in the fastest mode.
+static const int PERF_OV_W = 480, PERF_OV_LINES = 12, PERF_OV_LINE_H = 18;
+static const int PERF_OV_H = PERF_OV_LINES * PERF_OV_LINE_H + 8;
+
+inline void perfOverlayDraw() {
+  static M5Canvas* c = nullptr;
+  if (!c) {
+    c = new M5Canvas(&M5.Display);
+    c->setColorDepth(1);
+    if (!c->createSprite(PERF_OV_W, PERF_OV_H)) { delete c; c = nullptr; return; }
+  }
+  PerfLog& p = perfLog();
+  c->fillScreen(WHITE);
+  c->drawRect(0, 0, PERF_OV_W, PERF_OV_H, BLACK);
+  c->setFont(&fonts::Font0);
+  c->setTextSize(2);
+  c->setTextColor(BLACK);
+  c->setCursor(6, 4);
+  c->printf("heap %luK/%luK psram %luK", (unsigned long)p.heapFree / 1024,
+            (unsigned long)p.heapMin / 1024, (unsigned long)p.psramMin / 1024);
+  char line[64];
+  for (int i = 0; i < p.nstat && i < PERF_OV_LINES - 1; ++i) {
+    p.format(i, line, sizeof(line));
+    line[38] = 0;                                  // name, n, avg, max fit the box
+    c->setCursor(6, 4 + (i + 1) * PERF_OV_LINE_H);
+    c->print(line);
+  }
+  int x = M5.Display.width() - PERF_OV_W, y = M5.Display.height() - PERF_OV_H;
+  auto prevMode = M5.Display.getEpdMode();
+  M5.Display.setEpdMode(m5gfx::epd_mode_t::epd_fastest);
+  c->pushSprite(x, y);
+  M5.Display.display(x, y, PERF_OV_W, PERF_OV_H);
+  M5.Display.setEpdMode(prevMode);
+}
+
+// Call once per loop(): samples memory once a second, redraws the overlay
+// every 5 s while it is on, and handles the serial commands. Returns true
+// when the overlay was just switched off and the view under it needs a
+// redraw.
+inline bool perfPoll() {
+  static uint32_t memMs = 0, overlayMs = 0;
+  PerfLog& p = perfLog();
+  uint32_t now = millis();
+  if (now - memMs >= 1000) { memMs = now; perfMem(); }
+
+  bool closed = false;
+  while (Serial.available()) {
+    switch (Serial.read()) {
+      case 'o':
+        p.overlay = !p.overlay;
+        overlayMs = 0;
+        closed = !p.overlay;
+        break;
+      case 's': p.printStats(); break;
+      case 't': p.dumpTrace(); break;
+      case 'r': p.reset(); perfOut("perf: reset\n"); break;
+    }
+  }
+  if (p.overlay && (!overlayMs || now - overlayMs >= 5000)) {
+    overlayMs = now;
+    perfOverlayDraw();
+  }
+  return closed;
+}
+#endif // ARDUINO
+
+#endif // PERF_H
@@ -0,0 +1,104 @@
+#ifndef SLEEPSCHEDULER_H
+#define SLEEPSCHEDULER_H
+
+#include <Arduino.h>
+#include <time.h>
+#include <sys/time.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+
+// ---------- Wake scheduler ----------
+// The calendar only changes on three clocks: the header minute, the weather
+// period and local midnight. planNextWake() picks the earliest of those and
+// sleepUntil() parks the chip until then (or until the panel is touched).
+//
+// Light sleep keeps RAM and wakes on the GT911 INT line as well as the timer.
+// Deep sleep wakes on the timer only: on the S3 the touch INT pin (G48) is not
+// an RTC GPIO, so it cannot bring the chip out of deep sleep.
+
+#ifndef TOUCH_INT_PIN
+#define TOUCH_INT_PIN 48   // PaperS3 GT911 INT
+#endif
+
+static const time_t VALID_EPOCH = 1700000000;   // anything earlier = clock not set yet
+
+enum WakeReason : uint8_t { WAKE_MINUTE, WAKE_WEATHER, WAKE_MIDNIGHT };
+enum SleepKind  : uint8_t { SLEEP_LIGHT, SLEEP_DEEP };
+
+struct WakePlan { time_t at; WakeReason why; };
+
+inline time_t nextMinuteEpoch(time_t now) { return (now / 60 + 1) * 60; }
+
+inline time_t nextMidnightEpoch(time_t now) {
+  struct tm lt; localtime_r(&now, &lt);
+  lt.tm_mday += 1; lt.tm_hour = 0; lt.tm_min = 0; lt.tm_sec = 0; lt.tm_isdst = -1;
+  return mktime(&lt);
+}
+
+// Earliest of the three redraw deadlines. Ties go to the bigger job.
+inline WakePlan planNextWake(time_t now, time_t lastWxEpoch, time_t wxPeriodS) {
+  WakePlan p{ nextMinuteEpoch(now), WAKE_MINUTE };
+  time_t wx = lastWxEpoch + wxPeriodS;
+  if (wx < now) wx = now;
+  if (wx <= p.at) p = { wx, WAKE_WEATHER };
+  time_t mid = nextMidnightEpoch(now);
+  if (mid <= p.at) p = { mid, WAKE_MIDNIGHT };
+  return p;
+}
+
+// "23-6" style window, wraps past midnight. from == to means never.
+inline bool hourInWindow(int hour, int from, int to) {
+  if (from == to) return false;
+  return (from < to) ? (hour >= from && hour < to) : (hour >= from || hour < to);
+}
+
+// ---------- Awake-time accounting (survives deep sleep) ----------
+struct AwakeStats {
+  int32_t  hourKey;    // epoch / 3600 of the bucket being filled
+  uint32_t awakeMs;
+  uint16_t wakes;
+};
+static RTC_DATA_ATTR AwakeStats g_awake = { -1, 0, 0 };
+
+inline void awakeAccount(time_t now, uint32_t awakeMs) {
+  int32_t key = (int32_t)(now / 3600);
+  if (g_awake.hourKey != key) {
+    if (g_awake.hourKey >= 0) {
+      time_t bucket = (time_t)g_awake.hourKey * 3600;
+      struct tm lt; localtime_r(&bucket, &lt);
+      Serial.printf("power: %02d:00 hour awake %lu.%03lus over %u wakes (%.2f%%)\n",
+                    lt.tm_hour, (unsigned long)(g_awake.awakeMs / 1000),
+                    (unsigned long)(g_awake.awakeMs % 1000), g_awake.wakes,
+                    g_awake.awakeMs / 36000.0f);
+    }
+    g_awake = { key, 0, 0 };
+  }
+  g_awake.awakeMs += awakeMs;
+  g_awake.wakes++;
+}
+
+// Sleep until wall-clock second `at` (+ a little slack so the minute has
+// actually rolled over when we read the clock). Returns after light sleep;
+// deep sleep never returns.
+inline void sleepUntil(time_t at, SleepKind kind) {
+  struct timeval tv; gettimeofday(&tv, nullptr);
+  int64_t us = ((int64_t)at - tv.tv_sec) * 1000000LL - tv.tv_usec + 200000LL;
+  if (us < 100000LL) us = 100000LL;
+
+  Serial.printf("sleep: %s for %ld ms\n", kind == SLEEP_DEEP ? "deep" : "light", (long)(us / 1000));
+  Serial.flush();
+
+  esp_sleep_enable_timer_wakeup((uint64_t)us);
+  if (kind == SLEEP_DEEP) {
+    esp_deep_sleep_start();
+  }
+  gpio_wakeup_enable((gpio_num_t)TOUCH_INT_PIN, GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  esp_light_sleep_start();
+  gpio_wakeup_disable((gpio_num_t)TOUCH_INT_PIN);
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+}
+
+inline bool wokeByTouch() { return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO; }
+
+#endif // SLEEPSCHEDULER_H
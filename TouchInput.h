@@ -0,0 +1,213 @@
+#ifndef TOUCHINPUT_H
+#define TOUCHINPUT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+
+// ---------- Touch events ----------
+// The panel is sampled at a fixed rate by its own task, not from loop(). So
+// a press is seen even while loop() is stuck in a fetch or a panel flush.
+// Each sample goes through a small gesture recognizer. Its events go into
+// a lock-free ring (one producer, one consumer), stamped with the time of
+// the sample. Apps drain the ring in loop() and never wait on the finger.
+// The recognizer and ring are plain C++, so recorded traces replay on a
+// host. touchTrace(true) prints the samples as trace lines to Serial.
+//
+// M5.update() reads the touch controller on the internal I2C bus, which
+// the RTC shares. The task holds I2cBusLock around it; take one around any
+// other use of that bus from loop() (M5.Rtc get/set).
+//
+//   touchBegin();                            // setup(); owns M5.update() from now on
+//   TouchEvent e;
+//   while (touchPoll(e)) if (touchIsTap(e)) onTap(e.x, e.y);
+//   { I2cBusLock bus; M5.Rtc.getTime(&rt); }
+//
+// Per press: DOWN, then LONG_PRESS (held still) or DRAG (moved past the
+// slop), then UP. After the UP comes TAP, DOUBLE_TAP (a second tap close in
+// time and place) or SWIPE (a quick long drag), when they apply.
+
+enum TouchType : uint8_t {
+  TOUCH_DOWN, TOUCH_UP, TOUCH_TAP, TOUCH_DOUBLE_TAP, TOUCH_LONG_PRESS, TOUCH_DRAG, TOUCH_SWIPE
+};
+
+struct TouchEvent {
+  uint32_t ms;                 // sample time (millis)
+  int16_t  x, y;               // TAP / LONG_PRESS: where it went down; others: current point
+  int16_t  dx, dy;             // DRAG: since the last DRAG; UP / SWIPE: whole press
+  uint8_t  type;
+};
+
+inline bool touchIsTap(const TouchEvent& e) { return e.type == TOUCH_TAP || e.type == TOUCH_DOUBLE_TAP; }
+
+typedef void (*TouchSinkFn)(void* ctx, const TouchEvent& e);
+
+struct TouchRecognizer {
+  static const int      SLOP_PX      = 10;    // movement still counted as a tap
+  static const uint32_t TAP_MAX_MS   = 400;
+  static const uint32_t DOUBLE_MS    = 350;   // release to release
+  static const uint32_t LONG_MS      = 600;
+  static const int      SWIPE_MIN_PX = 60;
+  static const uint32_t SWIPE_MAX_MS = 500;
+
+  TouchSinkFn sink = nullptr;
+  void*       ctx = nullptr;
+  bool        down = false, moved = false, longSent = false;
+  int16_t     x0 = 0, y0 = 0;                 // press point
+  int16_t     px = 0, py = 0;                 // last pressed sample
+  int16_t     lx = 0, ly = 0;                 // last DRAG
+  uint32_t    t0 = 0;
+  uint32_t    tapMs = 0;                      // last single tap, 0 = none
+  int16_t     tapX = 0, tapY = 0;
+
+  void emit(uint32_t ms, uint8_t type, int x, int y, int dx = 0, int dy = 0) {
+    TouchEvent e = { ms, (int16_t)x, (int16_t)y, (int16_t)dx, (int16_t)dy, type };
+    sink(ctx, e);
+  }
+
+  void sample(uint32_t ms, bool pressed, int x, int y) {
+    if (pressed && !down) {
+      down = true; moved = false; longSent = false;
+      x0 = px = lx = x; y0 = py = ly = y; t0 = ms;
+      emit(ms, TOUCH_DOWN, x, y);
+      return;
+    }
+    if (pressed) {
+      px = x; py = y;
+      if (!moved && (abs(x - x0) > SLOP_PX || abs(y - y0) > SLOP_PX)) moved = true;
+      if (moved) {
+        if (x != lx || y != ly) { emit(ms, TOUCH_DRAG, x, y, x - lx, y - ly); lx = x; ly = y; }
+      } else if (!longSent && ms - t0 >= LONG_MS) {
+        longSent = true;
+        emit(ms, TOUCH_LONG_PRESS, x0, y0);
+      }
+      return;
+    }
+    if (!down) return;
+
+    // Released: the finger's last position, not the lift sample's
+    down = false;
+    int dx = px - x0, dy = py - y0;
+    emit(ms, TOUCH_UP, px, py, dx, dy);
+    if (moved) {
+      if (ms - t0 <= SWIPE_MAX_MS && (abs(dx) >= SWIPE_MIN_PX || abs(dy) >= SWIPE_MIN_PX))
+        emit(ms, TOUCH_SWIPE, px, py, dx, dy);
+    } else if (!longSent && ms - t0 <= TAP_MAX_MS) {
+      bool second = tapMs && ms - tapMs <= DOUBLE_MS &&
+                    abs(x0 - tapX) <= 3 * SLOP_PX && abs(y0 - tapY) <= 3 * SLOP_PX;
+      if (second) { emit(ms, TOUCH_DOUBLE_TAP, x0, y0); tapMs = 0; }
+      else        { emit(ms, TOUCH_TAP, x0, y0); tapMs = ms; tapX = x0; tapY = y0; }
+    }
+  }
+};
+
+// One producer (the sampler), one consumer (loop). A full ring drops the
+// newest event; the last few slots are kept for presses and releases, so a
+// long drag while loop() is blocked cannot push out its own UP.
+struct TouchRing {
+  static const int N = 64;                    // power of two, divides 256
+  static const int RESERVE = 8;
+  TouchEvent           ev[N];
+  std::atomic<uint8_t> head{0}, tail{0};
+  uint32_t             dropped = 0;           // producer side only
+
+  bool push(const TouchEvent& e) {
+    uint8_t h = head.load(std::memory_order_relaxed);
+    int used = (uint8_t)(h - tail.load(std::memory_order_acquire));
+    if (used >= N || (e.type == TOUCH_DRAG && used >= N - RESERVE)) { dropped++; return false; }
+    ev[h % N] = e;
+    head.store((uint8_t)(h + 1), std::memory_order_release);
+    return true;
+  }
+
+  bool pop(TouchEvent& e) {
+    uint8_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    e = ev[t % N];
+    tail.store((uint8_t)(t + 1), std::memory_order_release);
+    return true;
+  }
+
+  void clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); }
+};
+
+inline void touchRingSink(void* ctx, const TouchEvent& e) { ((TouchRing*)ctx)->push(e); }
+
+// One sample of a trace: "T,<ms>,<pressed>,<x>,<y>"; false for anything else
+inline bool touchTraceLine(const char* line, uint32_t& ms, bool& pressed, int& x, int& y) {
+  unsigned long t; int p;
+  if (sscanf(line, "T,%lu,%d,%d,%d", &t, &p, &x, &y) != 4) return false;
+  ms = (uint32_t)t; pressed = p != 0;
+  return true;
+}
+
+#ifdef ARDUINO
+#include <M5Unified.h>
+
+struct TouchService {
+  TouchRing             ring;
+  TouchRecognizer       rec;
+  TaskHandle_t          task = nullptr;
+  uint32_t              periodMs = 10;
+  std::atomic<uint32_t> lastPressMs{0};       // last sample with a finger down
+  std::atomic<bool>     trace{false};
+};
+
+inline TouchService& touchService() { static TouchService s; return s; }
+
+// The internal I2C bus: touch controller and RTC
+inline SemaphoreHandle_t i2cBusMutex() {
+  static SemaphoreHandle_t m = xSemaphoreCreateMutex();
+  return m;
+}
+
+struct I2cBusLock {
+  I2cBusLock()  { xSemaphoreTake(i2cBusMutex(), portMAX_DELAY); }
+  ~I2cBusLock() { xSemaphoreGive(i2cBusMutex()); }
+  I2cBusLock(const I2cBusLock&) = delete;
+  I2cBusLock& operator=(const I2cBusLock&) = delete;
+};
+
+// M5.update() runs here and nowhere else, so no one else reads the panel
+inline void touchTask(void*) {
+  TouchService& s = touchService();
+  TickType_t wake = xTaskGetTickCount();
+  bool was = false;
+  for (;;) {
+    { I2cBusLock bus; M5.update(); }
+    auto d = M5.Touch.getDetail();
+    uint32_t ms = millis();
+    bool pressed = M5.Touch.getCount() > 0 && d.isPressed();
+    if (pressed) s.lastPressMs.store(ms, std::memory_order_relaxed);
+    if ((pressed || was) && s.trace.load(std::memory_order_relaxed))
+      Serial.printf("T,%lu,%d,%d,%d\n", (unsigned long)ms, pressed ? 1 : 0, d.x, d.y);
+    was = pressed;
+    s.rec.sample(ms, pressed, d.x, d.y);
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(s.periodMs));
+  }
+}
+
+inline void touchBegin(uint32_t hz = 100) {
+  TouchService& s = touchService();
+  if (s.task) return;
+  i2cBusMutex();                              // made before the task and loop() can race for it
+  s.periodMs = hz ? 1000 / hz : 10;
+  s.rec.sink = touchRingSink;
+  s.rec.ctx = &s.ring;
+  xTaskCreatePinnedToCore(touchTask, "touch", 4096, nullptr, 2, &s.task, 0);
+}
+
+inline bool touchPoll(TouchEvent& e) { return touchService().ring.pop(e); }
+
+// Drop what is queued (e.g. presses made against a screen that is gone)
+inline void touchClear() { touchService().ring.clear(); }
+
+// millis() of the last sample with a finger on the panel, 0 = never
+inline uint32_t touchLastMs() { return touchService().lastPressMs.load(std::memory_order_relaxed); }
+
+// Print pressed samples and each release as trace lines, for test/data
+inline void touchTrace(bool on) { touchService().trace.store(on, std::memory_order_relaxed); }
+#endif // ARDUINO
+
+#endif // TOUCHINPUT_H
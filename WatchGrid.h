@@ -0,0 +1,137 @@
+#ifndef WATCHGRID_H
+#define WATCHGRID_H
+
+#include <stdint.h>
+
+// ---------- Paged button grid ----------
+// Fixed-pitch, column-major grid (fills top-to-bottom, then left-to-right),
+// one page at a time. Cell rects and touch hit-tests are plain arithmetic,
+// so neither depends on how many items are in the list.
+//
+//   GridLayout g{ left, top, cellW, cellH, pitchX, pitchY, cols, rows };
+//   int idx = g.hitIndex(x, y, page, count);   // -1 = gap / empty cell
+
+struct GridLayout {
+  int left, top;
+  int cellW, cellH;      // button size
+  int pitchX, pitchY;    // button size + gap
+  int cols, rows;
+
+  int perPage() const { return cols * rows; }
+  int pageCount(int count) const { return count <= 0 ? 1 : (count + perPage() - 1) / perPage(); }
+  int pageOf(int idx) const { return idx / perPage(); }
+  int height() const { return rows * pitchY; }
+
+  // Rect of the idx-th item, relative to the grid origin (left, top)
+  void cellRect(int idx, int& x, int& y) const {
+    int slot = idx % perPage();
+    x = (slot / rows) * pitchX;
+    y = (slot % rows) * pitchY;
+  }
+
+  // Screen point -> item index on `page`, -1 for gaps and empty cells
+  int hitIndex(int x, int y, int page, int count) const {
+    int dx = x - left, dy = y - top;
+    if (dx < 0 || dy < 0) return -1;
+    int col = dx / pitchX, row = dy / pitchY;
+    if (col >= cols || row >= rows) return -1;
+    if (dx - col * pitchX > cellW || dy - row * pitchY > cellH) return -1;
+    int idx = page * perPage() + col * rows + row;
+    return idx < count ? idx : -1;
+  }
+};
+
+#ifdef ARDUINO
+#include <M5Unified.h>
+#include "GrayRender.h"
+
+// ---------- Page cache ----------
+// Pages are rendered ahead of time into one 8-bit gray canvas and packed to
+// 1 bpp frames in PSRAM. A page flip is then one push of the grid band in
+// the fastest waveform instead of N button draws. Any change to what a cell
+// shows (selection, labels) must call invalidate().
+typedef void (*GridCellFn)(LovyanGFX& g, int idx, int x, int y, int w, int h);
+
+struct GridPageCache {
+  static const int SLOTS = 3;          // current page plus both neighbours
+
+  M5Canvas* scratch = nullptr;         // where cells are drawn before packing
+  GrayFrame frame[SLOTS];
+  int       page[SLOTS]   = { -1, -1, -1 };
+  uint32_t  epochOf[SLOTS] = {};
+  uint32_t  used[SLOTS]    = {};
+  uint32_t  epoch = 1, tick = 0;
+  int       w = 0, h = 0;
+
+  // ~40 KB per page for an 880x372 band (the 8bpp canvases were ~330 KB
+  // each); `width` must be a multiple of 8. Returns false (and the caller
+  // draws directly) when PSRAM is short.
+  bool begin(int width, int height) {
+    w = width; h = height;
+    scratch = grayCanvas(w, h);
+    if (!scratch) { Serial.println("grid cache: canvas alloc failed"); return false; }
+    for (int i = 0; i < SLOTS; ++i) {
+      if (!frame[i].alloc(w, h, GC_TEXT)) {
+        Serial.printf("grid cache: slot %d alloc failed\n", i);
+        return i > 0;
+      }
+    }
+    return true;
+  }
+
+  void invalidate() { epoch++; }
+
+  // Give the canvas and every frame back; begin() again before the next show
+  void end() {
+    delete scratch;
+    scratch = nullptr;
+    for (int i = 0; i < SLOTS; ++i) { frame[i].release(); page[i] = -1; }
+  }
+
+  // Cached frame for `page`, rendering it into the least recently used slot
+  // on a miss. nullptr when nothing could be allocated.
+  GrayFrame* get(const GridLayout& L, int pg, int count, GridCellFn cell) {
+    int victim = -1;
+    for (int i = 0; i < SLOTS; ++i) {
+      if (!scratch || !frame[i].bits) continue;
+      if (page[i] == pg && epochOf[i] == epoch) { used[i] = ++tick; return &frame[i]; }
+      if (victim < 0 || used[i] < used[victim]) victim = i;
+    }
+    if (victim < 0) return nullptr;
+
+    M5Canvas* c = scratch;
+    c->fillScreen(WHITE);
+    c->setFont(M5.Display.getFont());
+    c->setTextSize(M5.Display.getTextSizeX());
+    int first = pg * L.perPage();
+    for (int idx = first; idx < count && idx < first + L.perPage(); ++idx) {
+      int x, y; L.cellRect(idx, x, y);
+      cell(*c, idx, x, y, L.cellW, L.cellH);
+    }
+    frame[victim].capture(*c, L.top);
+    page[victim] = pg; epochOf[victim] = epoch; used[victim] = ++tick;
+    return &frame[victim];
+  }
+
+  // Push `pg` to the panel; falls back to drawing straight onto the display
+  void show(const GridLayout& L, int pg, int count, GridCellFn cell) {
+    GrayFrame* f = get(L, pg, count, cell);
+    if (f) { f->push(L.left, L.top); return; }
+    M5.Display.fillRect(L.left, L.top, w, h, WHITE);
+    int first = pg * L.perPage();
+    for (int idx = first; idx < count && idx < first + L.perPage(); ++idx) {
+      int x, y; L.cellRect(idx, x, y);
+      cell(M5.Display, idx, L.left + x, L.top + y, L.cellW, L.cellH);
+    }
+  }
+
+  // Render the neighbours while the user is looking at `pg`
+  void prefetch(const GridLayout& L, int pg, int count, GridCellFn cell) {
+    int pages = L.pageCount(count);
+    if (pg + 1 < pages) get(L, pg + 1, count, cell);
+    if (pg > 0)         get(L, pg - 1, count, cell);
+  }
+};
+#endif // ARDUINO
+
+#endif // WATCHGRID_H
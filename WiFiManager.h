@@ -0,0 +1,267 @@
+#ifndef WIFIMANAGER_H
+#define WIFIMANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <lwip/dhcp.h>
+#include <vector>
+
+// ---------- WiFi connection manager ----------
+// Non-blocking replacement for the old "WiFi.begin + delay(250) poll" loops.
+//   net_begin(list)   once from setup(); returns immediately
+//   net_update(list)  new list after a config edit; an up link is kept
+//   net_tick()        every loop(); drives joins, fallbacks and reconnects
+//   net_isUp()        current link state
+//   net_justConnected() true once after each successful (re)connect
+//   net_suspend()/net_resume()  radio off/on around sleep
+//
+// The last good BSSID, channel and DHCP lease are kept in NVS so the next boot
+// can skip the scan and DHCP round trips. If that fast path does not come up
+// quickly the cache is dropped and every configured network is tried in order.
+// The address is reused as a static config only until half the lease has run
+// (when a DHCP client would renew), and only when the clock is set. Past
+// that, or with no clock, the fast path keeps the BSSID and channel but asks
+// DHCP again, and the new lease is cached.
+
+struct WiFiCred { String ssid; String pass; };
+
+static const unsigned long NET_FAST_TIMEOUT_MS = 3000;   // cached BSSID/channel/IP
+static const unsigned long NET_JOIN_TIMEOUT_MS = 10000;  // per network, full scan + DHCP
+static const unsigned long NET_BACKOFF_MIN_MS  = 5000;
+static const unsigned long NET_BACKOFF_MAX_MS  = 120000;
+static const time_t        NET_VALID_EPOCH     = 1700000000;   // clock is set
+
+enum NetState : uint8_t { NET_IDLE, NET_FAST, NET_NEXT, NET_JOINING, NET_UP, NET_BACKOFF };
+
+struct NetCache {
+  uint32_t magic;
+  char     ssid[33];
+  uint8_t  bssid[6];
+  int32_t  channel;
+  uint32_t ip, gw, mask, dns;
+  uint32_t reuseUntil;        // epoch; the address is not reused after it (0: never)
+};
+static const uint32_t NET_CACHE_MAGIC = 0x4E455432; // "NET2"
+
+struct NetManager {
+  std::vector<WiFiCred> creds;
+  NetCache cache{};
+  bool     haveCache = false;
+  NetState state = NET_IDLE;
+  size_t   idx = 0;                 // network being tried in NET_JOINING
+  unsigned long deadline = 0;
+  unsigned long backoff  = NET_BACKOFF_MIN_MS;
+  unsigned long upSince  = 0;
+  bool     justConnected = false;
+  bool     fastDhcp = false;        // NET_FAST without the cached address
+  bool     suspended = false;
+  uint16_t reconnects = 0;
+};
+static NetManager g_net;
+
+inline void net_loadCache() {
+  Preferences p;
+  g_net.haveCache = false;
+  if (!p.begin("netcache", true)) return;
+  if (p.getBytesLength("c") == sizeof(NetCache)) {
+    p.getBytes("c", &g_net.cache, sizeof(NetCache));
+    g_net.haveCache = (g_net.cache.magic == NET_CACHE_MAGIC && g_net.cache.ssid[0]);
+  }
+  p.end();
+}
+
+// Length of the station's current DHCP lease in seconds, 0 if unknown
+inline uint32_t net_leaseSeconds() {
+  esp_netif_t* nif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+  struct netif* n = nif ? (struct netif*)esp_netif_get_netif_impl(nif) : nullptr;
+  struct dhcp* d = n ? netif_dhcp_data(n) : nullptr;
+  return d ? d->offered_t0_lease : 0;
+}
+
+inline void net_saveCache() {
+  NetCache c{};
+  c.magic = NET_CACHE_MAGIC;
+  strncpy(c.ssid, WiFi.SSID().c_str(), sizeof(c.ssid) - 1);
+  const uint8_t* b = WiFi.BSSID();
+  if (b) memcpy(c.bssid, b, 6);
+  c.channel = WiFi.channel();
+  c.ip   = (uint32_t)WiFi.localIP();
+  c.gw   = (uint32_t)WiFi.gatewayIP();
+  c.mask = (uint32_t)WiFi.subnetMask();
+  c.dns  = (uint32_t)WiFi.dnsIP();
+  time_t now = time(nullptr);
+  uint32_t lease = net_leaseSeconds();
+  if (now > NET_VALID_EPOCH && lease) c.reuseUntil = (uint32_t)now + lease / 2;
+
+  // Only touch flash when something actually changed
+  if (g_net.haveCache && memcmp(&c, &g_net.cache, sizeof(c)) == 0) return;
+
+  Preferences p;
+  if (!p.begin("netcache", false)) return;
+  p.putBytes("c", &c, sizeof(c));
+  p.end();
+  g_net.cache = c;
+  g_net.haveCache = true;
+}
+
+inline void net_clearCache() {
+  Preferences p;
+  if (p.begin("netcache", false)) { p.clear(); p.end(); }
+  g_net.haveCache = false;
+}
+
+inline const WiFiCred* net_credForSsid(const char* ssid) {
+  for (auto &c : g_net.creds) if (c.ssid == ssid) return &c;
+  return nullptr;
+}
+
+// Join the cached AP directly: no scan, and no DHCP while the lease holds
+inline bool net_startFast() {
+  if (!g_net.haveCache) return false;
+  const WiFiCred* c = net_credForSsid(g_net.cache.ssid);
+  if (!c) return false;   // network removed from the config since last boot
+
+  time_t now = time(nullptr);
+  bool reuseIp = g_net.cache.ip && now > NET_VALID_EPOCH && (uint32_t)now < g_net.cache.reuseUntil;
+  Serial.printf("WiFi: fast-connect %s ch%d%s\n", g_net.cache.ssid, (int)g_net.cache.channel,
+                reuseIp ? "" : " (DHCP)");
+  if (reuseIp) {
+    WiFi.config(IPAddress(g_net.cache.ip), IPAddress(g_net.cache.gw),
+                IPAddress(g_net.cache.mask), IPAddress(g_net.cache.dns));
+  } else {
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+  }
+  g_net.fastDhcp = !reuseIp;
+  const char* pass = c->pass.length() ? c->pass.c_str() : nullptr;
+  WiFi.begin(c->ssid.c_str(), pass, g_net.cache.channel, g_net.cache.bssid, true);
+  g_net.state = NET_FAST;
+  g_net.deadline = millis() + NET_FAST_TIMEOUT_MS;
+  return true;
+}
+
+inline void net_startJoin(size_t i) {
+  const WiFiCred& c = g_net.creds[i];
+  Serial.print("WiFi: joining "); Serial.println(c.ssid);
+  WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);   // back to DHCP
+  if (c.pass.length() == 0) WiFi.begin(c.ssid.c_str());
+  else                      WiFi.begin(c.ssid.c_str(), c.pass.c_str());
+  g_net.idx = i;
+  g_net.state = NET_JOINING;
+  g_net.deadline = millis() + NET_JOIN_TIMEOUT_MS;
+}
+
+inline void net_begin(const std::vector<WiFiCred>& creds) {
+  g_net.creds = creds;
+  g_net.backoff = NET_BACKOFF_MIN_MS;
+
+  WiFi.persistent(false);        // we keep our own cache; skip the SDK flash writes
+  WiFi.setAutoReconnect(false);  // reconnects are driven from net_tick()
+  WiFi.mode(WIFI_STA);
+
+  if (g_net.creds.empty()) {
+    Serial.println("WiFi: no networks configured");
+    g_net.state = NET_IDLE;
+    return;
+  }
+  net_loadCache();
+  if (!net_startFast()) { g_net.idx = 0; g_net.state = NET_NEXT; }
+}
+
+// Networks edited at runtime: while the link is up the new list is only used
+// for the next (re)join, so saving the config does not drop the connection
+inline void net_update(const std::vector<WiFiCred>& creds) {
+  if (g_net.state == NET_UP) { g_net.creds = creds; return; }
+  net_begin(creds);
+}
+
+inline void net_tick() {
+  const unsigned long now = millis();
+  switch (g_net.state) {
+    case NET_IDLE:
+      return;
+
+    case NET_FAST:
+    case NET_JOINING:
+      if (WiFi.status() == WL_CONNECTED) {
+        Serial.printf("WiFi: connected %s  IP %s  (%s)\n", WiFi.SSID().c_str(),
+                      WiFi.localIP().toString().c_str(),
+                      g_net.state == NET_FAST ? "fast" : "full");
+        if (g_net.state == NET_JOINING || g_net.fastDhcp) net_saveCache();
+        g_net.state = NET_UP;
+        g_net.upSince = now;
+        g_net.backoff = NET_BACKOFF_MIN_MS;
+        g_net.justConnected = true;
+        return;
+      }
+      if ((long)(now - g_net.deadline) < 0) return;
+      WiFi.disconnect();
+      if (g_net.state == NET_FAST) {
+        Serial.println("WiFi: fast-connect timed out, dropping cache");
+        net_clearCache();
+        g_net.idx = 0;
+      } else {
+        Serial.println("WiFi: join timed out");
+        g_net.idx++;
+      }
+      g_net.state = NET_NEXT;
+      return;
+
+    case NET_NEXT:
+      if (g_net.idx < g_net.creds.size()) { net_startJoin(g_net.idx); return; }
+      Serial.printf("WiFi: all networks failed, retry in %lus\n", g_net.backoff / 1000);
+      g_net.state = NET_BACKOFF;
+      g_net.deadline = now + g_net.backoff;
+      g_net.backoff = min(g_net.backoff * 2, NET_BACKOFF_MAX_MS);
+      return;
+
+    case NET_UP:
+      if (WiFi.status() == WL_CONNECTED) return;
+      Serial.println("WiFi: link dropped, reconnecting");
+      g_net.reconnects++;
+      WiFi.disconnect();
+      if (!net_startFast()) { g_net.idx = 0; g_net.state = NET_NEXT; }
+      return;
+
+    case NET_BACKOFF:
+      if ((long)(now - g_net.deadline) < 0) return;
+      if (!net_startFast()) { g_net.idx = 0; g_net.state = NET_NEXT; }
+      return;
+  }
+}
+
+// Radio off (e.g. before light sleep). The manager stays idle until resumed.
+inline void net_suspend() {
+  if (g_net.suspended || g_net.creds.empty()) return;
+  WiFi.disconnect(true);
+  WiFi.mode(WIFI_OFF);
+  g_net.state = NET_IDLE;
+  g_net.suspended = true;
+}
+
+inline void net_resume() {
+  if (!g_net.suspended) return;
+  g_net.suspended = false;
+  WiFi.mode(WIFI_STA);
+  if (!net_startFast()) { g_net.idx = 0; g_net.state = NET_NEXT; }
+}
+
+inline bool net_isUp() { return g_net.state == NET_UP && WiFi.status() == WL_CONNECTED; }
+
+inline bool net_justConnected() {
+  bool v = g_net.justConnected;
+  g_net.justConnected = false;
+  return v;
+}
+
+// For the few callers that really need the link before continuing (e.g. a
+// user-pressed "Sync Time"). Keeps ticking the state machine while it waits.
+inline bool net_waitUp(unsigned long timeoutMs) {
+  unsigned long start = millis();
+  while (!net_isUp() && millis() - start < timeoutMs) { net_tick(); delay(50); }
+  return net_isUp();
+}
+
+#endif // WIFIMANAGER_H
@@ -0,0 +1,144 @@
+#ifndef WORLDCLOCK_H
+#define WORLDCLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ---------- Time zones without touching TZ ----------
+// Each zone's UTC offset changes come from a small table built once from
+// its DST rule (WC_FIRST_YEAR..WC_LAST_YEAR). After that, a UTC instant
+// maps to local time with a binary search and integer arithmetic. There is
+// no setenv("TZ")/tzset() swap and no strftime. Plain C++.
+//
+//   WcTable ny; wcBuild(*wcFind("America/New_York"), ny);
+//   int32_t m = wcLocalMinute(ny, now);     // compare to the last one drawn
+//   WcCivil c = wcCivil(m);                 // c.hour, c.min, c.wday, ...
+
+enum WcRule : uint8_t { WC_NONE, WC_US, WC_EU, WC_AU };
+
+struct WcZone {
+  const char* key;       // IANA-style name used in config files
+  const char* label;     // what the clock face prints
+  int16_t     stdMin, dstMin;
+  uint8_t     rule;
+};
+
+static const WcZone WC_ZONES[] = {
+  { "UTC",                 "UTC",       0,    0,   WC_NONE },
+  { "America/New_York",    "New York", -300, -240, WC_US },
+  { "America/Chicago",     "Chicago",  -360, -300, WC_US },
+  { "America/Denver",      "Denver",   -420, -360, WC_US },
+  { "America/Los_Angeles", "LA",       -480, -420, WC_US },
+  { "Europe/London",       "London",    0,    60,  WC_EU },
+  { "Europe/Paris",        "Paris",     60,   120, WC_EU },
+  { "Europe/Berlin",       "Berlin",    60,   120, WC_EU },
+  { "Asia/Kolkata",        "Mumbai",    330,  330, WC_NONE },
+  { "Asia/Singapore",      "Singapore", 480,  480, WC_NONE },
+  { "Asia/Hong_Kong",      "Hong Kong", 480,  480, WC_NONE },
+  { "Asia/Shanghai",       "Shanghai",  480,  480, WC_NONE },
+  { "Asia/Tokyo",          "Tokyo",     540,  540, WC_NONE },
+  { "Australia/Sydney",    "Sydney",    600,  660, WC_AU },
+};
+static const int WC_ZONE_COUNT = sizeof(WC_ZONES) / sizeof(WC_ZONES[0]);
+
+static const int WC_FIRST_YEAR = 2024;
+static const int WC_LAST_YEAR  = 2037;     // uint32 epochs are fine well past this
+static const int WC_MAX_TR     = 2 * (WC_LAST_YEAR - WC_FIRST_YEAR + 1);
+
+struct WcTable {
+  int16_t  baseMin;          // offset before the first transition
+  uint8_t  n;
+  uint32_t at[WC_MAX_TR];    // UTC epoch of each change, ascending
+  int16_t  off[WC_MAX_TR];   // offset from that instant on
+};
+
+struct WcCivil { int year, month, day, hour, min, wday; };   // wday 0 = Sunday
+
+inline const WcZone* wcFind(const char* key) {
+  for (int i = 0; i < WC_ZONE_COUNT; ++i) if (!strcmp(WC_ZONES[i].key, key)) return &WC_ZONES[i];
+  return nullptr;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant)
+inline int32_t wcDays(int y, int m, int d) {
+  y -= m <= 2;
+  int32_t era = (y >= 0 ? y : y - 399) / 400;
+  int32_t yoe = y - era * 400;
+  int32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+inline uint32_t wcEpoch(int y, int m, int d, int hh = 0, int mm = 0) {
+  return (uint32_t)wcDays(y, m, d) * 86400u + (uint32_t)(hh * 3600 + mm * 60);
+}
+
+inline int wcDow(int32_t days) { return (int)((days % 7 + 11) % 7); }   // 1970-01-01 was a Thursday
+
+// Day of month of the n-th (1-based) Sunday, or the last one for n = -1
+inline int wcSunday(int y, int m, int n) {
+  if (n > 0) return 1 + (7 - wcDow(wcDays(y, m, 1))) % 7 + (n - 1) * 7;
+  static const int mdays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  int len = mdays[m - 1] + (m == 2 && ((y % 4 == 0 && y % 100 != 0) || y % 400 == 0));
+  return len - wcDow(wcDays(y, m, len));
+}
+
+inline void wcBuild(const WcZone& z, WcTable& t) {
+  t.n = 0;
+  t.baseMin = (z.rule == WC_AU) ? z.dstMin : z.stdMin;   // January is summer down under
+  if (z.rule == WC_NONE) return;
+  for (int y = WC_FIRST_YEAR; y <= WC_LAST_YEAR; ++y) {
+    uint32_t on, off;                                      // UTC instants
+    switch (z.rule) {
+      case WC_US:   // 02:00 local, second Sunday of March / first Sunday of November
+        on  = wcEpoch(y, 3,  wcSunday(y, 3, 2),  2) - z.stdMin * 60;
+        off = wcEpoch(y, 11, wcSunday(y, 11, 1), 2) - z.dstMin * 60;
+        break;
+      case WC_EU:   // 01:00 UTC, last Sunday of March / October
+        on  = wcEpoch(y, 3,  wcSunday(y, 3, -1),  1);
+        off = wcEpoch(y, 10, wcSunday(y, 10, -1), 1);
+        break;
+      default:      // AU: 03:00 DST first Sunday of April, 02:00 std first Sunday of October
+        off = wcEpoch(y, 4,  wcSunday(y, 4, 1),  3) - z.dstMin * 60;
+        on  = wcEpoch(y, 10, wcSunday(y, 10, 1), 2) - z.stdMin * 60;
+        break;
+    }
+    bool onFirst = on < off;
+    t.at[t.n] = onFirst ? on : off;  t.off[t.n++] = onFirst ? z.dstMin : z.stdMin;
+    t.at[t.n] = onFirst ? off : on;  t.off[t.n++] = onFirst ? z.stdMin : z.dstMin;
+  }
+}
+
+// UTC offset in minutes at `utc`
+inline int16_t wcOffset(const WcTable& t, uint32_t utc) {
+  int lo = 0, hi = t.n;                     // first transition after utc
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (t.at[mid] <= utc) lo = mid + 1; else hi = mid;
+  }
+  return lo ? t.off[lo - 1] : t.baseMin;
+}
+
+// Local wall-clock minutes since 1970; changes exactly once per local minute
+inline int32_t wcLocalMinute(const WcTable& t, uint32_t utc) {
+  return (int32_t)(utc / 60) + wcOffset(t, utc);
+}
+
+inline WcCivil wcCivil(int32_t localMinute) {
+  WcCivil c;
+  int32_t days = localMinute / 1440, mod = localMinute % 1440;
+  if (mod < 0) { mod += 1440; days--; }
+  c.hour = mod / 60; c.min = mod % 60; c.wday = wcDow(days);
+  int32_t z = days + 719468;                 // civil_from_days (H. Hinnant)
+  int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+  int32_t doe = z - era * 146097;
+  int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int32_t mp = (5 * doy + 2) / 153;
+  c.day = doy - (153 * mp + 2) / 5 + 1;
+  c.month = mp < 10 ? mp + 3 : mp - 9;
+  c.year = yoe + era * 400 + (c.month <= 2);
+  return c;
+}
+
+#endif // WORLDCLOCK_H
@@ -0,0 +1,33 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+
+// ---------- Host benchmark helpers ----------
+// Best of `rounds` runs of `iters` calls, per call. Host numbers only rank
+// alternatives; the ESP32-S3 is roughly 20-50x slower.
+
+static volatile uint64_t g_benchSink;   // results land here so they are not optimised away
+
+template <class F>
+double benchNs(int iters, F&& f, int rounds = 5) {
+  using namespace std::chrono;
+  double best = 1e300;
+  for (int r = 0; r < rounds; ++r) {
+    auto t0 = steady_clock::now();
+    for (int i = 0; i < iters; ++i) f(i);
+    double ns = duration<double, std::nano>(steady_clock::now() - t0).count() / iters;
+    if (ns < best) best = ns;
+  }
+  return best;
+}
+
+inline void benchLine(const char* name, double ns) {
+  if (ns >= 1e6)      printf("  %-40s %9.2f ms\n", name, ns / 1e6);
+  else if (ns >= 1e3) printf("  %-40s %9.2f us\n", name, ns / 1e3);
+  else                printf("  %-40s %9.1f ns\n", name, ns);
+}
+
+#endif // BENCH_H
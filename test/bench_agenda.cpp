@@ -0,0 +1,206 @@
+// Agenda frame time for a 1,000-event store, on a host display simulator
+// (Agenda.h). The simulator is an 8-bit canvas with the calls the agenda
+// makes: clipped fills, a row scroll and fixed-cell text (the built-in
+// font's 6x8 cell, scaled). Rows are wrapped and measured the way
+// agendaRowH does. A drag is replayed as the 150 ms batches agendaTouch
+// sends. Each step scrolls the kept pixels and draws only the exposed
+// strip, as AgendaView::scrollTo does, and is timed against redrawing the
+// whole viewport. Every strip frame must match a full redraw pixel for pixel.
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include "Agenda.h"
+#include "bench.h"
+
+static const int VIEW_W = 960, VIEW_H = 480;
+static const int HEAD_H = 44, TIME_W = 170, PAD = 10;
+
+// ---------- Simulated canvas ----------
+struct SimCanvas {
+  int w, h, cx0 = 0, cy0 = 0, cx1, cy1;
+  std::vector<uint8_t> px;
+  SimCanvas(int width, int height) : w(width), h(height), cx1(width), cy1(height), px((size_t)width * height, 0xFF) {}
+
+  void clip(int x, int y, int cw, int ch) { cx0 = x; cy0 = y; cx1 = x + cw; cy1 = y + ch; }
+  void noClip() { cx0 = 0; cy0 = 0; cx1 = w; cy1 = h; }
+
+  void fillRect(int x, int y, int fw, int fh, uint8_t c) {
+    int x0 = std::max(x, cx0), y0 = std::max(y, cy0), x1 = std::min(x + fw, cx1), y1 = std::min(y + fh, cy1);
+    for (int yy = y0; yy < y1; ++yy) memset(&px[(size_t)yy * w + x0], c, x1 > x0 ? x1 - x0 : 0);
+  }
+
+  // Like LGFX scroll(0, dy): the image moves, the exposed rows are left as they were
+  void scroll(int dy) {
+    if (dy < 0) memmove(&px[0], &px[(size_t)-dy * w], (size_t)(h + dy) * w);
+    else        memmove(&px[(size_t)dy * w], &px[0], (size_t)(h - dy) * w);
+  }
+
+  // One glyph: a cell with a letter-ish block, so text costs what pixels cost
+  void glyph(int x, int y, int sz, char ch) {
+    int cw = 6 * sz, chh = 8 * sz;
+    fillRect(x + sz, y + sz, cw - 2 * sz, chh - 2 * sz, (uint8_t)(ch & 1 ? 0x00 : 0x66));
+  }
+  int textW(const std::string& s, int sz) const { return 6 * sz * (int)s.size(); }
+  void text(int x, int y, const std::string& s, int sz) {
+    if (y >= cy1 || y + 8 * sz <= cy0) return;
+    for (size_t i = 0; i < s.size(); ++i) glyph(x + 6 * sz * (int)i, y, sz, s[i]);
+  }
+};
+
+// wrapText from Calendar.ino, minus the ellipsis
+static int wrap(SimCanvas& g, int x, int y, int w, int bottom, const std::string& t, int sz, bool draw) {
+  int lineH = 8 * sz, cy = y;
+  std::string line, word;
+  auto flush = [&] { if (cy + lineH > bottom) return false; if (draw) g.text(x, cy, line, sz); cy += lineH + 2; line.clear(); return true; };
+  for (size_t i = 0; i <= t.size(); ++i) {
+    char c = i < t.size() ? t[i] : ' ';
+    if (c == ' ') {
+      std::string p = line.empty() ? word : line + " " + word;
+      if (g.textW(p, sz) <= w) line = p;
+      else { if (!flush()) return bottom; line = word; }
+      word.clear();
+    } else word += c;
+  }
+  if (!line.empty()) flush();
+  return cy;
+}
+
+// ---------- Agenda rows ----------
+struct Event { int day, sh, sm; std::string title, location; };
+struct Row { int ev; int day; };                     // ev < 0: day heading
+
+static std::vector<Event> g_events;
+static std::vector<Row>   g_rows;
+static AgendaLayout       g_layout;
+static const int TEXT_W = VIEW_W - TIME_W - 2 * PAD;
+
+static int rowH(SimCanvas& g, int i) {
+  const Row& r = g_rows[i];
+  if (r.ev < 0) return HEAD_H;
+  const Event& e = g_events[r.ev];
+  int cy = wrap(g, 0, 0, TEXT_W, INT16_MAX, e.title, 2, false);
+  if (!e.location.empty()) cy = wrap(g, 0, cy, TEXT_W, INT16_MAX, e.location, 1, false);
+  return std::max(cy, 36) + 2 * PAD;
+}
+
+static void drawRow(SimCanvas& g, int i, int y, int w) {
+  const Row& r = g_rows[i];
+  int h = g_layout.rowH(i);
+  if (r.ev < 0) {
+    g.fillRect(0, y + 4, w, h - 8, 0xCC);
+    g.text(PAD, y + 14, "DAY " + std::to_string(r.day), 2);
+    return;
+  }
+  const Event& e = g_events[r.ev];
+  char tm[8];
+  snprintf(tm, sizeof(tm), "%02d:%02d", e.sh, e.sm);
+  g.text(PAD, y + PAD, tm, 2);
+  int cy = wrap(g, TIME_W + PAD, y + PAD, TEXT_W, y + h, e.title, 2, true);
+  if (!e.location.empty()) wrap(g, TIME_W + PAD, cy, TEXT_W, y + h, e.location, 1, true);
+  g.fillRect(PAD, y + h - 1, w - 2 * PAD, 1, 0x66);
+}
+
+static int g_rowsDrawn;
+
+// AgendaView::renderStrip
+static void renderStrip(SimCanvas& g, int32_t scroll, int y0, int y1) {
+  g.clip(0, y0, VIEW_W, y1 - y0);
+  g.fillRect(0, y0, VIEW_W, y1 - y0, 0xFF);
+  int n = g_layout.count();
+  for (int i = g_layout.rowAt(scroll + y0); i < n && g_layout.rowTop(i) < scroll + y1; ++i, ++g_rowsDrawn)
+    drawRow(g, i, g_layout.rowTop(i) - scroll, VIEW_W);
+  g.noClip();
+}
+
+static void makeStore(int n) {
+  static const char* W[] = { "planning", "review", "with", "the", "platform", "team", "sync", "quarterly", "budget",
+                             "interview", "candidate", "onboarding", "retro", "design", "1:1", "lunch", "customer", "call" };
+  uint32_t r = 1;
+  auto rnd = [&](uint32_t m) { r = r * 1664525u + 1013904223u; return (r >> 8) % m; };
+  g_events.clear();
+  for (int i = 0; i < n; ++i) {
+    Event e;
+    e.day = i * 90 / n;                                 // three months, ~11 a day
+    e.sh = 7 + (int)rnd(12); e.sm = 15 * (int)rnd(4);
+    int words = 2 + (int)rnd(14);
+    for (int k = 0; k < words; ++k) e.title += std::string(k ? " " : "") + W[rnd(18)];
+    if (rnd(3) == 0) e.location = "Building " + std::to_string(rnd(9)) + ", room " + std::to_string(100 + rnd(400));
+    g_events.push_back(e);
+  }
+}
+
+static void layout(SimCanvas& g) {
+  g_rows.clear();
+  for (int j = 0; j < (int)g_events.size(); ++j) {
+    if (g_rows.empty() || g_rows.back().day != g_events[j].day) g_rows.push_back({ -1, g_events[j].day });
+    g_rows.push_back({ j, g_events[j].day });
+  }
+  g_layout.build((int)g_rows.size(), [&](int i) { return rowH(g, i); });
+}
+
+int main() {
+  const int N = 1000;
+  makeStore(N);
+  SimCanvas view(VIEW_W, VIEW_H), ref(VIEW_W, VIEW_H);
+  layout(view);
+  printf("agenda, %d events, %d rows, %d px tall, %dx%d viewport\n", N, g_layout.count(),
+         (int)g_layout.total(), VIEW_W, VIEW_H);
+
+  benchLine("layout (measure every row)", benchNs(5, [&](int) { layout(view); g_benchSink = g_layout.total(); }));
+  benchLine("row at offset, prefix sum", benchNs(200000, [&](int i) { g_benchSink = g_layout.rowAt((i * 7919) % g_layout.total()); }));
+  benchLine("row at offset, linear scan", benchNs(2000, [&](int i) {
+    int32_t y = (i * 7919) % g_layout.total(), k = 0;
+    while (k + 1 < g_layout.count() && g_layout.rowTop(k + 1) <= y) ++k;
+    g_benchSink = k;
+  }));
+
+  // A drag: down through the store in 150 ms batches, a fling, then back up
+  std::vector<int32_t> offsets;
+  int32_t s = 0;
+  uint32_t r = 9;
+  for (int k = 0; k < 400; ++k) {
+    r = r * 1664525u + 1013904223u;
+    int32_t d = 40 + (int32_t)((r >> 8) % 120);
+    if (k % 50 == 49) d = 3 * VIEW_H;                   // a fling past a whole screen
+    s = g_layout.clamp(s + (k < 300 ? d : -d), VIEW_H);
+    offsets.push_back(s);
+  }
+
+  // Strip frames must equal full redraws
+  int bad = 0;
+  int32_t cur = 0;
+  renderStrip(view, cur, 0, VIEW_H);
+  for (int32_t to : offsets) {
+    if (to == cur) continue;
+    AgendaStrip st = agendaScroll(cur, to, VIEW_H);
+    if (st.shift) view.scroll(st.shift);
+    renderStrip(view, to, st.y0, st.y1);
+    cur = to;
+    renderStrip(ref, to, 0, VIEW_H);
+    if (view.px != ref.px) ++bad;
+  }
+  if (bad) printf("  %d strip frames differ from a full redraw\n", bad);
+
+  benchLine("open (full viewport)", benchNs(50, [&](int i) { renderStrip(view, offsets[i % offsets.size()], 0, VIEW_H); }));
+
+  g_rowsDrawn = 0;
+  int frames = 0;
+  cur = 0;
+  renderStrip(view, cur, 0, VIEW_H);
+  double strip = benchNs((int)offsets.size(), [&](int i) {
+    int32_t to = offsets[i];
+    AgendaStrip st = agendaScroll(cur, to, VIEW_H);
+    if (st.shift) view.scroll(st.shift);
+    renderStrip(view, to, st.y0, st.y1);
+    cur = to; ++frames;
+  }, 1);
+  benchLine("drag frame, exposed strip", strip);
+  printf("  %-40s %9.1f rows\n", "  drawn per frame", (double)g_rowsDrawn / frames);
+
+  g_rowsDrawn = 0;
+  double full = benchNs((int)offsets.size(), [&](int i) { renderStrip(view, offsets[i], 0, VIEW_H); }, 1);
+  benchLine("drag frame, full redraw", full);
+  printf("  %-40s %9.1f rows\n", "  drawn per frame", (double)g_rowsDrawn / offsets.size());
+  return bad ? 1 : 0;
+}
@@ -0,0 +1,86 @@
+// Saved-frame codec throughput (FrameStore.h) for a full 960x540 panel
+// frame. Encoding is fed one row at a time, as frameSave does after each
+// readRect. Decoding reads the file in 1 KB chunks and draws runs into a
+// level buffer, as frameRestore does into the panel. Three frames: a
+// calendar-like one, a blank one and a dithered worst case where no two
+// neighbours match. Every decode must give back the frame it was fed, and
+// no file may be bigger than the raw levels: the dithered one is stored
+// raw, as frameSave falls back to once the run coding outgrows that.
+
+#include <string.h>
+#include <vector>
+#include "FrameStore.h"
+#include "bench.h"
+
+static const int W = 960, H = 540;
+
+static bool sinkVec(void* ctx, const uint8_t* p, size_t n) {
+  std::vector<uint8_t>& v = *(std::vector<uint8_t>*)ctx;
+  v.insert(v.end(), p, p + n);
+  return true;
+}
+
+static void runInto(void* ctx, int x, int y, int len, uint8_t level) {
+  memset((uint8_t*)ctx + (size_t)y * W + x, level, len);
+}
+
+// Run-coded, or raw when that comes out bigger; returns the mode
+static uint8_t encode(const std::vector<uint8_t>& lv, std::vector<uint8_t>& out) {
+  FrameRleEncoder enc;
+  for (uint8_t mode = FRAME_RLE; ; mode = FRAME_RAW) {
+    out.clear();
+    enc.begin(sinkVec, &out, mode == FRAME_RAW);
+    int y = 0;
+    for (; y < H && enc.size() <= frameRawBytes(W, H); ++y) enc.pixels(&lv[(size_t)y * W], W);
+    if (y == H && enc.finish() && (mode == FRAME_RAW || enc.bytes <= frameRawBytes(W, H))) return mode;
+  }
+}
+
+static bool decode(const std::vector<uint8_t>& in, uint8_t mode, std::vector<uint8_t>& lv) {
+  FrameRleDecoder dec;
+  dec.begin(W, H, mode == FRAME_RAW);
+  for (size_t at = 0; at < in.size(); at += 1024)
+    if (!dec.feed(&in[at], std::min(in.size() - at, (size_t)1024), runInto, lv.data())) return false;
+  return dec.done();
+}
+
+int main() {
+  std::vector<uint8_t> cal((size_t)W * H), blank((size_t)W * H, 15), noise((size_t)W * H);
+  for (int y = 0; y < H; ++y)
+    for (int x = 0; x < W; ++x) {
+      uint8_t v;
+      if (y < 111)                    v = (x / 3 + y / 5) % 9 < 2 ? 0 : 12;     // header: text on light gray
+      else if (y < 150)               v = (x / 240) & 1 ? 13 : 15;              // forecast ribbon
+      else if ((x % 192) < 6)         v = 8;                                    // card edges
+      else if ((y - 150) % 64 < 18)   v = (x / 2 + y / 3) % 7 < 2 ? 0 : 15;     // event titles
+      else                            v = 15;
+      cal[(size_t)y * W + x] = v;
+      noise[(size_t)y * W + x] = (uint8_t)((x + y) & 1 ? (x * 7 + y) & 15 : ((x * 7 + y) & 15) ^ 8);
+    }
+
+  printf("frame store, %dx%d frame (1 bpp would be %d KB, raw %u KB)\n", W, H, W * H / 8 / 1024,
+         (unsigned)frameRawBytes(W, H) / 1024);
+  int bad = 0;
+  struct { const char* name; const std::vector<uint8_t>* lv; } frames[] = {
+    { "calendar", &cal }, { "blank", &blank }, { "dithered", &noise },
+  };
+  for (auto& fr : frames) {
+    std::vector<uint8_t> file, back((size_t)W * H);
+    uint8_t mode = encode(*fr.lv, file);
+    if (!decode(file, mode, back) || back != *fr.lv) { printf("  %s: decoded frame differs\n", fr.name); ++bad; }
+    if (file.size() > frameRawBytes(W, H)) { printf("  %s: bigger than raw\n", fr.name); ++bad; }
+    printf("  %-40s %9zu B  (%.1f%% of 1 bpp, %s)\n", fr.name, file.size(),
+           file.size() * 800.0 / ((double)W * H), mode == FRAME_RAW ? "raw" : "run-coded");
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s encode", fr.name);
+    double ns = benchNs(10, [&](int) { encode(*fr.lv, file); g_benchSink = file.size(); });
+    benchLine(name, ns);
+    printf("  %-40s %9.1f Mpx/s\n", "  throughput", (double)W * H / ns * 1e3);
+    snprintf(name, sizeof(name), "%s decode", fr.name);
+    ns = benchNs(10, [&](int) { g_benchSink = decode(file, mode, back); });
+    benchLine(name, ns);
+    printf("  %-40s %9.1f Mpx/s\n", "  throughput", (double)W * H / ns * 1e3);
+  }
+  return bad;
+}
@@ -0,0 +1,76 @@
+// Gray packing for a full 960x540 panel frame (GrayRender.h): the LUT
+// packer at 1 and 2 bpp against a direct per-pixel version that works
+// out the level and dither threshold arithmetically, as a first cut would.
+// Both must give the same bits. The frame mixes flat fills, text-like
+// strokes and a gradient, so every path through the dither is taken.
+
+#include <vector>
+#include "GrayRender.h"
+#include "bench.h"
+
+static const int W = 960, H = 540;
+
+// Level below `g` and the dithered step, without tables
+static uint8_t directLevel(uint8_t g, int x, int y, uint8_t bpp) {
+  static const uint8_t lv2[] = { GRAY_V_BLACK, GRAY_V_DARK, GRAY_V_LIGHT, GRAY_V_WHITE };
+  static const uint8_t lv1[] = { GRAY_V_BLACK, GRAY_V_WHITE };
+  const uint8_t* lv = bpp == 2 ? lv2 : lv1;
+  int top = bpp == 2 ? 3 : 1;
+  if (g >= lv[top]) return (uint8_t)top;
+  if (bpp == 1 && (g == GRAY_V_DARK || g == GRAY_V_LIGHT)) return g == GRAY_V_LIGHT;   // flat fills
+  int i = 0;
+  while (i < top - 1 && g >= lv[i + 1]) ++i;
+  int f = (g - lv[i]) * 16 / (lv[i + 1] - lv[i]);
+  f += f * (16 - f) / 48;
+  if (f > 15) f = 15;
+  return (uint8_t)(i + (f > GRAY_CLUSTER[y & 3][x & 3]));
+}
+
+static void directPack(const uint8_t* src, uint8_t bpp, uint8_t* dst) {
+  size_t rowBytes = (size_t)W * bpp / 8;
+  memset(dst, 0, grayPackedSize(W, H, bpp));
+  for (int y = 0; y < H; ++y)
+    for (int x = 0; x < W; ++x) {
+      uint8_t v = directLevel(src[y * W + x], x, y, bpp);
+      int bit = x * bpp;
+      dst[y * rowBytes + bit / 8] |= (uint8_t)(v << (8 - bpp - bit % 8));
+    }
+}
+
+int main() {
+  std::vector<uint8_t> frame((size_t)W * H);
+  for (int y = 0; y < H; ++y)
+    for (int x = 0; x < W; ++x) {
+      uint8_t g;
+      if (y < 60)       g = GRAY_V_LIGHT;                                   // header card
+      else if (y < 300) g = ((x / 3 + y / 5) % 7 < 2) ? GRAY_V_BLACK : GRAY_V_WHITE;   // text
+      else              g = (uint8_t)(x * 255 / (W - 1));                   // chart shading
+      frame[(size_t)y * W + x] = g;
+    }
+
+  printf("gray pack, %dx%d frame (%zu KB 8-bit)\n", W, H, frame.size() / 1024);
+  int bad = 0;
+  for (uint8_t bpp : { 1, 2 }) {
+    GrayLut lut;
+    grayBuildLut(lut, bpp);
+    size_t n = grayPackedSize(W, H, bpp);
+    std::vector<uint8_t> a(n), b(n);
+    grayPack(lut, frame.data(), W, W, H, a.data());
+    directPack(frame.data(), bpp, b.data());
+    if (a != b) { printf("  %d bpp: LUT and direct packs differ\n", bpp); ++bad; }
+    // The light header card is a flat fill: solid at either depth, no halftone
+    uint8_t card = bpp == 2 ? 0xAA : 0xFF;
+    for (size_t k = 0; k < 60 * (size_t)W * bpp / 8; ++k)
+      if (a[k] != card) { printf("  %d bpp: flat light fill dithered\n", bpp); ++bad; break; }
+
+    char name[48];
+    snprintf(name, sizeof(name), "%d bpp direct (%zu KB out)", bpp, n / 1024);
+    benchLine(name, benchNs(5, [&](int) { directPack(frame.data(), bpp, b.data()); g_benchSink = b[n / 2]; }));
+    snprintf(name, sizeof(name), "%d bpp LUT", bpp);
+    double ns = benchNs(20, [&](int) { grayPack(lut, frame.data(), W, W, H, a.data()); g_benchSink = a[n / 2]; });
+    benchLine(name, ns);
+    printf("  %-40s %9.1f Mpx/s\n", "  throughput", (double)W * H / ns * 1e3);
+  }
+  benchLine("LUT build", benchNs(2000, [&](int i) { GrayLut l; grayBuildLut(l, 1 + (i & 1)); g_benchSink = l.frac[100]; }));
+  return bad;
+}
@@ -0,0 +1,89 @@
+// Watchlist state: the columnar InstrumentTable against the String vectors it
+// replaced, at its 200-instrument capacity. A menu frame labels every
+// instrument; a refresh finds a symbol and stores its quote. std::string
+// keeps short symbols inline, so the old side looks better here than
+// Arduino String (always on the heap) does on the device.
+
+#include <string>
+#include <vector>
+#include "InstrumentTable.h"
+#include "bench.h"
+
+// ---- The old way: one String per symbol, type and label worked out per use ----
+static bool endsWithNoCase(const std::string& s, const char* suf) {
+  size_t n = s.size(), m = strlen(suf);
+  if (m > n) return false;
+  for (size_t i = 0; i < m; ++i) if (toupper(s[n - m + i]) != toupper(suf[i])) return false;
+  return true;
+}
+static bool isCryptoSymbol(const std::string& s) { return s.find('-') != std::string::npos && endsWithNoCase(s, "-USD"); }
+static std::string displayLabel(const std::string& s) { return isCryptoSymbol(s) ? s.substr(0, s.size() - 4) : s; }
+static int textWidth(const char* s) { int w = 0; while (*s) w += 9 + (*s++ & 3); return w; }   // stands in for the font
+
+struct OldWatchlist {
+  std::vector<std::string> items;
+  std::vector<float> price, high, low, open, prevClose, change, volume;
+  int find(const std::string& s) const {
+    for (size_t i = 0; i < items.size(); ++i)
+      if (items[i].size() == s.size() && endsWithNoCase(items[i], s.c_str())) return (int)i;
+    return -1;
+  }
+};
+
+int main() {
+  std::vector<std::string> syms;
+  for (int i = 0; i < InstrumentTable::CAP; ++i) {
+    char s[16];
+    if (i % 4 == 0) snprintf(s, sizeof(s), "C%dX-USD", i);
+    else            snprintf(s, sizeof(s), "SYM%d", i);
+    syms.push_back(s);
+  }
+
+  OldWatchlist old;
+  for (auto& s : syms) {
+    old.items.push_back(s);
+    for (auto* v : { &old.price, &old.high, &old.low, &old.open, &old.prevClose, &old.change, &old.volume })
+      v->push_back(0);
+  }
+  static InstrumentTable t;
+  for (auto& s : syms) t.add(s.c_str());
+  for (int i = 0; i < t.count; ++i) t.labelW[i] = (uint16_t)textWidth(t.label[i]);
+
+  printf("instrument table, %d instruments (%zu B)\n", t.count, sizeof(t));
+
+  benchLine("menu frame, String vectors", benchNs(2000, [&](int) {
+    uint64_t acc = 0;
+    for (auto& s : old.items) { std::string l = displayLabel(s); acc += textWidth(l.c_str()) + isCryptoSymbol(s); }
+    g_benchSink = acc;
+  }));
+  benchLine("menu frame, table", benchNs(2000, [&](int) {
+    uint64_t acc = 0;
+    for (int i = 0; i < t.count; ++i) acc += t.labelW[i] + t.type[i] + (uint8_t)t.label[i][0];
+    g_benchSink = acc;
+  }));
+
+  benchLine("find + quote, String vectors", benchNs(20000, [&](int i) {
+    int id = old.find(syms[(i * 37) % syms.size()]);
+    old.price[id] = (float)i; old.high[id] = (float)i + 1; old.low[id] = (float)i - 1;
+    g_benchSink = id;
+  }));
+  benchLine("find + quote, table", benchNs(20000, [&](int i) {
+    int id = t.find(syms[(i * 37) % syms.size()].c_str());
+    t.setQuote(id, (float)i, (float)i + 1, (float)i - 1, 0, 0, 0, 0, (uint32_t)i);
+    g_benchSink = id;
+  }));
+  benchLine("quote by id, table", benchNs(200000, [&](int i) {
+    int id = (i * 37) % t.count;
+    t.setQuote(id, (float)i, (float)i + 1, (float)i - 1, 0, 0, 0, 0, (uint32_t)i);
+    t.clean(id);
+    g_benchSink = t.dirty[id];
+  }));
+
+  benchLine("dirty scan, table", benchNs(20000, [&](int i) {
+    t.dirty[i % t.count] |= INSTR_DIRTY_PRICE;
+    int n = 0;
+    for (int k = 0; k < t.count; ++k) if (t.dirty[k] & INSTR_DIRTY_PRICE) { n++; t.clean(k); }
+    g_benchSink = n;
+  }));
+  return 0;
+}
@@ -0,0 +1,58 @@
+// Decode cost per response: the filtered fixed documents (QuoteDecode.h)
+// against what they replaced, a String copy of the body parsed whole into a
+// 16-32 KB DynamicJsonDocument. Needs ArduinoJson (see the Makefile).
+
+#include <stdio.h>
+#include <string>
+#include "QuoteDecode.h"
+#include "bench.h"
+
+static std::string slurp(const char* path) {
+  std::string s;
+  FILE* f = fopen(path, "rb");
+  if (!f) return s;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) s.append(buf, n);
+  fclose(f);
+  return s;
+}
+
+template <class Doc, class Filter>
+static void row(const char* label, const std::string& body, size_t oldDoc, Filter&& makeFilter) {
+  printf("%s: %zu B body\n", label, body.size());
+  Doc probe;
+  {
+    StaticJsonDocument<384> filter; makeFilter(filter);
+    deserializeJson(probe, body.data(), body.size(), DeserializationOption::Filter(filter));
+  }
+  DynamicJsonDocument whole(oldDoc);
+  deserializeJson(whole, body.data(), body.size());
+  printf("  memory: fixed %zu B doc (%zu used), was %zu B copy + %zu B doc (%zu used)\n",
+         probe.capacity(), probe.memoryUsage(), body.size(), oldDoc, whole.memoryUsage());
+
+  benchLine("filtered, fixed document", benchNs(2000, [&](int) {
+    StaticJsonDocument<384> filter; makeFilter(filter);
+    Doc doc;
+    deserializeJson(doc, body.data(), body.size(), DeserializationOption::Filter(filter));
+    g_benchSink = doc.memoryUsage();
+  }));
+  benchLine("String copy, whole document", benchNs(2000, [&](int) {
+    std::string copy(body);                     // http.getString()
+    DynamicJsonDocument doc(oldDoc);
+    deserializeJson(doc, copy);
+    g_benchSink = doc.memoryUsage();
+  }));
+}
+
+int main() {
+  row<FinnhubQuoteDoc>("finnhub quote", slurp("data/finnhub_quote.json"), 1024,
+                       [](JsonDocument& f) { finnhubQuoteFilter(f); });
+  row<CoindeskTickDoc>("coindesk tick", slurp("data/coindesk_tick.json"), 32 * 1024,
+                       [](JsonDocument& f) { coindeskTickFilter(f, "BTC-USD"); });
+  row<FinnhubCandleDoc>("finnhub candle", slurp("data/finnhub_candle.json"), 16 * 1024,
+                        [](JsonDocument& f) { finnhubCandleFilter(f); });
+  row<FinnhubNameDoc>("finnhub profile", slurp("data/finnhub_profile.json"), 4096,
+                      [](JsonDocument& f) { finnhubNameFilter(f); });
+  return 0;
+}
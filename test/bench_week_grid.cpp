@@ -0,0 +1,85 @@
+// Week grid layout cost (WeekGrid.h). gridLayout's sweep with a min-heap
+// against the plain way: each event scans every earlier one for the columns
+// still taken, O(n^2). Days from 10 to 5,000 events, plus a whole week of
+// 1,000 events cut over the columns and laid out, as weekLayout does.
+
+#include <string.h>
+#include <vector>
+#include "WeekGrid.h"
+#include "bench.h"
+
+static uint32_t g_seed = 777;
+static int rnd(int n) { g_seed = g_seed * 1103515245u + 12345u; return (int)((g_seed >> 8) % (uint32_t)n); }
+
+// ---- The plain way ----
+static void naiveLayout(GridItem* it, int n) {
+  std::sort(it, it + n, [](const GridItem& a, const GridItem& b) {
+    return a.start != b.start ? a.start < b.start : a.end > b.end;
+  });
+  std::vector<uint8_t> taken;
+  for (int i = 0; i < n; ++i) {
+    taken.assign(256, 0);
+    for (int j = 0; j < i; ++j) if (it[j].end > it[i].start) taken[it[j].col] = 1;
+    int c = 0;
+    while (c < 254 && taken[c]) c++;
+    it[i].col = (uint8_t)c;
+  }
+  for (int a = 0; a < n; ) {
+    int b = a + 1, end = it[a].end, cols = it[a].col + 1;
+    while (b < n && it[b].start < end) { end = std::max(end, (int)it[b].end); cols = std::max(cols, it[b].col + 1); b++; }
+    for (int k = a; k < b; ++k) it[k].cols = (uint8_t)cols;
+    a = b;
+  }
+}
+
+static std::vector<GridItem> day(int n) {
+  std::vector<GridItem> it;
+  for (int k = 0; k < n; ++k) {
+    int s = 7 * 60 + rnd(15 * 60 - 30), len = 15 + rnd(rnd(4) ? 75 : 240);
+    it.push_back({ (int16_t)s, (int16_t)std::min(s + len, 22 * 60), (uint16_t)k, 0, 0 });
+  }
+  return it;
+}
+
+int main() {
+  printf("week grid layout\n");
+  for (int n : { 10, 100, 1000, 5000 }) {
+    std::vector<GridItem> src = day(n), work(n), check(n);
+    int iters = n >= 1000 ? 20 : 2000;
+    char name[64];
+    snprintf(name, sizeof(name), "%d events, sweep + heap", n);
+    benchLine(name, benchNs(iters, [&](int) {
+      memcpy(work.data(), src.data(), n * sizeof(GridItem));
+      g_benchSink = gridLayout(work.data(), n);
+    }));
+    snprintf(name, sizeof(name), "%d events, scan earlier (n^2)", n);
+    benchLine(name, benchNs(n >= 1000 ? 2 : iters, [&](int) {
+      memcpy(check.data(), src.data(), n * sizeof(GridItem));
+      naiveLayout(check.data(), n);
+      g_benchSink = check[0].cols;
+    }, n >= 1000 ? 2 : 5));
+    bool same = true;
+    for (int k = 0; k < n; ++k) same = same && work[k].col == check[k].col && work[k].cols == check[k].cols;
+    if (!same) printf("  !! %d events: the two layouts differ\n", n);
+  }
+
+  // A week: 1,000 events, some past midnight, some all-day or days long
+  std::vector<WeekSpan> evs;
+  for (int k = 0; k < 1000; ++k) {
+    int32_t d = 20000 + rnd(9) - 1;
+    int s = rnd(24 * 60), len = rnd(10) ? 15 + rnd(180) : 60 * (4 + rnd(60));
+    int32_t e = d * 1440 + s + len;
+    evs.push_back({ d, e / 1440, (int16_t)s, (int16_t)(e % 1440), rnd(12) == 0, (uint16_t)k });
+  }
+  const WeekHours hrs = { 7 * 60, 22 * 60, 20 };
+  std::vector<GridItem> band, timed[7];
+  benchLine("week of 1000 events, cut + laid out", benchNs(200, [&](int) {
+    band.clear();
+    for (auto& t : timed) t.clear();
+    for (const WeekSpan& ev : evs) weekPlace(ev, 20000, 7, hrs, band, timed);
+    int w = gridLayout(band.data(), (int)band.size());
+    for (auto& t : timed) w += gridLayout(t.data(), (int)t.size());
+    g_benchSink = w;
+  }));
+  return 0;
+}
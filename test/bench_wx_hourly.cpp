@@ -0,0 +1,103 @@
+// Weather fetch cost (WxHourly.h): one /forecast reply decoded through the
+// filter into the packed hourly timeline, against the two requests it
+// replaced. The old path took a String copy of /weather and of /forecast
+// and parsed each whole (8 KB and 64 KB documents), then kept daily hi/lo
+// and a condition name. Recorded replies in data/owm_*.json stand in for
+// the socket. Needs ArduinoJson (see the Makefile).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "WxHourly.h"
+#include "bench.h"
+
+static std::string slurp(const char* path) {
+  std::string s;
+  FILE* f = fopen(path, "rb");
+  if (!f) return s;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) s.append(buf, n);
+  fclose(f);
+  return s;
+}
+
+// ---- The old way: what fetchWeather() kept ----
+struct OldDay { int y, m, d, hi, lo; std::string cond; };
+struct OldWx  { int t, hi, lo; std::string cond; OldDay day[7]; int days; };
+
+static bool oldFetch(const std::string& weather, const std::string& forecast, OldWx& wx, size_t* used) {
+  {
+    std::string body(weather);                    // http.getString()
+    DynamicJsonDocument d1(8 * 1024);
+    if (deserializeJson(d1, body)) return false;
+    wx.t    = int(d1["main"]["temp"].as<float>() + 0.5f);
+    wx.cond = d1["weather"][0]["main"].as<std::string>();
+    if (used) used[0] = d1.memoryUsage();
+  }
+  std::string body(forecast);
+  DynamicJsonDocument d2(64 * 1024);
+  if (deserializeJson(d2, body)) return false;
+  if (used) used[1] = d2.memoryUsage();
+  uint32_t keys[7];
+  wx.days = 0;
+  for (JsonObject item : d2["list"].as<JsonArray>()) {
+    time_t ts = item["dt"].as<long>();
+    struct tm lt; localtime_r(&ts, &lt);
+    uint32_t key = (uint32_t)((lt.tm_year + 1900) * 10000 + (lt.tm_mon + 1) * 100 + lt.tm_mday);
+    int s = 0;
+    while (s < wx.days && keys[s] != key) s++;
+    if (s == wx.days) {
+      if (wx.days >= 7) continue;
+      keys[s] = key; wx.days++;
+      wx.day[s] = { lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday, -999, 999, "" };
+    }
+    float tmin = item["main"]["temp_min"].as<float>(), tmax = item["main"]["temp_max"].as<float>();
+    if (tmax > wx.day[s].hi) wx.day[s].hi = int(tmax + 0.5f);
+    if (tmin < wx.day[s].lo) wx.day[s].lo = int(tmin + 0.5f);
+    std::string cond = item["weather"][0]["main"].as<std::string>();
+    if ((lt.tm_hour >= 11 && lt.tm_hour <= 14) || wx.day[s].cond.empty()) wx.day[s].cond = cond;
+  }
+  wx.hi = wx.days ? wx.day[0].hi : wx.t;
+  wx.lo = wx.days ? wx.day[0].lo : wx.t;
+  return true;
+}
+
+int main() {
+  setenv("TZ", "EST5EDT,M3.2.0,M11.1.0", 1);
+  tzset();
+  std::string weather = slurp("data/owm_weather.json"), forecast = slurp("data/owm_forecast.json");
+  if (weather.empty() || forecast.empty()) { printf("wx hourly: fixtures missing\n"); return 1; }
+
+  static WxTimeline tl;
+  OldWx old;
+  size_t oldUsed[2] = { 0, 0 };
+  bool okNew = wxParseForecast(forecast.c_str(), tl), okOld = oldFetch(weather, forecast, old, oldUsed);
+  WxDay days[7];
+  int n = wxDays(tl, days, 7);
+  printf("weather: %d hours (%zu B timeline) from %zu B; old path %d days from %zu B in 2 requests\n",
+         tl.count, sizeof(tl.hour), forecast.size(), old.days, weather.size() + forecast.size());
+  printf("  documents: filtered %zu B capacity, old %u + %u B used of 8 + 64 KB, plus %zu B of String copies\n",
+         WX_DOC_BYTES, (unsigned)oldUsed[0], (unsigned)oldUsed[1], weather.size() + forecast.size());
+
+  // Same days, same highs and lows within the rounding of interpolated hours
+  int bad = !okNew || !okOld || n < 5;
+  for (int i = 0; i < n && i < old.days; ++i)
+    if (days[i].d != old.day[i].d || abs(days[i].hi - old.day[i].hi) > 1 || days[i].lo < old.day[i].lo - 1) {
+      printf("  day %d: timeline %d/%d, old %d/%d\n", days[i].d, days[i].hi, days[i].lo, old.day[i].hi, old.day[i].lo);
+      bad++;
+    }
+
+  benchLine("timeline: 1 reply, filtered", benchNs(200, [&](int) {
+    g_benchSink = wxParseForecast(forecast.c_str(), tl) + tl.count;
+  }));
+  benchLine("  + daily summary from the timeline", benchNs(2000, [&](int) {
+    WxDay d[7];
+    g_benchSink = wxDays(tl, d, 7);
+  }));
+  benchLine("old: 2 replies, String copies, whole docs", benchNs(200, [&](int) {
+    OldWx w;
+    g_benchSink = oldFetch(weather, forecast, w, nullptr) + w.days;
+  }));
+  return bad;
+}
@@ -0,0 +1,18 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// ---------- Host test helpers ----------
+// Each test is one program: CHECKs count failures, main() returns checkDone().
+
+static int g_checks = 0, g_failed = 0;
+
+#define CHECK(c) do { ++g_checks; if (!(c)) { ++g_failed; printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); } } while (0)
+
+inline int checkDone(const char* name) {
+  printf("%s: %d checks, %d failed\n", name, g_checks, g_failed);
+  return g_failed ? 1 : 0;
+}
+
+#endif // CHECK_H
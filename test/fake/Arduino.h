@@ -0,0 +1,39 @@
+#ifndef FAKE_ARDUINO_H
+#define FAKE_ARDUINO_H
+
+// ---------- Host stand-in for the Arduino core ----------
+// Only what the SD-backed headers under test use: String, Serial.printf.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <string>
+
+struct String {
+  std::string s;
+  String() {}
+  String(const char* c) : s(c ? c : "") {}
+  String(const std::string& v) : s(v) {}
+  const char* c_str() const { return s.c_str(); }
+  size_t length() const { return s.size(); }
+  String operator+(const char* c) const { return String(s + c); }
+  String operator+(const String& o) const { return String(s + o.s); }
+  bool operator==(const String& o) const { return s == o.s; }
+  bool operator<(const String& o) const { return s < o.s; }
+};
+
+struct FakeSerial {
+  bool quiet = true;               // tests turn it on to see the sketch's log
+  int printf(const char* fmt, ...) {
+    if (quiet) return 0;
+    va_list ap; va_start(ap, fmt);
+    int n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+  }
+  void println(const char* s) { if (!quiet) puts(s); }
+};
+static FakeSerial Serial;
+
+#endif // FAKE_ARDUINO_H
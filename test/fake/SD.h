@@ -0,0 +1,80 @@
+#ifndef FAKE_SD_H
+#define FAKE_SD_H
+
+// ---------- Host stand-in for the SD library ----------
+// Files are byte vectors in a map. `writeBudget` cuts writes short after
+// that many more bytes, the way a power cut leaves a torn record; -1 = no
+// limit.
+
+#include <map>
+#include <memory>
+#include <vector>
+#include "Arduino.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+typedef std::vector<uint8_t> FakeBytes;
+
+class File {
+ public:
+  File() {}
+  File(std::shared_ptr<FakeBytes> d, size_t pos, long* budget) : data(d), pos(pos), budget(budget) {}
+  explicit operator bool() const { return (bool)data; }
+
+  int read() { return pos < data->size() ? (*data)[pos++] : -1; }
+  int read(uint8_t* buf, size_t n) {
+    size_t k = pos < data->size() ? data->size() - pos : 0;
+    if (k > n) k = n;
+    memcpy(buf, data->data() + pos, k);
+    pos += k;
+    return (int)k;
+  }
+  size_t write(const uint8_t* buf, size_t n) {
+    if (*budget >= 0 && (long)n > *budget) n = (size_t)*budget;
+    if (*budget >= 0) *budget -= (long)n;
+    if (pos + n > data->size()) data->resize(pos + n);
+    memcpy(data->data() + pos, buf, n);
+    pos += n;
+    return n;
+  }
+  size_t write(uint8_t b) { return write(&b, 1); }
+  int    available() const { return (int)(data->size() - pos); }
+  size_t size() const { return data->size(); }
+  size_t position() const { return pos; }
+  void   close() { data.reset(); }
+
+ private:
+  std::shared_ptr<FakeBytes> data;
+  size_t pos = 0;
+  long*  budget = nullptr;
+};
+
+struct FakeSD {
+  std::map<std::string, std::shared_ptr<FakeBytes>> files;
+  std::map<std::string, bool> dirs;
+  long writeBudget = -1;
+
+  bool exists(const char* p) { return files.count(p) || dirs.count(p); }
+  bool mkdir(const char* p) { dirs[p] = true; return true; }
+  bool remove(const char* p) { return files.erase(p) > 0; }
+  bool rename(const char* a, const char* b) {
+    auto it = files.find(a);
+    if (it == files.end()) return false;
+    files[b] = it->second;
+    files.erase(it);
+    return true;
+  }
+  File open(const char* p, const char* mode) {
+    auto it = files.find(p);
+    if (*mode == 'r') return it == files.end() ? File() : File(it->second, 0, &writeBudget);
+    if (*mode == 'w' || it == files.end()) files[p] = std::make_shared<FakeBytes>();
+    auto& d = files[p];
+    return File(d, *mode == 'a' ? d->size() : 0, &writeBudget);
+  }
+  size_t sizeOf(const char* p) { auto it = files.find(p); return it == files.end() ? 0 : it->second->size(); }
+};
+static FakeSD SD;
+
+#endif // FAKE_SD_H
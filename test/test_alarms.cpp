@@ -0,0 +1,184 @@
+// Timer wheel and alarm recurrence against a virtual clock (Scheduler.h,
+// Alarms.h). The clock only moves when the test moves it, so stalls, sleeps
+// and DST changes can be stepped through second by second.
+
+#include <stdlib.h>
+#include <vector>
+#include "Scheduler.h"
+#include "Alarms.h"
+#include "check.h"
+
+struct Fired { int tag; int64_t due, now; };
+static std::vector<Fired> g_fired;
+
+static void record(void* ctx, int64_t due, int64_t now) { g_fired.push_back({ (int)(intptr_t)ctx, due, now }); }
+
+static time_t local(int y, int mo, int d, int h, int mi, int s = 0) {
+  struct tm t = {};
+  t.tm_year = y - 1900; t.tm_mon = mo - 1; t.tm_mday = d;
+  t.tm_hour = h; t.tm_min = mi; t.tm_sec = s; t.tm_isdst = -1;
+  return mktime(&t);
+}
+
+static void testWheel() {
+  TimerWheel w;
+  const int64_t T0 = 1760000000;
+  w.advance(T0);
+
+  // One-shots fire once, on their second, in deadline order
+  g_fired.clear();
+  w.add(T0 + 5, 0, record, (void*)1);
+  w.add(T0 + 3, 0, record, (void*)2);
+  w.add(T0 + 3 + TimerWheel::SLOTS, 0, record, (void*)3);   // same slot, next lap
+  for (int64_t t = T0 + 1; t <= T0 + 10; ++t) w.advance(t);
+  CHECK(g_fired.size() == 2);
+  CHECK(g_fired.size() == 2 && g_fired[0].tag == 2 && g_fired[0].now == T0 + 3);
+  CHECK(g_fired.size() == 2 && g_fired[1].tag == 1 && g_fired[1].now == T0 + 5);
+  for (int64_t t = T0 + 11; t <= T0 + 80; ++t) w.advance(t);
+  CHECK(g_fired.size() == 3 && g_fired[2].tag == 3 && g_fired[2].now == T0 + 3 + TimerWheel::SLOTS);
+
+  // A stalled loop: everything due meanwhile fires late, oldest first, none skipped
+  g_fired.clear();
+  int64_t t = T0 + 100;
+  w.advance(t);
+  for (int k = 1; k <= 10; ++k) w.add(t + k * 7, 0, record, (void*)(intptr_t)k);
+  t += 500;                                     // several laps of the wheel in one call
+  CHECK(w.advance(t) == 10);
+  bool ordered = g_fired.size() == 10;
+  for (size_t k = 1; ordered && k < g_fired.size(); ++k) ordered = g_fired[k - 1].due <= g_fired[k].due;
+  CHECK(ordered);
+
+  // A periodic job keeps its phase across a stall and does not fire per missed period
+  g_fired.clear();
+  int id = w.add((t / 60 + 1) * 60, 60, record, (void*)9);
+  int64_t first = w.dueOf(id);
+  w.advance(first);
+  w.advance(first + 60 * 5 + 17);               // asleep through five minutes
+  CHECK(g_fired.size() == 2);
+  CHECK(w.dueOf(id) == first + 60 * 6);
+  CHECK(w.dueOf(id) % 60 == 0);
+
+  // Stale ids do not cancel a job that reused the slot
+  CHECK(w.cancel(id));
+  int reuse = w.add(t + 1000, 0, record, (void*)10);
+  CHECK(!w.cancel(id));
+  CHECK(w.dueOf(reuse) == t + 1000);
+  CHECK(w.cancel(reuse));
+
+  // The clock going back re-bases instead of replaying or stalling
+  g_fired.clear();
+  int64_t now = first + 60 * 6;
+  w.advance(now);
+  w.add(now + 2, 0, record, (void*)11);
+  w.advance(now - 3600);                        // SNTP correction
+  for (int64_t s = now - 3600 + 1; s <= now + 2; s += 600) w.advance(s);
+  w.advance(now + 2);
+  CHECK(g_fired.size() == 1 && g_fired[0].tag == 11);
+
+  // nextDue() sees the earliest pending deadline
+  w.clear();
+  w.advance(T0);
+  w.add(T0 + 400, 0, record, nullptr);
+  w.add(T0 + 90, 0, record, nullptr);
+  CHECK(w.nextDue() == T0 + 90);
+
+  // Jobs added before the first advance (setup(), before SNTP) that are
+  // already overdue fire on that first call, whatever slot they sit in
+  w.clear();
+  g_fired.clear();
+  w.add(T0 - 40, 0, record, (void*)12);
+  w.add(T0 - 1, 0, record, (void*)13);
+  w.add(T0 + 5, 0, record, (void*)14);
+  CHECK(w.advance(T0) == 2);
+  CHECK(g_fired.size() == 2 && g_fired[0].tag == 12 && g_fired[1].tag == 13 && g_fired[1].now == T0);
+  w.advance(T0 + 5);
+  CHECK(g_fired.size() == 3 && g_fired[2].tag == 14);
+}
+
+// The sketch's arm / fire / re-arm cycle, driven for weeks of virtual time
+struct Armed { TimerWheel* w; Alarm* a; int fires; std::vector<time_t> at; };
+
+static void arm(Armed& s, time_t now);
+
+static void onAlarm(void* ctx, int64_t due, int64_t now) {
+  Armed& s = *(Armed*)ctx;
+  s.a->jobId = -1;
+  s.fires++;
+  s.at.push_back((time_t)due);
+  if (s.a->days == ALARM_ONCE) s.a->enabled = false;
+  else arm(s, (time_t)now);
+}
+
+static void arm(Armed& s, time_t now) {
+  s.w->cancel(s.a->jobId);
+  s.a->jobId = -1;
+  if (!s.a->enabled) return;
+  time_t at = alarmNextFire(*s.a, now);
+  if (at > 0) s.a->jobId = s.w->add(at, 0, onAlarm, &s);
+}
+
+static void testRecurrence() {
+  setenv("TZ", "EST5EDT,M3.2.0,M11.1.0", 1);
+  tzset();
+
+  Alarm a;
+  CHECK(alarmParseLine("07:30 weekdays on", a) && a.days == ALARM_WEEKDAYS && a.enabled);
+  CHECK(alarmParseLine("06:45 mon,tue,thu on", a) && a.days == (ALARM_MON | ALARM_TUE | ALARM_THU));
+  CHECK(alarmParseLine("08:00", a) && a.days == ALARM_ONCE && a.enabled);
+  CHECK(alarmParseLine("9:05 Weekends off", a) && a.days == ALARM_WEEKENDS && !a.enabled);
+  CHECK(!alarmParseLine("24:00 daily on", a));
+
+  // Next fire: strictly after now, on an allowed day
+  Alarm wd = { 7, 30, ALARM_WEEKDAYS, true, -1 };
+  time_t fri = local(2026, 10, 16, 7, 30);      // a Friday
+  CHECK(alarmNextFire(wd, fri - 1) == fri);
+  CHECK(alarmNextFire(wd, fri) == local(2026, 10, 19, 7, 30));   // skips the weekend
+  Alarm once = { 23, 59, ALARM_ONCE, true, -1 };
+  CHECK(alarmNextFire(once, local(2026, 10, 16, 23, 59, 30)) == local(2026, 10, 17, 23, 59));
+
+  // Across DST: the alarm stays on local 07:30, so the gap is 23 h or 25 h
+  Alarm daily = { 7, 30, ALARM_DAILY, true, -1 };
+  time_t before = local(2026, 3, 7, 7, 30);
+  CHECK(alarmNextFire(daily, before) - before == 23 * 3600);
+  before = local(2026, 10, 31, 7, 30);
+  CHECK(alarmNextFire(daily, before) - before == 25 * 3600);
+  // A time that does not exist on the spring-forward day still fires once that day
+  Alarm gap = { 2, 30, ALARM_DAILY, true, -1 };
+  time_t t = alarmNextFire(gap, local(2026, 3, 8, 0, 0));
+  struct tm lt; localtime_r(&t, &lt);
+  CHECK(lt.tm_mday == 8 && lt.tm_mon == 2);
+
+  // Three weeks, one-minute loop steps with a few long stalls: every weekday
+  // fires exactly once, at 07:30 local, never on a weekend
+  TimerWheel w;
+  Alarm al = { 7, 30, ALARM_WEEKDAYS, true, -1 };
+  Armed s = { &w, &al, 0, {} };
+  time_t now = local(2026, 10, 4, 12, 0);       // Sunday noon
+  w.advance(now);
+  arm(s, now);
+  time_t end = now + 21 * 86400;
+  while (now < end) {
+    now += (now / 3600) % 29 == 0 ? 5400 : 60;  // sometimes stuck for 90 minutes
+    w.advance(now);
+  }
+  CHECK(s.fires == 15);
+  bool onTime = true;
+  for (time_t f : s.at) {
+    struct tm ft; localtime_r(&f, &ft);
+    onTime = onTime && ft.tm_hour == 7 && ft.tm_min == 30 && ft.tm_wday >= 1 && ft.tm_wday <= 5;
+  }
+  CHECK(onTime);
+
+  // A one-shot fires once and switches itself off
+  Alarm one = { 6, 0, ALARM_ONCE, true, -1 };
+  Armed o = { &w, &one, 0, {} };
+  arm(o, now);
+  for (int k = 0; k < 3 * 1440; ++k) w.advance(now += 60);
+  CHECK(o.fires == 1 && !one.enabled && one.jobId == -1);
+}
+
+int main() {
+  testWheel();
+  testRecurrence();
+  return checkDone("alarms");
+}
@@ -0,0 +1,150 @@
+// Alert rules against a replayed price tape (AlertEngine.h). The rules are
+// parsed from an ALERTS.txt as the sketch reads it; the tape walks each
+// symbol up to, around and back through its levels, and the test asserts
+// exactly which rules fire, in which direction and on which tick.
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include "AlertEngine.h"
+#include "check.h"
+
+static const char* ALERTS_TXT =
+  "# watchlist alerts\n"
+  "BTC-USD above 70000\n"           // band 350
+  "AAPL    below 180 1.5\n"
+  "ETH-USD cross 3000 10\n"
+  "TSLA    move  5\n"
+  "\n"
+  "  # indented comment\n"
+  "MSFT sideways 400\n"             // unknown kind
+  "NVDA above\n"                    // no level
+  "DOGE-USD above 1\n"              // not on the watchlist
+  "AAPL above 200\n";               // second rule, same symbol
+
+// What alertsLoadFromSD does, from a string
+static int loadRules(AlertBook& book, const InstrumentTable& t, const char* text, int& skipped) {
+  book.count = 0; skipped = 0;
+  std::string all(text);
+  size_t at = 0;
+  while (at < all.size()) {
+    size_t nl = all.find('\n', at);
+    std::string line = all.substr(at, nl == std::string::npos ? std::string::npos : nl - at);
+    at = nl == std::string::npos ? all.size() : nl + 1;
+    char sym[InstrumentTable::SYM_LEN]; uint8_t kind; float level, band;
+    if (!alertParseLine(line.c_str(), sym, sizeof(sym), kind, level, band)) continue;
+    int id = t.find(sym);
+    if (id < 0 || !book.add(id, kind, level, band)) ++skipped;
+  }
+  book.build();
+  return book.count;
+}
+
+struct Tick { const char* sym; float price, changePct; };
+struct Hit  { int tick; const char* sym; uint8_t kind; int dir; };
+
+static void testParse() {
+  char sym[InstrumentTable::SYM_LEN]; uint8_t kind; float level, band;
+  CHECK(alertParseLine("AAPL below 180 1.5", sym, sizeof(sym), kind, level, band));
+  CHECK(!strcmp(sym, "AAPL") && kind == ALERT_BELOW && level == 180 && band == 1.5f);
+  CHECK(alertParseLine("\tBTC-USD cross 65000", sym, sizeof(sym), kind, level, band));
+  CHECK(kind == ALERT_CROSS && band == -1);
+  CHECK(!alertParseLine("", sym, sizeof(sym), kind, level, band));
+  CHECK(!alertParseLine("# AAPL above 1", sym, sizeof(sym), kind, level, band));
+  CHECK(!alertParseLine("AAPL near 180", sym, sizeof(sym), kind, level, band));
+  CHECK(!alertParseLine("AAPL above x", sym, sizeof(sym), kind, level, band));
+}
+
+static void testReplay() {
+  InstrumentTable t;
+  const char* WATCH[] = { "AAPL", "MSFT", "NVDA", "TSLA", "BTC-USD", "ETH-USD" };
+  for (const char* s : WATCH) t.add(s);
+
+  AlertBook book;
+  int skipped;
+  CHECK(loadRules(book, t, ALERTS_TXT, skipped) == 5);
+  CHECK(skipped == 1);                                  // DOGE-USD
+  CHECK(book.rulesFor(t.find("AAPL")) == 2);
+  CHECK(book.rulesFor(t.find("MSFT")) == 0);
+  CHECK(book.rulesFor(t.find("BTC-USD")) == 1);
+  CHECK(book.rule[book.start[t.find("BTC-USD")]].band == 350);     // 0.5 % default
+
+  static const Tick TAPE[] = {
+    // BTC: up through 70000 once; jitter inside the band does not re-fire
+    { "BTC-USD", 69000, 0 }, { "BTC-USD", 70000, 0 },      // 1: above
+    { "BTC-USD", 69800, 0 }, { "BTC-USD", 70100, 0 },
+    { "BTC-USD", 69600, 0 },                               // below level - band: re-armed
+    { "BTC-USD", 70500, 0 },                               // 5: above again
+    // AAPL: down to 180, bounce inside 181.5, then out and back
+    { "AAPL", 185, 0 }, { "AAPL", 179.9f, 0 },             // 7: below
+    { "AAPL", 181, 0 }, { "AAPL", 179, 0 },
+    { "AAPL", 182, 0 }, { "AAPL", 180, 0 },                // 11: below
+    { "AAPL", 201, 0 },                                    // 12: the other AAPL rule
+    // ETH: the first quote only tells the side; crossings either way fire
+    { "ETH-USD", 2950, 0 }, { "ETH-USD", 3005, 0 },        // inside the band: nothing
+    { "ETH-USD", 3011, 0 },                                // 15: up
+    { "ETH-USD", 2995, 0 }, { "ETH-USD", 3008, 0 },
+    { "ETH-USD", 2980, 0 },                                // 18: down
+    // TSLA: day change, either sign
+    { "TSLA", 250, 2 }, { "TSLA", 262, 5.2f },             // 20: move up
+    { "TSLA", 261, 4.7f }, { "TSLA", 250, 4.4f },          // re-armed below 4.5
+    { "TSLA", 236, -5.5f },                                // 23: move down
+    // No rules: evaluated as nothing
+    { "MSFT", 420, 9 }, { "NVDA", 1, -50 },
+  };
+  static const Hit WANT[] = {
+    { 1, "BTC-USD", ALERT_ABOVE, 1 }, { 5, "BTC-USD", ALERT_ABOVE, 1 },
+    { 7, "AAPL", ALERT_BELOW, -1 },   { 11, "AAPL", ALERT_BELOW, -1 }, { 12, "AAPL", ALERT_ABOVE, 1 },
+    { 15, "ETH-USD", ALERT_CROSS, 1 }, { 18, "ETH-USD", ALERT_CROSS, -1 },
+    { 20, "TSLA", ALERT_MOVE, 1 },    { 23, "TSLA", ALERT_MOVE, -1 },
+  };
+
+  std::vector<Hit> got;
+  for (int k = 0; k < (int)(sizeof(TAPE) / sizeof(TAPE[0])); ++k) {
+    int id = t.find(TAPE[k].sym);
+    AlertHit hits[4];
+    int n = book.onQuote(id, TAPE[k].price, TAPE[k].changePct, hits, 4);
+    for (int i = 0; i < n; ++i) {
+      CHECK(hits[i].id == id);                          // only this symbol's rules
+      got.push_back({ k, t.symbol[hits[i].id], hits[i].kind, hits[i].dir });
+    }
+  }
+  size_t want = sizeof(WANT) / sizeof(WANT[0]);
+  CHECK(got.size() == want);
+  for (size_t i = 0; i < got.size() && i < want; ++i) {
+    CHECK(got[i].tick == WANT[i].tick);
+    CHECK(!strcmp(got[i].sym, WANT[i].sym));
+    CHECK(got[i].kind == WANT[i].kind && got[i].dir == WANT[i].dir);
+    if (got[i].tick != WANT[i].tick) printf("  hit %zu: tick %d, wanted %d\n", i, got[i].tick, WANT[i].tick);
+  }
+
+  // Bad input is ignored, and the output cap is honoured
+  AlertHit one[1];
+  CHECK(book.onQuote(-1, 100, 0, one, 1) == 0);
+  CHECK(book.onQuote(InstrumentTable::CAP, 100, 0, one, 1) == 0);
+  CHECK(book.onQuote(t.find("AAPL"), 0, 0, one, 1) == 0);
+}
+
+// A full book: every rule lands, and a quote sees only its own
+static void testFullBook() {
+  InstrumentTable t;
+  char s[8];
+  for (int i = 0; i < 32; ++i) { snprintf(s, sizeof(s), "S%d", i); t.add(s); }
+  AlertBook book;
+  for (int i = 0; i < AlertBook::MAX; ++i) CHECK(book.add((i * 7) % 32, ALERT_ABOVE, 100.0f + i));
+  CHECK(!book.add(0, ALERT_ABOVE, 1));
+  book.build();
+  int total = 0, sorted = 1;
+  for (int id = 0; id < 32; ++id) total += book.rulesFor(id);
+  for (int i = 1; i < book.count; ++i) if (book.rule[i - 1].id > book.rule[i].id) sorted = 0;
+  CHECK(total == AlertBook::MAX && sorted);
+  AlertHit hits[8];
+  CHECK(book.onQuote(0, 1000, 0, hits, 8) == book.rulesFor(0));
+}
+
+int main() {
+  testParse();
+  testReplay();
+  testFullBook();
+  return checkDone("alert engine");
+}
@@ -0,0 +1,247 @@
+// App switches replayed through the app host (AppHost.h) against a fake
+// heap. Stand-ins for the firmware's apps allocate the way the real ones
+// do: a calendar home that frees its fonts and marquees on suspend and its
+// events on teardown, a stocks app that keeps its tables until teardown,
+// and a leaky one that forgets its canvas on suspend. The host's numbers
+// must show the leak and only the leak, and closing an app must give the
+// heap back to where it was before its first open.
+
+#include <stdint.h>
+#include "AppHost.h"
+#include "check.h"
+
+// ---------- Fake heap and clock ----------
+static const uint32_t HEAP = 300 * 1024;
+static uint32_t g_used = 0, g_ms = 0;
+
+static uint32_t fakeFree() { return HEAP - g_used; }
+static uint32_t fakeMs() { return g_ms; }
+
+// One allocation of `bytes`, dropped again by drop()
+struct Block {
+  uint32_t bytes = 0;
+  void take(uint32_t n) { if (!bytes) { bytes = n; g_used += n; } }
+  void drop() { g_used -= bytes; bytes = 0; }
+};
+
+// ---------- Stand-in apps ----------
+struct FakeApp {
+  uint32_t kept, shown;   // held from init to teardown; only while in front
+  Block    state, screen;
+  int      inits = 0, resumes = 0, suspends = 0, teardowns = 0;
+  int      ticksLeft = -1;     // tick returns false once this reaches 0
+  bool     refuse = false;     // init fails
+  bool     leaky = false;      // suspend forgets the screen
+  uint32_t resumeCost = 10;    // ms
+};
+
+static bool fakeInit(void* ctx) {
+  FakeApp& a = *(FakeApp*)ctx;
+  if (a.refuse) return false;
+  a.inits++;
+  a.state.take(a.kept);
+  return true;
+}
+
+static void fakeResume(void* ctx) {
+  FakeApp& a = *(FakeApp*)ctx;
+  a.resumes++;
+  a.screen.take(a.shown);
+  g_ms += a.resumeCost;
+}
+
+static bool fakeTick(void* ctx) {
+  FakeApp& a = *(FakeApp*)ctx;
+  g_ms += 30;
+  if (a.ticksLeft > 0) a.ticksLeft--;
+  return a.ticksLeft != 0;
+}
+
+static void fakeSuspend(void* ctx) {
+  FakeApp& a = *(FakeApp*)ctx;
+  a.suspends++;
+  if (a.leaky) { a.screen.bytes = 0; return; }   // lost, never given back
+  a.screen.drop();
+}
+
+static void fakeTeardown(void* ctx) {
+  FakeApp& a = *(FakeApp*)ctx;
+  a.teardowns++;
+  a.state.drop();
+}
+
+static const AppOps HID  = { "hid", fakeInit, fakeResume, fakeTick, fakeSuspend, fakeTeardown };
+static const AppOps CAL  = { "calendar", fakeInit, fakeResume, fakeTick, fakeSuspend, fakeTeardown };
+static const AppOps STK  = { "stocks", fakeInit, fakeResume, fakeTick, fakeSuspend, fakeTeardown };
+static const AppOps LEAK = { "leaky", fakeInit, fakeResume, fakeTick, fakeSuspend, fakeTeardown };
+
+struct Rig {
+  AppHost  h;
+  FakeApp  cal, hid, stocks, leaky;
+  int      iCal, iHid, iStocks, iLeaky;
+
+  Rig() {
+    g_used = 0; g_ms = 0;
+    cal    = FakeApp(); cal.kept = 40 * 1024; cal.shown = 24 * 1024;
+    hid    = FakeApp(); hid.kept = 0;         hid.shown = 6 * 1024;
+    stocks = FakeApp(); stocks.kept = 20 * 1024; stocks.shown = 64 * 1024;
+    leaky  = FakeApp(); leaky.kept = 2 * 1024; leaky.shown = 16 * 1024; leaky.leaky = true;
+    h.heapFree = fakeFree;
+    h.clockMs = fakeMs;
+    iCal    = h.add(&CAL, &cal);
+    iHid    = h.add(&HID, &hid);
+    iStocks = h.add(&STK, &stocks);
+    iLeaky  = h.add(&LEAK, &leaky);
+    h.switchTo(iCal);
+  }
+
+  // Heap one app gives back is never charged to another: nothing held or
+  // retained goes negative, whatever closes while something else is in front
+  void sane() {
+    for (int i = 0; i < h.count; ++i) {
+      const AppStats& st = h.app[i].st;
+      CHECK(st.held >= 0 && st.retained >= 0 && st.retainedMax >= 0 && st.peak >= 0);
+    }
+  }
+
+  // Open from a tap, then run a few ticks in front
+  void visit(int i, int ticks = 3) {
+    h.open(i);
+    for (int k = 0; k < ticks; ++k) h.tick();
+    sane();
+  }
+
+  void close(int i) { h.teardown(i); sane(); }
+  int closeBackground() { int n = h.closeBackground(); sane(); return n; }
+};
+
+static void testLazyInit() {
+  Rig r;
+  CHECK(r.h.current() == r.iCal && r.cal.inits == 1);
+  CHECK(r.stocks.inits == 0 && r.hid.inits == 0 && r.h.app[r.iStocks].run == APP_IDLE);
+  CHECK(g_used == r.cal.kept + r.cal.shown);
+
+  // Opens are queued: the switch happens at the start of the next tick
+  r.h.open(r.iStocks);
+  CHECK(r.h.current() == r.iCal && !r.h.inFront(r.iCal));
+  r.h.tick();
+  CHECK(r.h.inFront(r.iStocks) && r.stocks.inits == 1 && r.cal.suspends == 1);
+
+  // Back and forth: init once, resume every time
+  for (int k = 0; k < 5; ++k) { r.visit(r.iCal); r.visit(r.iStocks); }
+  CHECK(r.stocks.inits == 1 && r.stocks.resumes == 6);
+  CHECK(r.h.app[r.iStocks].st.opens == 6 && r.h.app[r.iStocks].st.inits == 1);
+  CHECK(r.h.app[r.iCal].st.opens == 6 && r.cal.inits == 1);
+  CHECK(r.h.app[r.iStocks].st.resumeMs == r.stocks.resumeCost);
+}
+
+static void testRetained() {
+  Rig r;
+  const char* seq = "hschlscslclhc";   // hid, stocks, calendar, leaky
+  for (const char* p = seq; *p; ++p)
+    r.visit(*p == 'h' ? r.iHid : *p == 's' ? r.iStocks : *p == 'l' ? r.iLeaky : r.iCal);
+
+  // Well-behaved apps keep only what they keep on purpose
+  const AppStats& hid = r.h.app[r.iHid].st, &stk = r.h.app[r.iStocks].st;
+  CHECK(hid.retainedMax == 0 && hid.peak == (int32_t)r.hid.shown);
+  CHECK(stk.retainedMax == (int32_t)r.stocks.kept);
+  CHECK(stk.held == (int32_t)r.stocks.shown);   // the tables predate this visit's base
+  // The calendar's events came with its first open and show only there
+  CHECK(r.h.app[r.iCal].st.retained == 0 && r.h.app[r.iCal].st.retainedMax == (int32_t)r.cal.kept);
+
+  // The leak is reported as what it is, on every visit
+  const AppStats& lk = r.h.app[r.iLeaky].st;
+  CHECK(lk.opens == 3 && lk.retained == (int32_t)r.leaky.shown);
+  CHECK(lk.retainedMax == (int32_t)(r.leaky.kept + r.leaky.shown));
+  CHECK(g_used == r.cal.kept + r.cal.shown + r.stocks.kept + r.leaky.kept + 3 * r.leaky.shown);
+  r.h.report();
+}
+
+static void testTeardown() {
+  Rig r;
+  uint32_t home = g_used;
+  r.visit(r.iStocks);
+  r.visit(r.iHid);
+  r.visit(r.iCal);
+  CHECK(g_used == home + r.stocks.kept);
+
+  // Closing a background app gives back everything it kept
+  r.close(r.iStocks);
+  CHECK(g_used == home && r.stocks.teardowns == 1);
+  CHECK(r.h.app[r.iStocks].run == APP_IDLE && r.h.inFront(r.iCal));
+  // and none of it counts for or against the calendar, which was in front
+  r.visit(r.iHid);
+  CHECK(r.h.app[r.iCal].st.held == (int32_t)r.cal.shown && r.h.app[r.iCal].st.retained == 0);
+
+  // Closing the app in front suspends it and brings home back
+  r.visit(r.iStocks);
+  r.close(r.iStocks);
+  CHECK(r.h.inFront(r.iCal) && g_used == home);
+  CHECK(r.stocks.inits == 2 && r.stocks.teardowns == 2);
+
+  // The next open inits again; an app never opened is not torn down
+  r.visit(r.iStocks);
+  CHECK(r.stocks.inits == 3);
+  r.close(r.iLeaky);
+  CHECK(r.leaky.teardowns == 0);
+
+  // Low heap: everything in the background but home closes
+  r.visit(r.iHid);
+  CHECK(r.closeBackground() == 1);   // stocks; hid is in front
+  CHECK(r.h.inFront(r.iHid) && r.stocks.teardowns == 3 && r.cal.teardowns == 0);
+  r.visit(r.iCal);
+  CHECK(r.closeBackground() == 1 && r.hid.teardowns == 1);
+  CHECK(g_used == home);
+
+  // Home too, once it is in the background; closing the app in front then
+  // brings it back from scratch
+  r.visit(r.iHid);
+  r.close(r.iCal);
+  CHECK(g_used == r.hid.shown);
+  r.close(r.iHid);
+  CHECK(r.h.inFront(r.iCal) && r.cal.inits == 2 && g_used == r.cal.kept + r.cal.shown);
+  r.h.suspendCurrent();
+  r.close(r.iCal);
+  CHECK(g_used == 0 && r.cal.teardowns == 2 && r.cal.inits == 2);
+}
+
+static void testFallbacks() {
+  Rig r;
+  // An app that cannot start leaves home in front, resumed again
+  r.stocks.refuse = true;
+  r.visit(r.iStocks, 1);
+  CHECK(r.h.inFront(r.iCal) && r.h.app[r.iStocks].run == APP_IDLE);
+  CHECK(r.cal.resumes == 2 && g_used == r.cal.kept + r.cal.shown);
+
+  // tick() false (Exit, Home, Return) goes home on the next tick
+  r.hid.ticksLeft = 2;
+  r.visit(r.iHid, 2);
+  CHECK(r.h.current() == r.iHid && !r.h.inFront(r.iHid));
+  r.h.tick();
+  CHECK(r.h.inFront(r.iCal) && r.h.app[r.iHid].st.retained == 0);
+
+  // Home's own tick returning false stays put
+  r.cal.ticksLeft = 1;
+  r.h.tick();
+  r.h.tick();
+  CHECK(r.h.inFront(r.iCal));
+
+  // Opens past the end are ignored; a fifth app does not fit
+  r.h.open(7);
+  r.h.tick();
+  CHECK(r.h.inFront(r.iCal) && r.h.add(&HID, &r.hid) == -1);
+
+  // A slow resume is on the books
+  r.stocks.refuse = false;
+  r.stocks.resumeCost = 1500;
+  r.visit(r.iStocks, 1);
+  CHECK(r.h.app[r.iStocks].st.resumeMaxMs == 1500);
+}
+
+int main() {
+  testLazyInit();
+  testRetained();
+  testTeardown();
+  testFallbacks();
+  return checkDone("app host");
+}
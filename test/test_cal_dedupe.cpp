@@ -0,0 +1,177 @@
+// Cross-feed dedupe and the refresh diff on overlapping ICS fixtures
+// (CalFeeds.h). data/cal_team.ics and data/cal_personal.ics share three
+// meetings: one where the personal copy has the higher SEQUENCE, one where
+// only LAST-MODIFIED differs, and one that is identical (the earlier feed
+// keeps it). A recurring meeting has an overridden instance, which is its
+// own event. data/cal_team_v2.ics is the next refresh: a SEQUENCE bump
+// that moves a meeting, an override moved to another day, a master that
+// was deleted and a new meeting. The diff must touch exactly those days.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "CalFeeds.h"
+#include "check.h"
+
+struct Ev {
+  std::string title;
+  uint32_t    ymd = 0, hm = 0;
+  uint32_t    key = 0, seq = 0, mod = 0, sig = 0;
+};
+
+// Trimmed-down onIcsLine from Calendar.ino: same keys, same nesting rule
+struct Feed {
+  std::vector<Ev> list;
+  Ev       cur;
+  bool     in = false, hasUid = false;
+  int      depth = 0;
+  uint32_t uid = 0, rid = 0;
+};
+
+static const char* icsValue(const char* line, const char* name) {
+  size_t n = strlen(name);
+  if (strncmp(line, name, n) || (line[n] != ':' && line[n] != ';')) return nullptr;
+  const char* v = strchr(line + n, ':');
+  return v ? v + 1 : nullptr;
+}
+
+static bool onLine(void* ctx, const char* line, int) {
+  Feed& f = *(Feed*)ctx;
+  if (!f.in) {
+    if (strcmp(line, "BEGIN:VEVENT")) return false;
+    f.cur = Ev(); f.in = true; f.depth = 0; f.uid = f.rid = 0; f.hasUid = false;
+    return false;
+  }
+  if (!strcmp(line, "END:VEVENT")) {
+    f.in = false;
+    Ev& e = f.cur;
+    e.sig = calHashInt((int32_t)e.hm, calHashInt((int32_t)e.ymd, calHash(e.title.c_str())));
+    e.key = f.hasUid ? calHashInt((int32_t)f.rid, f.uid)
+                     : calHashInt((int32_t)e.ymd, calHashInt((int32_t)e.hm, calHash(e.title.c_str())));
+    f.list.push_back(e);
+    return true;
+  }
+  if (!strncmp(line, "BEGIN:", 6)) { f.depth++; return false; }
+  if (!strncmp(line, "END:", 4))   { if (f.depth) f.depth--; return false; }
+  if (f.depth) return false;
+  const char* v;
+  if ((v = icsValue(line, "SUMMARY")))            f.cur.title = v;
+  else if ((v = icsValue(line, "DTSTART")))       { unsigned y, h, m; sscanf(v, "%8uT%2u%2u", &y, &h, &m); f.cur.ymd = y; f.cur.hm = h * 100 + m; }
+  else if ((v = icsValue(line, "UID")))           { f.uid = calHash(v); f.hasUid = true; }
+  else if ((v = icsValue(line, "RECURRENCE-ID"))) f.rid = calHash(v);
+  else if ((v = icsValue(line, "SEQUENCE")))      f.cur.seq = strtoul(v, nullptr, 10);
+  else if ((v = icsValue(line, "LAST-MODIFIED"))) f.cur.mod = calStamp(v);
+  return false;
+}
+
+static Feed load(const char* path) {
+  Feed f;
+  IcsStream ics;
+  ics.begin(onLine, &f);
+  FILE* fp = fopen(path, "rb");
+  CHECK(fp != nullptr);
+  uint8_t buf[100];                                   // small reads: lines span them
+  size_t n;
+  while (fp && (n = fread(buf, 1, sizeof(buf), fp)) > 0) ics.feed(buf, n);
+  if (fp) fclose(fp);
+  ics.finish();
+  CHECK(ics.events == f.list.size());
+  return f;
+}
+
+// What fetchCalendar does after the fetch: dedupe across feeds, keep winners
+static std::vector<Ev> merge(std::vector<Feed>& feeds, int& dropped) {
+  std::vector<CalRef> refs;
+  for (size_t k = 0; k < feeds.size(); ++k)
+    for (size_t i = 0; i < feeds[k].list.size(); ++i) {
+      const Ev& e = feeds[k].list[i];
+      refs.push_back({ e.key, e.seq, e.mod, (uint16_t)k, (uint16_t)i, false });
+    }
+  dropped = calDedupe(refs.data(), (int)refs.size());
+  std::vector<Ev> out;
+  for (const CalRef& r : refs) if (!r.drop) out.push_back(feeds[r.feed].list[r.idx]);
+  return out;
+}
+
+static const Ev* byTitle(const std::vector<Ev>& v, const char* prefix) {
+  const Ev* hit = nullptr;
+  for (const Ev& e : v) if (!e.title.compare(0, strlen(prefix), prefix)) { if (hit) return nullptr; hit = &e; }
+  return hit;
+}
+
+static std::vector<CalSig> sigsOf(const std::vector<Ev>& v) {
+  std::vector<CalSig> s;
+  for (const Ev& e : v) s.push_back({ e.key, e.sig, e.ymd });
+  calSortSigs(s.data(), (int)s.size());
+  return s;
+}
+
+// Seven day cards from 2025-12-01, as markDirtyDay sees them
+struct Dirty { uint32_t mask = 0; int calls[3] = { 0, 0, 0 }; };
+static void markDay(void* ctx, CalChange c, uint32_t ymd) {
+  Dirty& d = *(Dirty*)ctx;
+  d.calls[c]++;
+  if (ymd >= 20251201 && ymd <= 20251207) d.mask |= 1u << (ymd - 20251201);
+}
+
+int main() {
+  std::vector<Feed> feeds = { load("data/cal_team.ics"), load("data/cal_personal.ics") };
+  CHECK(feeds[0].list.size() == 5 && feeds[1].list.size() == 5);
+
+  int dropped;
+  std::vector<Ev> r1 = merge(feeds, dropped);
+  CHECK(dropped == 3);
+  CHECK(r1.size() == 7);
+  const Ev* e;
+  CHECK((e = byTitle(r1, "Design review")) && e->title == "Design review (room change)");   // SEQUENCE 3 > 2
+  CHECK((e = byTitle(r1, "Offsite")) && e->title == "Offsite - bus at 8:30");               // later LAST-MODIFIED
+  CHECK(byTitle(r1, "Standup") != nullptr);                                                // one copy
+  CHECK(byTitle(r1, "Weekly sync (moved)") && byTitle(r1, "Dentist") && byTitle(r1, "Gym"));
+  int weekly = 0;
+  for (const Ev& x : r1) weekly += !x.title.compare(0, 11, "Weekly sync");
+  CHECK(weekly == 2);                                 // master and override are two events
+  // A VALARM's own UID does not rename the event it sits in
+  Feed again = load("data/cal_team.ics");
+  CHECK(again.list[0].key == feeds[1].list[0].key);
+
+  // Same data again: nothing to redraw
+  std::vector<CalSig> s1 = sigsOf(r1);
+  Dirty d0;
+  CalDiffCount c0 = calDiff(s1.data(), (int)s1.size(), s1.data(), (int)s1.size(), markDay, &d0);
+  CHECK(c0.added == 0 && c0.changed == 0 && c0.removed == 0 && d0.mask == 0);
+
+  // The next refresh
+  feeds[0] = load("data/cal_team_v2.ics");
+  std::vector<Ev> r2 = merge(feeds, dropped);
+  CHECK(dropped == 3);
+  CHECK((e = byTitle(r2, "Design review")) && e->title == "Design review (now 15:00)" && e->hm == 1500);
+  CHECK(byTitle(r2, "Retro") && byTitle(r2, "Weekly sync (moved)"));
+  weekly = 0;
+  for (const Ev& x : r2) weekly += !x.title.compare(0, 11, "Weekly sync");
+  CHECK(weekly == 1);                                 // the master was deleted
+
+  std::vector<CalSig> s2 = sigsOf(r2);
+  Dirty d;
+  CalDiffCount c = calDiff(s1.data(), (int)s1.size(), s2.data(), (int)s2.size(), markDay, &d);
+  CHECK(c.added == 1);                                // Retro
+  CHECK(c.changed == 2);                              // review moved, override moved
+  CHECK(c.removed == 1);                              // the weekly master
+  // Dec 2 (review), Dec 4 + 5 (override old/new day, master gone), Dec 7 (retro)
+  CHECK(d.mask == ((1u << 1) | (1u << 3) | (1u << 4) | (1u << 6)));
+  CHECK(d.calls[CAL_CHANGED] == 3);                   // the moved override reports both days
+
+  // And back: the inverse diff touches the same days
+  Dirty back;
+  CalDiffCount cb = calDiff(s2.data(), (int)s2.size(), s1.data(), (int)s1.size(), markDay, &back);
+  CHECK(cb.added == 1 && cb.removed == 1 && cb.changed == 2 && back.mask == d.mask);
+
+  // Order of feeds only decides exact ties
+  std::vector<Feed> swapped = { feeds[1], feeds[0] };
+  std::vector<Ev> r3 = merge(swapped, dropped);
+  CHECK(sigsOf(r3).size() == s2.size());
+  bool same = true;
+  std::vector<CalSig> s3 = sigsOf(r3);
+  for (size_t i = 0; i < s3.size() && i < s2.size(); ++i) same &= s3[i].key == s2[i].key && s3[i].sig == s2[i].sig;
+  CHECK(same);
+  return checkDone("cal dedupe");
+}
@@ -0,0 +1,322 @@
+// Concurrent calendar fetch against local stub servers (CalFeeds.h). Each
+// feed is a real HTTP/1.0 server on 127.0.0.1 with its own injected
+// latency: slow first byte, a drip of tiny chunks that splits folded lines,
+// a body delimited only by the close, a server that stalls past the
+// deadline, a 404 and a short body. The pool is run the way calFetchAll
+// runs it, CAL_WORKERS at a time through calStreamBody, and the result
+// must come back inside the per-feed deadline with every failing feed
+// parsed from its cached copy.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CalFeeds.h"
+#include "check.h"
+
+using namespace std::chrono;
+
+static uint32_t usNow() {
+  static const steady_clock::time_point t0 = steady_clock::now();
+  return (uint32_t)duration_cast<microseconds>(steady_clock::now() - t0).count();
+}
+static void sleepMs(int ms) { std::this_thread::sleep_for(milliseconds(ms)); }
+
+// ---------- Fixtures ----------
+// Long SUMMARY lines are folded at 75 octets, as servers send them
+static std::string icsBody(int feed, int n, const char* tag) {
+  std::string s = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\n";
+  for (int i = 0; i < n; ++i) {
+    char b[160];
+    snprintf(b, sizeof(b), "DTSTART:202512%02dT%02d%02d00Z", 1 + (i * 7 + feed) % 28, (i * 5 + feed) % 24, (i * 13) % 60);
+    std::string summary = std::string("SUMMARY:") + tag + " " + std::to_string(feed) + "." + std::to_string(i) +
+                          " quarterly planning review with the platform and infrastructure groups";
+    std::string folded;
+    for (size_t k = 0; k < summary.size(); k += 74) folded += (k ? "\r\n " : "") + summary.substr(k, 74);
+    s += "BEGIN:VEVENT\r\nUID:" + std::to_string(feed) + "-" + std::to_string(i) + "@stub\r\n" + b + "\r\n" +
+         folded + "\r\nBEGIN:VALARM\r\nTRIGGER:-PT10M\r\nEND:VALARM\r\nEND:VEVENT\r\n";
+  }
+  return s + "END:VCALENDAR\r\n";
+}
+
+enum StubKind { STUB_FAST, STUB_SLOW_START, STUB_DRIP, STUB_NO_LENGTH, STUB_STALL, STUB_404, STUB_SHORT };
+
+struct Stub {
+  StubKind    kind;
+  int         events;
+  std::string body, cache;     // what it serves, what the SD card held from last time
+};
+
+// ---------- Stub server ----------
+static void serveOne(int fd, const std::vector<Stub>* stubs) {
+  std::string req;
+  char c;
+  while (req.find("\r\n\r\n") == std::string::npos && recv(fd, &c, 1, 0) == 1) req += c;
+  unsigned k = 0;
+  sscanf(req.c_str(), "GET /%u", &k);
+  const Stub& s = (*stubs)[k < stubs->size() ? k : 0];
+  auto put = [&](const std::string& d) { return send(fd, d.data(), d.size(), MSG_NOSIGNAL) == (ssize_t)d.size(); };
+  std::string ok = "HTTP/1.0 200 OK\r\nContent-Type: text/calendar\r\n";
+  std::string len = "Content-Length: " + std::to_string(s.body.size()) + "\r\n";
+  switch (s.kind) {
+    case STUB_FAST:
+      put(ok + len + "\r\n");
+      for (size_t i = 0; i < s.body.size(); i += 1400) { put(s.body.substr(i, 1400)); sleepMs(2); }
+      break;
+    case STUB_SLOW_START:
+      sleepMs(150);
+      put(ok + len + "\r\n" + s.body);
+      break;
+    case STUB_DRIP: {
+      put(ok + len + "\r\n");
+      uint32_t r = 7;
+      for (size_t i = 0; i < s.body.size(); ) {
+        r = r * 1103515245u + 12345u;
+        size_t n = 1 + (r >> 16) % 97;
+        if (!put(s.body.substr(i, n))) break;
+        i += n;
+        if ((r >> 8) % 8 == 0) sleepMs(1);
+      }
+      break;
+    }
+    case STUB_NO_LENGTH:
+      sleepMs(30);
+      put(ok + "\r\n" + s.body);
+      break;
+    case STUB_STALL:
+      put(ok + len + "\r\n" + s.body.substr(0, s.body.size() / 2));
+      sleepMs(1200);                                  // well past the deadline
+      put(s.body.substr(s.body.size() / 2));
+      break;
+    case STUB_404:
+      put("HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+      break;
+    case STUB_SHORT:
+      put(ok + len + "\r\n" + s.body.substr(0, s.body.size() - 100));   // closes early
+      break;
+  }
+  close(fd);
+}
+
+struct StubServer {
+  int port = 0, lfd = -1;
+  std::thread accepter;
+  std::vector<std::thread> conns;
+
+  void start(const std::vector<Stub>* stubs, int connections) {
+    lfd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in a = {};
+    a.sin_family = AF_INET; a.sin_addr.s_addr = htonl(INADDR_LOOPBACK); a.sin_port = 0;
+    bind(lfd, (sockaddr*)&a, sizeof(a));
+    listen(lfd, 16);
+    socklen_t al = sizeof(a);
+    getsockname(lfd, (sockaddr*)&a, &al);
+    port = ntohs(a.sin_port);
+    accepter = std::thread([this, stubs, connections] {
+      for (int i = 0; i < connections; ++i) {
+        int fd = accept(lfd, nullptr, nullptr);
+        if (fd < 0) break;
+        conns.emplace_back(serveOne, fd, stubs);
+      }
+    });
+  }
+  void stop() {
+    accepter.join();
+    for (auto& t : conns) t.join();
+    close(lfd);
+  }
+};
+
+// ---------- Host side of a feed ----------
+struct Collected { std::vector<std::string> starts, titles; std::string title; bool in = false; };
+
+static bool onLine(void* ctx, const char* line, int) {
+  Collected& c = *(Collected*)ctx;
+  if (!strcmp(line, "BEGIN:VEVENT")) { c.in = true; return false; }
+  if (!c.in) return false;
+  if (!strcmp(line, "END:VEVENT")) { c.in = false; c.titles.push_back(c.title); return true; }
+  if (!strncmp(line, "DTSTART:", 8)) c.starts.push_back(line + 8);
+  if (!strncmp(line, "SUMMARY:", 8)) c.title = line + 8;
+  return false;
+}
+
+static void onReset(void* ctx) { *(Collected*)ctx = Collected(); }
+
+struct HostFeed {
+  int         index;
+  const Stub* stub;
+  Collected   got;
+  int         code = 0;
+  CalBodyStats st = {};
+  bool        fromCache = false;
+  uint32_t    startUs = 0, fetchMs = 0;
+};
+
+static int readSock(void* src, uint8_t* buf, size_t n) {
+  int fd = *(int*)src;
+  pollfd p = { fd, POLLIN, 0 };
+  if (poll(&p, 1, 2) == 0) return 0;                  // the 2 ms the firmware waits
+  ssize_t k = recv(fd, buf, n, 0);
+  return k > 0 ? (int)k : -1;
+}
+
+// calFetchOne, with a socket for HTTPClient and a string for the SD cache
+static void fetchOne(HostFeed& f, int port, uint32_t timeoutMs) {
+  f.startUs = usNow();
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a = {};
+  a.sin_family = AF_INET; a.sin_addr.s_addr = htonl(INADDR_LOOPBACK); a.sin_port = htons(port);
+  bool complete = false;
+  if (connect(fd, (sockaddr*)&a, sizeof(a)) == 0) {
+    std::string req = "GET /" + std::to_string(f.index) + " HTTP/1.0\r\n\r\n";
+    send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+    std::string hdr;
+    char c;
+    while (hdr.find("\r\n\r\n") == std::string::npos && recv(fd, &c, 1, 0) == 1) hdr += c;
+    sscanf(hdr.c_str(), "HTTP/%*s %d", &f.code);
+    int size = -1;
+    size_t at = hdr.find("Content-Length: ");
+    if (at != std::string::npos) size = atoi(hdr.c_str() + at + 16);
+    if (f.code == 200) {
+      IcsStream ics;
+      ics.begin(onLine, &f.got);
+      complete = calStreamBody(ics, size, f.startUs + timeoutMs * 1000, readSock, &fd, nullptr, nullptr, usNow, f.st);
+    }
+  }
+  close(fd);
+  f.fetchMs = (usNow() - f.startUs) / 1000;
+  if (!complete) {
+    onReset(&f.got);
+    IcsStream ics;
+    ics.begin(onLine, &f.got);
+    ics.feed((const uint8_t*)f.stub->cache.data(), f.stub->cache.size());
+    ics.finish();
+    f.fromCache = true;
+  }
+}
+
+static void testPool() {
+  signal(SIGPIPE, SIG_IGN);
+  std::vector<Stub> stubs;
+  const StubKind kinds[] = { STUB_FAST, STUB_SLOW_START, STUB_DRIP, STUB_NO_LENGTH, STUB_STALL, STUB_404, STUB_SHORT };
+  for (int i = 0; i < (int)(sizeof(kinds) / sizeof(kinds[0])); ++i) {
+    int n = 20 + 7 * i;
+    stubs.push_back({ kinds[i], n, icsBody(i, n, "new"), icsBody(i, 3, "cached") });
+  }
+  const int N = (int)stubs.size();
+  const uint32_t TIMEOUT_MS = 500;
+
+  StubServer srv;
+  srv.start(&stubs, N);
+  std::vector<HostFeed> feeds(N);
+  for (int i = 0; i < N; ++i) { feeds[i].index = i; feeds[i].stub = &stubs[i]; }
+
+  // calWorker: take the next feed until there are none
+  std::atomic<int> next(0);
+  uint32_t t0 = usNow();
+  std::vector<std::thread> workers;
+  for (int k = 0; k < CAL_WORKERS; ++k)
+    workers.emplace_back([&] { for (int i; (i = next++) < N; ) fetchOne(feeds[i], srv.port, TIMEOUT_MS); });
+  for (auto& w : workers) w.join();
+  uint32_t wallMs = (usNow() - t0) / 1000;
+  srv.stop();
+
+  uint32_t serialMs = 0;
+  for (int i = 0; i < N; ++i) {
+    const HostFeed& f = feeds[i];
+    serialMs += f.fetchMs;
+    printf("  calendar %d: %d%s%s, %lu B, %zu events, fetch %lu ms, parse %.2f ms\n", i + 1, f.code,
+           f.st.timedOut ? " timeout" : "", f.fromCache ? " (cache)" : "", (unsigned long)f.st.bytes,
+           f.got.titles.size(), (unsigned long)f.fetchMs, f.st.parseUs / 1000.0);
+    bool shouldFail = f.stub->kind == STUB_STALL || f.stub->kind == STUB_404 || f.stub->kind == STUB_SHORT;
+    CHECK(f.fromCache == shouldFail);
+    size_t want = shouldFail ? 3 : (size_t)f.stub->events;
+    CHECK(f.got.titles.size() == want && f.got.starts.size() == want);
+    // Folded lines come back whole, whatever the chunking
+    bool whole = true;
+    for (const std::string& t : f.got.titles)
+      whole &= t.find("platform and infrastructure groups") != std::string::npos &&
+               !t.compare(0, shouldFail ? 6 : 3, shouldFail ? "cached" : "new");
+    CHECK(whole);
+  }
+  CHECK(feeds[4].st.timedOut);
+  CHECK(feeds[4].fetchMs >= TIMEOUT_MS && feeds[4].fetchMs < TIMEOUT_MS + 200);
+  CHECK(feeds[5].code == 404 && feeds[6].code == 200 && !feeds[6].st.timedOut);
+  CHECK(feeds[3].st.bytes == stubs[3].body.size());   // close-delimited, all of it
+  // The stall costs one worker its deadline, not the whole refresh
+  CHECK(wallMs < TIMEOUT_MS + 300);
+  CHECK(wallMs < serialMs);
+  printf("  %d feeds in %lu ms (%lu ms one after another)\n", N, (unsigned long)wallMs, (unsigned long)serialMs);
+
+  // Merged into one store, sorted by start
+  std::vector<std::string> all;
+  for (const HostFeed& f : feeds) all.insert(all.end(), f.got.starts.begin(), f.got.starts.end());
+  std::sort(all.begin(), all.end());
+  size_t total = 0;
+  for (const HostFeed& f : feeds) total += f.got.starts.size();
+  CHECK(all.size() == total && std::is_sorted(all.begin(), all.end()));
+}
+
+// The body loop on its own: a source that never delivers hits the deadline,
+// and a Content-Length shorter than what arrives stops at the length
+struct Canned { const std::string* s; size_t at; int chunk; };
+
+static int readCanned(void* src, uint8_t* buf, size_t n) {
+  Canned& c = *(Canned*)src;
+  if (c.at >= c.s->size()) return c.chunk ? -1 : 0;
+  size_t k = std::min({ n, (size_t)(c.chunk ? c.chunk : 1), c.s->size() - c.at });
+  memcpy(buf, c.s->data() + c.at, k);
+  c.at += k;
+  return (int)k;
+}
+
+static void testBody() {
+  std::string body = icsBody(0, 5, "x");
+  Collected got;
+  IcsStream ics;
+  ics.begin(onLine, &got);
+  Canned src = { &body, 0, 333 };
+  CalBodyStats st = {};
+  CHECK(calStreamBody(ics, (int)body.size(), usNow() + 1000000, readCanned, &src, nullptr, nullptr, usNow, st));
+  CHECK(got.titles.size() == 5 && st.bytes == body.size() && !st.timedOut);
+
+  // Silent source: gives up at the deadline and leaves the parser open
+  Canned quiet = { &body, body.size(), 0 };
+  Collected none;
+  ics.begin(onLine, &none);
+  st = {};
+  uint32_t t0 = usNow();
+  CHECK(!calStreamBody(ics, -1, t0 + 20000, readCanned, &quiet, nullptr, nullptr, usNow, st));
+  CHECK(st.timedOut && usNow() - t0 >= 20000);
+
+  // Close before any byte of a close-delimited body: not a body
+  Canned closed = { &body, body.size(), 1 };
+  st = {};
+  CHECK(!calStreamBody(ics, -1, usNow() + 1000000, readCanned, &closed, nullptr, nullptr, usNow, st));
+  CHECK(!st.timedOut && st.bytes == 0);
+
+  // The tee sees exactly what the parser saw
+  std::string tee;
+  Canned again = { &body, 0, 1000 };
+  got = Collected();
+  ics.begin(onLine, &got);
+  st = {};
+  CHECK(calStreamBody(ics, (int)body.size(), usNow() + 1000000, readCanned, &again,
+                      [](void* ctx, const uint8_t* b, size_t n) { ((std::string*)ctx)->append((const char*)b, n); },
+                      &tee, usNow, st));
+  CHECK(tee == body);
+}
+
+int main() {
+  testBody();
+  testPool();
+  return checkDone("cal feeds");
+}
@@ -0,0 +1,90 @@
+// Secrets in config files are masked on the way out and restored on the way
+// back in (ConfigServer.h).
+
+#include <string>
+#include <string.h>
+#include "ConfigServer.h"
+#include "check.h"
+
+static std::string masked(const std::string& s, CfgSecretsFn f) {
+  std::string out;
+  cfgMaskSecrets(s.data(), s.size(), f, out);
+  return out;
+}
+
+static std::string unmasked(const std::string& posted, const std::string& old, CfgSecretsFn f, int* n = nullptr) {
+  std::string out;
+  int k = cfgUnmaskSecrets(posted.data(), posted.size(), old.data(), old.size(), f, out);
+  if (n) *n = k;
+  return out;
+}
+
+int main() {
+  const std::string secrets =
+    "# ---- Primary WiFi ----\n"
+    "SSID=home\n"
+    "PASS=hunter2\n"
+    "PASS2=\n"
+    "CAL1=https://example.com/private/abc.ics\n"
+    "OWM_KEY = 0123abcd \n"
+    "LAT=25.7\n"
+    "CFG_PASS=letmein\n"
+    "# PASS=commented\n";
+
+  std::string m = masked(secrets, cfgSecretsKeyValue);
+  CHECK(m.find("hunter2") == std::string::npos);
+  CHECK(m.find("letmein") == std::string::npos);
+  CHECK(m.find("0123abcd") == std::string::npos);
+  CHECK(m.find("private") == std::string::npos);
+  CHECK(m.find("SSID=home\n") != std::string::npos);
+  CHECK(m.find("LAT=25.7\n") != std::string::npos);
+  CHECK(m.find("PASS2=\n") != std::string::npos);          // empty stays empty
+  CHECK(m.find("# PASS=commented") != std::string::npos);  // comments untouched
+  CHECK(m.find("OWM_KEY = ********") != std::string::npos);
+
+  // Posting the masked file back restores every value
+  int n = 0;
+  CHECK(unmasked(m, secrets, cfgSecretsKeyValue, &n) == secrets);
+  CHECK(n == 4);
+
+  // An edited value is taken as typed; the others come back
+  std::string edited = m;
+  edited.replace(edited.find("LAT=25.7"), 8, "LAT=40.7");
+  size_t p = edited.find("PASS=********");
+  edited.replace(p, 13, "PASS=newpass");
+  std::string saved = unmasked(edited, secrets, cfgSecretsKeyValue);
+  CHECK(saved.find("PASS=newpass\n") != std::string::npos);
+  CHECK(saved.find("LAT=40.7\n") != std::string::npos);
+  CHECK(saved.find("CFG_PASS=letmein\n") != std::string::npos);
+  CHECK(saved.find("CAL1=https://example.com/private/abc.ics\n") != std::string::npos);
+
+  // A masked value with nothing to match is dropped, not saved as stars
+  std::string added = m + "API_KEY=********\n";
+  CHECK(unmasked(added, secrets, cfgSecretsKeyValue).find("API_KEY=\n") != std::string::npos);
+
+  const std::string wifi =
+    "HomeNet\r\n"
+    "wifipass\r\n"
+    "CafeOpen\n"
+    "\n"
+    "Office\n"
+    "officepass\n"
+    "APIKEY:finnhubkey\n"
+    "BACKUP:backupkey\n"
+    "CFGPASS:letmein\n";
+  std::string w = masked(wifi, cfgSecretsWifiTxt);
+  CHECK(w.find("wifipass") == std::string::npos);
+  CHECK(w.find("officepass") == std::string::npos);
+  CHECK(w.find("finnhubkey") == std::string::npos);
+  CHECK(w.find("backupkey") == std::string::npos);
+  CHECK(w.find("letmein") == std::string::npos);
+  CHECK(w.find("HomeNet\r\n********\r\n") != std::string::npos);
+  CHECK(w.find("CafeOpen\n\nOffice\n") != std::string::npos);   // open network keeps its blank line
+  CHECK(unmasked(w, wifi, cfgSecretsWifiTxt) == wifi);
+
+  // Reordered networks still get their own passwords
+  std::string swapped = "Office\n********\nHomeNet\n********\nAPIKEY:********\n";
+  CHECK(unmasked(swapped, wifi, cfgSecretsWifiTxt) == "Office\nofficepass\nHomeNet\nwifipass\nAPIKEY:finnhubkey\n");
+
+  return checkDone("config secrets");
+}
@@ -0,0 +1,137 @@
+// Delta patches applied through DeltaPatcher into a fake flash partition
+// (DeltaOta.h): the old image is read back in windows the way
+// esp_partition_read does, the new one is written sequentially into erased
+// flash the way esp_ota_write does, and the patch arrives in uneven chunks.
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "DeltaOta.h"
+#include "check.h"
+
+// A flash partition: erased to 0xFF, writes may only clear bits, in order
+struct FakePartition {
+  std::vector<uint8_t> mem;
+  uint32_t written = 0, reads = 0, failAt = UINT32_MAX;
+  explicit FakePartition(size_t size) : mem(size, 0xFF) {}
+};
+
+struct FakeOta {
+  FakePartition* running;
+  FakePartition* next;
+};
+
+static bool fakeRead(void* ctx, uint32_t off, uint8_t* buf, size_t n) {
+  FakePartition* p = ((FakeOta*)ctx)->running;
+  p->reads++;
+  if (off + n > p->mem.size()) return false;
+  memcpy(buf, p->mem.data() + off, n);
+  return true;
+}
+
+static bool fakeWrite(void* ctx, const uint8_t* buf, size_t n) {
+  FakePartition* p = ((FakeOta*)ctx)->next;
+  if (p->written + n > p->mem.size() || p->written + n > p->failAt) return false;
+  for (size_t i = 0; i < n; ++i) {
+    uint8_t& m = p->mem[p->written + i];
+    if ((m & buf[i]) != buf[i]) return false;       // not erased
+    m &= buf[i];
+  }
+  p->written += n;
+  return true;
+}
+
+// A plausible app image: code-like runs with addresses that shift between builds
+static std::vector<uint8_t> image(uint32_t seed, size_t n) {
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> v(n);
+  for (size_t i = 0; i < n; ++i) v[i] = (uint8_t)(i % 251 < 200 ? (i * 7) ^ (i >> 9) : rng());
+  return v;
+}
+
+static std::vector<uint8_t> rebuild(const std::vector<uint8_t>& a) {
+  std::vector<uint8_t> b(a);
+  std::mt19937 rng(7);
+  for (size_t i = 0; i < b.size(); i += 4096) b[i + (rng() % 4000)] ^= 0x5A;   // scattered edits
+  b.insert(b.begin() + b.size() / 3, 3000, 0x42);                              // a new function
+  for (size_t i = b.size() / 2; i + 4 <= b.size(); i += 64) b[i] += 4;          // moved addresses
+  b.erase(b.begin() + b.size() * 3 / 4, b.begin() + b.size() * 3 / 4 + 1500);   // dropped code
+  return b;
+}
+
+// Feed `patch` in chunks of 1..maxChunk bytes; null on success, else the error
+static const char* applyToFlash(const std::vector<uint8_t>& patch, FakeOta& ota, uint32_t seed, size_t maxChunk) {
+  DeltaPatcher* p = new DeltaPatcher;
+  p->begin(fakeRead, fakeWrite, &ota);
+  std::mt19937 rng(seed);
+  bool ok = true;
+  for (size_t i = 0; ok && i < patch.size();) {
+    size_t k = 1 + rng() % maxChunk;
+    if (k > patch.size() - i) k = patch.size() - i;
+    ok = p->feed(patch.data() + i, k);
+    i += k;
+  }
+  const char* err = ok && p->done() ? nullptr : (p->error ? p->error : "patch truncated");
+  delete p;
+  return err;
+}
+
+int main() {
+  std::vector<uint8_t> a = image(1, 512 * 1024), b = rebuild(a), patch;
+  deltaMake(a.data(), a.size(), b.data(), b.size(), patch);
+  printf("delta: %zu -> %zu B image, %zu B patch (%.1f%%)\n", a.size(), b.size(), patch.size(),
+         100.0 * patch.size() / b.size());
+  CHECK(patch.size() < b.size() / 4);
+
+  // Whole patch, then uneven chunks down to single bytes
+  size_t chunks[] = { 1 << 20, 512, 97, 1 };
+  for (size_t c : chunks) {
+    FakePartition run(a.size()), next(b.size() + 4096);
+    run.mem = a;
+    FakeOta ota = { &run, &next };
+    const char* err = applyToFlash(patch, ota, (uint32_t)c, c);
+    CHECK(err == nullptr);
+    CHECK(next.written == b.size());
+    CHECK(std::equal(b.begin(), b.end(), next.mem.begin()));
+    CHECK(run.reads < a.size() / 64);           // windows, not byte-by-byte reads
+  }
+
+  // Each failure stops before the image is complete and says why
+  {
+    FakePartition run(a.size()), next(b.size());
+    run.mem = a;
+    next.failAt = b.size() / 2;                 // flash write error half way
+    FakeOta ota = { &run, &next };
+    const char* err = applyToFlash(patch, ota, 3, 700);
+    CHECK(err && !strcmp(err, "write failed"));
+    CHECK(next.written < b.size());
+  }
+  {
+    FakePartition run(a.size() / 2), next(b.size());   // running image shorter than the patch expects
+    memcpy(run.mem.data(), a.data(), run.mem.size());
+    FakeOta ota = { &run, &next };
+    CHECK(applyToFlash(patch, ota, 4, 700) != nullptr);
+  }
+  {
+    std::vector<uint8_t> bad(patch);
+    bad[bad.size() / 2] ^= 0xFF;                // corrupt in transit
+    FakePartition run(a.size()), next(b.size() + 4096);
+    run.mem = a;
+    FakeOta ota = { &run, &next };
+    CHECK(applyToFlash(bad, ota, 5, 700) != nullptr);
+  }
+  {
+    std::vector<uint8_t> cut(patch.begin(), patch.end() - 10);
+    FakePartition run(a.size()), next(b.size() + 4096);
+    run.mem = a;
+    FakeOta ota = { &run, &next };
+    const char* err = applyToFlash(cut, ota, 6, 700);
+    CHECK(err && !strcmp(err, "patch truncated"));
+  }
+  {
+    std::vector<uint8_t> other = image(2, a.size()), out;   // made against another build
+    CHECK(deltaApply(other.data(), other.size(), patch.data(), patch.size(), out) != nullptr);
+  }
+
+  return checkDone("delta ota");
+}
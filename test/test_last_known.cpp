@@ -0,0 +1,179 @@
+// Last-known-good journal through a session that loses the network
+// (LastKnown.h), on an in-memory SD card (fake/SD.h). Quotes are fetched
+// and journalled while the link is up; the link drops mid-session and the
+// views must still draw the last values, badged stale. The power is cut
+// in the middle of a journal write, the board reboots offline, and finally
+// the network comes back and fresh data replaces the stale.
+
+#include <stdlib.h>
+#include <time.h>
+#include "LastKnown.h"
+#include "check.h"
+
+struct Quote { float price, high, low, open, prevClose, changePct, volume; };
+
+static const char* SYMS[] = { "AAPL", "MSFT", "BTC-USD" };
+static const int   NSYM = 3;
+static const uint32_t T0 = 1763989200;     // 2025-11-24 13:00Z
+
+// The "network": a price per symbol and tick, or nothing while it is down
+static bool g_online = true;
+static bool fetchQuote(int s, int tick, Quote& q) {
+  if (!g_online) return false;
+  float p = 100.0f * (s + 1) + tick;
+  q = { p, p + 1, p - 1, p - 0.5f, p - 2, 2.0f / p * 100, 1000.0f * tick };
+  return true;
+}
+
+// What a view draws: the value, and "since ..." when it is not fresh
+struct Shown { float price; bool stale; char badge[24]; };
+
+static Shown refresh(LastKnown& lk, int s, int tick, uint32_t now) {
+  Shown v = { 0, false, "" };
+  Quote q;
+  if (fetchQuote(s, tick, q)) {
+    lk.put(LK_QUOTE, SYMS[s], &q, sizeof(q), now);
+    v.price = q.price;
+    return v;
+  }
+  uint32_t at;
+  if (lk.get(LK_QUOTE, SYMS[s], &q, sizeof(q), &at)) {
+    v.price = q.price; v.stale = true;
+    lkStaleLabel(v.badge, sizeof(v.badge), at, now);
+  }
+  return v;
+}
+
+static void testSession() {
+  SD = FakeSD();
+  LastKnown lk;
+  lk.begin();
+  CHECK(lk.count == 0);
+
+  // Up: ten polls a minute apart
+  uint32_t now = T0;
+  int tick = 0;
+  for (; tick < 10; ++tick, now += 60)
+    for (int s = 0; s < NSYM; ++s) CHECK(!refresh(lk, s, tick, now).stale);
+  size_t rec = 25 + sizeof(Quote);
+  CHECK(SD.sizeOf("/cache/last.bin") == 10 * NSYM * rec);
+
+  // Down mid-session: every view still shows the last price, badged
+  g_online = false;
+  uint32_t lastGood = now - 60;
+  for (int k = 0; k < 5; ++k, ++tick, now += 60)
+    for (int s = 0; s < NSYM; ++s) {
+      Shown v = refresh(lk, s, tick, now);
+      CHECK(v.stale && v.price == 100.0f * (s + 1) + 9);
+      CHECK(!strcmp(v.badge, "since 13:09"));
+    }
+  CHECK(SD.sizeOf("/cache/last.bin") == 10 * NSYM * rec);   // nothing written while down
+
+  // A flap: one quote gets through, and the power goes halfway into its record
+  g_online = true;
+  SD.writeBudget = (long)rec / 2;
+  refresh(lk, 0, tick, now);
+  SD.writeBudget = -1;
+  g_online = false;
+  CHECK(SD.sizeOf("/cache/last.bin") == 10 * NSYM * rec + rec / 2);
+
+  // Reboot offline: the good records replay, the torn tail is dropped and
+  // the journal rewritten to one record per key
+  LastKnown boot;
+  boot.begin();
+  CHECK(boot.count == NSYM);
+  CHECK(SD.sizeOf("/cache/last.bin") == NSYM * rec);
+  CHECK(!SD.exists("/cache/last.bin.tmp"));
+  for (int s = 0; s < NSYM; ++s) {
+    Shown v = refresh(boot, s, tick, now);
+    CHECK(v.stale && v.price == 100.0f * (s + 1) + 9);
+  }
+  Quote q; uint32_t at = 0;
+  CHECK(boot.get(LK_QUOTE, "AAPL", &q, sizeof(q), &at) && at == lastGood);
+  CHECK(!boot.get(LK_QUOTE, "AAPL", &q, sizeof(q) - 1));    // wrong size: not ours
+  CHECK(!boot.get(LK_WEATHER, "AAPL", &q, sizeof(q)));      // other kind, same key
+
+  // Back online the next day: fresh data replaces the stale, and survives a reboot
+  g_online = true;
+  now = T0 + 86400;
+  ++tick;
+  for (int s = 0; s < NSYM; ++s) CHECK(!refresh(boot, s, tick, now).stale);
+  LastKnown again;
+  again.begin();
+  CHECK(again.get(LK_QUOTE, "MSFT", &q, sizeof(q), &at) && at == now && q.price == 200.0f + tick);
+
+  // A stale badge from another day names the weekday
+  g_online = false;
+  Shown v = refresh(again, 2, tick, now + 86400);
+  CHECK(v.stale && !strcmp(v.badge, "since Tue 13:00"));
+  g_online = true;
+}
+
+// Every kind of damage at the tail, one byte at a time
+static void testTornTail() {
+  SD = FakeSD();
+  LastKnown lk;
+  lk.begin();
+  Quote q = { 1, 2, 3, 4, 5, 6, 7 };
+  lk.put(LK_QUOTE, "AAPL", &q, sizeof(q), T0);
+  size_t good = SD.sizeOf("/cache/last.bin");
+  bool ok = true;
+  for (size_t cut = 1; cut < good; ++cut) {
+    SD.files["/cache/last.bin"]->resize(good);
+    SD.writeBudget = (long)cut;
+    lk.put(LK_QUOTE, "MSFT", &q, sizeof(q), T0 + 1);
+    SD.writeBudget = -1;
+    LastKnown b;
+    b.begin();
+    if (b.count != 1 || SD.sizeOf("/cache/last.bin") != good) ok = false;
+  }
+  CHECK(ok);
+
+  // A flipped byte inside a record stops the replay at that record
+  SD.files["/cache/last.bin"]->resize(good);
+  lk.put(LK_QUOTE, "MSFT", &q, sizeof(q), T0 + 1);
+  (*SD.files["/cache/last.bin"])[good + 10] ^= 0x40;
+  LastKnown b;
+  b.begin();
+  CHECK(b.count == 1 && b.find(LK_QUOTE, "AAPL") == 0);
+}
+
+// The journal is compacted past its size limit and keys beyond the slots
+// evict the oldest data
+static void testCompactAndEvict() {
+  SD = FakeSD();
+  LastKnown lk;
+  lk.begin();
+  Quote q = {};
+  size_t peak = 0;
+  for (int i = 0; i < 2000; ++i) {
+    q.price = (float)i;
+    lk.put(LK_QUOTE, SYMS[i % NSYM], &q, sizeof(q), T0 + i);
+    size_t n = SD.sizeOf("/cache/last.bin");
+    if (n > peak) peak = n;
+  }
+  CHECK(peak <= LastKnown::COMPACT_SIZE + 25 + sizeof(Quote));
+  LastKnown b;
+  b.begin();
+  CHECK(b.count == NSYM);
+  CHECK(b.get(LK_QUOTE, SYMS[1999 % NSYM], &q, sizeof(q)) && q.price == 1999);
+
+  char key[16];
+  for (int i = 0; i < LastKnown::SLOTS + 5; ++i) {
+    snprintf(key, sizeof(key), "K%d", i);
+    b.put(LK_WEATHER, key, &q, sizeof(q), T0 + 10000 + i);
+  }
+  CHECK(b.count == LastKnown::SLOTS);
+  for (int s = 0; s < NSYM; ++s) CHECK(b.find(LK_QUOTE, SYMS[s]) < 0);   // oldest first
+  CHECK(b.find(LK_WEATHER, "K0") < 0 && b.find(LK_WEATHER, "K4") < 0);
+  CHECK(b.find(LK_WEATHER, "K5") >= 0 && b.find(LK_WEATHER, "K52") >= 0);
+}
+
+int main() {
+  setenv("TZ", "UTC0", 1);
+  tzset();
+  testSession();
+  testTornTail();
+  testCompactAndEvict();
+  return checkDone("last known");
+}
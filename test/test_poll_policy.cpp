@@ -0,0 +1,185 @@
+// NYSE calendar and the polling policy against a simulated clock (PollPolicy.h).
+// A week of minute prices is replayed: Thanksgiving week, so it has a
+// holiday, an early close and a weekend. Each instrument is polled only when
+// its nextAt comes round, and the polls made are compared with the fixed
+// 30 s cadence the sketches used to have.
+
+#include <stdlib.h>
+#include <vector>
+#include "PollPolicy.h"
+#include "check.h"
+
+static struct tm et(int y, int mo, int d, int h, int mi) {
+  struct tm t = {};
+  t.tm_year = y - 1900; t.tm_mon = mo - 1; t.tm_mday = d; t.tm_hour = h; t.tm_min = mi;
+  return t;
+}
+
+static MarketSession sessAt(int y, int mo, int d, int h, int mi) { return nyseSession(et(y, mo, d, h, mi)); }
+
+static void testCalendar() {
+  // 2025 NYSE holidays, as published
+  static const int H[][2] = { {1, 1}, {1, 20}, {2, 17}, {4, 18}, {5, 26}, {6, 19}, {7, 4}, {9, 1}, {11, 27}, {12, 25} };
+  int n = 0;
+  for (int m = 1; m <= 12; ++m)
+    for (int d = 1; d <= 31; ++d)
+      if (nyseHoliday(2025, m, d)) ++n;
+  CHECK(n == 10);
+  for (auto& h : H) CHECK(nyseHoliday(2025, h[0], h[1]));
+
+  // Observed on Friday / Monday; a Saturday New Year is not made up
+  CHECK(nyseHoliday(2026, 7, 3));                       // July 4 2026 is a Saturday
+  CHECK(nyseHoliday(2027, 12, 24));                     // Christmas 2027 is a Saturday
+  CHECK(!nyseHoliday(2021, 12, 31));
+  CHECK(nyseHoliday(2023, 1, 2));                       // New Year 2023 is a Sunday
+  CHECK(nyseHoliday(2024, 3, 29));                      // Good Friday
+
+  // Sessions, with the 13:00 close the day after Thanksgiving
+  CHECK(sessAt(2025, 11, 24, 3, 59) == SESS_CLOSED);
+  CHECK(sessAt(2025, 11, 24, 4, 0) == SESS_PRE);
+  CHECK(sessAt(2025, 11, 24, 9, 30) == SESS_REGULAR);
+  CHECK(sessAt(2025, 11, 24, 16, 0) == SESS_AFTER);
+  CHECK(sessAt(2025, 11, 24, 20, 0) == SESS_CLOSED);
+  CHECK(sessAt(2025, 11, 27, 11, 0) == SESS_CLOSED);    // Thanksgiving
+  CHECK(sessAt(2025, 11, 28, 12, 59) == SESS_REGULAR);
+  CHECK(sessAt(2025, 11, 28, 13, 0) == SESS_AFTER);
+  CHECK(sessAt(2025, 11, 28, 17, 0) == SESS_CLOSED);
+  CHECK(sessAt(2025, 11, 29, 11, 0) == SESS_CLOSED);    // Saturday
+
+  // Time to the next edge, and past the last one of the day to midnight
+  CHECK(nyseSecondsToChange(et(2025, 11, 24, 3, 0)) == 3600);
+  CHECK(nyseSecondsToChange(et(2025, 11, 24, 9, 0)) == 1800);
+  CHECK(nyseSecondsToChange(et(2025, 11, 28, 12, 0)) == 3600);
+  CHECK(nyseSecondsToChange(et(2025, 11, 24, 21, 0)) == 3 * 3600);
+  CHECK(nyseSecondsToChange(et(2025, 11, 29, 6, 0)) == 18 * 3600);
+
+  // UTC to New York across both DST changes of 2025
+  struct tm t;
+  nyseLocalTime(1741503600 - 1, t);                     // 2025-03-09 06:59:59Z
+  CHECK(t.tm_hour == 1 && t.tm_min == 59);
+  nyseLocalTime(1741503600, t);                         // 07:00Z: 03:00 EDT
+  CHECK(t.tm_hour == 3 && t.tm_min == 0);
+  nyseLocalTime(1762063200 - 1, t);                     // 2025-11-02 05:59:59Z: 01:59 EDT
+  CHECK(t.tm_hour == 1 && t.tm_min == 59);
+  nyseLocalTime(1762063200, t);                         // 06:00Z: 01:00 EST
+  CHECK(t.tm_hour == 1 && t.tm_min == 0);
+}
+
+// ---------- Tape ----------
+// Minute prices for Mon 2025-11-24 00:00 EST to Sun 11-30 24:00. A stock
+// only prints while a session is open: a random walk, wider in regular
+// hours, with a busy half hour on Tuesday morning. Crypto walks all week.
+
+static const uint32_t T0 = 1763960400;                 // 2025-11-24 05:00Z = 00:00 EST
+static const int      MINUTES = 7 * 24 * 60;
+
+struct Tape { std::vector<float> stock, crypto; std::vector<uint8_t> sess; };
+
+static uint32_t g_rng = 12345;
+static float noise() { g_rng = g_rng * 1664525u + 1013904223u; return ((g_rng >> 8) / 16777216.0f) * 2 - 1; }
+
+static Tape makeTape() {
+  Tape tp;
+  float s = 200, c = 60000;
+  for (int k = 0; k < MINUTES; ++k) {
+    struct tm t;
+    nyseLocalTime(T0 + k * 60, t);
+    MarketSession ss = nyseSession(t);
+    bool busy = t.tm_mday == 25 && t.tm_hour == 10 && t.tm_min < 30;
+    float sigma = ss == SESS_REGULAR ? (busy ? 0.008f : 0.0006f) : ss == SESS_CLOSED ? 0 : 0.0002f;
+    // Pre/after trade thinly: most minutes print the same price again
+    if (ss != SESS_REGULAR && (k % 7)) sigma = 0;
+    s *= 1 + sigma * noise();
+    s = (int)(s * 100 + 0.5f) / 100.0f;                 // quotes come in cents
+    c *= 1 + 0.0008f * noise();
+    tp.stock.push_back(s); tp.crypto.push_back(c); tp.sess.push_back(ss);
+  }
+  return tp;
+}
+
+struct Replay {
+  std::vector<uint32_t> at;            // poll times
+  std::vector<uint32_t> wait;          // interval chosen after each
+  PollState st;
+};
+
+static Replay replay(const Tape& tp, bool crypto) {
+  Replay r;
+  pollReset(r.st);
+  uint32_t now = T0, end = T0 + MINUTES * 60;
+  while (now < end) {
+    int k = (now - T0) / 60;
+    struct tm t;
+    nyseLocalTime(now, t);
+    float price = crypto ? tp.crypto[k] : tp.stock[k];
+    pollObserve(r.st, price, now, crypto, nyseSession(t), nyseSecondsToChange(t));
+    r.at.push_back(now);
+    r.wait.push_back(r.st.nextAt - now);
+    now = r.st.nextAt;
+  }
+  return r;
+}
+
+static int pollsBetween(const Replay& r, uint32_t a, uint32_t b) {
+  int n = 0;
+  for (uint32_t t : r.at) n += t >= a && t < b;
+  return n;
+}
+
+static uint32_t utcOfEt(int d, int h, int mi) { return T0 + ((d - 24) * 24 * 60 + h * 60 + mi) * 60; }
+
+static void testReplay() {
+  Tape tp = makeTape();
+  Replay s = replay(tp, false), c = replay(tp, true);
+  uint32_t end = T0 + MINUTES * 60;
+
+  // Never faster than the session floor, never slower than its ceiling
+  // (the cap at a session edge may make it shorter)
+  bool inLimits = true;
+  for (size_t i = 0; i < s.at.size(); ++i) {
+    struct tm t; nyseLocalTime(s.at[i], t);
+    PollLimits lim = pollLimits(false, nyseSession(t));
+    uint32_t edge = nyseSecondsToChange(t);
+    if (s.wait[i] > lim.ceil || (s.wait[i] < lim.floor && s.wait[i] != edge)) inLimits = false;
+  }
+  CHECK(inLimits);
+
+  // Every open is seen within a minute: a night of backoff does not run
+  // through 04:00 or 09:30
+  for (int d : { 24, 25, 26, 28 }) {
+    CHECK(pollsBetween(s, utcOfEt(d, 4, 0), utcOfEt(d, 4, 1)) >= 1);
+    CHECK(pollsBetween(s, utcOfEt(d, 9, 30), utcOfEt(d, 9, 31)) >= 1);
+  }
+
+  // Holiday and weekend: no more than the half-hour closed floor allows
+  CHECK(pollsBetween(s, utcOfEt(27, 0, 0), utcOfEt(28, 0, 0)) <= 24 * 2);
+  CHECK(pollsBetween(s, utcOfEt(29, 0, 0), end) <= 2 * 24 * 2);
+  // ... and the early close counts as after-hours at 13:00, not regular
+  CHECK(pollsBetween(s, utcOfEt(28, 13, 0), utcOfEt(28, 16, 0)) <= 3 * 60);
+
+  // The busy half hour is followed at the floor
+  uint32_t fastest = 0xffffffff;
+  for (size_t i = 0; i < s.at.size(); ++i)
+    if (s.at[i] >= utcOfEt(25, 10, 0) && s.at[i] < utcOfEt(25, 10, 30) && s.wait[i] < fastest) fastest = s.wait[i];
+  CHECK(fastest == 15);
+
+  // Crypto stays inside its limits all week, weekends included
+  bool cryptoLimits = true;
+  for (uint32_t w : c.wait) if (w < 15 || w > 300) cryptoLimits = false;
+  CHECK(cryptoLimits);
+  CHECK(pollsBetween(c, utcOfEt(29, 0, 0), end) > 2 * 24 * 12);
+
+  // The point of it: far fewer requests than one every 30 s
+  int32_t fixed = (int32_t)((end - T0) / POLL_FIXED_S);
+  int32_t saved = pollSaved(s.st, s.at.back());
+  CHECK(saved > fixed * 3 / 4);
+  CHECK(pollSaved(c.st, c.at.back()) > 0);
+  printf("week replay: fixed %ld polls; stock %zu (saved %ld), crypto %zu (saved %ld)\n", (long)fixed,
+         s.at.size(), (long)saved, c.at.size(), (long)pollSaved(c.st, c.at.back()));
+}
+
+int main() {
+  testCalendar();
+  testReplay();
+  return checkDone("poll_policy");
+}
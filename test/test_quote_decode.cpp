@@ -0,0 +1,176 @@
+// Recorded API responses through the decoders' filters, documents and field
+// mapping (QuoteDecode.h), then the same responses mangled many thousand
+// ways. Needs ArduinoJson on the include path (see the Makefile); build with
+// -fsanitize=address,undefined to have the fuzz pass catch memory errors.
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <random>
+#include "QuoteDecode.h"
+#include "check.h"
+
+static std::string slurp(const char* path) {
+  std::string s;
+  FILE* f = fopen(path, "rb");
+  if (!f) { printf("missing %s (run from test/)\n", path); return s; }
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) s.append(buf, n);
+  fclose(f);
+  return s;
+}
+
+static bool near(float a, float b) { return fabs(a - b) <= fabs(b) * 1e-5f + 1e-5f; }
+
+// Each decoder as the device runs it, minus the socket
+static bool quote(const std::string& body, Quote& q) {
+  FinnhubQuoteFilter filter; finnhubQuoteFilter(filter);
+  FinnhubQuoteDoc doc;
+  if (deserializeJson(doc, body.data(), body.size(), DeserializationOption::Filter(filter))) return false;
+  finnhubQuoteFrom(doc, q);
+  return true;
+}
+
+static bool tick(const std::string& body, const char* inst, Quote& q, size_t* used = nullptr) {
+  CoindeskTickFilter filter; coindeskTickFilter(filter, inst);
+  CoindeskTickDoc doc;
+  if (deserializeJson(doc, body.data(), body.size(), DeserializationOption::Filter(filter))) return false;
+  if (used) *used = doc.memoryUsage();
+  return coindeskTickFrom(doc, inst, q);
+}
+
+static bool candle(const std::string& body, float& v) {
+  FinnhubCandleFilter filter; finnhubCandleFilter(filter);
+  FinnhubCandleDoc doc;
+  if (deserializeJson(doc, body.data(), body.size(), DeserializationOption::Filter(filter))) return false;
+  v = finnhubLastVolumeFrom(doc);
+  return true;
+}
+
+static bool name(const std::string& body, std::string& out) {
+  FinnhubNameFilter filter; finnhubNameFilter(filter);
+  FinnhubNameDoc doc;
+  if (deserializeJson(doc, body.data(), body.size(), DeserializationOption::Filter(filter))) return false;
+  out = doc["name"] | "";
+  return true;
+}
+
+// A response body read the way Arduino's Stream reads a socket: byte by
+// byte, with find() and findUntil() consuming what they pass over
+struct BodyStream {
+  const std::string& body;
+  size_t at = 0;
+  explicit BodyStream(const std::string& b) : body(b) {}
+  int read() { return at < body.size() ? (unsigned char)body[at++] : -1; }
+  size_t readBytes(char* buf, size_t n) {
+    size_t k = 0;
+    while (k < n && at < body.size()) buf[k++] = body[at++];
+    return k;
+  }
+  // True once `target` has been read; false at `term` or the end
+  bool findUntil(const char* target, const char* term) {
+    size_t t = 0, u = 0, tn = strlen(target), un = term ? strlen(term) : 0;
+    for (int c; (c = read()) >= 0; ) {
+      t = (c == target[t]) ? t + 1 : (c == target[0]);
+      if (t == tn) return true;
+      if (un) { u = (c == term[u]) ? u + 1 : (c == term[0]); if (u == un) return false; }
+    }
+    return false;
+  }
+  bool find(const char* target) { return findUntil(target, nullptr); }
+};
+
+// The news array through the device's own walk (finnhubHeadlinesFrom)
+static int headlines(const std::string& body, size_t maxItems, std::vector<std::string>& out,
+                     bool* overflowed, size_t* read = nullptr) {
+  FinnhubNewsItemDoc item;
+  BodyStream s(body);
+  out.clear();
+  finnhubHeadlinesFrom(s, item, out, maxItems);
+  *overflowed = item.overflowed();
+  if (read) *read = s.at;
+  return (int)out.size();
+}
+
+// Byte flips, cuts, dropped and repeated spans, stray tokens
+static std::string mutate(const std::string& s, std::mt19937& rng) {
+  static const char* TOKENS[] = { "{", "}", "[", "]", ",", ":", "\"", "null", "1e999", "-0", "\"\\u00", "true", "9999999999999999999" };
+  std::string m = s;
+  int edits = 1 + rng() % 4;
+  for (int k = 0; k < edits && !m.empty(); ++k) {
+    size_t at = rng() % m.size();
+    switch (rng() % 5) {
+      case 0: m[at] = (char)(rng() & 0xFF); break;
+      case 1: m.resize(at); break;
+      case 2: m.erase(at, 1 + rng() % 32); break;
+      case 3: m.insert(at, m.substr(at, 1 + rng() % 64)); break;
+      case 4: m.insert(at, TOKENS[rng() % (sizeof(TOKENS) / sizeof(TOKENS[0]))]); break;
+    }
+  }
+  return m;
+}
+
+int main() {
+  std::string rq = slurp("data/finnhub_quote.json"), rt = slurp("data/coindesk_tick.json");
+  std::string rc = slurp("data/finnhub_candle.json"), rp = slurp("data/finnhub_profile.json");
+  std::string rn = slurp("data/finnhub_news.json");
+  CHECK(!rq.empty() && !rt.empty() && !rc.empty() && !rp.empty() && !rn.empty());
+
+  // Recorded responses decode to what the API sent
+  Quote q = {};
+  CHECK(quote(rq, q));
+  CHECK(near(q.price, 189.84f) && near(q.high, 191.05f) && near(q.low, 188.61f) && near(q.prevClose, 191.07f));
+  CHECK(near(q.changePct, (189.84f - 191.07f) / 191.07f * 100.0f));
+
+  size_t used = 0;
+  CHECK(tick(rt, "BTC-USD", q, &used));
+  CHECK(near(q.price, 67234.52f) && near(q.changePct, 1.3f));
+  CHECK(used <= CoindeskTickDoc().capacity());
+  printf("coindesk tick: %zu B body -> %zu B of a %zu B document\n", rt.size(), used, CoindeskTickDoc().capacity());
+  CHECK(tick(rt, "ETH-USD", q) && near(q.price, 2618.4f));
+  CHECK(!tick(rt, "DOGE-USD", q));                  // not in the reply
+
+  float v = 0;
+  CHECK(candle(rc, v) && v == 48213507.0f);
+  std::string n;
+  CHECK(name(rp, n) && n == "Apple Inc");
+
+  std::vector<std::string> heads;
+  bool over = false;
+  size_t read = 0;
+  CHECK(headlines(rn, 5, heads, &over, &read) == 5);
+  CHECK(!over);
+  CHECK(heads.size() == 5 && heads[0].find("Headline number 0") == 0);
+  CHECK(heads.size() == 5 && heads[4].find("Headline number 4") == 0);
+  // The walk stops after the fifth element, well short of the whole body
+  CHECK(read < rn.size() && rn[read - 1] == '}' && rn[read] == ',');
+  printf("news: %zu of %zu B read for 5 headlines\n", read, rn.size());
+
+  // Asking for more than there are ends at the closing bracket
+  std::string three = "[{\"headline\":\"a, b\"},{\"id\":2},\n {\"headline\":\"c]\"}]";
+  CHECK(headlines(three, 10, heads, &over, &read) == 2 && read == three.size());
+  CHECK(heads[0] == "a, b" && heads[1] == "c]");         // one without a headline is skipped
+  CHECK(headlines("[]", 5, heads, &over) == 0);
+  CHECK(headlines("{\"error\":\"limit\"}", 5, heads, &over) == 0);
+
+  // Fuzz: nothing may crash, and fixed documents never grow past capacity
+  std::mt19937 rng(2026);
+  const int ROUNDS = 20000;
+  int parsed = 0;
+  for (int i = 0; i < ROUNDS; ++i) {
+    Quote fq = {};
+    float fv;
+    std::string fn;
+    parsed += quote(mutate(rq, rng), fq);
+    parsed += tick(mutate(rt, rng), "BTC-USD", fq, &used);
+    CHECK(used <= CoindeskTickDoc().capacity());
+    parsed += candle(mutate(rc, rng), fv);
+    parsed += name(mutate(rp, rng), fn);
+    if (i % 8 == 0) headlines(mutate(rn, rng), 5, heads, &over);
+  }
+  printf("fuzz: %d mutated responses, %d still parsed\n", ROUNDS * 4, parsed);
+
+  return checkDone("quote decode");
+}
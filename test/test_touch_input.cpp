@@ -0,0 +1,149 @@
+// Touch traces replayed through the gesture recognizer and event ring
+// (TouchInput.h). data/touch_*.trace hold samples in the format
+// touchTrace(true) prints on the device. Each replay must give the same
+// gestures in the same order. A replay with the consumer stalled shows a
+// long drag cannot push out its own press and release. A producer thread
+// against a consumer thread checks the ring loses and reorders nothing.
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TouchInput.h"
+#include "check.h"
+
+static const char* NAMES[] = { "DOWN", "UP", "TAP", "DOUBLE", "LONG", "DRAG", "SWIPE" };
+
+// Feed a trace into `ring`; the number of samples, -1 when unreadable
+static int replay(const char* path, TouchRing& ring, TouchRecognizer& rec) {
+  FILE* f = fopen(path, "r");
+  if (!f) return -1;
+  rec.sink = touchRingSink;
+  rec.ctx = &ring;
+  char line[128];
+  int n = 0;
+  while (fgets(line, sizeof(line), f)) {
+    uint32_t ms; bool pressed; int x, y;
+    if (line[0] == '#' || !touchTraceLine(line, ms, pressed, x, y)) continue;
+    rec.sample(ms, pressed, x, y);
+    n++;
+  }
+  fclose(f);
+  return n;
+}
+
+static void drain(TouchRing& ring, std::vector<TouchEvent>& ev) {
+  TouchEvent e;
+  while (ring.pop(e)) ev.push_back(e);
+}
+
+// Event names, a run of DRAGs as one
+static std::string gestures(const std::vector<TouchEvent>& ev) {
+  std::string s;
+  for (size_t k = 0; k < ev.size(); ++k) {
+    if (k && ev[k].type == TOUCH_DRAG && ev[k - 1].type == TOUCH_DRAG) continue;
+    s += std::string(s.empty() ? "" : " ") + NAMES[ev[k].type];
+  }
+  return s;
+}
+
+static void testTaps() {
+  TouchRing ring; TouchRecognizer rec;
+  CHECK(replay("data/touch_taps.trace", ring, rec) > 0);
+  std::vector<TouchEvent> ev;
+  drain(ring, ev);
+  CHECK(gestures(ev) == "DOWN UP TAP DOWN UP TAP DOWN UP DOUBLE");
+  // Taps report where the finger went down, stamped with the release
+  CHECK(ev.size() == 9 && ev[2].x == ev[0].x && ev[2].y == ev[0].y && ev[2].ms == 1100);
+  CHECK(ev.size() == 9 && ev[8].ms == 2870 && ev[8].x == ev[6].x);
+  CHECK(ring.dropped == 0);
+}
+
+static void testLongDrag() {
+  TouchRing ring; TouchRecognizer rec;
+  std::vector<TouchEvent> ev;
+  // Drained as it goes, the way loop() does
+  FILE* f = fopen("data/touch_long_drag.trace", "r");
+  CHECK(f != nullptr);
+  if (!f) return;
+  rec.sink = touchRingSink; rec.ctx = &ring;
+  char line[128];
+  while (fgets(line, sizeof(line), f)) {
+    uint32_t ms; bool pressed; int x, y;
+    if (line[0] == '#' || !touchTraceLine(line, ms, pressed, x, y)) continue;
+    rec.sample(ms, pressed, x, y);
+    drain(ring, ev);
+  }
+  fclose(f);
+  CHECK(gestures(ev) == "DOWN LONG UP DOWN DRAG UP DOWN DRAG UP SWIPE");
+
+  // A shaky finger stays a long press; it fires once, LONG_MS in
+  int longs = 0; uint32_t longMs = 0;
+  for (auto& e : ev) if (e.type == TOUCH_LONG_PRESS) { longs++; longMs = e.ms; }
+  CHECK(longs == 1 && longMs == 5000 + TouchRecognizer::LONG_MS);
+
+  // The slow scroll: its DRAGs add up to the whole move, and it is no swipe
+  int sumX = 0, sumY = 0, upDx = 0, upDy = 0;
+  for (const TouchEvent& e : ev) {
+    if (e.ms < 7000 || e.ms > 8000) continue;
+    if (e.type == TOUCH_DRAG) { sumX += e.dx; sumY += e.dy; }
+    if (e.type == TOUCH_UP) { upDx = e.dx; upDy = e.dy; }
+  }
+  CHECK(sumY == 495 && upDy == 495 && sumX == upDx);
+
+  // The quick one is a swipe left of 200 px
+  CHECK(!ev.empty() && ev.back().type == TOUCH_SWIPE && ev.back().dx == -200);
+  CHECK(ring.dropped == 0);
+}
+
+static void testStalledConsumer() {
+  // loop() blocked for the whole trace: nothing is drained until the end
+  TouchRing ring; TouchRecognizer rec;
+  replay("data/touch_long_drag.trace", ring, rec);
+  std::vector<TouchEvent> ev;
+  drain(ring, ev);
+  CHECK(ring.dropped > 0);
+  CHECK((int)ev.size() <= TouchRing::N);
+  // Only DRAGs were dropped: every press and release is there, in order
+  std::string edges;
+  for (auto& e : ev) if (e.type != TOUCH_DRAG) edges += std::string(edges.empty() ? "" : " ") + NAMES[e.type];
+  CHECK(edges == "DOWN LONG UP DOWN UP DOWN UP SWIPE");
+  bool ordered = true;
+  for (size_t k = 1; k < ev.size(); ++k) ordered = ordered && ev[k - 1].ms <= ev[k].ms;
+  CHECK(ordered);
+}
+
+static void testRingThreads() {
+  // One producer, one consumer, as the touch task and loop(); sequence
+  // numbers ride in ms, and x carries a check of them
+  TouchRing ring;
+  const uint32_t N = 2000000;
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < N; ) {
+      TouchEvent e = { i, (int16_t)(i * 7), 0, 0, 0, (uint8_t)(i % 5 == 4 ? TOUCH_UP : TOUCH_DOWN) };
+      if (ring.push(e)) ++i;
+      else std::this_thread::yield();
+    }
+  });
+  uint32_t next = 0, bad = 0;
+  while (next < N) {
+    TouchEvent e;
+    if (!ring.pop(e)) { std::this_thread::yield(); continue; }
+    if (e.ms != next || e.x != (int16_t)(next * 7)) bad++;
+    next = e.ms + 1;
+  }
+  producer.join();
+  CHECK(bad == 0);
+  CHECK(next == N);
+  TouchEvent e;
+  CHECK(!ring.pop(e));
+}
+
+int main() {
+  testTaps();
+  testLongDrag();
+  testStalledConsumer();
+  testRingThreads();
+  return checkDone("touch input");
+}
@@ -0,0 +1,198 @@
+// Week grid layout (WeekGrid.h): column assignment on pathological and
+// random overlap sets, and how events are cut over the visible days. Every
+// layout is checked against what it must hold: overlapping blocks never
+// share a column, and each cluster is as wide as its busiest moment.
+
+#include <stdlib.h>
+#include <vector>
+#include "WeekGrid.h"
+#include "check.h"
+
+static uint32_t g_seed = 12345;
+static int rnd(int n) { g_seed = g_seed * 1103515245u + 12345u; return (int)((g_seed >> 8) % (uint32_t)n); }
+
+static bool overlap(const GridItem& a, const GridItem& b) { return a.start < b.end && b.start < a.end; }
+
+// Laid-out items (sorted by start) against the invariants; false on the first breach
+static bool valid(const std::vector<GridItem>& it) {
+  int n = (int)it.size();
+  for (int i = 0; i < n; ++i) {
+    if (it[i].cols == 0 || it[i].col >= it[i].cols) return false;
+    for (int j = i + 1; j < n && it[j].start < it[i].end; ++j)
+      if (overlap(it[i], it[j]) && it[i].col == it[j].col && it[i].col < 254) return false;
+  }
+  // Clusters: runs linked by overlaps; width = most running at once (capped), same for all
+  for (int a = 0; a < n; ) {
+    int b = a + 1, end = it[a].end;
+    while (b < n && it[b].start < end) { end = std::max(end, (int)it[b].end); b++; }
+    int busiest = 0, used = 0;
+    for (int k = a; k < b; ++k) {
+      int running = 0;
+      for (int q = a; q <= k; ++q) if (it[q].end > it[k].start) running++;
+      busiest = std::max(busiest, running);
+      used = std::max(used, it[k].col + 1);
+      if (it[k].cols != it[a].cols) return false;
+    }
+    if (it[a].cols != std::min(busiest, 255) || it[a].cols != used) return false;
+    a = b;
+  }
+  return true;
+}
+
+static std::vector<GridItem> laid(std::vector<GridItem> it) {
+  gridLayout(it.data(), (int)it.size());
+  return it;
+}
+
+static void testPathological() {
+  std::vector<GridItem> it;
+
+  CHECK(gridLayout(nullptr, 0) == 0);
+
+  // All identical: one column each
+  for (int k = 0; k < 40; ++k) it.push_back({ 600, 660, (uint16_t)k, 0, 0 });
+  it = laid(it);
+  CHECK(valid(it) && it[0].cols == 40);
+
+  // Past 255 at once the rest share the last column, and cols still fits
+  it.clear();
+  for (int k = 0; k < 300; ++k) it.push_back({ 600, 660, (uint16_t)k, 0, 0 });
+  int widest = gridLayout(it.data(), (int)it.size());
+  CHECK(widest == 255 && valid(it));
+  CHECK(it[299].col == 254 && it[299].cols == 255);
+
+  // Back to back, no gap: one column, separate clusters
+  it.clear();
+  for (int k = 0; k < 20; ++k) it.push_back({ (int16_t)(k * 30), (int16_t)(k * 30 + 30), (uint16_t)k, 0, 0 });
+  it = laid(it);
+  bool single = valid(it);
+  for (const GridItem& g : it) single = single && g.col == 0 && g.cols == 1;
+  CHECK(single);
+
+  // Nested: each inside the last, all at once
+  it.clear();
+  for (int k = 0; k < 30; ++k) it.push_back({ (int16_t)(k * 10), (int16_t)(1000 - k * 10), (uint16_t)k, 0, 0 });
+  it = laid(it);
+  CHECK(valid(it) && it[0].cols == 30);
+
+  // A chain: each overlaps only the next, so one cluster two wide
+  it.clear();
+  for (int k = 0; k < 50; ++k) it.push_back({ (int16_t)(k * 20), (int16_t)(k * 20 + 30), (uint16_t)k, 0, 0 });
+  it = laid(it);
+  CHECK(valid(it) && it[0].cols == 2 && it[49].cols == 2);
+
+  // One long block under many short ones: two wide, the long one keeps column 0
+  it.clear();
+  it.push_back({ 480, 1200, 0, 0, 0 });
+  for (int k = 0; k < 20; ++k) it.push_back({ (int16_t)(480 + k * 36), (int16_t)(480 + k * 36 + 36), (uint16_t)(k + 1), 0, 0 });
+  it = laid(it);
+  CHECK(valid(it) && it[0].idx == 0 && it[0].col == 0 && it[0].cols == 2);
+
+  // Freed columns are reused lowest first
+  it = laid({ { 0, 100, 0, 0, 0 }, { 10, 50, 1, 0, 0 }, { 20, 100, 2, 0, 0 }, { 60, 90, 3, 0, 0 } });
+  CHECK(valid(it) && it[3].col == 1 && it[3].cols == 3);
+}
+
+static void testRandom() {
+  for (int round = 0; round < 400; ++round) {
+    int n = 1 + rnd(round < 300 ? 40 : 400);
+    int spread = 1 + rnd(1440);
+    std::vector<GridItem> it;
+    for (int k = 0; k < n; ++k) {
+      int s = rnd(spread), len = 1 + rnd(rnd(4) ? 90 : 600);
+      it.push_back({ (int16_t)s, (int16_t)(s + len), (uint16_t)k, 0, 0 });
+    }
+    it = laid(it);
+    bool ok = valid(it);
+    if (!ok) printf("  random set %d (n=%d) broke the layout\n", round, n);
+    CHECK(ok);
+  }
+}
+
+// ---------- Events over the week ----------
+static const int32_t D0 = 20000;                // day number of the first column
+static const WeekHours HRS = { 7 * 60, 22 * 60, 20 };
+
+struct Placed {
+  std::vector<GridItem> band, timed[7];
+  int blocks() const { int n = 0; for (auto& t : timed) n += (int)t.size(); return n; }
+};
+
+static Placed place(WeekSpan ev) {
+  Placed p;
+  weekPlace(ev, D0, 7, HRS, p.band, p.timed);
+  return p;
+}
+
+static void testPlace() {
+  // Same day: one block, as before
+  Placed p = place({ D0 + 2, D0 + 2, 9 * 60, 10 * 60, false, 1 });
+  CHECK(p.band.empty() && p.blocks() == 1 && p.timed[2].size() == 1);
+  CHECK(p.timed[2][0].start == 540 && p.timed[2][0].end == 600);
+
+  // Past midnight: the evening on its day, the rest on the next
+  p = place({ D0 + 1, D0 + 2, 20 * 60, 9 * 60, false, 2 });
+  CHECK(p.band.empty() && p.blocks() == 2);
+  CHECK(p.timed[1].size() == 1 && p.timed[1][0].start == 1200 && p.timed[1][0].end == 22 * 60);
+  CHECK(p.timed[2].size() == 1 && p.timed[2][0].start == 7 * 60 && p.timed[2][0].end == 540);
+
+  // Ends at midnight exactly: nothing on the next day
+  p = place({ D0 + 3, D0 + 4, 19 * 60, 0, false, 3 });
+  CHECK(p.blocks() == 1 && p.timed[3].size() == 1 && p.timed[3][0].end == 22 * 60);
+
+  // Late night, off the grid: clamped to its last WEEK_MIN_MIN
+  p = place({ D0, D0 + 1, 23 * 60, 30, false, 4 });
+  CHECK(p.timed[0].size() == 1 && p.timed[0][0].start == 22 * 60 - 20 && p.timed[0][0].end == 22 * 60);
+  CHECK(p.timed[1].size() == 1 && p.timed[1][0].start == 7 * 60 && p.timed[1][0].end == 7 * 60 + 20);
+
+  // No usable end: to midnight
+  p = place({ D0 + 5, D0 + 5, 21 * 60, 20 * 60, false, 5 });
+  CHECK(p.blocks() == 1 && p.timed[5][0].start == 21 * 60 && p.timed[5][0].end == 22 * 60);
+
+  // 24 h or more: a span in the band, over every day it touches
+  p = place({ D0 + 1, D0 + 3, 10 * 60, 12 * 60, false, 6 });
+  CHECK(p.blocks() == 0 && p.band.size() == 1 && p.band[0].start == 1 && p.band[0].end == 4);
+
+  // All-day: inclusive days; clipped at both ends of the week
+  p = place({ D0 + 2, D0 + 2, 0, 0, true, 7 });
+  CHECK(p.band.size() == 1 && p.band[0].start == 2 && p.band[0].end == 3);
+  p = place({ D0 - 3, D0 + 1, 0, 0, true, 8 });
+  CHECK(p.band.size() == 1 && p.band[0].start == 0 && p.band[0].end == 2);
+  p = place({ D0 + 5, D0 + 20, 0, 0, true, 9 });
+  CHECK(p.band.size() == 1 && p.band[0].start == 5 && p.band[0].end == 7);
+
+  // Out of the week: nothing; started last week and still running: the tail
+  CHECK(place({ D0 + 7, D0 + 7, 0, 0, true, 10 }).band.empty());
+  CHECK(place({ D0 - 1, D0 - 1, 600, 700, false, 11 }).blocks() == 0);
+  p = place({ D0 - 1, D0, 22 * 60, 8 * 60, false, 12 });
+  CHECK(p.blocks() == 1 && p.timed[0].size() == 1 && p.timed[0][0].end == 480);
+}
+
+static void testBand() {
+  // Spans stack in rows; columns with more spans than rows count the rest
+  std::vector<GridItem> band = {
+    { 0, 7, 0, 0, 0 },                          // the whole week
+    { 1, 3, 1, 0, 0 }, { 2, 4, 2, 0, 0 },       // overlap on column 2
+    { 5, 6, 3, 0, 0 },
+  };
+  gridLayout(band.data(), (int)band.size());
+  uint8_t more[7];
+  weekBandMore(band.data(), (int)band.size(), 2, more, 7);
+  CHECK(band[0].col == 0 && band[1].col == 1 && band[2].col == 2 && band[3].col == 1);
+  CHECK(more[0] == 0 && more[1] == 0 && more[5] == 0 && more[6] == 0);
+  CHECK(more[2] == 2 && more[3] == 1 && more[4] == 0);
+  // Rows never collide where spans share a column
+  bool apart = true;
+  for (size_t a = 0; a < band.size(); ++a)
+    for (size_t b = a + 1; b < band.size(); ++b)
+      if (overlap(band[a], band[b])) apart = apart && band[a].col != band[b].col;
+  CHECK(apart);
+}
+
+int main() {
+  testPathological();
+  testRandom();
+  testPlace();
+  testBand();
+  return checkDone("week grid");
+}
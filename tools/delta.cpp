@@ -0,0 +1,91 @@
+// Host tool for delta firmware patches (DeltaOta.h).
+//
+//   delta make   OLD.bin NEW.bin OUT.dlt     patch that turns OLD into NEW
+//   delta apply  OLD.bin PATCH.dlt OUT.bin   rebuild NEW, as the device would
+//   delta verify OLD.bin PATCH.dlt [NEW.bin] check the patch against the images
+//
+// OLD is the .bin of the build running on the device (Sketch > Export
+// compiled binary), NEW the one to move to. Copy OUT.dlt to
+// /update/<sketch>.dlt on the card, or serve it and POST its URL to /update.
+//
+//   g++ -std=gnu++17 -O2 -I.. -o delta delta.cpp
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "DeltaOta.h"
+
+static bool readFile(const char* path, std::vector<uint8_t>& v) {
+  FILE* f = fopen(path, "rb");
+  if (!f) { fprintf(stderr, "delta: cannot open %s\n", path); return false; }
+  v.clear();
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) v.insert(v.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+static bool writeFile(const char* path, const std::vector<uint8_t>& v) {
+  FILE* f = fopen(path, "wb");
+  if (!f) { fprintf(stderr, "delta: cannot create %s\n", path); return false; }
+  bool ok = fwrite(v.data(), 1, v.size(), f) == v.size();
+  ok = fclose(f) == 0 && ok;
+  if (!ok) fprintf(stderr, "delta: write to %s failed\n", path);
+  return ok;
+}
+
+static void describe(const std::vector<uint8_t>& patch) {
+  DeltaHeader h;
+  memcpy(&h, patch.data(), sizeof(h));
+  printf("patch %zu B: %u B (crc %08x) -> %u B (crc %08x), %.1f%% of the new image\n", patch.size(),
+         (unsigned)h.oldSize, (unsigned)h.oldCrc, (unsigned)h.newSize, (unsigned)h.newCrc,
+         h.newSize ? 100.0 * patch.size() / h.newSize : 0.0);
+}
+
+static int usage() {
+  fprintf(stderr, "usage: delta make OLD NEW OUT | apply OLD PATCH OUT | verify OLD PATCH [NEW]\n");
+  return 2;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 4) return usage();
+  const char* cmd = argv[1];
+  std::vector<uint8_t> a, p, b;
+  if (!readFile(argv[2], a)) return 1;
+
+  if (!strcmp(cmd, "make") && argc == 5) {
+    if (!readFile(argv[3], b)) return 1;
+    deltaMake(a.data(), (uint32_t)a.size(), b.data(), (uint32_t)b.size(), p);
+    std::vector<uint8_t> check;
+    if (const char* err = deltaApply(a.data(), (uint32_t)a.size(), p.data(), p.size(), check)) {
+      fprintf(stderr, "delta: patch does not round-trip: %s\n", err);
+      return 1;
+    }
+    if (!writeFile(argv[4], p)) return 1;
+    describe(p);
+    return 0;
+  }
+
+  if (!readFile(argv[3], p)) return 1;
+  if (p.size() < sizeof(DeltaHeader)) { fprintf(stderr, "delta: %s is not a patch\n", argv[3]); return 1; }
+  const char* err = deltaApply(a.data(), (uint32_t)a.size(), p.data(), p.size(), b);
+  if (err) { fprintf(stderr, "delta: %s\n", err); return 1; }
+
+  if (!strcmp(cmd, "apply") && argc == 5) {
+    if (!writeFile(argv[4], b)) return 1;
+    describe(p);
+    return 0;
+  }
+  if (!strcmp(cmd, "verify") && (argc == 4 || argc == 5)) {
+    if (argc == 5) {
+      std::vector<uint8_t> want;
+      if (!readFile(argv[4], want)) return 1;
+      if (want != b) { fprintf(stderr, "delta: patch does not produce %s\n", argv[4]); return 1; }
+    }
+    describe(p);
+    printf("ok\n");
+    return 0;
+  }
+  return usage();
+}